@@ -13,6 +13,9 @@ include $(CLEAR_VARS)
 
 LOCAL_MODULE    := libaria-android
 LOCAL_LDLIBS	:= -lc -ldl
+# a static lib's LDLIBS aren't used, so the modules linking this get
+# zlib (for ArDataLogger's columnar logs) from here
+LOCAL_EXPORT_LDLIBS := -lz
 LOCAL_SRC_FILES := \
 	pthread_android_additions.cpp \
 	ArAction.cpp \
@@ -50,6 +53,7 @@ LOCAL_SRC_FILES := \
 	ArArgumentParser.cpp \
 	ArASyncTask.cpp \
 	ArBasePacket.cpp \
+	ArBinaryLog.cpp \
 	ArBumpers.cpp\
 	ArCameraCollection.cpp \
 	ArCameraCommands.cpp \
@@ -57,6 +61,7 @@ LOCAL_SRC_FILES := \
 	ArConfig.cpp \
 	ArConfigArg.cpp \
 	ArConfigGroup.cpp \
+	ArDataLogReader.cpp \
 	ArDataLogger.cpp \
 	ArDeviceConnection.cpp \
 	ArDPPTU.cpp \
@@ -111,6 +116,7 @@ LOCAL_SRC_FILES := \
 	ArRatioInputRobotJoydrive.cpp \
 	ArRatioInputKeydrive.cpp \
 	ArRecurrentTask.cpp \
+	ArReplayConnection.cpp \
 	ArRobot.cpp \
 	ArRobotConfig.cpp \
 	ArRobotConfigPacketReader.cpp \
@@ -119,6 +125,7 @@ LOCAL_SRC_FILES := \
 	ArRobotPacket.cpp \
 	ArRobotPacketSender.cpp \
 	ArRobotPacketReceiver.cpp \
+	ArRobotPacketRecorder.cpp \
 	ArRobotParams.cpp \
 	ArRobotTypes.cpp \
 	ArRVisionPTZ.cpp \
@@ -149,6 +156,7 @@ LOCAL_SRC_FILES := \
 	ArUrg.cpp \
 	ArVCC4.cpp \
 	ArVersalogicIO.cpp \
+	ArWorkerPool.cpp \
 	md5.cpp \
 
 include $(BUILD_STATIC_LIBRARY)
@@ -178,6 +186,7 @@ LOCAL_SRC_FILES := \
 	ArNetPacketReceiverTcp.cpp \
 	ArNetPacketReceiverUdp.cpp \
 	ArNetPacketSenderTcp.cpp \
+	ArNetSharedPacket.cpp \
 	ArServerBase.cpp \
 	ArServerClient.cpp \
 	ArServerData.cpp \
@@ -194,6 +203,7 @@ LOCAL_SRC_FILES := \
 	ArServerInfoRobot.cpp \
 	ArServerInfoSensor.cpp \
 	ArServerInfoStrings.cpp \
+	ArServerInfoSyncTasks.cpp \
 	ArServerMode.cpp \
 	ArServerModeDrive.cpp \
 	ArServerModeIdle.cpp \
@@ -208,3 +218,51 @@ LOCAL_SRC_FILES := \
 LOCAL_STATIC_LIBRARIES := libaria-android
 
 include $(BUILD_SHARED_LIBRARY)
+
+# the argument builder benchmark, push it to a device and run it to
+# compare ArArgumentBuilder with how it used to keep its args
+#
+include $(CLEAR_VARS)
+
+LOCAL_MODULE    := argumentBuilderBenchmark
+LOCAL_LDLIBS	:= -lc -ldl
+LOCAL_SRC_FILES := benchmarks/argumentBuilderBenchmark.cpp
+LOCAL_STATIC_LIBRARIES := libaria-android
+
+include $(BUILD_EXECUTABLE)
+
+# turns a binary log from ArBinaryLog into text, run it on the device
+# the log was written on (the log is in that machine's byte order)
+#
+include $(CLEAR_VARS)
+
+LOCAL_MODULE    := arBinaryLogDecode
+LOCAL_LDLIBS	:= -lc -ldl
+LOCAL_SRC_FILES := utils/arBinaryLogDecode.cpp
+LOCAL_STATIC_LIBRARIES := libaria-android
+
+include $(BUILD_EXECUTABLE)
+
+# turns a binary laser log from ArLaserLogger into a .2d text log, run
+# it on the device the log was written on (same byte order)
+#
+include $(CLEAR_VARS)
+
+LOCAL_MODULE    := convertLaserLog
+LOCAL_LDLIBS	:= -lc -ldl
+LOCAL_SRC_FILES := utils/convertLaserLog.cpp
+LOCAL_STATIC_LIBRARIES := libaria-android
+
+include $(BUILD_EXECUTABLE)
+
+# turns a columnar log from ArDataLogger into a CSV file, run it on the
+# device the log was written on (same byte order)
+#
+include $(CLEAR_VARS)
+
+LOCAL_MODULE    := exportDataLogCSV
+LOCAL_LDLIBS	:= -lc -ldl
+LOCAL_SRC_FILES := utils/exportDataLogCSV.cpp
+LOCAL_STATIC_LIBRARIES := libaria-android
+
+include $(BUILD_EXECUTABLE)
@@ -58,7 +58,7 @@ AREXPORT void ArActionRobotJoydrive::setRobot(ArRobot *robot)
   if (myRobot != NULL)
   {
     myRobot->addConnectCB(&myConnectCB);
-    myRobot->addPacketHandler(&myHandleJoystickPacketCB);
+    myRobot->addPacketHandlerForID(&myHandleJoystickPacketCB, 0xF8);
     if (robot->isConnected())
       connectCallback();
   }
@@ -89,7 +89,7 @@ AREXPORT void ArAnalogGyro::stabilizingCallback(void)
     myHaveGottenData = false;
     // moved these two here from above
     myRobot->setEncoderCorrectionCallback(&myEncoderCorrectCB);
-    myRobot->addPacketHandler(&myHandleGyroPacketCB);
+    myRobot->addPacketHandlerForID(&myHandleGyroPacketCB, 0x98);
 
     myScalingFactor = myRobot->getRobotParams()->getGyroScaler();  
     
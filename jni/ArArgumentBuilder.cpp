@@ -40,7 +40,9 @@ char * cppstrdup(const char *str)
   return ret;
 }
 /**
-   @param argvLen the largest number of arguments we'll parse
+   @param argvLen the largest number of arguments we'll parse (argv
+   only grows to this as it needs to, so a big one doesn't cost
+   anything up front)
 
    @param extraSpaceChar if not NULL, then this character will also be 
     used to break up arguments (in addition to whitespace)
@@ -51,7 +53,11 @@ AREXPORT ArArgumentBuilder::ArArgumentBuilder(size_t argvLen,
   myArgc = 0;
   myOrigArgc = 0;
   myArgvLen = argvLen;
-  myArgv = new char *[myArgvLen];
+  myArgv = myInlineArgv;
+  myArgvCapacity = INLINE_ARGV_LEN;
+  myBlock = myInlineBlock;
+  myBlockUsed = 0;
+  myBlockLen = INLINE_BLOCK_LEN;
   myFirstAdd = true;
   myExtraSpace = extraSpaceChar;
   myIsQuiet = false;
@@ -60,27 +66,191 @@ AREXPORT ArArgumentBuilder::ArArgumentBuilder(size_t argvLen,
 AREXPORT ArArgumentBuilder::ArArgumentBuilder(const ArArgumentBuilder & builder)
 {
   size_t i;
+  size_t len;
   myFullString = builder.myFullString;
   myExtraString = builder.myExtraString;
-  myArgc = builder.getArgc();
+  myArgc = 0;
   myArgvLen = builder.getArgvLen();
-  myOrigArgc = myArgc;
-  myArgv = new char *[myArgvLen];
-  for (i = 0; i < myArgc; i++)
-    myArgv[i] = cppstrdup(builder.getArg(i));
-  //myArgv[i] = strdup(builder.getArg(i));
+  myArgv = myInlineArgv;
+  myArgvCapacity = INLINE_ARGV_LEN;
+  myBlock = myInlineBlock;
+  myBlockUsed = 0;
+  myBlockLen = INLINE_BLOCK_LEN;
+  myFirstAdd = builder.myFirstAdd;
+  myExtraSpace = builder.myExtraSpace;
   myIsQuiet = builder.myIsQuiet;
+
+  // size our first block to hold all the args so they get copied
+  // with at most one allocation
+  for (len = 0, i = 0; i < builder.getArgc(); i++)
+    len += strlen(builder.getArg(i)) + 1;
+  if (len > myBlockLen)
+  {
+    myBlock = new char[len];
+    myBlockLen = len;
+    myAllocatedBlocks.push_back(myBlock);
+  }
+  growArgv(builder.getArgc() + 1);
+  for (i = 0; i < builder.getArgc(); i++)
+    myArgv[i] = storeArg(builder.getArg(i), strlen(builder.getArg(i)));
+  myArgc = builder.getArgc();
+  myOrigArgc = myArgc;
 }
 
 AREXPORT ArArgumentBuilder::~ArArgumentBuilder()
+{
+  clearStorage();
+}
+
+AREXPORT void ArArgumentBuilder::clearStorage(void)
+{
+  std::list<char *>::iterator it;
+
+  for (it = myAllocatedBlocks.begin(); it != myAllocatedBlocks.end(); it++)
+    delete[] (*it);
+  myAllocatedBlocks.clear();
+  if (myArgv != myInlineArgv)
+    delete[] myArgv;
+
+  myArgc = 0;
+  myOrigArgc = 0;
+  myArgv = myInlineArgv;
+  myArgvCapacity = INLINE_ARGV_LEN;
+  myBlock = myInlineBlock;
+  myBlockUsed = 0;
+  myBlockLen = INLINE_BLOCK_LEN;
+  myFirstAdd = true;
+  myFullString = "";
+  myExtraString = "";
+}
+
+/**
+   This only ever grows argv up to the argvLen given to the
+   constructor, and copies everything over (including anything past
+   argc, since removeArg leaves the removed arg there).
+**/
+AREXPORT bool ArArgumentBuilder::growArgv(size_t count)
+{
+  size_t newCapacity;
+  char **newArgv;
+
+  if (count <= myArgvCapacity)
+    return true;
+  if (count > myArgvLen)
+    return false;
+
+  for (newCapacity = myArgvCapacity * 2; newCapacity < count; 
+       newCapacity *= 2)
+    ;
+  if (newCapacity > myArgvLen)
+    newCapacity = myArgvLen;
+  newArgv = new char *[newCapacity];
+  memcpy(newArgv, myArgv, myArgvCapacity * sizeof(char *));
+  if (myArgv != myInlineArgv)
+    delete[] myArgv;
+  myArgv = newArgv;
+  myArgvCapacity = newCapacity;
+  return true;
+}
+
+/**
+   The args are packed one after the other into our current block, when
+   one won't fit a new block (twice as big as the last, or big enough
+   for the arg) is allocated; blocks are never moved so the pointers in
+   argv stay good until we're destroyed.
+**/
+AREXPORT char *ArArgumentBuilder::storeArg(const char *str, size_t len)
+{
+  char *ret;
+  size_t newLen;
+
+  if (myBlockUsed + len + 1 > myBlockLen)
+  {
+    newLen = myBlockLen * 2;
+    if (newLen < MIN_BLOCK_LEN)
+      newLen = MIN_BLOCK_LEN;
+    if (newLen < len + 1)
+      newLen = len + 1;
+    myBlock = new char[newLen];
+    myBlockLen = newLen;
+    myBlockUsed = 0;
+    myAllocatedBlocks.push_back(myBlock);
+  }
+  ret = &myBlock[myBlockUsed];
+  memcpy(ret, str, len);
+  ret[len] = '\0';
+  myBlockUsed += len + 1;
+  return ret;
+}
+
+/**
+   The heap parts (argv if it grew, and the blocks) are just handed
+   over, the parts inside the builder are copied and any args that
+   pointed into its inline block are pointed into ours instead.
+**/
+AREXPORT void ArArgumentBuilder::takeFrom(ArArgumentBuilder &builder)
 {
   size_t i;
-  if (myOrigArgc > 0)
+
+  myArgc = builder.myArgc;
+  myOrigArgc = builder.myOrigArgc;
+  myArgvLen = builder.myArgvLen;
+  myFullString.swap(builder.myFullString);
+  myExtraString.swap(builder.myExtraString);
+  myFirstAdd = builder.myFirstAdd;
+  myExtraSpace = builder.myExtraSpace;
+  myIsQuiet = builder.myIsQuiet;
+
+  if (builder.myArgv == builder.myInlineArgv)
   {
-    for (i = 0; i < myOrigArgc; ++i)
-      delete[] myArgv[i];
+    memcpy(myInlineArgv, builder.myInlineArgv, sizeof(myInlineArgv));
+    myArgv = myInlineArgv;
   }
-  delete[] myArgv;
+  else
+  {
+    myArgv = builder.myArgv;
+  }
+  myArgvCapacity = builder.myArgvCapacity;
+
+  memcpy(myInlineBlock, builder.myInlineBlock, sizeof(myInlineBlock));
+  for (i = 0; i < myArgc; i++)
+  {
+    if (myArgv[i] >= builder.myInlineBlock && 
+	myArgv[i] < builder.myInlineBlock + INLINE_BLOCK_LEN)
+      myArgv[i] = myInlineBlock + (myArgv[i] - builder.myInlineBlock);
+  }
+  if (builder.myBlock == builder.myInlineBlock)
+    myBlock = myInlineBlock;
+  else
+    myBlock = builder.myBlock;
+  myBlockUsed = builder.myBlockUsed;
+  myBlockLen = builder.myBlockLen;
+  myAllocatedBlocks.swap(builder.myAllocatedBlocks);
+
+  // now the builder doesn't own any of that anymore
+  builder.myArgv = builder.myInlineArgv;
+  builder.clearStorage();
+}
+
+/**
+   This is how to move a builder without copying all its args, since
+   argv and the blocks the args are in just change hands (only what's
+   stored inside the builders themselves is copied), for instance:
+
+   @code
+   ArArgumentBuilder moved;
+   moved.swap(builder);
+   @endcode
+**/
+AREXPORT void ArArgumentBuilder::swap(ArArgumentBuilder &builder)
+{
+  ArArgumentBuilder temp;
+
+  if (&builder == this)
+    return;
+  temp.takeFrom(builder);
+  builder.takeFrom(*this);
+  takeFrom(temp);
 }
 
 
@@ -156,8 +326,12 @@ AREXPORT void ArArgumentBuilder::internalAdd(const char *str, int position)
   else
     addAtEnd = false;
   
-  strncpy(buf, str, sizeof(buf));
-  len = strlen(buf);
+  // only copy what's there (strncpy would zero the rest of buf every time)
+  len = strlen(str);
+  if (len > (int)sizeof(buf) - 1)
+    len = sizeof(buf) - 1;
+  memcpy(buf, str, len);
+  buf[len] = '\0';
 
   // can do whatever you want with the buf now
   // first we advance to non-space
@@ -206,8 +380,9 @@ AREXPORT void ArArgumentBuilder::internalAdd(const char *str, int position)
 	     (i == len || isspace(buf[i]) || buf[i] == '\0' || 
 	      (myExtraSpace != '\0' && buf[i] == myExtraSpace)))
     {
-      // see if we have room in our argvLen
-      if (myArgc + 1 >= myArgvLen)
+      // see if we have room in our argvLen (and make room in argv for
+      // it and the one moved down past it if it's going in the middle)
+      if (myArgc + 1 >= myArgvLen || !growArgv(myArgc + 2))
       {
 	ArLog::log(ArLog::Terse, "ArArgumentBuilder::Add: could not add argument since argc (%u) has grown beyond the argv given in the constructor (%u)", myArgc, myArgvLen);
       }
@@ -217,9 +392,7 @@ AREXPORT void ArArgumentBuilder::internalAdd(const char *str, int position)
 	// at the end if its too far out
 	if (addAtEnd)
 	{
-	  myArgv[myArgc] = new char[i - startNonSpace + 1];
-	  strncpy(myArgv[myArgc], &buf[startNonSpace], i - startNonSpace);
-	  myArgv[myArgc][i - startNonSpace] = '\0';
+	  myArgv[myArgc] = storeArg(&buf[startNonSpace], i - startNonSpace);
 	  // add to our full string
 	  // if its not our first add a space (or whatever our space char is)
 	  if (!myFirstAdd && myExtraSpace == '\0')
@@ -244,9 +417,7 @@ AREXPORT void ArArgumentBuilder::internalAdd(const char *str, int position)
 	  myArgc++;
 	  myOrigArgc = myArgc;
 
-	  myArgv[position] = new char[i - startNonSpace + 1];
-	  strncpy(myArgv[position], &buf[startNonSpace], i - startNonSpace);
-	  myArgv[position][i - startNonSpace] = '\0';
+	  myArgv[position] = storeArg(&buf[startNonSpace], i - startNonSpace);
 	  position++;
 
 		rebuildFullString();
@@ -353,9 +524,12 @@ AREXPORT void ArArgumentBuilder::addPlainAsIs(const char *str, int position)
 
 AREXPORT void ArArgumentBuilder::internalAddAsIs(const char *str, int position)
 {
-  myArgv[myArgc] = new char[strlen(str) + 1];
-  strcpy(myArgv[myArgc], str);
-  myArgv[myArgc][strlen(str)] = '\0';
+  if (myArgc + 1 >= myArgvLen || !growArgv(myArgc + 1))
+  {
+    ArLog::log(ArLog::Terse, "ArArgumentBuilder::Add: could not add argument since argc (%u) has grown beyond the argv given in the constructor (%u)", myArgc, myArgvLen);
+    return;
+  }
+  myArgv[myArgc] = storeArg(str, strlen(str));
 
   // add to our full string
   // if its not our first add a space (or whatever our space char is)
@@ -615,10 +789,9 @@ AREXPORT void ArArgumentBuilder::compressQuoted(bool stripQuotationMarks)
     {
       myNewArg = &myArgv[i][1];
       myNewArg[myNewArg.size() - 1] = '\0';
-      delete[] myArgv[i];
-      // but replacing ourself with the new arg
-      myArgv[i] = cppstrdup(myNewArg.c_str());
-      //myArgv[i] = strdup(myNewArg.c_str());
+      // but replacing ourself with the new arg (the old one just
+      // stays in its block until we're destroyed)
+      myArgv[i] = storeArg(myNewArg.c_str(), strlen(myNewArg.c_str()));
       continue;
     }
     // if this arg begins with a quote but doesn't end with one
@@ -654,12 +827,8 @@ AREXPORT void ArArgumentBuilder::compressQuoted(bool stripQuotationMarks)
 	  myNewArg[myNewArg.size() - 1] = '\0';
         // removing those next args
         removeArg(i+1);
-        // and ourself
-        delete[] myArgv[i];
-
         // but replacing ourself with the new arg
-        myArgv[i] = cppstrdup(myNewArg.c_str());
-	//myArgv[i] = strdup(myNewArg.c_str());
+        myArgv[i] = storeArg(myNewArg.c_str(), strlen(myNewArg.c_str()));
       }
     }
   }
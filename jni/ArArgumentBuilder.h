@@ -28,6 +28,14 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ariaTypedefs.h"
 
 /// This class is to build arguments for things that require argc and argv
+/**
+   The argv starts out inside the builder itself and the arguments are
+   copied into blocks of memory the builder owns (the first of which is
+   also inside the builder), so building short lines (like those from
+   config files or commands) doesn't have to allocate anything.  The
+   argv only grows onto the heap when there are more arguments than fit
+   in it, and never past the argvLen given to the constructor.
+**/
 class ArArgumentBuilder
 {
 public:
@@ -37,6 +45,8 @@ public:
   AREXPORT ArArgumentBuilder(const ArArgumentBuilder &builder);
   /// Destructor
   AREXPORT virtual ~ArArgumentBuilder();
+  /// Swaps the contents of this builder with another (cheaply, to move one)
+  AREXPORT void swap(ArArgumentBuilder &builder);
 #ifndef SWIG
   /** @brief Adds the given string, with varargs, separates if there are spaces
    *  @swignote Not available
@@ -144,8 +154,21 @@ protected:
   AREXPORT void internalAdd(const char *str, int position = -1);
   AREXPORT void internalAddAsIs(const char *str, int position = -1);
 	AREXPORT void rebuildFullString();
+  /// Makes sure argv has room for count entries, false if it can't
+  AREXPORT bool growArgv(size_t count);
+  /// Copies len chars of str (and a terminating NUL) into our blocks
+  AREXPORT char *storeArg(const char *str, size_t len);
+  /// Takes everything from the builder (leaving it empty), we must be empty
+  AREXPORT void takeFrom(ArArgumentBuilder &builder);
+  /// Frees any memory we allocated and goes back to being empty
+  AREXPORT void clearStorage(void);
 
   size_t getArgvLen(void) const { return myArgvLen; }
+  enum { 
+    INLINE_ARGV_LEN = 32, ///< How many args fit in the argv inside us
+    INLINE_BLOCK_LEN = 256, ///< How many chars fit in the block inside us
+    MIN_BLOCK_LEN = 1024 ///< Smallest block we'll allocate for args
+  };
   // how many arguments we had originally (so we can delete 'em)
   size_t myOrigArgc;
   // how many arguments we have
@@ -154,6 +177,20 @@ protected:
   char **myArgv;
   // argv length
   size_t myArgvLen;
+  // how many entries myArgv has room for right now
+  size_t myArgvCapacity;
+  // the argv we use until we need more than INLINE_ARGV_LEN
+  char *myInlineArgv[INLINE_ARGV_LEN];
+  // the block we're copying args into now
+  char *myBlock;
+  // how much of myBlock is used
+  size_t myBlockUsed;
+  // how big myBlock is
+  size_t myBlockLen;
+  // the blocks we allocated (so we can delete 'em)
+  std::list<char *> myAllocatedBlocks;
+  // the block we use first
+  char myInlineBlock[INLINE_BLOCK_LEN];
   // the extra string (utility thing)
   std::string myExtraString;
   // the full string
@@ -164,6 +201,10 @@ protected:
   char myExtraSpace;
 
   bool myIsQuiet;
+private:
+  /// Not implemented, myArgv can point into our own storage so the
+  /// default one would be wrong (use the copy constructor or swap())
+  ArArgumentBuilder &operator=(const ArArgumentBuilder &builder);
 };
 
 #endif // ARARGUMENTBUILDER_H
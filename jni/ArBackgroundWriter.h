@@ -0,0 +1,251 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#ifndef ARBACKGROUNDWRITER_H
+#define ARBACKGROUNDWRITER_H
+
+#include <list>
+#include "ariaTypedefs.h"
+#include "ArFunctor.h"
+#include "ArMutex.h"
+#include "ArCondition.h"
+#include "ArASyncTask.h"
+
+/// A thread that writes out the items another thread fills in
+/**
+   This is for logs that shouldn't format or write anything in the
+   robot's cycle (ArLaserLogger and ArDataLogger use it).  The thread
+   making the log gets an item with getFilling(), fills it in, then
+   hands it over with queueFilling().  This thread calls the write
+   functor for each item that has been queued, then the flush functor
+   once all of them are written, then puts the items back to be filled
+   again.  The items move between lists with splice, and all of them
+   are made in the constructor, so nothing is allocated while logging.
+   If this thread falls behind and every item is still waiting to be
+   written getFilling() returns NULL (and counts it, see getDropped())
+   instead of making another, unless it's told the item can't be
+   dropped.
+
+   Only one thread should fill items.  stop() (and the destructor) wait
+   for everything queued to be written, so they must not be called
+   while holding a lock the write or flush functors need (or one that
+   blocks the robot for that long, like the robot lock).
+**/
+template<class Item>
+class ArBackgroundWriter : public ArASyncTask
+{
+public:
+  /// Constructor, makes the items and starts the thread
+  ArBackgroundWriter(const char *name, ArFunctor1<Item *> *writeCB,
+		     ArFunctor *flushCB = NULL, size_t numItems = 16);
+  /// Destructor, stops the thread (after it writes what's queued)
+  virtual ~ArBackgroundWriter() { stop(); }
+  /// Gets the item being filled in, taking an unused one if there isn't one
+  Item *getFilling(bool *isNew = NULL, bool mustHave = false);
+  /// Gets how many items getFilling() couldn't give out
+  size_t getDropped(void) 
+    { size_t ret; myListsMutex.lock(); ret = myDropped; 
+      myListsMutex.unlock(); return ret; }
+  /// Hands the item being filled in (if there is one) over to be written
+  void queueFilling(void);
+  /// Stops the thread once it's written everything that was queued
+  void stop(void);
+  virtual void *runThread(void *arg);
+protected:
+  /// Waits (for a little while at most) for items to be queued
+  void waitForQueued(void);
+  /// Writes all the items that are queued
+  void writeQueued(void);
+
+  ArFunctor1<Item *> *myWriteCB;
+  ArFunctor *myFlushCB;
+  bool myStopped;
+  // how many items there should be, and how many there are (more
+  // only while ones made for mustHave are around)
+  size_t myNumItems;
+  size_t myItems;
+  size_t myDropped;
+  // the mutex is just for moving items between the lists
+  ArMutex myListsMutex;
+  std::list<Item> myFree;
+  std::list<Item> myFilling;
+  std::list<Item> myQueued;
+  std::list<Item> myWriting;
+  ArCondition myQueuedCond;
+};
+
+template<class Item>
+ArBackgroundWriter<Item>::ArBackgroundWriter(const char *name, 
+					     ArFunctor1<Item *> *writeCB,
+					     ArFunctor *flushCB,
+					     size_t numItems)
+{
+  setThreadName(name);
+  myListsMutex.setLogName("ArBackgroundWriter::myListsMutex");
+  myWriteCB = writeCB;
+  myFlushCB = flushCB;
+  myStopped = false;
+  if (numItems < 1)
+    numItems = 1;
+  myNumItems = numItems;
+  myItems = numItems;
+  myDropped = 0;
+  myFree.resize(numItems);
+  runAsync();
+}
+
+/**
+   @param isNew if not NULL this is set to whether the item was just
+   taken to be filled (in which case it has whatever was in it the
+   last time it was written, and needs to be reset)
+
+   @param mustHave if this is true and all of the items are waiting to
+   be written another one is made anyways (it's gotten rid of once it
+   has been written), this is for the few records a log can't do
+   without (like its header), not for the ones made every cycle
+
+   @return the item to fill, or NULL if all of the items are waiting
+   to be written (and mustHave is false)
+**/
+template<class Item>
+Item *ArBackgroundWriter<Item>::getFilling(bool *isNew, bool mustHave)
+{
+  Item *item;
+  bool taken = false;
+
+  myListsMutex.lock();
+  if (myFilling.empty())
+  {
+    if (myFree.empty() && !mustHave)
+    {
+      myDropped++;
+      myListsMutex.unlock();
+      if (isNew != NULL)
+	*isNew = false;
+      return NULL;
+    }
+    if (myFree.empty())
+    {
+      myFree.push_back(Item());
+      myItems++;
+    }
+    myFilling.splice(myFilling.end(), myFree, myFree.begin());
+    taken = true;
+  }
+  item = &myFilling.front();
+  myListsMutex.unlock();
+  if (isNew != NULL)
+    *isNew = taken;
+  return item;
+}
+
+template<class Item>
+void ArBackgroundWriter<Item>::queueFilling(void)
+{
+  myListsMutex.lock();
+  if (myFilling.empty())
+  {
+    myListsMutex.unlock();
+    return;
+  }
+  myQueued.splice(myQueued.end(), myFilling);
+  myListsMutex.unlock();
+  myQueuedCond.signal();
+}
+
+template<class Item>
+void ArBackgroundWriter<Item>::stop(void)
+{
+  if (myStopped)
+    return;
+  myStopped = true;
+  stopRunning();
+  myQueuedCond.signal();
+  join();
+}
+
+template<class Item>
+void *ArBackgroundWriter<Item>::runThread(void *arg)
+{
+  threadStarted();
+
+  while (getRunning())
+  {
+    waitForQueued();
+    writeQueued();
+  }
+  // write whatever came in while we were stopping
+  writeQueued();
+
+  threadFinished();
+  return NULL;
+}
+
+template<class Item>
+void ArBackgroundWriter<Item>::waitForQueued(void)
+{
+  bool haveQueued;
+
+  myListsMutex.lock();
+  haveQueued = !myQueued.empty();
+  myListsMutex.unlock();
+  // ArCondition can't check for items and wait in one step, so this
+  // is timed so that a missed wakeup only costs a little
+  if (!haveQueued)
+    myQueuedCond.timedWait(100);
+}
+
+/**
+   The items are moved over to myWriting so more can be queued while
+   we write, then they go back on the free list (less any extras made
+   for mustHave).
+**/
+template<class Item>
+void ArBackgroundWriter<Item>::writeQueued(void)
+{
+  typename std::list<Item>::iterator it;
+
+  myListsMutex.lock();
+  myWriting.splice(myWriting.end(), myQueued);
+  myListsMutex.unlock();
+
+  if (myWriting.empty())
+    return;
+
+  for (it = myWriting.begin(); it != myWriting.end(); it++)
+    myWriteCB->invoke(&(*it));
+  if (myFlushCB != NULL)
+    myFlushCB->invoke();
+
+  myListsMutex.lock();
+  myFree.splice(myFree.end(), myWriting);
+  while (myItems > myNumItems && !myFree.empty())
+  {
+    myFree.pop_back();
+    myItems--;
+  }
+  myListsMutex.unlock();
+}
+
+#endif // ARBACKGROUNDWRITER_H
@@ -27,6 +27,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 
 
 #include <string>
+#include <string.h>
 #include "ariaTypedefs.h"
 
 /// Base packet class
@@ -194,6 +195,151 @@ public:
   AREXPORT virtual bool setHeaderLength(ArTypes::UByte2 length);
   /// Makes this packet a duplicate of another packet
   AREXPORT virtual void duplicatePacket(ArBasePacket *packet);
+
+  /// Reserves room at the end of the packet to write straight into
+  /**
+     This checks once that there's room for length more bytes, adds
+     them to the packet, and returns where they start (or NULL, and
+     makes the packet invalid, if they don't fit).  The caller then
+     fills them in, usually with a Writer.
+  **/
+  char *reserveToBuf(ArTypes::UByte2 length)
+    {
+      char *ret;
+      if (myLength + length > myMaxLength)
+      {
+	myIsValid = false;
+	return NULL;
+      }
+      ret = myBuf + myLength;
+      myLength += length;
+      return ret;
+    }
+  /// Takes the next length bytes from where the packet is being read to read straight from
+  /**
+     This checks once that there are length more bytes to read, skips
+     the read position past them, and returns where they start (or
+     NULL, and makes the packet invalid, if there aren't enough).
+  **/
+  const char *reserveFromBuf(ArTypes::UByte2 length)
+    {
+      const char *ret;
+      if (myReadLength + length > myLength - myFooterLength)
+      {
+	myIsValid = false;
+	return NULL;
+      }
+      ret = myBuf + myReadLength;
+      myReadLength += length;
+      return ret;
+    }
+
+  /// Writes several values into a packet with only one check for room
+  /**
+     This reserves all the room it needs up front (see reserveToBuf)
+     and then writes each value with an inline copy, instead of the
+     virtual somethingToBuf calls that each check for room, so that
+     filling in big packets (like the points of a map) is a tight
+     loop.  It writes the same (little endian) bytes as ArBasePacket's
+     somethingToBuf functions on any host, so it must not be used on packets that encode
+     differently (like ArLMS1XXPacket, which uses ascii).  If the room
+     couldn't be reserved isValid() is false and nothing may be
+     written.
+
+     @code
+     ArBasePacket::Writer writer(&packet, 8 * points.size());
+     if (writer.isValid())
+       for (...)
+       {
+         writer.byte4ToBuf(x);
+         writer.byte4ToBuf(y);
+       }
+     @endcode
+  **/
+  class Writer
+  {
+  public:
+    /// Constructor, reserves length bytes at the end of the packet
+    Writer(ArBasePacket *packet, ArTypes::UByte2 length) 
+      { myPos = packet->reserveToBuf(length); }
+    /// Whether the room was reserved
+    bool isValid(void) const { return myPos != NULL; }
+    /// Puts ArTypes::Byte into the reserved room
+    void byteToBuf(ArTypes::Byte val) { *myPos++ = val; }
+    /// Puts ArTypes::Byte2 into the reserved room
+    void byte2ToBuf(ArTypes::Byte2 val) { uByte2ToBuf(val); }
+    /// Puts ArTypes::Byte4 into the reserved room
+    void byte4ToBuf(ArTypes::Byte4 val) { uByte4ToBuf(val); }
+    /// Puts ArTypes::UByte into the reserved room
+    void uByteToBuf(ArTypes::UByte val) { *myPos++ = val; }
+    /// Puts ArTypes::UByte2 into the reserved room
+    void uByte2ToBuf(ArTypes::UByte2 val) 
+      { 
+	myPos[0] = val & 0xff; 
+	myPos[1] = (val >> 8) & 0xff; 
+	myPos += 2; 
+      }
+    /// Puts ArTypes::UByte4 into the reserved room
+    void uByte4ToBuf(ArTypes::UByte4 val) 
+      { 
+	myPos[0] = val & 0xff; 
+	myPos[1] = (val >> 8) & 0xff; 
+	myPos[2] = (val >> 16) & 0xff; 
+	myPos[3] = (val >> 24) & 0xff; 
+	myPos += 4; 
+      }
+    /// Copies length bytes from data into the reserved room
+    void dataToBuf(const char *data, int length)
+      { memcpy(myPos, data, length); myPos += length; }
+  protected:
+    char *myPos;
+  };
+
+  /// Reads several values from a packet with only one check for length
+  /**
+     The reading version of Writer, this takes all the bytes it needs
+     up front (see reserveFromBuf) then reads each value with an
+     inline copy.  The same limits as Writer apply.  If there weren't
+     enough bytes isValid() is false and nothing may be read.
+  **/
+  class Reader
+  {
+  public:
+    /// Constructor, takes the next length bytes from the packet
+    Reader(ArBasePacket *packet, ArTypes::UByte2 length) 
+      { myPos = packet->reserveFromBuf(length); }
+    /// Whether there were enough bytes
+    bool isValid(void) const { return myPos != NULL; }
+    /// Gets a ArTypes::Byte
+    ArTypes::Byte bufToByte(void) { return *myPos++; }
+    /// Gets a ArTypes::Byte2
+    ArTypes::Byte2 bufToByte2(void) { return (ArTypes::Byte2)bufToUByte2(); }
+    /// Gets a ArTypes::Byte4
+    ArTypes::Byte4 bufToByte4(void) { return (ArTypes::Byte4)bufToUByte4(); }
+    /// Gets a ArTypes::UByte
+    ArTypes::UByte bufToUByte(void) { return *myPos++; }
+    /// Gets a ArTypes::UByte2
+    ArTypes::UByte2 bufToUByte2(void) 
+      { 
+	const unsigned char *pos = (const unsigned char *)myPos;
+	myPos += 2;
+	return pos[0] | (pos[1] << 8);
+      }
+    /// Gets a ArTypes::UByte4
+    ArTypes::UByte4 bufToUByte4(void) 
+      { 
+	const unsigned char *pos = (const unsigned char *)myPos;
+	myPos += 4;
+	return (pos[0] | (pos[1] << 8) | (pos[2] << 16) | 
+		((ArTypes::UByte4)pos[3] << 24));
+      }
+    /// Copies length bytes into data
+    void bufToData(char *data, int length)
+      { memcpy(data, myPos, length); myPos += length; }
+  protected:
+    const char *myPos;
+  };
+
 protected:
   // internal function to make sure we have enough length left to read in the packet
   AREXPORT bool isNextGood(int bytes);
@@ -0,0 +1,691 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "ArExport.h"
+#include "ariaOSDef.h"
+#include "ArBinaryLog.h"
+#include "ariaUtil.h"
+#include <stdarg.h>
+#include <ctype.h>
+#include <time.h>
+
+ArMutex ArBinaryLog::ourMutex;
+FILE *ArBinaryLog::ourFile = NULL;
+std::string ArBinaryLog::ourFileName;
+std::vector<ArBinaryLog::Message *> ArBinaryLog::ourMessages;
+char ArBinaryLog::ourBuf[ArBinaryLog::BUFFER_SIZE];
+int ArBinaryLog::ourBufUsed = 0;
+volatile ArTypes::UByte4 ArBinaryLog::ourLastFlush = 0;
+ArBinaryLog::Slot ArBinaryLog::ourRing[ArBinaryLog::RING_SIZE];
+volatile int ArBinaryLog::ourEnqueuePos = 0;
+volatile int ArBinaryLog::ourDequeuePos = 0;
+volatile bool ArBinaryLog::ourOpen = false;
+volatile int ArBinaryLog::ourInFlight = 0;
+
+/**
+   The file is made up of records that start with a byte saying what
+   they are.  'D' defines a message, a ubyte2 ID, a ubyte level, then
+   a ubyte2 length and the format.  'M' is a message being logged, a
+   ubyte2 ID, a ubyte4 time (seconds, like time()), then the
+   arguments, ints are 4 bytes, longs and pointers are two 4 byte
+   halves (low first), doubles are 8 bytes, and strings are a ubyte
+   length then the characters.  Everything is in the byte order of the
+   machine that wrote it (little endian for everything ARIA runs on).
+
+   @param fileName the file to log to (it is truncated)
+**/
+AREXPORT bool ArBinaryLog::open(const char *fileName)
+{
+  ArTypes::UByte4 version = VERSION;
+  int i;
+
+  close();
+  ourMutex.lock();
+  if ((ourFile = ArUtil::fopen(fileName, "wb")) == NULL)
+  {
+    ourMutex.unlock();
+    ArLog::log(ArLog::Terse, "ArBinaryLog: Could not open %s", fileName);
+    return false;
+  }
+  ourFileName = fileName;
+  fwrite(getMagic(), 1, strlen(getMagic()), ourFile);
+  fwrite(&version, 1, 4, ourFile);
+  ourBufUsed = 0;
+  ourLastFlush = cheapNow();
+  for (i = 0; i < RING_SIZE; i++)
+    ourRing[i].mySeq = i;
+  ourEnqueuePos = 0;
+  ourDequeuePos = 0;
+  ArUtil::memoryBarrier();
+  ourOpen = true;
+  ourMutex.unlock();
+  ArLog::log(ArLog::Normal, "ArBinaryLog: Logging to %s", fileName);
+  return true;
+}
+
+AREXPORT void ArBinaryLog::close(void)
+{
+  std::vector<Message *>::iterator it;
+
+  ourMutex.lock();
+  if (ourFile == NULL)
+  {
+    ourMutex.unlock();
+    return;
+  }
+  ourOpen = false;
+  ArUtil::memoryBarrier();
+  // wait for anyone still putting records in the ring, and keep
+  // draining it since they could be waiting for room
+  while (ourInFlight > 0)
+  {
+    if (!drainNoLock())
+      ArUtil::sleep(1);
+  }
+  flushNoLock();
+  fclose(ourFile);
+  ourFile = NULL;
+  // the next file needs the formats again
+  for (it = ourMessages.begin(); it != ourMessages.end(); it++)
+    (*it)->myID = -1;
+  ourMessages.clear();
+  ourMutex.unlock();
+}
+
+AREXPORT bool ArBinaryLog::isOpen(void)
+{
+  return ourFile != NULL;
+}
+
+AREXPORT void ArBinaryLog::flush(void)
+{
+  ourMutex.lock();
+  flushNoLock();
+  ourMutex.unlock();
+}
+
+/**
+   @return true if any records were moved, false if there weren't any
+   ready
+**/
+bool ArBinaryLog::drainNoLock(void)
+{
+  Slot *slot;
+  int ready;
+  int i;
+
+  // see how many are ready, then copy them all and free them all, so
+  // it's only two barriers however many there are
+  for (ready = 0; ready < RING_SIZE; ready++)
+  {
+    slot = &ourRing[(ourDequeuePos + ready) & (RING_SIZE - 1)];
+    if (slot->mySeq != ourDequeuePos + ready + 1)
+      break;
+  }
+  if (ready == 0)
+    return false;
+  ArUtil::memoryBarrier();
+  for (i = 0; i < ready; i++)
+  {
+    slot = &ourRing[(ourDequeuePos + i) & (RING_SIZE - 1)];
+    if (ourBufUsed + slot->myLength > BUFFER_SIZE)
+    {
+      if (ourFile != NULL)
+	fwrite(ourBuf, 1, ourBufUsed, ourFile);
+      ourBufUsed = 0;
+    }
+    memcpy(ourBuf + ourBufUsed, slot->myData, slot->myLength);
+    ourBufUsed += slot->myLength;
+  }
+  ArUtil::memoryBarrier();
+  // free them for the next time around the ring
+  for (i = 0; i < ready; i++)
+    ourRing[(ourDequeuePos + i) & (RING_SIZE - 1)].mySeq = 
+      ourDequeuePos + i + RING_SIZE;
+  ourDequeuePos += ready;
+  return true;
+}
+
+void ArBinaryLog::flushNoLock(void)
+{
+  drainNoLock();
+  if (ourFile != NULL && ourBufUsed > 0)
+  {
+    fwrite(ourBuf, 1, ourBufUsed, ourFile);
+    fflush(ourFile);
+  }
+  ourBufUsed = 0;
+  ourLastFlush = cheapNow();
+}
+
+/**
+   This is only kept to the second, so it uses the coarse clock where
+   there is one, which is just a read of what the kernel already has
+   (the normal clock can mean a system call on some platforms).
+**/
+ArTypes::UByte4 ArBinaryLog::cheapNow(void)
+{
+#if !defined(WIN32) && defined(CLOCK_REALTIME_COARSE)
+  struct timespec now;
+  if (clock_gettime(CLOCK_REALTIME_COARSE, &now) == 0)
+    return now.tv_sec;
+#endif
+  return time(NULL);
+}
+
+/**
+   @param str where to start looking
+   @param end set to just past the conversion
+   @param type set to 'i' for int, 'l' for long, 'd' for double, 's'
+   for string, 'p' for pointer, '%' for %%, or 0 if the conversion
+   isn't one that can be logged in binary
+   @return where the conversion starts, or NULL if there aren't any more
+**/
+const char *ArBinaryLog::nextConversion(const char *str, const char **end,
+					char *type)
+{
+  const char *start;
+  bool isLong = false;
+  bool isLongLong = false;
+
+  if ((start = strchr(str, '%')) == NULL)
+    return NULL;
+  str = start + 1;
+  *type = 0;
+  if (*str == '%')
+  {
+    *type = '%';
+    *end = str + 1;
+    return start;
+  }
+  while (*str != '\0' && strchr("-+ #0", *str) != NULL)
+    str++;
+  while (isdigit(*str))
+    str++;
+  if (*str == '.')
+  {
+    str++;
+    while (isdigit(*str))
+      str++;
+  }
+  if (*str == 'h')
+  {
+    str++;
+    if (*str == 'h')
+      str++;
+  }
+  else if (*str == 'l')
+  {
+    isLong = true;
+    str++;
+    // long long isn't supported
+    if (*str == 'l')
+      isLongLong = true;
+  }
+  *end = str + (*str != '\0' ? 1 : 0);
+  if (isLongLong)
+    return start;
+  switch (*str)
+  {
+  case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+    *type = isLong ? 'l' : 'i';
+    break;
+  case 'c':
+    if (!isLong)
+      *type = 'i';
+    break;
+  case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': 
+  case 'a': case 'A':
+    *type = 'd';
+    break;
+  case 's':
+    if (!isLong)
+      *type = 's';
+    break;
+  case 'p':
+    *type = 'p';
+    break;
+  }
+  return start;
+}
+
+bool ArBinaryLog::parseFormat(const char *format, std::string *types)
+{
+  const char *end;
+  char type;
+
+  types->clear();
+  while ((format = nextConversion(format, &end, &type)) != NULL)
+  {
+    if (type == 0)
+      return false;
+    if (type != '%')
+      *types += type;
+    format = end;
+  }
+  return true;
+}
+
+void ArBinaryLog::registerMessage(Message *message)
+{
+  std::string types;
+  std::string::const_iterator it;
+  ArTypes::UByte2 id;
+  ArTypes::UByte2 len;
+  int maxLength;
+
+  if (!parseFormat(message->myFormat, &types))
+  {
+    message->myID = NOT_BINARY;
+    return;
+  }
+  // the 'M', the ID and the time, then the arguments
+  maxLength = 7;
+  for (it = types.begin(); it != types.end(); it++)
+  {
+    if (*it == 'i')
+      maxLength += 4;
+    else if (*it == 's')
+      maxLength += MAX_STRING + 1;
+    else
+      maxLength += 8;
+  }
+  len = strlen(message->myFormat);
+  if (ourBufUsed + 6 + len > BUFFER_SIZE)
+    flushNoLock();
+  if (ourBufUsed + 6 + len > BUFFER_SIZE)
+  {
+    message->myID = NOT_BINARY;
+    return;
+  }
+  id = ourMessages.size();
+  ourMessages.push_back(message);
+  message->myTypes = types;
+  message->myMaxLength = maxLength;
+
+  char *pos = ourBuf + ourBufUsed;
+  *pos++ = 'D';
+  memcpy(pos, &id, 2);
+  pos += 2;
+  *pos++ = message->myLevel;
+  memcpy(pos, &len, 2);
+  pos += 2;
+  memcpy(pos, message->myFormat, len);
+  pos += len;
+  ourBufUsed = pos - ourBuf;
+  // log reads the types without the lock once it sees the ID
+  ArUtil::memoryBarrier();
+  message->myID = id;
+}
+
+char *ArBinaryLog::encode(char *pos, Message *message, ArTypes::UByte4 now,
+			  va_list ptr)
+{
+  std::string::const_iterator it;
+  ArTypes::UByte2 id;
+  ArTypes::Byte4 intVal;
+  ArTypes::UByte4 halves[2];
+  unsigned long longVal;
+  double doubleVal;
+  const char *strVal;
+  size_t len;
+
+  id = message->myID;
+  *pos++ = 'M';
+  memcpy(pos, &id, 2);
+  pos += 2;
+  memcpy(pos, &now, 4);
+  pos += 4;
+  for (it = message->myTypes.begin(); it != message->myTypes.end(); it++)
+  {
+    switch (*it)
+    {
+    case 'i':
+      intVal = va_arg(ptr, int);
+      memcpy(pos, &intVal, 4);
+      pos += 4;
+      break;
+    case 'l':
+    case 'p':
+      if (*it == 'l')
+	longVal = va_arg(ptr, unsigned long);
+      else
+	longVal = (unsigned long) va_arg(ptr, void *);
+      halves[0] = longVal & 0xffffffff;
+      // shifted in two steps since longs may only be 32 bits
+      halves[1] = ((longVal >> 16) >> 16) & 0xffffffff;
+      memcpy(pos, halves, 8);
+      pos += 8;
+      break;
+    case 'd':
+      doubleVal = va_arg(ptr, double);
+      memcpy(pos, &doubleVal, 8);
+      pos += 8;
+      break;
+    case 's':
+      if ((strVal = va_arg(ptr, const char *)) == NULL)
+	strVal = "(null)";
+      if ((len = strlen(strVal)) > MAX_STRING)
+	len = MAX_STRING;
+      *pos++ = (char) len;
+      memcpy(pos, strVal, len);
+      pos += len;
+      break;
+    }
+  }
+  return pos;
+}
+
+/**
+   This only copies the arguments into the ring (see the class
+   description), unless there's no binary log open, then it just goes
+   to ArLog.  The lock is only taken the first time a message is
+   logged to a file, for messages too big for the ring, and (with
+   tryLock, so nobody waits on it) to move the ring into the buffer.
+**/
+AREXPORT void ArBinaryLog::log(Message *message, ...)
+{
+  va_list ptr;
+  ArTypes::UByte4 now;
+  Slot *slot;
+  int pos;
+  int dif;
+
+  if (message->myLevel > ArLog::getLogLevel())
+    return;
+
+  va_start(ptr, message);
+  if (!ourOpen || message->myID == NOT_BINARY)
+  {
+    ArLog::vlog(message->myLevel, message->myFormat, ptr);
+    va_end(ptr);
+    return;
+  }
+
+  if (message->myID == -1)
+  {
+    ourMutex.lock();
+    if (ourFile != NULL && message->myID == -1)
+      registerMessage(message);
+    ourMutex.unlock();
+  }
+
+  now = cheapNow();
+  // too big for a slot, so it goes right into the buffer
+  if (message->myMaxLength > SLOT_SIZE)
+  {
+    ourMutex.lock();
+    if (ourFile == NULL || message->myID < 0)
+    {
+      ourMutex.unlock();
+      ArLog::vlog(message->myLevel, message->myFormat, ptr);
+      va_end(ptr);
+      return;
+    }
+    // so it lands after what's already in the ring
+    drainNoLock();
+    if (ourBufUsed + message->myMaxLength > BUFFER_SIZE || 
+	now != ourLastFlush)
+      flushNoLock();
+    ourBufUsed = encode(ourBuf + ourBufUsed, message, now, ptr) - ourBuf;
+    ourMutex.unlock();
+    va_end(ptr);
+    return;
+  }
+
+  // close waits for this to be 0 before it gets rid of the ring
+  ArUtil::atomicAdd(&ourInFlight, 1);
+  if (!ourOpen || message->myID < 0)
+  {
+    ArUtil::atomicAdd(&ourInFlight, -1);
+    ArLog::vlog(message->myLevel, message->myFormat, ptr);
+    va_end(ptr);
+    return;
+  }
+
+  pos = ourEnqueuePos;
+  while (1)
+  {
+    slot = &ourRing[pos & (RING_SIZE - 1)];
+    dif = (int) ((unsigned int) slot->mySeq - (unsigned int) pos);
+    // it's free, try to take it
+    if (dif == 0)
+    {
+      if (ArUtil::atomicCompareAndSwap(&ourEnqueuePos, pos, pos + 1))
+	break;
+    }
+    // it hasn't been moved out yet, so we're full, move the ring out
+    // unless someone else is (they'll make room)
+    else if (dif < 0)
+    {
+      if (ourMutex.tryLock() == 0)
+      {
+	if (!drainNoLock())
+	  ArUtil::sleep(1);
+	ourMutex.unlock();
+      }
+      else
+	ArUtil::sleep(1);
+    }
+    // otherwise someone else took it first
+    pos = ourEnqueuePos;
+  }
+
+  slot->myLength = encode(slot->myData, message, now, ptr) - slot->myData;
+  ArUtil::memoryBarrier();
+  slot->mySeq = pos + 1;
+  va_end(ptr);
+
+  // about once a second, or if the ring's getting full, move it into
+  // the buffer, unless someone else already is
+  if ((now != ourLastFlush || pos + 1 - ourDequeuePos > RING_SIZE / 2) &&
+      ourMutex.tryLock() == 0)
+  {
+    if (now != ourLastFlush)
+      flushNoLock();
+    else
+      drainNoLock();
+    ourMutex.unlock();
+  }
+  ArUtil::atomicAdd(&ourInFlight, -1);
+}
+
+/**
+   This writes each message as a line in the same format ArLog would
+   have, with the time in front if logTime is true.
+
+   @param fileName the binary log to decode
+   @param out where to write the text (like stdout, or a file)
+   @param logTime whether to put the time at the start of each line
+   @return true if the whole file was decoded, false if it couldn't be
+   read or ended early (whatever could be decoded is still written)
+**/
+AREXPORT bool ArBinaryLog::decode(const char *fileName, FILE *out, 
+				  bool logTime)
+{
+  FILE *file;
+  std::vector<std::string> formats;
+  std::vector<std::string> types;
+  std::string line;
+  char buf[1024];
+  char spec[64];
+  char str[MAX_STRING + 1];
+  ArTypes::UByte4 version;
+  ArTypes::UByte2 id;
+  ArTypes::UByte2 len;
+  ArTypes::UByte4 when;
+  ArTypes::Byte4 intVal;
+  ArTypes::UByte4 halves[2];
+  unsigned long longVal;
+  double doubleVal;
+  unsigned char strLen;
+  const char *format;
+  const char *start;
+  const char *end;
+  char type;
+  int record;
+  int level;
+  int c;
+  time_t whenTime;
+  bool ok = true;
+
+  if ((file = ArUtil::fopen(fileName, "rb")) == NULL)
+  {
+    ArLog::log(ArLog::Terse, "ArBinaryLog::decode: Could not open %s", 
+	       fileName);
+    return false;
+  }
+  if (fread(buf, 1, strlen(getMagic()), file) != strlen(getMagic()) ||
+      strncmp(buf, getMagic(), strlen(getMagic())) != 0 ||
+      fread(&version, 1, 4, file) != 4 || version != VERSION)
+  {
+    ArLog::log(ArLog::Terse, 
+	       "ArBinaryLog::decode: %s is not a binary log this can read", 
+	       fileName);
+    fclose(file);
+    return false;
+  }
+
+  while (ok && (record = fgetc(file)) != EOF)
+  {
+    if (fread(&id, 1, 2, file) != 2)
+    {
+      ok = false;
+      break;
+    }
+    if (record == 'D')
+    {
+      if ((level = fgetc(file)) == EOF || fread(&len, 1, 2, file) != 2)
+      {
+	ok = false;
+	break;
+      }
+      std::string newFormat(len, '\0');
+      if (len > 0 && fread(&newFormat[0], 1, len, file) != len)
+      {
+	ok = false;
+	break;
+      }
+      if (formats.size() <= id)
+      {
+	formats.resize(id + 1);
+	types.resize(id + 1);
+      }
+      formats[id] = newFormat;
+      parseFormat(newFormat.c_str(), &types[id]);
+      continue;
+    }
+    if (record != 'M' || id >= formats.size() || 
+	fread(&when, 1, 4, file) != 4)
+    {
+      ok = false;
+      break;
+    }
+
+    line = "";
+    if (logTime)
+    {
+      // same as ArLog does it
+      whenTime = when;
+      line.append(ctime(&whenTime), 20);
+    }
+    format = formats[id].c_str();
+    while ((start = nextConversion(format, &end, &type)) != NULL)
+    {
+      line.append(format, start - format);
+      format = end;
+      if (type == '%')
+      {
+	line += '%';
+	continue;
+      }
+      if ((size_t) (end - start) >= sizeof(spec))
+      {
+	ok = false;
+	break;
+      }
+      strncpy(spec, start, end - start);
+      spec[end - start] = '\0';
+      buf[0] = '\0';
+      if (type == 'i')
+      {
+	if (fread(&intVal, 1, 4, file) != 4)
+	  ok = false;
+	else
+	  snprintf(buf, sizeof(buf), spec, (int) intVal);
+      }
+      else if (type == 'l' || type == 'p')
+      {
+	if (fread(halves, 1, 8, file) != 8)
+	  ok = false;
+	else
+	{
+	  longVal = ((((unsigned long) halves[1]) << 16) << 16) | halves[0];
+	  if (type == 'l')
+	    snprintf(buf, sizeof(buf), spec, longVal);
+	  else
+	    snprintf(buf, sizeof(buf), spec, (void *) longVal);
+	}
+      }
+      else if (type == 'd')
+      {
+	if (fread(&doubleVal, 1, 8, file) != 8)
+	  ok = false;
+	else
+	  snprintf(buf, sizeof(buf), spec, doubleVal);
+      }
+      else if (type == 's')
+      {
+	if ((c = fgetc(file)) == EOF)
+	  ok = false;
+	else 
+	{
+	  strLen = c;
+	  if (fread(str, 1, strLen, file) != strLen)
+	    ok = false;
+	  else
+	  {
+	    str[strLen] = '\0';
+	    snprintf(buf, sizeof(buf), spec, str);
+	  }
+	}
+      }
+      if (!ok)
+	break;
+      buf[sizeof(buf) - 1] = '\0';
+      line += buf;
+    }
+    if (!ok)
+      break;
+    line += format;
+    fprintf(out, "%s\n", line.c_str());
+  }
+
+  fclose(file);
+  if (!ok)
+    ArLog::log(ArLog::Terse, 
+	       "ArBinaryLog::decode: %s ended in the middle of a record", 
+	       fileName);
+  return ok;
+}
@@ -0,0 +1,169 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#ifndef ARBINARYLOG_H
+#define ARBINARYLOG_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string>
+#include <vector>
+#include "ariaTypedefs.h"
+#include "ArLog.h"
+#include "ArMutex.h"
+
+/// Logs frequent messages in binary, to be turned into text later
+/**
+   Formatting a line of text for every call gets expensive for the
+   messages that are logged very often (like tracking every packet the
+   robot gets).  With this, each of those messages is an
+   ArBinaryLog::Message that is made once with its level and printf
+   style format.  Logging one (with ArBinaryLog::log) only copies an ID,
+   the time (from a coarse clock, it's only kept to the second), and
+   the raw arguments into the next slot of a lock free ring, the
+   format is written to the file once, the first time that message is
+   logged.  Whichever thread logs when the second changes or the ring
+   gets half full moves the ring into the file's buffer (if nobody
+   else is already), the buffer is written to the file when it fills,
+   about every second, and on flush() or close().  Messages that could
+   be too big for a slot (more than one string, usually) are copied
+   into the buffer under the lock instead.
+
+   decode() turns a binary log back into the same text ArLog would
+   have written, the arBinaryLogDecode utility does that from the
+   command line.
+
+   If no binary log is open (or the format uses something that can't
+   be logged in binary, like a * width or %n) messages just go to
+   ArLog::log, so code can always log this way.  Either way, messages
+   above ArLog's level aren't logged.
+
+   The formats can use %d, %i, %u, %x, %X, %o and %c (with h or l),
+   %f, %e, %g and %a (and their capitals), %s and %p, with any flags,
+   widths or precisions written in the format.  Strings are cut off at
+   255 characters.
+
+   @code
+   static ArBinaryLog::Message ourSentMsg(ArLog::Normal, "Sent: com(%d)");
+   ...
+   ArBinaryLog::log(&ourSentMsg, command);
+   @endcode
+**/
+class ArBinaryLog
+{
+public:
+  /// A message that can be logged in binary
+  class Message
+  {
+  public:
+    /// Constructor (format must stay around, it isn't copied)
+    Message(ArLog::LogLevel level, const char *format) : 
+      myLevel(level), myFormat(format), myID(-1), myMaxLength(0) {}
+    /// Gets the level the message is logged at
+    ArLog::LogLevel getLevel(void) const { return myLevel; }
+    /// Gets the format of the message
+    const char *getFormat(void) const { return myFormat; }
+  protected:
+    friend class ArBinaryLog;
+    ArLog::LogLevel myLevel;
+    const char *myFormat;
+    // -1 if not registered yet, NOT_BINARY if it can't be binary
+    volatile int myID;
+    // the types of the arguments and the longest the record could be,
+    // set before myID so log can use them without the lock
+    std::string myTypes;
+    int myMaxLength;
+  };
+
+#ifndef SWIG
+  /// Logs a message with its arguments
+  AREXPORT static void log(Message *message, ...);
+#endif
+  /// Opens a file to log binary messages to
+  AREXPORT static bool open(const char *fileName);
+  /// Closes the binary log file
+  AREXPORT static void close(void);
+  /// Gets whether a binary log file is open
+  AREXPORT static bool isOpen(void);
+  /// Writes what's been logged out to the file
+  AREXPORT static void flush(void);
+  /// Turns a binary log file into text
+  AREXPORT static bool decode(const char *fileName, FILE *out, 
+			      bool logTime = true);
+
+  /// The version of the file format this writes
+  enum { VERSION = 1 };
+  /// The magic at the start of the file
+  static const char *getMagic(void) { return "ARIABLOG"; }
+protected:
+  enum { 
+    NOT_BINARY = -2, 
+    BUFFER_SIZE = 65536, 
+    MAX_STRING = 255,
+    RING_SIZE = 512, ///< must be a power of two
+    SLOT_SIZE = 512
+  };
+  // a record in the ring, mySeq says whether it is free for the next
+  // logger to fill or ready to be moved into the buffer (the same way
+  // ArLog's async lines work)
+  struct Slot
+  {
+    volatile int mySeq;
+    int myLength;
+    char myData[SLOT_SIZE];
+  };
+  /// Gives the message an ID and writes its format out
+  static void registerMessage(Message *message);
+  /// Finds the next conversion in str and what type of argument it takes
+  static const char *nextConversion(const char *str, const char **end, 
+				    char *type);
+  /// Gets the types of the arguments for a format, false if not all are supported
+  static bool parseFormat(const char *format, std::string *types);
+  /// Puts a message's record at pos, returns where the record ends
+  static char *encode(char *pos, Message *message, ArTypes::UByte4 now,
+		      va_list ptr);
+  /// Gets the time for a record, from the cheapest clock there is
+  static ArTypes::UByte4 cheapNow(void);
+  /// Moves the ready records from the ring into the buffer (ourMutex must be locked)
+  static bool drainNoLock(void);
+  /// Writes the buffer out (ourMutex must be locked)
+  static void flushNoLock(void);
+
+  static ArMutex ourMutex;
+  static FILE *ourFile;
+  static std::string ourFileName;
+  static std::vector<Message *> ourMessages;
+  static char ourBuf[BUFFER_SIZE];
+  static int ourBufUsed;
+  static volatile ArTypes::UByte4 ourLastFlush;
+  static Slot ourRing[RING_SIZE];
+  static volatile int ourEnqueuePos;
+  static volatile int ourDequeuePos;
+  // set while the file is open, close waits for ourInFlight to be 0
+  // after clearing it before it touches the ring
+  static volatile bool ourOpen;
+  static volatile int ourInFlight;
+};
+
+#endif // ARBINARYLOG_H
@@ -79,15 +79,7 @@ AREXPORT ArCentralForwarder::~ArCentralForwarder()
     delete mySocket;
   }
 
-  if (myRequestOnces.begin() != myRequestOnces.end())
-    ArUtil::deleteSetPairs(myRequestOnces.begin(), myRequestOnces.end());
-  myRequestOnces.clear();
-  if (myLastRequest.begin() != myLastRequest.end())
-    ArUtil::deleteSetPairs(myLastRequest.begin(), myLastRequest.end());
-  myLastRequest.clear();
-  if (myLastBroadcast.begin() != myLastBroadcast.end())
-    ArUtil::deleteSetPairs(myLastBroadcast.begin(), myLastBroadcast.end());
-  myLastBroadcast.clear();
+  myCommands.clear();
 }
 
 AREXPORT bool ArCentralForwarder::callOnce(
@@ -247,6 +239,7 @@ AREXPORT bool ArCentralForwarder::gatheringCallOnce(
 
   std::map<unsigned int, ArClientData *>::const_iterator dIt;
   ArClientData *clientData;
+  ReturnType returnType;
 
   myServer->addClientRemovedCallback(&myRobotServerClientRemovedCB);
 
@@ -286,37 +279,29 @@ AREXPORT bool ArCentralForwarder::gatheringCallOnce(
     }
     else if (clientData->hasDataFlag("RETURN_NONE"))
     {
-      myReturnTypes[clientData->getCommand()] = RETURN_NONE;
+      returnType = RETURN_NONE;
     }
     else if (clientData->hasDataFlag("RETURN_SINGLE"))
     {
-      myReturnTypes[clientData->getCommand()] = RETURN_SINGLE;
-      myRequestOnces[clientData->getCommand()] = 
-                    new std::list<ArServerClient *>;
+      returnType = RETURN_SINGLE;
     }
     else if (clientData->hasDataFlag("RETURN_VIDEO"))
     {
       ArLog::log(ArLog::Normal, 
 		 "%sForwarding %s that is RETURN_VIDEO",
 		 myPrefix.c_str(), clientData->getName());
-      myReturnTypes[clientData->getCommand()] = RETURN_VIDEO;
-      myRequestOnces[clientData->getCommand()] = 
-                    new std::list<ArServerClient *>;
+      returnType = RETURN_VIDEO;
     }
     else if (clientData->hasDataFlag("RETURN_VIDEO_OPTIM"))
     {
       ArLog::log(ArLog::Normal, 
 		 "%sForwarding %s that is RETURN_VIDEO_OPTIM",
 		 myPrefix.c_str(), clientData->getName());
-      myReturnTypes[clientData->getCommand()] = RETURN_VIDEO_OPTIM;
-      myRequestOnces[clientData->getCommand()] = 
-                    new std::list<ArServerClient *>;
+      returnType = RETURN_VIDEO_OPTIM;
     }
     else if (clientData->hasDataFlag("RETURN_UNTIL_EMPTY"))
     {
-      myReturnTypes[clientData->getCommand()] = RETURN_UNTIL_EMPTY;
-      myRequestOnces[clientData->getCommand()] = 
-                    new std::list<ArServerClient *>;
+      returnType = RETURN_UNTIL_EMPTY;
 
     }
     else if (clientData->hasDataFlag("RETURN_COMPLEX"))
@@ -335,8 +320,12 @@ AREXPORT bool ArCentralForwarder::gatheringCallOnce(
       continue;
     }
 
-    myLastRequest[clientData->getCommand()] = new ArTime;
-    myLastBroadcast[clientData->getCommand()] = new ArTime;
+    if (clientData->getCommand() >= myCommands.size())
+      myCommands.resize(clientData->getCommand() + 1);
+    myCommands[clientData->getCommand()].myForwarded = true;
+    myCommands[clientData->getCommand()].myReturnType = returnType;
+    myCommands[clientData->getCommand()].myServerCommand = 
+                                                clientData->getCommand();
 
     myServer->addDataAdvanced(
 	    clientData->getName(), clientData->getDescription(),
@@ -415,42 +404,22 @@ AREXPORT bool ArCentralForwarder::connectedCallOnce(
 
 void ArCentralForwarder::robotServerClientRemoved(ArServerClient *client)
 {
-  std::map<unsigned int, std::list<ArServerClient *> *>::iterator rIt;
+  std::vector<CommandInfo>::iterator cIt;
   std::list<ArServerClient *> *requestList = NULL;
   std::list<ArServerClient *>::iterator scIt;
 
   printf("Client disconnected\n");
-  for (rIt = myRequestOnces.begin(); rIt != myRequestOnces.end(); rIt++)
+  for (cIt = myCommands.begin(); cIt != myCommands.end(); cIt++)
   {
-    requestList = (*rIt).second;
-    // while we have entries for this client we loop and replace them
-    // with NULLs
-    bool foundOne = true;
-    while (foundOne)
+    requestList = &(*cIt).myRequestOnces;
+    // replace this client's entries with NULLs, so that the
+    // responses already on their way for it get thrown away
+    for (scIt = requestList->begin(); scIt != requestList->end(); scIt++)
     {
-      foundOne = false;
-      // see if we found one
-      for (scIt = requestList->begin(); 
-	   !foundOne && scIt != requestList->end(); 
-	   scIt++)
+      if ((*scIt) == client)
       {
-	if ((*scIt) == client)
-	{
-	  foundOne = true;
-	  printf("Got...\n");
-	  requestList->insert(scIt, NULL);	  
-	  for (scIt = requestList->begin(); 
-	       scIt != requestList->end(); 
-	       scIt++)
-	  {
-	    if ((*scIt) == client)
-	    {
-	      requestList->erase(scIt);
-	      printf("Removed request for client %p\n", client);
-	      break;
-	    }
-	  }
-	}
+	(*scIt) = NULL;
+	printf("Removed request for client %p\n", client);
       }
     }
   }
@@ -464,203 +433,180 @@ void ArCentralForwarder::clientServerClientRemoved(ArServerClient *client)
 
 
 
+/**
+   Makes the shared copy of the packet the first time one is needed,
+   so that all the tcp clients for this packet get the same bytes
+   without each one copying and checksumming it again.
+**/
+ArNetSharedPacket *ArCentralForwarder::getSharedPacket(
+	ArNetPacket *packet, ArNetSharedPacket **shared)
+{
+  CommandInfo *info;
+
+  if (*shared == NULL)
+  {
+    info = getCommandInfo(packet->getCommand());
+    if (info != NULL)
+      *shared = new ArNetSharedPacket(packet, info->myServerCommand);
+    else
+      *shared = new ArNetSharedPacket(packet);
+  }
+  return *shared;
+}
+
+void ArCentralForwarder::forwardToClient(ArServerClient *client,
+					 ArNetPacket *packet,
+					 ArNetSharedPacket **shared)
+{
+  if (packet->getPacketSource() == ArNetPacket::TCP)
+    client->sendSharedPacketTcp(getSharedPacket(packet, shared));
+  else if (packet->getPacketSource() == ArNetPacket::UDP)
+    client->sendPacketUdp(packet);
+  else
+  {
+    client->sendSharedPacketTcp(getSharedPacket(packet, shared));
+    ArLog::log(ArLog::Normal,
+	       "%sDon't know what type of packet %s is (%d)",
+	       myPrefix.c_str(),
+	       myClient->getName(packet->getCommand(), true),
+	       packet->getPacketSource());
+  }
+}
+
+void ArCentralForwarder::forwardBroadcast(ArNetPacket *packet,
+					  ArNetSharedPacket **shared)
+{
+  ArNetSharedPacket *sharedPacket;
+
+  if (packet->getPacketSource() == ArNetPacket::UDP)
+  {
+    myServer->broadcastPacketUdpByCommand(packet, packet->getCommand());
+    return;
+  }
+
+  if (packet->getPacketSource() != ArNetPacket::TCP)
+    ArLog::log(ArLog::Normal,
+	       "%sDon't know what type of packet %s is (%d)",
+	       myPrefix.c_str(),
+	       myClient->getName(packet->getCommand(), true),
+	       packet->getPacketSource());
+  sharedPacket = getSharedPacket(packet, shared);
+  myServer->broadcastSharedPacketTcpByCommand(sharedPacket,
+					      sharedPacket->getCommand());
+}
+
 void ArCentralForwarder::receiveData(ArNetPacket *packet)
 {
-  ReturnType returnType;
-  std::list<ArServerClient *>::iterator it;
+  CommandInfo *info;
+  std::list<ArServerClient *> *requestOnces;
   ArServerClient *client;
+  // this is only made if a tcp client needs it, then every client
+  // shares it, we release our reference to it at the end
+  ArNetSharedPacket *shared = NULL;
 
-  // chop off the old footer
-  //packet->setLength(packet->getLength() - ArNetPacket::FOOTER_LENGTH);
+  // the footer came in with the packet, so keep it
   packet->setAddedFooter(true);
 
-  /*
-  if (strcmp(myClient->getName(packet->getCommand(), true), 
-	     "getPictureCam1") == 0)
-    printf("Got getPictureCam1...\n");
-  */
-  returnType = myReturnTypes[packet->getCommand()];
+  if ((info = getCommandInfo(packet->getCommand())) == NULL)
+  {
+    ArLog::log(ArLog::Verbose, "%sGot packet for command %d we don't forward",
+	       myPrefix.c_str(), packet->getCommand());
+    return;
+  }
+  requestOnces = &info->myRequestOnces;
   //printf("Got a packet in for %s %d\n", myClient->getName(packet->getCommand(), true), packet->getCommand());
 
   // this part is seeing if it came from a request_once, if so we
   // don't service anything else (so we take care of those things that
   // only happen once better then the ones that are mixing... but that
   // should be okay)
-  if ((returnType == RETURN_SINGLE || returnType == RETURN_UNTIL_EMPTY) &&
-      (it = myRequestOnces[packet->getCommand()]->begin()) != 
-      myRequestOnces[packet->getCommand()]->end())
+  if ((info->myReturnType == RETURN_SINGLE ||
+       info->myReturnType == RETURN_UNTIL_EMPTY) &&
+      !requestOnces->empty())
   {
-    //if (returnType == RETURN_UNTIL_EMPTY)
-    //printf("Got a packet for %s with length %d %d\n", myClient->getName(packet->getCommand(), true), packet->getDataLength(), packet->getLength());
-
-    client = (*it);
+    client = requestOnces->front();
     if (client != NULL)
-    {
-      if (packet->getPacketSource() == ArNetPacket::TCP)
-	client->sendPacketTcp(packet);
-      else if (packet->getPacketSource() == ArNetPacket::UDP)
-	client->sendPacketUdp(packet);
-      else
-      {
-	client->sendPacketTcp(packet);
-	ArLog::log(ArLog::Normal, 
-		   "%sDon't know what type of packet %s is (%d)", 
-		   myPrefix.c_str(), 
-		   myClient->getName(packet->getCommand(), true), 
-		   packet->getPacketSource());
-      }
-    }
-    if ((returnType == RETURN_UNTIL_EMPTY && packet->getDataLength() == 0) || 
-	returnType == RETURN_SINGLE)
-    {
-      //if (returnType == RETURN_UNTIL_EMPTY)
-      //printf("Got final packet for for %s\n", myClient->getName(packet->getCommand(), true));
-      myRequestOnces[packet->getCommand()]->pop_front();
-    }
+      forwardToClient(client, packet, &shared);
+    if ((info->myReturnType == RETURN_UNTIL_EMPTY &&
+	 packet->getDataLength() == 0) ||
+	info->myReturnType == RETURN_SINGLE)
+      requestOnces->pop_front();
   }
-  else if (returnType == RETURN_VIDEO)
+  else if (info->myReturnType == RETURN_VIDEO)
   {
     // what we do here is send it to the ones that have requested it
     // but aren't listening for the broadcast... then we broadcast it
     // to everyone whose listening... this should ensure that everyone
-    // just gets the packet once as often as we see it... 
-
-    while ((it = myRequestOnces[packet->getCommand()]->begin()) != 
-	   myRequestOnces[packet->getCommand()]->end())
+    // just gets the packet once as often as we see it...
+    while (!requestOnces->empty())
     {
-      //printf("Sent a single return_single_and_broadcast for %s\n", myClient->getName(packet->getCommand(), true));
-      client = (*it);
+      client = requestOnces->front();
       if (client != NULL && client->getFrequency(packet->getCommand()) == -2)
-      {
-	if (packet->getPacketSource() == ArNetPacket::TCP)
-	  client->sendPacketTcp(packet);
-	else if (packet->getPacketSource() == ArNetPacket::UDP)
-	  client->sendPacketUdp(packet);
-	else
-	{
-	  client->sendPacketTcp(packet);
-	  ArLog::log(ArLog::Normal, 
-		     "%sDon't know what type of packet %s is (%d)", 
-		     myPrefix.c_str(), 
-		     myClient->getName(packet->getCommand(), true), 
-		     packet->getPacketSource());
-	}
-      }
-      myRequestOnces[packet->getCommand()]->pop_front();
-    }
-    //printf("Broadcast return_single_and_broadcast for %s\n", myClient->getName(packet->getCommand(), true));
-    myLastBroadcast[packet->getCommand()]->setToNow();
-    if (packet->getPacketSource() == ArNetPacket::TCP)
-    {
-      myServer->broadcastPacketTcpByCommand(packet, packet->getCommand());
-    }
-    else if (packet->getPacketSource() == ArNetPacket::UDP)
-    {
-      myServer->broadcastPacketUdpByCommand(packet, packet->getCommand());
-    }
-    else
-    {
-      myServer->broadcastPacketTcpByCommand(packet, packet->getCommand());
-      ArLog::log(ArLog::Normal, 
-		 "%sDon't know what type of packet %s is (%d)", 
-		 myPrefix.c_str(), 
-		 myClient->getName(packet->getCommand(), true), 
-		 packet->getPacketSource());
+	forwardToClient(client, packet, &shared);
+      requestOnces->pop_front();
     }
+    info->myLastBroadcast.setToNow();
+    forwardBroadcast(packet, &shared);
   }
-  else if (returnType == RETURN_VIDEO_OPTIM)
+  else if (info->myReturnType == RETURN_VIDEO_OPTIM)
   {
     // what we do here is send it to the ones that have requested it
-    while ((it = myRequestOnces[packet->getCommand()]->begin()) != 
-	   myRequestOnces[packet->getCommand()]->end())
+    while (!requestOnces->empty())
     {
-      client = (*it);
-      /*
-      ArLog::log(ArLog::Normal, "%sSent a return_video_optim for %s to %s", 
-		 myPrefix.c_str(), 
-		 myClient->getName(packet->getCommand(), true),
-		 client->getIPString());
-      */
+      client = requestOnces->front();
       if (client != NULL)
-      {
-	if (packet->getPacketSource() == ArNetPacket::TCP)
-	  client->sendPacketTcp(packet);
-	else if (packet->getPacketSource() == ArNetPacket::UDP)
-	  client->sendPacketUdp(packet);
-	else
-	{
-	  client->sendPacketTcp(packet);
-	  ArLog::log(ArLog::Normal, 
-		     "%sDon't know what type of packet %s is (%d)", 
-		     myPrefix.c_str(),
-		     myClient->getName(packet->getCommand(), true), 
-		     packet->getPacketSource());
-	}
-      }
-      myRequestOnces[packet->getCommand()]->pop_front();
+	forwardToClient(client, packet, &shared);
+      requestOnces->pop_front();
     }
   }
   else
   {
-    myLastBroadcast[packet->getCommand()]->setToNow();
-    if (packet->getPacketSource() == ArNetPacket::TCP)
-    {
-      myServer->broadcastPacketTcpByCommand(packet, packet->getCommand());
-    }
-    else if (packet->getPacketSource() == ArNetPacket::UDP)
-    {
-      myServer->broadcastPacketUdpByCommand(packet, packet->getCommand());
-    }
-    else
-    {
-      myServer->broadcastPacketTcpByCommand(packet, packet->getCommand());
-      ArLog::log(ArLog::Normal, 
-		 "%sDon't know what type of packet %s is (%d)", 
-		 myPrefix.c_str(), 
-		 myClient->getName(packet->getCommand(), true), 
-		 packet->getPacketSource());
-    }
+    info->myLastBroadcast.setToNow();
+    forwardBroadcast(packet, &shared);
   }
 
+  if (shared != NULL)
+    shared->release();
 }
 
-void ArCentralForwarder::requestChanged(long interval, 
+void ArCentralForwarder::requestChanged(long interval,
 					     unsigned int command)
 {
-  /*
-  if (strcmp(myClient->getName(command, true), 
-	     "getPictureCam1") == 0)
-    printf("Changed getPictureCam1 to %d...\n", interval);
-  */
+  CommandInfo *info;
+
+  if ((info = getCommandInfo(command)) == NULL)
+  {
+    ArLog::log(ArLog::Verbose, "%sIgnoring request change for command %u we don't forward",
+	       myPrefix.c_str(), command);
+    return;
+  }
+
   if (interval == -2)
   {
-    ArLog::log(ArLog::Verbose, "%sStopping request for %s", 
+    ArLog::log(ArLog::Verbose, "%sStopping request for %s",
 	       myPrefix.c_str(), myClient->getName(command, true));
     myClient->requestStopByCommand(command);
-    myLastRequest[command]->setToNow();
+    info->myLastRequest.setToNow();
   }
-  else 
+  else
   {
-    ReturnType returnType;
-    
-    returnType = myReturnTypes[command];    
-    if (returnType == RETURN_VIDEO && interval != -1)
+    if (info->myReturnType == RETURN_VIDEO && interval != -1)
     {
-      ArLog::log(ArLog::Verbose, "%sIgnoring a RETURN_VIDEO attempted request of %s at %d interval since RETURN_VIDEOs cannot request at an interval", 
+      ArLog::log(ArLog::Verbose, "%sIgnoring a RETURN_VIDEO attempted request of %s at %d interval since RETURN_VIDEOs cannot request at an interval",
 		 myPrefix.c_str(), myClient->getName(command, true), interval);
       return;
     }
-    if (returnType == RETURN_VIDEO_OPTIM && interval != -1)
+    if (info->myReturnType == RETURN_VIDEO_OPTIM && interval != -1)
     {
-      ArLog::log(ArLog::Verbose, "%sIgnoring a RETURN_VIDEO_OPTIM attempted request of %s at %d interval since RETURN_VIDEOs cannot request at an interval", 
+      ArLog::log(ArLog::Verbose, "%sIgnoring a RETURN_VIDEO_OPTIM attempted request of %s at %d interval since RETURN_VIDEOs cannot request at an interval",
 		 myPrefix.c_str(), myClient->getName(command, true), interval);
       return;
     }
-    
-    ArLog::log(ArLog::Verbose, "%sRequesting %s at interval of %ld", 
+
+    ArLog::log(ArLog::Verbose, "%sRequesting %s at interval of %ld",
 	       myPrefix.c_str(), myClient->getName(command, true), interval);
     myClient->requestByCommand(command, interval);
-    myLastRequest[command]->setToNow();
+    info->myLastRequest.setToNow();
     // if the interval is -1 then also requestOnce it so that anyone
     // connecting after the first connection can actually get data too
     myClient->requestOnceByCommand(command);
@@ -669,43 +615,30 @@ void ArCentralForwarder::requestChanged(long interval,
 
 void ArCentralForwarder::requestOnce(ArServerClient *client, ArNetPacket *packet)
 {
-  ReturnType returnType;
-  
-  returnType = myReturnTypes[packet->getCommand()];
+  CommandInfo *info;
 
-  // chop off the footer
-  packet->setAddedFooter(true);
-  /*
-  if (strcmp(myClient->getName(packet->getCommand(), true), 
-	     "getPictureCam1") == 0)
-    printf("Request once for getPictureCam1...\n");
-  */
-  // if its video and the last broadcast or request was very recently
-  // then ignore it so we don't wind up using up our wireless
-  // bandwidth
-  // MPL taking this out since it may be causing some problems
-  /*
-  if (returnType == RETURN_VIDEO && 
-      (myLastBroadcast[packet->getCommand()]->mSecSince() < 25 ||
-       myLastRequest[packet->getCommand()]->mSecSince() < 25))
-  {
-    ArLog::log(ArLog::Normal, "Ignoring a RETURN_VIDEO of %s since request or broadcast was recent", myClient->getName(packet->getCommand(), true));
+  if ((info = getCommandInfo(packet->getCommand())) == NULL)
+  {
+    ArLog::log(ArLog::Verbose, "%sIgnoring request once for command %d we don't forward",
+	       myPrefix.c_str(), packet->getCommand());
     return;
   }
-  */
+
+  // chop off the footer
+  packet->setAddedFooter(true);
   // if its a type where we keep track then put it into the list
-  if (returnType == RETURN_SINGLE || returnType == RETURN_UNTIL_EMPTY || 
-      returnType == RETURN_VIDEO || returnType == RETURN_VIDEO_OPTIM)
+  if (info->myReturnType == RETURN_SINGLE ||
+      info->myReturnType == RETURN_UNTIL_EMPTY ||
+      info->myReturnType == RETURN_VIDEO ||
+      info->myReturnType == RETURN_VIDEO_OPTIM)
   {
-    //if (returnType == RETURN_UNTIL_EMPTY)
-    //printf("Trying to request once %s\n", myClient->getName(packet->getCommand(), true));
-    myRequestOnces[packet->getCommand()]->push_back(client);
+    info->myRequestOnces.push_back(client);
   }
-  
-  ArLog::log(ArLog::Verbose, "%sRequesting %s once", 
+
+  ArLog::log(ArLog::Verbose, "%sRequesting %s once",
 	     myPrefix.c_str(), myClient->getName(packet->getCommand()));
   myClient->requestOnceByCommand(packet->getCommand(), packet);
-  myLastRequest[packet->getCommand()]->setToNow();
+  info->myLastRequest.setToNow();
 }
 
 
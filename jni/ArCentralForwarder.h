@@ -56,6 +56,11 @@ protected:
   void receiveData(ArNetPacket *packet);
   void requestChanged(long interval, unsigned int command);
   void requestOnce(ArServerClient *client, ArNetPacket *packet);
+  void forwardToClient(ArServerClient *client, ArNetPacket *packet,
+		       ArNetSharedPacket **shared);
+  void forwardBroadcast(ArNetPacket *packet, ArNetSharedPacket **shared);
+  ArNetSharedPacket *getSharedPacket(ArNetPacket *packet,
+				     ArNetSharedPacket **shared);
 
   AREXPORT bool startingCallOnce(
 	  double heartbeatTimeout, double udpHeartbeatTimeout,
@@ -107,10 +112,28 @@ protected:
     RETURN_VIDEO_OPTIM,
   };
 
-  std::map<unsigned int, ReturnType> myReturnTypes;
-  std::map<unsigned int, std::list<ArServerClient *> *> myRequestOnces;
-  std::map<unsigned int, ArTime *> myLastRequest;
-  std::map<unsigned int, ArTime *> myLastBroadcast;
+  /// What we know about each command we forward
+  struct CommandInfo
+  {
+    CommandInfo() : myForwarded(false), myReturnType(RETURN_NONE), 
+		    myServerCommand(0) {}
+    bool myForwarded;
+    ReturnType myReturnType;
+    /// the command number this goes out to our clients as
+    unsigned int myServerCommand;
+    std::list<ArServerClient *> myRequestOnces;
+    ArTime myLastRequest;
+    ArTime myLastBroadcast;
+  };
+  /// Gets the info for a command, or NULL if we don't forward it
+  CommandInfo *getCommandInfo(unsigned int command)
+    { 
+      if (command < myCommands.size() && myCommands[command].myForwarded)
+	return &myCommands[command];
+      return NULL;
+    }
+  /// Indexed by the robot's command number
+  std::vector<CommandInfo> myCommands;
 
   ArTime myLastTcpHeartbeat;
   ArTime myLastUdpHeartbeat;
@@ -43,6 +43,12 @@ class ArNetPacket;
    interval and everyone'll want it after we've transfered it),
    RETURN_COMPLEX (The return is more complex (so you'll need a helper
    class))
+
+   There are also flags for what priority the server sends the data
+   with: CONTROL_PRIORITY (goes out ahead of nearly everything else)
+   and BULK_PRIORITY (big data that can wait, SLOW_PACKET and
+   IDLE_PACKET data is sent this way too), anything else is sent at
+   status priority.  See ArNetPacketSenderTcp.
 **/
 
 class ArClientData
@@ -31,7 +31,15 @@ AREXPORT ArClientFileLister::ArClientFileLister(ArClientBase *client) :
   myGetDirListingCB(this, &ArClientFileLister::netGetDirListing),
   myGetDirListingMultiplePacketsCB(
 	  this, 
-	  &ArClientFileLister::netGetDirListingMultiplePackets)
+	  &ArClientFileLister::netGetDirListingMultiplePackets),
+  myFilterPattern(),
+  myFilterType(0),
+  myPageStart(0),
+  myPageMaxEntries(0),
+  myTotalEntries(-1),
+  myGetDirListingFilteredCB(
+	  this, 
+	  &ArClientFileLister::netGetDirListingFiltered)
 {
   myDataMutex.setLogName("ArClientFileLister::myDataMutex");
   myCallbackMutex.setLogName("ArClientFileLister::myCallbackMutex");
@@ -48,6 +56,9 @@ AREXPORT ArClientFileLister::ArClientFileLister(ArClientBase *client) :
     ArLog::log(ArLog::Verbose, "ArClientFileLister: Using getDirListing (old)");
     myClient->addHandler("getDirListing", &myGetDirListingCB);
   }
+  if (myClient->dataExists("getDirListingFiltered"))
+    myClient->addHandler("getDirListingFiltered", 
+			 &myGetDirListingFilteredCB);
   myCurrentDir[0] = '\0';
   myWaitingForDir[0] = '\0';
   myLastDirMatched = false;
@@ -67,7 +78,21 @@ AREXPORT bool ArClientFileLister::isAvailable(void)
 
 void ArClientFileLister::getDirListing(const char *dir)
 {
-  if (myClient->dataExists("getDirListingMultiplePackets"))
+  if ((!myFilterPattern.empty() || myFilterType != 0 || 
+       myPageStart != 0 || myPageMaxEntries != 0) &&
+      myClient->dataExists("getDirListingFiltered"))
+  {
+    ArNetPacket sendPacket;
+    sendPacket.strToBuf(dir);
+    sendPacket.uByte4ToBuf(myPageStart);
+    sendPacket.uByte4ToBuf(myPageMaxEntries);
+    sendPacket.byteToBuf(myFilterType);
+    sendPacket.strToBuf(myFilterPattern.c_str());
+    myClient->requestOnce("getDirListingFiltered", &sendPacket);
+    myLastDirMatched = false;
+    myNewDirListing = true;
+  }
+  else if (myClient->dataExists("getDirListingMultiplePackets"))
   {
     myClient->requestOnceWithString("getDirListingMultiplePackets", dir);
     myLastDirMatched = false;
@@ -166,6 +191,55 @@ AREXPORT const char *ArClientFileLister::getWaitingForDir(void) const
   return myWaitingForDir;
 }
 
+/**
+   This takes effect with the next directory change.
+
+   @param namePattern a shell style pattern (like "*.map") that is
+   matched without case, NULL or empty for everything
+
+   @param type 0 for directories and files, 1 for only directories, 2
+   for only files
+**/
+AREXPORT void ArClientFileLister::setFilter(const char *namePattern, 
+					    int type)
+{
+  myDataMutex.lock();
+  if (namePattern != NULL)
+    myFilterPattern = namePattern;
+  else
+    myFilterPattern = "";
+  myFilterType = type;
+  myDataMutex.unlock();
+}
+
+/**
+   This takes effect with the next directory change.
+
+   @param start the index of the first entry to list (directories come
+   first, then files, each sorted by name)
+
+   @param maxEntries the most entries to list, 0 for all of them
+**/
+AREXPORT void ArClientFileLister::setPage(ArTypes::UByte4 start, 
+					  ArTypes::UByte4 maxEntries)
+{
+  myDataMutex.lock();
+  myPageStart = start;
+  myPageMaxEntries = maxEntries;
+  myDataMutex.unlock();
+}
+
+/**
+   If the last listing was a page this is how many entries there are
+   in total, otherwise it is how many were listed.
+**/
+AREXPORT ArTypes::UByte4 ArClientFileLister::getTotalEntries(void) const
+{
+  if (myTotalEntries >= 0)
+    return myTotalEntries;
+  return myDirectories.size() + myFiles.size();
+}
+
 
 AREXPORT void ArClientFileLister::netGetDirListing(ArNetPacket *packet)
 {
@@ -209,6 +283,7 @@ AREXPORT void ArClientFileLister::netGetDirListing(ArNetPacket *packet)
 
   myDirectories.clear();
   myFiles.clear();
+  myTotalEntries = -1;
   num = packet->bufToUByte2();
 
   for (i = 0; i < num; i++)
@@ -238,6 +313,19 @@ AREXPORT void ArClientFileLister::netGetDirListing(ArNetPacket *packet)
 AREXPORT void ArClientFileLister::netGetDirListingMultiplePackets(
 	ArNetPacket *packet)
 {
+  doGetDirListingMultiplePackets(packet, false);
+}
+
+AREXPORT void ArClientFileLister::netGetDirListingFiltered(
+	ArNetPacket *packet)
+{
+  doGetDirListingMultiplePackets(packet, true);
+}
+
+void ArClientFileLister::doGetDirListingMultiplePackets(
+	ArNetPacket *packet, bool filtered)
+{
+  ArTypes::UByte4 total = 0;
   int type;
   char name[2048];
   char directory[2048];
@@ -306,8 +394,16 @@ AREXPORT void ArClientFileLister::netGetDirListingMultiplePackets(
     myDirectories.clear();
     myFiles.clear();
     myNewDirListing = false;
+    myTotalEntries = -1;
 
   }
+  if (filtered)
+  {
+    total = packet->bufToUByte4();
+    // the start of this packet, we don't need it
+    packet->bufToUByte4();
+    myTotalEntries = total;
+  }
   /*** 
   else {
     ArLog::log(ArLog::Verbose, 
@@ -471,7 +567,23 @@ AREXPORT ArClientFileToClient::ArClientFileToClient(ArClientBase *client) :
   myLastReceived(),
   myFileReceivedCallbacks(),
   myGetFileCB(this, &ArClientFileToClient::netGetFile),
-  myGetFileWithTimestampCB(this, &ArClientFileToClient::netGetFileWithTimestamp)
+  myGetFileWithTimestampCB(this, &ArClientFileToClient::netGetFileWithTimestamp),
+  myChunked(false),
+  myChunkedTimestamp(false),
+  myChunkWindow(4),
+  myChunkSize(30000),
+  myChunkInFlight(0),
+  myChunkRetries(0),
+  myChunkOffset(0),
+  myChunkReceived(0),
+  myChunkFileSize(-1),
+  myChunkVerifying(false),
+  myChunkVerifyOffset(0),
+  myChunkPartFileName(),
+  myChunkInfoFileName(),
+  myChunkPartSize(-1),
+  myChunkPartModTime(-1),
+  myGetFileChunkCB(this, &ArClientFileToClient::netGetFileChunk)
 {
   myDataMutex.setLogName("ArClientFileToClient::myDataMutex");
   myCallbackMutex.setLogName("ArClientFileToClient::myCallbackMutex");
@@ -479,6 +591,7 @@ AREXPORT ArClientFileToClient::ArClientFileToClient(ArClientBase *client) :
   if (myClient != NULL) {
     myClient->addHandler("getFile", &myGetFileCB);
     myClient->addHandler("getFileWithTimestamp", &myGetFileWithTimestampCB);
+    myClient->addHandler("getFileChunk", &myGetFileChunkCB);
   }
 }
 
@@ -691,8 +804,422 @@ AREXPORT void ArClientFileToClient::doGetFile(ArNetPacket *packet,
 }
 
 
+AREXPORT bool ArClientFileToClient::isAvailableChunked(void)
+{
+  return ((myClient != NULL) && myClient->dataExists("getFileChunk"));
+}
+
+/**
+   This gets the file in chunks with the getFileChunk command, each
+   chunk carries its offset and a CRC-32 so that bad chunks can just
+   be asked for again.  Several chunks are asked for at once (see
+   setChunkWindow()) so that the link doesn't sit idle waiting on each
+   one.
+
+   The file is written into clientFileName with ".part" on the end and
+   is only renamed to clientFileName once it is all there.  If that
+   .part file is already there (from a get that was cancelled or lost
+   its connection) then the end of it is checked against the server
+   and the get picks up where it left off.  If it doesn't match, or the
+   file's size or time on the server changed since the .part was
+   started, or the server can't give that part of the file anymore,
+   the file is gotten from the start.
+
+   The file received callbacks are called the same as with
+   getFileFromDirectory(), with -3 if chunks kept coming back bad.
+**/
+AREXPORT bool ArClientFileToClient::getFileChunkedFromDirectory(
+	const char *directory, const char *fileName, 
+	const char *clientFileName, bool isSetTimestamp)
+{
+  struct stat partStat;
+
+  myDataMutex.lock();
+  if (fileName == NULL || clientFileName == NULL)
+  {
+    ArLog::log(ArLog::Terse, 
+	       "ArClientFileToClient: NULL fileName ('%s') or clientFileName ('%s')", 
+	       fileName, clientFileName);
+    myDataMutex.unlock();
+    return false;
+  }
+  if (!isAvailableChunked())
+  {
+    ArLog::log(ArLog::Normal, "ArClientFileToClient::getFileChunkedFromDirectory: Tried to get file but the server doesn't support it.");
+    myDataMutex.unlock();
+    return false;
+  }
+  if (myIsWaitingForFile)
+  {
+    ArLog::log(ArLog::Terse, 
+	       "ArClientFileToClient: already busy downloading a file '%s' cannot download '%s'", 
+	       myFileName.c_str(), fileName);
+    myDataMutex.unlock();
+    return false;
+  }
+  if (directory != NULL)
+    myDirectory = directory;
+  else
+    myDirectory = "";
+  myFileName = fileName;
+  myClientFileName = clientFileName;
+
+  char *dirStr = NULL;
+  int dirLen;
+  if (directory != NULL)
+  {
+    dirLen = strlen(directory) + 2;
+    dirStr = new char[dirLen];
+    strncpy(dirStr, directory, dirLen);
+    ArUtil::appendSlash(dirStr, dirLen);
+    ArUtil::fixSlashes(dirStr, dirLen);
+  }
+
+  int fileLen = strlen(fileName) + 1;
+  char *fileStr = new char[fileLen];
+  strncpy(fileStr, fileName, fileLen);
+  ArUtil::fixSlashes(fileStr, fileLen);
+
+  if (directory == NULL)
+    myWholeFileName = "";
+  else
+    myWholeFileName = dirStr;
+  myWholeFileName += fileStr;
+
+  if (dirStr != NULL)
+    delete[] dirStr;
+  delete[] fileStr;
+
+  myChunkPartFileName = myClientFileName;
+  myChunkPartFileName += ".part";
+  myChunkInfoFileName = myClientFileName;
+  myChunkInfoFileName += ".partinfo";
+
+  myChunked = true;
+  myChunkedTimestamp = isSetTimestamp;
+  myChunkInFlight = 0;
+  myChunkRetries = 0;
+  myChunkOffset = 0;
+  myChunkReceived = 0;
+  myChunkFileSize = -1;
+  myChunkVerifying = false;
+  myChunkVerifyOffset = 0;
+  myChunkPartSize = -1;
+  myChunkPartModTime = -1;
+
+  // see if there's a part we can pick up from
+  if (stat(myChunkPartFileName.c_str(), &partStat) == 0 && 
+      partStat.st_size > 0 && 
+      (myFile = ArUtil::fopen(myChunkPartFileName.c_str(), "r+b")) != NULL)
+  {
+    FILE *infoFile;
+    myChunkReceived = partStat.st_size;
+    fseek(myFile, 0, SEEK_END);
+    if ((infoFile = ArUtil::fopen(myChunkInfoFileName.c_str(), "r")) != NULL)
+    {
+      if (fscanf(infoFile, "%ld %ld", &myChunkPartSize, 
+		 &myChunkPartModTime) != 2)
+      {
+	myChunkPartSize = -1;
+	myChunkPartModTime = -1;
+      }
+      fclose(infoFile);
+    }
+  }
+  else if ((myFile = ArUtil::fopen(myChunkPartFileName.c_str(), "wb")) == NULL)
+  {
+    ArLog::log(ArLog::Normal, "Can't open '%s' to put file into", 
+	       myChunkPartFileName.c_str());
+    myChunked = false;
+    myDataMutex.unlock();
+    return false;
+  }
+
+  myIsWaitingForFile = true;
+  myLastRequested.setToNow();
+
+  if (myChunkReceived > 0)
+  {
+    // ask for the last chunk we have so we can make sure the file
+    // didn't change on the server since we got it
+    ArLog::log(ArLog::Normal, "Checking %u bytes already received of %s", 
+	       myChunkReceived, myFileName.c_str());
+    myChunkVerifying = true;
+    if (myChunkReceived > myChunkSize)
+      myChunkVerifyOffset = myChunkReceived - myChunkSize;
+    else
+      myChunkVerifyOffset = 0;
+    requestChunk(myChunkVerifyOffset, myChunkReceived - myChunkVerifyOffset);
+  }
+  else
+  {
+    ArLog::log(ArLog::Verbose, "Getting file %s in chunks", 
+	       myFileName.c_str());
+    requestChunks();
+  }
+  myDataMutex.unlock();
+  return true;
+}
+
+/// Asks for one chunk, must be called with myDataMutex locked
+void ArClientFileToClient::requestChunk(ArTypes::UByte4 offset, 
+					ArTypes::UByte4 size)
+{
+  ArNetPacket sendPacket;
+
+  sendPacket.strToBuf(myWholeFileName.c_str());
+  sendPacket.uByte4ToBuf(offset);
+  sendPacket.uByte4ToBuf(size);
+  myClient->requestOnce("getFileChunk", &sendPacket);
+  myChunkInFlight++;
+}
+
+/**
+   Fills up the window of chunks asked for, until we know the size
+   only the one chunk is asked for.  Must be called with myDataMutex
+   locked.
+**/
+void ArClientFileToClient::requestChunks(void)
+{
+  while (myChunkInFlight < myChunkWindow &&
+	 ((myChunkFileSize < 0 && myChunkInFlight == 0) ||
+	  (myChunkFileSize >= 0 && myChunkOffset < myChunkFileSize)))
+  {
+    requestChunk(myChunkOffset, myChunkSize);
+    myChunkOffset += myChunkSize;
+  }
+}
+
+/**
+   Gives up on a chunked get, the .part file is kept so it can be
+   resumed unless it was bad.  Must be called with myDataMutex locked,
+   this unlocks it before calling the callbacks.
+**/
+void ArClientFileToClient::failChunked(int val)
+{
+  if (myFile != NULL)
+  {
+    fclose(myFile);
+    myFile = NULL;
+  }
+  myIsWaitingForFile = false;
+  myChunked = false;
+  myLastReceived.setToNow();
+  myDataMutex.unlock();
+  callFileReceivedCallbacks(val);
+}
+
+/**
+   Throws away the .part file and starts the get over from the start
+   (for when what we have can't be resumed).  Must be called with
+   myDataMutex locked, if the .part file can't be opened again this
+   returns false and the caller should fail the get.
+**/
+bool ArClientFileToClient::restartChunked(void)
+{
+  if (myFile != NULL)
+    fclose(myFile);
+  unlink(myChunkInfoFileName.c_str());
+  myChunkPartSize = -1;
+  myChunkPartModTime = -1;
+  myChunkVerifying = false;
+  myChunkReceived = 0;
+  myChunkOffset = 0;
+  if ((myFile = ArUtil::fopen(myChunkPartFileName.c_str(), "wb")) == NULL)
+  {
+    ArLog::log(ArLog::Normal, "Can't open '%s' to put file into", 
+	       myChunkPartFileName.c_str());
+    return false;
+  }
+  return true;
+}
+
+/// Notes which version of the file on the server the .part file is of
+void ArClientFileToClient::writeChunkInfo(long fileSize, time_t modTime)
+{
+  FILE *infoFile;
+
+  myChunkPartSize = fileSize;
+  myChunkPartModTime = modTime;
+  if ((infoFile = ArUtil::fopen(myChunkInfoFileName.c_str(), "w")) == NULL)
+    return;
+  fprintf(infoFile, "%ld %ld\n", myChunkPartSize, myChunkPartModTime);
+  fclose(infoFile);
+}
+
+AREXPORT void ArClientFileToClient::netGetFileChunk(ArNetPacket *packet)
+{
+  char fileName[2048];
+  char buf[32000];
+  int ret;
+  long fileSize;
+  time_t modTime;
+  ArTypes::UByte4 offset;
+  ArTypes::UByte4 numBytes;
+  ArTypes::UByte4 crc;
+
+  myDataMutex.lock();
+  if (!myIsWaitingForFile || !myChunked)
+  {
+    myDataMutex.unlock();
+    return;
+  }
+  ret = packet->bufToUByte2();
+  packet->bufToStr(fileName, sizeof(fileName));
+  ArUtil::fixSlashes(fileName, sizeof(fileName));
+  if (ArUtil::strcasecmp(fileName, myWholeFileName) != 0)
+  {
+    ArLog::log(ArLog::Normal, 
+	       "Got chunk for a file ('%s') we don't want (we want '%s') (ret %d)",
+	       fileName, myWholeFileName.c_str(), ret);
+    myDataMutex.unlock();
+    return;
+  } 
+  myChunkInFlight--;
+
+  if (ret != 0 && myChunkVerifying)
+  {
+    // the file on the server probably shrank or was replaced, so
+    // what we have is no good, but the file may still be there
+    ArLog::log(ArLog::Normal, 
+	       "ArClientFileToClient: Could not check what was already received of %s (ret %d), getting all of it", 
+	       fileName, ret);
+    if (!restartChunked())
+    {
+      failChunked(-2);
+      return;
+    }
+    myChunkFileSize = -1;
+    requestChunks();
+    myDataMutex.unlock();
+    return;
+  }
+  if (ret != 0)
+  {
+    ArLog::log(ArLog::Normal, "ArClientFileToClient: Bad return %d on file %s", ret, fileName);
+    failChunked(ret);
+    return;
+  }
+
+  fileSize = packet->bufToUByte4();
+  modTime = packet->bufToByte4();
+  offset = packet->bufToUByte4();
+  numBytes = packet->bufToUByte4();
+  crc = packet->bufToUByte4();
+  if (numBytes > sizeof(buf))
+  {
+    ArLog::log(ArLog::Normal, "ArClientFileToClient: Chunk of %u bytes of %s is too big", numBytes, fileName);
+    failChunked(4);
+    return;
+  }
+  packet->bufToData(buf, numBytes);
+
+  if (!packet->isValid() || ArUtil::crc32(buf, numBytes) != crc)
+  {
+    if (++myChunkRetries > 10)
+    {
+      ArLog::log(ArLog::Normal, "ArClientFileToClient: Too many bad chunks getting %s", fileName);
+      failChunked(-3);
+      return;
+    }
+    ArLog::log(ArLog::Normal, "ArClientFileToClient: Bad chunk at %u of %s, asking again", offset, fileName);
+    if (myChunkVerifying)
+      requestChunk(myChunkVerifyOffset, myChunkReceived - myChunkVerifyOffset);
+    else if (offset == myChunkReceived)
+    {
+      // go back and ask for everything from the bad one on again,
+      // the ones already asked for after it will be ignored
+      myChunkOffset = myChunkReceived;
+      requestChunks();
+    }
+    myDataMutex.unlock();
+    return;
+  }
+  myChunkFileSize = fileSize;
+
+  if (myChunkVerifying)
+  {
+    char localBuf[32000];
+    bool good = false;
+
+    myChunkVerifying = false;
+    if ((myChunkPartSize < 0 || 
+	 (myChunkPartSize == fileSize && myChunkPartModTime == modTime)) &&
+	myChunkReceived <= (ArTypes::UByte4)fileSize &&
+	offset == myChunkVerifyOffset && 
+	numBytes == myChunkReceived - myChunkVerifyOffset &&
+	fseek(myFile, myChunkVerifyOffset, SEEK_SET) == 0 &&
+	fread(localBuf, 1, numBytes, myFile) == numBytes &&
+	ArUtil::crc32(localBuf, numBytes) == crc)
+      good = true;
+    if (good && fseek(myFile, 0, SEEK_END) == 0)
+    {
+      ArLog::log(ArLog::Normal, "Resuming get of %s at %u", 
+		 myFileName.c_str(), myChunkReceived);
+      myChunkOffset = myChunkReceived;
+    }
+    else
+    {
+      ArLog::log(ArLog::Normal, 
+		 "File %s changed since it was partly received, getting all of it", 
+		 myFileName.c_str());
+      if (!restartChunked())
+      {
+	failChunked(-2);
+	return;
+      }
+    }
+  }
+  else if (offset == myChunkReceived)
+  {
+    if (numBytes == 0 && myChunkReceived < fileSize)
+    {
+      ArLog::log(ArLog::Normal, "ArClientFileToClient: No data at %u of %s", offset, fileName);
+      failChunked(4);
+      return;
+    }
+    if (fwrite(buf, 1, numBytes, myFile) != numBytes)
+    {
+      ArLog::log(ArLog::Normal, "ArClientFileToClient: Could not write to '%s'", 
+		 myChunkPartFileName.c_str());
+      failChunked(-2);
+      return;
+    }
+    if (offset == 0)
+      writeChunkInfo(fileSize, modTime);
+    myChunkReceived += numBytes;
+    ArLog::log(ArLog::Verbose, "Got %u bytes of file '%s' (%u of %ld)", 
+	       numBytes, myFileName.c_str(), myChunkReceived, fileSize);
+  }
+  // otherwise this is one we asked for before going back, so ignore it
 
+  if (myChunkReceived >= fileSize)
+  {
+    fclose(myFile);
+    myFile = NULL;
+    unlink(myChunkInfoFileName.c_str());
+    unlink(myClientFileName.c_str());
+    if (rename(myChunkPartFileName.c_str(), myClientFileName.c_str()) != 0)
+    {
+      ArLog::log(ArLog::Normal, "ArClientFileToClient: Could not move '%s' to '%s'", 
+		 myChunkPartFileName.c_str(), myClientFileName.c_str());
+      failChunked(-2);
+      return;
+    }
+    if (myChunkedTimestamp)
+      ArUtil::changeFileTimestamp(myClientFileName.c_str(), modTime);
+    myIsWaitingForFile = false;
+    myChunked = false;
+    ArLog::log(ArLog::Normal, "Received file %s", myFileName.c_str());
+    myLastReceived.setToNow();
+    myDataMutex.unlock();
+    callFileReceivedCallbacks(0);
+    return;
+  }
 
+  requestChunks();
+  myDataMutex.unlock();
+}
 
 
 AREXPORT void ArClientFileToClient::addFileReceivedCallback(
@@ -760,6 +1287,20 @@ AREXPORT void ArClientFileToClient::cancelGet(void)
   // waiting for file state.
   // myWholeFileName = "";
   // TODO!
+
+  // chunked gets can just stop, the .part file is left to resume from
+  myDataMutex.lock();
+  if (myIsWaitingForFile && myChunked)
+  {
+    if (myFile != NULL)
+    {
+      fclose(myFile);
+      myFile = NULL;
+    }
+    myIsWaitingForFile = false;
+    myChunked = false;
+  }
+  myDataMutex.unlock();
 }
 
 AREXPORT bool ArClientFileToClient::isWaitingForFile(void) 
@@ -808,7 +1349,17 @@ AREXPORT ArClientFileFromClient::ArClientFileFromClient(ArClientBase *client) :
   myLastStartedSend(),
   myLastCompletedSend(),
   myFileSentCallbacks(),
-  myPutFileCB(this, &ArClientFileFromClient::netPutFile)
+  myPutFileCB(this, &ArClientFileFromClient::netPutFile),
+  myChunked(false),
+  myChunkSentDone(false),
+  myChunkWindow(4),
+  myChunkSize(30000),
+  myChunkInFlight(0),
+  myChunkRetries(0),
+  myChunkOffset(0),
+  myChunkAcked(0),
+  myChunkFileSize(0),
+  myPutFileChunkCB(this, &ArClientFileFromClient::netPutFileChunk)
 {
   myDataMutex.setLogName("ArClientFileFromClient::myDataMutex");
   myCallbackMutex.setLogName("ArClientFileFromClient::myCallbackMutex");
@@ -818,6 +1369,7 @@ AREXPORT ArClientFileFromClient::ArClientFileFromClient(ArClientBase *client) :
     myClient->addHandler("putFileInterleaved", &myPutFileCB);
     myClient->addHandler("putFileWithTimestamp", &myPutFileCB);
     myClient->addHandler("putFileWithTimestampInterleaved", &myPutFileCB);
+    myClient->addHandler("putFileChunk", &myPutFileChunkCB);
   }
 }
 
@@ -1138,6 +1690,291 @@ AREXPORT void ArClientFileFromClient::netPutFile(ArNetPacket *packet)
     callFileSentCallbacks(ret);
 }
 
+AREXPORT bool ArClientFileFromClient::isAvailableChunked(void)
+{
+  return ((myClient != NULL) && myClient->dataExists("putFileChunk"));
+}
+
+/**
+   This puts the file in chunks with the putFileChunk command, each
+   chunk carries its offset and a CRC-32 and the server acknowledges
+   each one, several chunks can be waiting on acknowledgement at once
+   (see setChunkWindow()).  Unlike putFileToDirectory() this doesn't
+   block, the chunks are sent as the acknowledgements come back.
+
+   If the server still has part of this file from an earlier put
+   (same name, size, and timestamp) that didn't finish then it tells
+   us how much it has and the put picks up from there.  
+
+   The file sent callbacks are called with the return from the server
+   (0 is good), or -3 if chunks kept coming back bad.
+**/
+AREXPORT bool ArClientFileFromClient::putFileChunkedToDirectory(
+	const char *directory, const char *fileName, 
+	const char *clientFileName, bool isSetTimestamp)
+{
+  struct stat fileStat;
+  ArNetPacket sendPacket;
+
+  myDataMutex.lock();
+  if (fileName == NULL || fileName[0] == '\0' || 
+      clientFileName == NULL || clientFileName[0] == '\0')
+  {
+    ArLog::log(ArLog::Terse, 
+	       "ArClientFileFromClient: NULL or empty fileName ('%s') or clientFileName ('%s')", 
+	       fileName, clientFileName);
+    myDataMutex.unlock();
+    return false;
+  }
+  if (myIsWaitingForReturn)
+  {
+    ArLog::log(ArLog::Terse, 
+	       "ArClientFileFromClient: already busy uploading a file '%s' cannot upload '%s'", 
+	       myFileName.c_str(), fileName);
+    myDataMutex.unlock();
+    return false;
+  }
+  if (!isAvailableChunked())
+  {
+    ArLog::log(ArLog::Normal, "ArClientFileFromClient::putFileChunkedToDirectory: Tried to put file but the server doesn't support it.");
+    myDataMutex.unlock();
+    return false;
+  }
+
+  if (directory != NULL)
+    myDirectory = directory;
+  else
+    myDirectory = "";
+  myFileName = fileName;
+  myClientFileName = clientFileName;
+
+  char *dirStr = NULL;
+  int dirLen;
+  if (directory != NULL)
+  {
+    dirLen = strlen(directory) + 2;
+    dirStr = new char[dirLen];
+    strncpy(dirStr, directory, dirLen);
+    ArUtil::appendSlash(dirStr, dirLen);
+    ArUtil::fixSlashes(dirStr, dirLen);
+  }
+
+  int fileLen = strlen(fileName) + 1;
+  char *fileStr = new char[fileLen];
+  strncpy(fileStr, fileName, fileLen);
+  ArUtil::fixSlashes(fileStr, fileLen);
+
+  if (directory == NULL)
+    myWholeFileName = "";
+  else
+    myWholeFileName = dirStr;
+  myWholeFileName += fileStr;
+
+  if (dirStr != NULL)
+    delete[] dirStr;
+  delete[] fileStr;
+
+  if ((myFile = ArUtil::fopen(myClientFileName.c_str(), "rb")) == NULL ||
+      fstat(fileno(myFile), &fileStat) != 0)
+  {
+    ArLog::log(ArLog::Normal, 
+	       "ArClientFileFromClient::putFileChunkedToDirectory: can't open file '%s'", 
+	       clientFileName);
+    if (myFile != NULL)
+    {
+      fclose(myFile);
+      myFile = NULL;
+    }
+    myDataMutex.unlock();
+    return false;
+  }
+
+  myCommandName = "putFileChunk";
+  myInterleaved = false;
+  myTimestamp = isSetTimestamp;
+  myChunked = true;
+  myChunkSentDone = false;
+  myChunkInFlight = 0;
+  myChunkRetries = 0;
+  myChunkOffset = 0;
+  myChunkAcked = 0;
+  myChunkFileSize = fileStat.st_size;
+  myIsWaitingForReturn = true;
+  myLastStartedSend.setToNow();
+
+  // tell the server what we're sending, it'll tell us where to start
+  sendPacket.uByte2ToBuf(0);
+  sendPacket.strToBuf(myWholeFileName.c_str());
+  sendPacket.uByte4ToBuf(myChunkFileSize);
+  if (isSetTimestamp)
+    sendPacket.byte4ToBuf(fileStat.st_mtime);
+  else
+    sendPacket.byte4ToBuf(-1);
+  myClient->requestOnce(myCommandName.c_str(), &sendPacket);
+  ArLog::log(ArLog::Normal, "Starting chunked send of file %s", 
+	     myWholeFileName.c_str());
+  myDataMutex.unlock();
+  return true;
+}
+
+/**
+   Sends chunks until the window is full, or says we're done if the
+   server has it all.  Must be called with myDataMutex locked, returns
+   false if the file couldn't be read.
+**/
+bool ArClientFileFromClient::sendChunks(void)
+{
+  ArNetPacket sendPacket;
+  char buf[30000];
+  ArTypes::UByte4 numBytes;
+
+  if (myChunkAcked >= myChunkFileSize)
+  {
+    if (!myChunkSentDone)
+    {
+      sendPacket.uByte2ToBuf(2);
+      sendPacket.strToBuf(myWholeFileName.c_str());
+      myClient->requestOnce(myCommandName.c_str(), &sendPacket);
+      myChunkSentDone = true;
+    }
+    return true;
+  }
+
+  while (myChunkInFlight < myChunkWindow && myChunkOffset < myChunkFileSize)
+  {
+    numBytes = myChunkFileSize - myChunkOffset;
+    if (numBytes > myChunkSize)
+      numBytes = myChunkSize;
+    if (fseek(myFile, myChunkOffset, SEEK_SET) != 0 ||
+	fread(buf, 1, numBytes, myFile) != numBytes)
+    {
+      ArLog::log(ArLog::Normal, 
+		 "ArClientFileFromClient: Error reading %s at %u", 
+		 myClientFileName.c_str(), myChunkOffset);
+      return false;
+    }
+    sendPacket.empty();
+    sendPacket.uByte2ToBuf(1);
+    sendPacket.strToBuf(myWholeFileName.c_str());
+    sendPacket.uByte4ToBuf(myChunkOffset);
+    sendPacket.uByte4ToBuf(ArUtil::crc32(buf, numBytes));
+    sendPacket.uByte4ToBuf(numBytes);
+    sendPacket.dataToBuf(buf, numBytes);
+    myClient->requestOnce(myCommandName.c_str(), &sendPacket);
+    myChunkOffset += numBytes;
+    myChunkInFlight++;
+  }
+  return true;
+}
+
+AREXPORT void ArClientFileFromClient::netPutFileChunk(ArNetPacket *packet)
+{
+  char fileName[2048];
+  ArNetPacket sendPacket;
+  int ret;
+  ArTypes::UByte4 offset;
+  ArTypes::UByte4 numBytes;
+  bool done = false;
+
+  myDataMutex.lock();
+  if (!myIsWaitingForReturn || !myChunked)
+  {
+    myDataMutex.unlock();
+    return;
+  }
+  ret = packet->bufToUByte2();
+  packet->bufToStr(fileName, sizeof(fileName));
+  ArUtil::fixSlashes(fileName, sizeof(fileName));
+  offset = packet->bufToUByte4();
+  numBytes = packet->bufToUByte4();
+  if (ArUtil::strcasecmp(fileName, myWholeFileName) != 0)
+  {
+    myDataMutex.unlock();
+    return;
+  }
+
+  // ready, start at whatever the server already has
+  if (ret == 1)
+  {
+    if (offset > 0)
+      ArLog::log(ArLog::Normal, "Resuming send of %s at %u", 
+		 myWholeFileName.c_str(), offset);
+    myChunkOffset = offset;
+    myChunkAcked = offset;
+    done = !sendChunks();
+  }
+  // got a chunk, it only counts if it's the next one
+  else if (ret == 10)
+  {
+    myChunkInFlight--;
+    if (offset == myChunkAcked)
+      myChunkAcked += numBytes;
+    done = !sendChunks();
+  }
+  // a bad chunk, go back and send from there again
+  else if (ret == 12)
+  {
+    myChunkInFlight--;
+    if (++myChunkRetries > 10)
+    {
+      ArLog::log(ArLog::Normal, "ArClientFileFromClient: Too many bad chunks sending %s", 
+		 myWholeFileName.c_str());
+      sendPacket.uByte2ToBuf(3);
+      sendPacket.strToBuf(myWholeFileName.c_str());
+      myClient->requestOnce(myCommandName.c_str(), &sendPacket);
+      ret = -3;
+      done = true;
+    }
+    else 
+    {
+      if (offset == myChunkAcked)
+	myChunkOffset = myChunkAcked;
+      done = !sendChunks();
+    }
+  }
+  // a chunk after a bad one, the server tells us what it has
+  else if (ret == 14)
+  {
+    myChunkInFlight--;
+    if (offset > myChunkAcked)
+      myChunkAcked = offset;
+    if (myChunkOffset < myChunkAcked)
+      myChunkOffset = myChunkAcked;
+    done = !sendChunks();
+  }
+  // anything else is the end, good or bad
+  else
+  {
+    done = true;
+  }
+
+  if (done)
+  {
+    if (ret == 1 || ret == 10 || ret == 12 || ret == 14)
+    {
+      // couldn't read the file
+      sendPacket.empty();
+      sendPacket.uByte2ToBuf(3);
+      sendPacket.strToBuf(myWholeFileName.c_str());
+      myClient->requestOnce(myCommandName.c_str(), &sendPacket);
+      ret = -2;
+    }
+    if (ret == 0)
+    {
+      ArLog::log(ArLog::Normal, "Sent file %s", myWholeFileName.c_str());
+      myLastCompletedSend.setToNow();
+    }
+    fclose(myFile);
+    myFile = NULL;
+    myChunked = false;
+    myIsWaitingForReturn = false;
+    myDataMutex.unlock();
+    callFileSentCallbacks(ret);
+    return;
+  }
+  myDataMutex.unlock();
+}
+
 
 AREXPORT void ArClientFileFromClient::addFileSentCallback(
 	ArFunctor1<int> *functor, ArListPos::Pos position)
@@ -1209,6 +2046,15 @@ AREXPORT void ArClientFileFromClient::cancelPut(void)
     sendPacket.uByte2ToBuf(3);
     sendPacket.strToBuf(myWholeFileName.c_str());
     myClient->requestOnce(myCommandName.c_str(), &sendPacket);
+    if (myChunked)
+    {
+      if (myFile != NULL)
+      {
+	fclose(myFile);
+	myFile = NULL;
+      }
+      myChunked = false;
+    }
   }
   myDataMutex.unlock();
 }
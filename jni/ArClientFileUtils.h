@@ -85,6 +85,10 @@ protected:
    this class (-1 == got directory but it wasn't what we wanted (if
    you wait the right one might come in, like if someone selects one
    dir then the other)).
+
+   If the server supports it setFilter() and setPage() can be used so
+   that only some of a big directory is listed, the server then only
+   sends the entries that are wanted.
 **/
 class ArClientFileLister
 {
@@ -107,6 +111,12 @@ public:
   AREXPORT const char *getCurrentDir(void) const;
   /// Gets the name of the directory that we're currently waiting for
   AREXPORT const char *getWaitingForDir(void) const;
+  /// Only lists entries matching this pattern and type (if the server can)
+  AREXPORT void setFilter(const char *namePattern, int type = 0);
+  /// Only lists this page of the entries (if the server can)
+  AREXPORT void setPage(ArTypes::UByte4 start, ArTypes::UByte4 maxEntries);
+  /// Gets how many entries the server has that match the filter
+  AREXPORT ArTypes::UByte4 getTotalEntries(void) const;
 
   /// Gets the directories in the current directory
   AREXPORT std::list<ArClientFileListerItem> getDirectories(void) const;
@@ -126,6 +136,8 @@ public:
 protected:
   AREXPORT void netGetDirListing(ArNetPacket *packet);
   AREXPORT void netGetDirListingMultiplePackets(ArNetPacket *packet);
+  AREXPORT void netGetDirListingFiltered(ArNetPacket *packet);
+  void doGetDirListingMultiplePackets(ArNetPacket *packet, bool filtered);
   AREXPORT void callUpdatedCallbacks(int val);
   AREXPORT void logList(
 	  std::list<ArClientFileListerItem> *logThis,
@@ -146,6 +158,15 @@ protected:
   ArFunctor1C<ArClientFileLister, ArNetPacket *> myGetDirListingCB;
   ArFunctor1C<ArClientFileLister, 
 	      ArNetPacket *> myGetDirListingMultiplePacketsCB;
+  // the filter and page to ask for, if the server has getDirListingFiltered
+  std::string myFilterPattern;
+  int myFilterType;
+  ArTypes::UByte4 myPageStart;
+  ArTypes::UByte4 myPageMaxEntries;
+  // -1 unless the last listing was filtered
+  long myTotalEntries;
+  ArFunctor1C<ArClientFileLister, 
+	      ArNetPacket *> myGetDirListingFilteredCB;
 };
 
 
@@ -182,6 +203,18 @@ public:
                                      const char *fileName, 
                                      const char *clientFileName,
                                      bool isSetTimestamp = false);
+  /// Sees if the server supports getting files in resumable chunks
+  AREXPORT bool isAvailableChunked(void);
+  /// Get the file from a directory in chunks (resuming an earlier get)
+  AREXPORT bool getFileChunkedFromDirectory(const char *directory, 
+					    const char *fileName, 
+					    const char *clientFileName,
+					    bool isSetTimestamp = false);
+  /// Sets how many chunks can be asked for at once (default 4)
+  void setChunkWindow(int window) { myChunkWindow = (window > 0 ? window : 1); }
+  /// Sets how big the chunks are (default and max 30000)
+  void setChunkSize(ArTypes::UByte4 size) 
+    { myChunkSize = ((size > 0 && size <= 30000) ? size : 30000); }
   /// Cancels getting a file
   AREXPORT void cancelGet(void);
   /// If we're getting a file now
@@ -211,6 +244,12 @@ protected:
   AREXPORT void doGetFile(ArNetPacket *packet,
                           bool isSetTimestamp);
   AREXPORT void callFileReceivedCallbacks(int val);
+  AREXPORT void netGetFileChunk(ArNetPacket *packet);
+  void requestChunks(void);
+  void requestChunk(ArTypes::UByte4 offset, ArTypes::UByte4 size);
+  void failChunked(int val);
+  bool restartChunked(void);
+  void writeChunkInfo(long fileSize, time_t modTime);
 
 
 protected:
@@ -232,6 +271,32 @@ protected:
 
   ArFunctor1C<ArClientFileToClient, ArNetPacket *> myGetFileCB;
   ArFunctor1C<ArClientFileToClient, ArNetPacket *> myGetFileWithTimestampCB;
+
+  // state for getting a file in chunks, we only ever write the chunk
+  // right after what we have, so the .part file is always good to
+  // resume from
+  bool myChunked;
+  bool myChunkedTimestamp;
+  int myChunkWindow;
+  ArTypes::UByte4 myChunkSize;
+  int myChunkInFlight;
+  int myChunkRetries;
+  // the next offset to ask for
+  ArTypes::UByte4 myChunkOffset;
+  // how many bytes we have (from the start)
+  ArTypes::UByte4 myChunkReceived;
+  // the size of the file on the server (-1 until we hear)
+  long myChunkFileSize;
+  // if we're checking the end of a .part file against the server
+  bool myChunkVerifying;
+  ArTypes::UByte4 myChunkVerifyOffset;
+  std::string myChunkPartFileName;
+  // the size and time of the file on the server that the .part file
+  // is from, kept in a .partinfo file next to it (-1 if not known)
+  std::string myChunkInfoFileName;
+  long myChunkPartSize;
+  long myChunkPartModTime;
+  ArFunctor1C<ArClientFileToClient, ArNetPacket *> myGetFileChunkCB;
 };
 
 /// Class for putting files to the server
@@ -281,6 +346,18 @@ public:
 				                           const char *clientFileName,
 				                           SendSpeed sendSpeed = SPEED_AUTO, 
                                    bool isSetTimestamp = false);
+  /// Sees if the server supports putting files in resumable chunks
+  AREXPORT bool isAvailableChunked(void);
+  /// Puts the client file on the server in chunks (resuming an earlier put)
+  AREXPORT bool putFileChunkedToDirectory(const char *directory, 
+					  const char *fileName, 
+					  const char *clientFileName,
+					  bool isSetTimestamp = false);
+  /// Sets how many chunks can be sent before they're acknowledged (default 4)
+  void setChunkWindow(int window) { myChunkWindow = (window > 0 ? window : 1); }
+  /// Sets how big the chunks are (default and max 30000)
+  void setChunkSize(ArTypes::UByte4 size) 
+    { myChunkSize = ((size > 0 && size <= 30000) ? size : 30000); }
   /// Cancels putting a file
   AREXPORT void cancelPut(void);
 
@@ -303,7 +380,9 @@ public:
   AREXPORT ArTime getLastStartedSend(void);
 protected:
   AREXPORT void netPutFile(ArNetPacket *packet);
+  AREXPORT void netPutFileChunk(ArNetPacket *packet);
   AREXPORT void callFileSentCallbacks(int val);
+  bool sendChunks(void);
 
   ArMutex myDataMutex;
   ArMutex myCallbackMutex;
@@ -323,6 +402,20 @@ protected:
   ArTime myLastCompletedSend;
   std::list<ArFunctor1<int> *> myFileSentCallbacks;
   ArFunctor1C<ArClientFileFromClient, ArNetPacket *> myPutFileCB;
+
+  // state for putting a file in chunks
+  bool myChunked;
+  bool myChunkSentDone;
+  int myChunkWindow;
+  ArTypes::UByte4 myChunkSize;
+  int myChunkInFlight;
+  int myChunkRetries;
+  // the next offset to send
+  ArTypes::UByte4 myChunkOffset;
+  // how many bytes the server has (from the start)
+  ArTypes::UByte4 myChunkAcked;
+  ArTypes::UByte4 myChunkFileSize;
+  ArFunctor1C<ArClientFileFromClient, ArNetPacket *> myPutFileChunkCB;
 };
 
 
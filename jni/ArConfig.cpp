@@ -61,6 +61,8 @@ AREXPORT ArConfig::ArConfig(const char *baseDirectory,
   myBaseDirectory(),
   myParser(NULL),
   mySections(),
+  mySectionIndex(),
+  mySectionIndexDirty(true),
   myParserCB(this, &ArConfig::parseArgument),
   mySectionCB(this, &ArConfig::parseSection),
   myUnknownCB(this, &ArConfig::parseUnknown)
@@ -83,6 +85,7 @@ AREXPORT ArConfig::ArConfig(const char *baseDirectory,
   mySectionBroken = false;
   mySectionIgnored = false;
   myDuplicateParams = false;
+  myChangeVersion = 0;
 
   myParserCB.setName("ArConfig::parseArgument");
   mySectionCB.setName("ArConfig::parseSection");
@@ -108,6 +111,8 @@ AREXPORT ArConfig::ArConfig(const ArConfig &config) :
   myBaseDirectory(),
   myParser(NULL),  
   mySections(),
+  mySectionIndex(),
+  mySectionIndexDirty(true),
   myParserCB(this, &ArConfig::parseArgument),
   mySectionCB(this, &ArConfig::parseSection),
   myUnknownCB(this, &ArConfig::parseUnknown) 
@@ -117,6 +122,7 @@ AREXPORT ArConfig::ArConfig(const ArConfig &config) :
   myIgnoreBounds = config.myIgnoreBounds;
   myFailOnBadSection = config.myFailOnBadSection;
   myDuplicateParams = config.myDuplicateParams;
+  myChangeVersion = config.myChangeVersion;
 
   myProcessFileCallbacksLogLevel = config.myProcessFileCallbacksLogLevel;
   mySectionBroken = config.mySectionBroken;
@@ -131,7 +137,7 @@ AREXPORT ArConfig::ArConfig(const ArConfig &config) :
        it != config.mySections.end(); 
        it++) 
   {
-    mySections.push_back(new ArConfigSection(*(*it)));
+    addSection(new ArConfigSection(*(*it)));
   }
   copySectionsToParse(config.mySectionsToParse);
 
@@ -178,13 +184,14 @@ AREXPORT ArConfig &ArConfig::operator=(const ArConfig &config)
     myDuplicateParams = config.myDuplicateParams;
 
     clearSections();
+    myChangeVersion = config.myChangeVersion;
 
     std::list<ArConfigSection *>::const_iterator it;
     for (it = config.mySections.begin(); 
 	       it != config.mySections.end(); 
 	       it++) 
     {
-      mySections.push_back(new ArConfigSection(*(*it)));
+      addSection(new ArConfigSection(*(*it)));
     }
 
     
@@ -292,6 +299,9 @@ AREXPORT void ArConfig::clearSections(void)
     delete mySections.front();
     mySections.pop_front();
   }
+  mySectionIndex.clear();
+  mySectionIndexDirty = false;
+  myChangeVersion++;
   // Clear this just in case...
   if (mySectionsToParse != NULL)
   {
@@ -375,10 +385,11 @@ AREXPORT void ArConfig::setSectionComment(const char *sectionName,
                myLogPrefix.c_str(), sectionName);
 
     section = new ArConfigSection(sectionName, comment);
-    mySections.push_back(section);
+    addSection(section);
   }
   else
     section->setComment(comment);
+  noteSectionChanged(section);
 }
 
 
@@ -401,10 +412,11 @@ AREXPORT bool ArConfig::addSectionFlags(const char *sectionName,
     section = new ArConfigSection(sectionName);
     section->addFlags(flags, myIsQuiet);
 
-    mySections.push_back(section);
+    addSection(section);
   }
   else
     section->addFlags(flags, myIsQuiet);
+  noteSectionChanged(section);
   return true;
 }
 
@@ -421,6 +433,7 @@ AREXPORT bool ArConfig::remSectionFlag(const char *sectionName,
     return false;
   
   section->remFlag(flag);
+  noteSectionChanged(section);
   return true;
 }
 
@@ -446,20 +459,13 @@ AREXPORT bool ArConfig::addParam(const ArConfigArg &arg,
     ArLog::log(ArLog::Verbose, "ArConfigArg %s: Making new section '%s' (for param)", 
                myLogPrefix.c_str(), sectionName);
     section = new ArConfigSection(sectionName);
-    mySections.push_back(section);
+    addSection(section);
   }
    
-  std::list<ArConfigArg> *params = section->getParams();
+  ArConfigArg *lastParam = section->getLastParam();
 
-  if (params == NULL)
-  {
-    ArLog::log(ArLog::Terse, "%sSomething has gone hideously wrong in ArConfig::addParam",
-               myLogPrefix.c_str());
-    return false;
-  }
-  
   if (arg.getType() == ArConfigArg::SEPARATOR && 
-      !params->empty() && params->back().getType() == ArConfigArg::SEPARATOR)
+      lastParam != NULL && lastParam->getType() == ArConfigArg::SEPARATOR)
   {
     //ArLog::log(ArLog::Verbose, "Last parameter a sep, so is this one, ignoring it");
     return true;
@@ -512,10 +518,12 @@ AREXPORT bool ArConfig::addParam(const ArConfigArg &arg,
   
   
   // we didn't have a parameter with this name so add it
-  params->push_back(arg);
-  params->back().setConfigPriority(priority);
-  params->back().setDisplayHint(displayHint);
-  params->back().setIgnoreBounds(myIgnoreBounds);
+  ArConfigArg *added = section->addParam(arg);
+  added->setConfigPriority(priority);
+  added->setDisplayHint(displayHint);
+  added->setIgnoreBounds(myIgnoreBounds);
+  // so changes since a version before this include it
+  noteParamChanged(section, added);
 
   IFDEBUG(ArLog::log(ArLog::Verbose, "%sAdded parameter '%s' to section '%s'", 
                       myLogPrefix.c_str(), arg.getName(), section->getName()));
@@ -561,62 +569,58 @@ AREXPORT bool ArConfig::parseSection(ArArgumentBuilder *arg,
   if (myFailOnBadSection && errorBuffer != NULL)
     errorBuffer[0] = '\0';
 
-  std::list<ArConfigSection *>::iterator sectionIt;
+  const std::list<ArConfigSection *> *sections;
   ArConfigSection *section = NULL;
   
   if (myFailOnBadSection && errorBuffer != NULL)
     errorBuffer[0] = '\0';
-  for (sectionIt = mySections.begin(); 
-       sectionIt != mySections.end(); 
-       sectionIt++)
+  // if there's more than one section with this name we use the first
+  if ((sections = findSections(arg->getFullString())) != NULL)
   {
-    section = (*sectionIt);
-    if (ArUtil::strcasecmp(section->getName(), arg->getFullString()) == 0)
-    {
-      bool isParseSection = true;
-      if (mySectionsToParse != NULL) {
-        isParseSection = false;
-        for (std::list<std::string>::iterator sIter = mySectionsToParse->begin();
-             sIter != mySectionsToParse->end();
-             sIter++) {
-          std::string sp = *sIter;
-          if (ArUtil::strcasecmp(section->getName(), sp.c_str()) == 0) {
-            isParseSection = true;
-            break;
-          } // end if section 
-        } // end for each section to parse
-
-      } // end else sections to parse specified
-
-      if (isParseSection) {
-
-        ArLog::log(ArLog::Verbose, "%sConfig switching to section '%s'",
-                   myLogPrefix.c_str(),
-		               arg->getFullString());
-        //printf("Config switching to section '%s'\n", 
-        //arg->getFullString());
-        mySection = arg->getFullString();
-        mySectionBroken = false;
-        mySectionIgnored = false;
-        myUsingSections = true;
-        return true;
-      }
-      else { // section is valid but shouldn't be parsed
-
-        ArLog::log(ArLog::Verbose, "%signoring section '%s'", 
-                   myLogPrefix.c_str(),
-		               arg->getFullString());
-        //printf("Config switching to section '%s'\n", 
-        //arg->getFullString());
-        mySection = arg->getFullString();
-        mySectionBroken = false;
-        mySectionIgnored = true;
-        myUsingSections = true;
-        return true;
-
-      } // end else don't parse section
-    } // end if section found
-  } // end for each section
+    section = sections->front();
+    bool isParseSection = true;
+    if (mySectionsToParse != NULL) {
+      isParseSection = false;
+      for (std::list<std::string>::iterator sIter = mySectionsToParse->begin();
+           sIter != mySectionsToParse->end();
+           sIter++) {
+        std::string sp = *sIter;
+        if (ArUtil::strcasecmp(section->getName(), sp.c_str()) == 0) {
+          isParseSection = true;
+          break;
+        } // end if section 
+      } // end for each section to parse
+
+    } // end else sections to parse specified
+
+    if (isParseSection) {
+
+      ArLog::log(ArLog::Verbose, "%sConfig switching to section '%s'",
+                 myLogPrefix.c_str(),
+			     arg->getFullString());
+      //printf("Config switching to section '%s'\n", 
+      //arg->getFullString());
+      mySection = arg->getFullString();
+      mySectionBroken = false;
+      mySectionIgnored = false;
+      myUsingSections = true;
+      return true;
+    }
+    else { // section is valid but shouldn't be parsed
+
+      ArLog::log(ArLog::Verbose, "%signoring section '%s'", 
+                 myLogPrefix.c_str(),
+			     arg->getFullString());
+      //printf("Config switching to section '%s'\n", 
+      //arg->getFullString());
+      mySection = arg->getFullString();
+      mySectionBroken = false;
+      mySectionIgnored = true;
+      myUsingSections = true;
+      return true;
+
+    } // end else don't parse section
+  } // end if section found
 
 
   if (myFailOnBadSection)
@@ -643,7 +647,7 @@ AREXPORT bool ArConfig::parseSection(ArArgumentBuilder *arg,
       mySectionBroken = false;
       mySectionIgnored = false;
       section = new ArConfigSection(arg->getFullString());
-      mySections.push_back(section);
+      addSection(section);
     }
     else
     {
@@ -677,14 +681,17 @@ AREXPORT bool ArConfig::parseArgument(ArArgumentBuilder *arg,
 				      char *errorBuffer,
 				      size_t errorBufferLen)
 {
-  std::list<ArConfigSection *>::iterator sectionIt;
-  std::list<ArConfigArg>::iterator paramIt;
+  const std::list<ArConfigSection *> *sections = NULL;
+  std::list<ArConfigSection *> noSections;
+  std::list<ArConfigSection *>::const_iterator sectionIt;
+  const std::list<std::list<ArConfigArg>::iterator> *params = NULL;
+  std::list<std::list<ArConfigArg>::iterator>::const_iterator paramIt;
   ArConfigSection *section = NULL;
-  std::list<ArConfigArg> *params = NULL;
   ArConfigArg *param = NULL;
   int valInt = 0;
   double valDouble = 0;
   bool valBool = false;
+  bool changed = false;
   bool ret = true;
 
   if (mySectionBroken)
@@ -726,183 +733,196 @@ AREXPORT bool ArConfig::parseArgument(ArArgumentBuilder *arg,
 
   if (errorBuffer != NULL)
     errorBuffer[0] = '\0';
-  for (sectionIt = mySections.begin(); 
-       sectionIt != mySections.end(); 
+  // if we have a section make sure we're in it, otherwise do the
+  // normal thing 
+
+  // MPL took out the part where if the param wasn't in a section at
+  // all it checked all the sections, I took this out since
+  // everything is generally in sections these days
+  if ((sections = findSections(mySection.c_str())) == NULL)
+    sections = &noSections;
+  for (sectionIt = sections->begin(); 
+       sectionIt != sections->end(); 
        sectionIt++)
   {
     section = (*sectionIt);
-    // if we have a section make sure we're in it, otherwise do the
-    // normal thing 
-
-    // MPL took out the part where if the param wasn't in a section at
-    // all it checked all the sections, I took this out since
-    // everything is generally in sections these days
-    if (ArUtil::strcasecmp(mySection, section->getName()))
-      continue;
-    params = section->getParams();
     // find this parameter
+    if ((params = section->findParams(arg->getExtraString())) == NULL)
+      continue;
     for (paramIt = params->begin(); paramIt != params->end(); paramIt++)
     {
-      if (strcasecmp((*paramIt).getName(), arg->getExtraString()) == 0)
+      // we found it
+      found = true;
+      param = &(*(*paramIt));
+      if (param->getType() != ArConfigArg::STRING &&
+	  param->getType() != ArConfigArg::FUNCTOR &&
+	  arg->getArg(0) == NULL)
       {
-	// we found it
-	found = true;
-	param = &(*paramIt);
-	if (param->getType() != ArConfigArg::STRING &&
-	    param->getType() != ArConfigArg::FUNCTOR &&
-	    arg->getArg(0) == NULL)
+	if (!myIsQuiet) 
 	{
-	  if (!myIsQuiet) 
-	  {
-	    ArLog::log(ArLog::Verbose, "%sparameter '%s' has no argument.",
-		       myLogPrefix.c_str(),
-		       param->getName());
-	  }
+	  ArLog::log(ArLog::Verbose, "%sparameter '%s' has no argument.",
+		     myLogPrefix.c_str(),
+		     param->getName());
+	}
+	continue;
+      }
+      // MPL added the string holder on 2/27 to get rid of the
+      // unknown type message
+      if ((param->getType() == ArConfigArg::DESCRIPTION_HOLDER) ||
+	  (param->getType() == ArConfigArg::SEPARATOR) || 
+	  (param->getType() == ArConfigArg::STRING_HOLDER))
+      {
+
+      }
+      // see if we're an int
+      else if (param->getType() == ArConfigArg::INT)
+      {
+	// if the param isn't an int fail
+	if (!arg->isArgInt(0))
+	{
+	  ArLog::log(ArLog::Terse, 
+               "%sparameter '%s' is an integer parameter but was given non-integer argument of '%s'", 
+               myLogPrefix.c_str(), param->getName(), arg->getArg(0));
+	  ret = false;
+	  if (errorBuffer != NULL)
+	    snprintf(errorBuffer, errorBufferLen, 
+		     "%s is an integer parameter but was given non-integer argument of '%s'", 
+		     param->getName(), arg->getArg(0));
 	  continue;
 	}
-	// MPL added the string holder on 2/27 to get rid of the
-	// unknown type message
-	if ((param->getType() == ArConfigArg::DESCRIPTION_HOLDER) ||
-	    (param->getType() == ArConfigArg::SEPARATOR) || 
-	    (param->getType() == ArConfigArg::STRING_HOLDER))
+	valInt = arg->getArgInt(0);
+	changed = (valInt != param->getInt());
+	if (param->setInt(valInt, errorBuffer, errorBufferLen))
+	{
+	  if (changed)
+	    noteParamChanged(section, param);
+	  IFDEBUG(ArLog::log(ArLog::Verbose, 
+			     "%sSet parameter '%s' to '%d'",
+			     myLogPrefix.c_str(), param->getName(), valInt));
+	  continue;
+	}
+	else
 	{
+	  ArLog::log(ArLog::Verbose, 
+		     "%sCould not set parameter '%s' to '%d'",
+		     myLogPrefix.c_str(), param->getName(), valInt);
+	  ret = false;
+	  continue;
+	}
+      }
+      else if (param->getType() == ArConfigArg::DOUBLE)
+      {
+	// if the param isn't an in tfail
+	if (!arg->isArgDouble(0))
+	{
+	  ArLog::log(ArLog::Terse, "%sparameter '%s' is a double parameter but was given non-double argument of '%s'", 
+               myLogPrefix.c_str(), param->getName(), arg->getArg(0));
+	  if (errorBuffer != NULL)
+	    snprintf(errorBuffer, errorBufferLen, "%s is a double parameter but was given non-double argument of '%s'", param->getName(), arg->getArg(0));
 
+	  ret = false;
+	  continue;
 	}
-	// see if we're an int
-	else if (param->getType() == ArConfigArg::INT)
+	valDouble = arg->getArgDouble(0);
+	changed = (valDouble != param->getDouble());
+	if (param->setDouble(valDouble, errorBuffer, errorBufferLen))
 	{
-	  // if the param isn't an int fail
-	  if (!arg->isArgInt(0))
-	  {
-	    ArLog::log(ArLog::Terse, 
-                 "%sparameter '%s' is an integer parameter but was given non-integer argument of '%s'", 
-                 myLogPrefix.c_str(), param->getName(), arg->getArg(0));
-	    ret = false;
-	    if (errorBuffer != NULL)
-	      snprintf(errorBuffer, errorBufferLen, 
-		       "%s is an integer parameter but was given non-integer argument of '%s'", 
-		       param->getName(), arg->getArg(0));
-	    continue;
-	  }
-	  valInt = arg->getArgInt(0);
-	  if (param->setInt(valInt, errorBuffer, errorBufferLen))
-	  {
-	    IFDEBUG(ArLog::log(ArLog::Verbose, 
-			       "%sSet parameter '%s' to '%d'",
-			       myLogPrefix.c_str(), param->getName(), valInt));
-	    continue;
-	  }
-	  else
-	  {
-	    ArLog::log(ArLog::Verbose, 
-		       "%sCould not set parameter '%s' to '%d'",
-		       myLogPrefix.c_str(), param->getName(), valInt);
-	    ret = false;
-	    continue;
-	  }
+	  if (changed)
+	    noteParamChanged(section, param);
+    IFDEBUG(ArLog::log(ArLog::Verbose, "%sSet parameter '%s' to '%.10f'",
+		     myLogPrefix.c_str(), param->getName(), valDouble));
+	  continue;
 	}
-	else if (param->getType() == ArConfigArg::DOUBLE)
+	else
 	{
-	  // if the param isn't an in tfail
-	  if (!arg->isArgDouble(0))
-	  {
-	    ArLog::log(ArLog::Terse, "%sparameter '%s' is a double parameter but was given non-double argument of '%s'", 
-                 myLogPrefix.c_str(), param->getName(), arg->getArg(0));
-	    if (errorBuffer != NULL)
-	      snprintf(errorBuffer, errorBufferLen, "%s is a double parameter but was given non-double argument of '%s'", param->getName(), arg->getArg(0));
-
-	    ret = false;
-	    continue;
-	  }
-	  valDouble = arg->getArgDouble(0);
-	  if (param->setDouble(valDouble, errorBuffer, errorBufferLen))
-	  {
-      IFDEBUG(ArLog::log(ArLog::Verbose, "%sSet parameter '%s' to '%.10f'",
-		       myLogPrefix.c_str(), param->getName(), valDouble));
-	    continue;
-	  }
-	  else
-	  {
-      ArLog::log(ArLog::Verbose, "%sCould not set parameter '%s' to '%.10f'",
-		       myLogPrefix.c_str(), param->getName(), valDouble);
-	    ret = false;
-	    continue;
-	  }
+    ArLog::log(ArLog::Verbose, "%sCould not set parameter '%s' to '%.10f'",
+		     myLogPrefix.c_str(), param->getName(), valDouble);
+	  ret = false;
+	  continue;
 	}
-	else if (param->getType() == ArConfigArg::BOOL)
+      }
+      else if (param->getType() == ArConfigArg::BOOL)
+      {
+	// if the param isn't an in tfail
+	if (!arg->isArgBool(0))
 	{
-	  // if the param isn't an in tfail
-	  if (!arg->isArgBool(0))
-	  {
-	    ArLog::log(ArLog::Terse, "%sparameter '%s' is a bool parameter but was given non-bool argument of '%s'", 
-                 myLogPrefix.c_str(), param->getName(), arg->getArg(0));
-	    ret = false;
-	    if (errorBuffer != NULL)
-	      snprintf(errorBuffer, errorBufferLen, "%s is a bool parameter but was given non-bool argument of '%s'", param->getName(), arg->getArg(0));
-	    continue;
-	  }
-	  valBool = arg->getArgBool(0);
-	  if (param->setBool(valBool, errorBuffer, errorBufferLen))
-	  {
-      IFDEBUG(ArLog::log(ArLog::Verbose, "%sSet parameter '%s' to %s",
-		       myLogPrefix.c_str(), param->getName(), valBool ? "true" : "false" ));
-	    continue;
-	  }
-	  else
-	  {
-      ArLog::log(ArLog::Verbose, "%sCould not set parameter '%s' to %s",
-		            myLogPrefix.c_str(), param->getName(), valBool ? "true" : "false" );
-	    ret = false;
-	    continue;
-	  }
+	  ArLog::log(ArLog::Terse, "%sparameter '%s' is a bool parameter but was given non-bool argument of '%s'", 
+               myLogPrefix.c_str(), param->getName(), arg->getArg(0));
+	  ret = false;
+	  if (errorBuffer != NULL)
+	    snprintf(errorBuffer, errorBufferLen, "%s is a bool parameter but was given non-bool argument of '%s'", param->getName(), arg->getArg(0));
+	  continue;
 	}
-	else if (param->getType() == ArConfigArg::STRING)
+	valBool = arg->getArgBool(0);
+	changed = (valBool != param->getBool());
+	if (param->setBool(valBool, errorBuffer, errorBufferLen))
 	{
-	  if (param->setString(arg->getFullString()))
-	  {
-      IFDEBUG(ArLog::log(ArLog::Verbose, "%sSet parameter string '%s' to '%s'",
-                          myLogPrefix.c_str(),
-		                      param->getName(), param->getString()));
-	    continue;
-	  }
-	  else
-	  {
-      ArLog::log(ArLog::Verbose, "%sCould not set string parameter '%s' to '%s'",
-           myLogPrefix.c_str(),
-		       param->getName(), param->getString());
-	    if (errorBuffer != NULL && errorBuffer[0] == '\0')
-	      snprintf(errorBuffer, errorBufferLen, "%s could not be set to '%s'.", param->getName(), arg->getFullString());
-
-	    ret = false;
-	    continue;
-	  }
+	  if (changed)
+	    noteParamChanged(section, param);
+    IFDEBUG(ArLog::log(ArLog::Verbose, "%sSet parameter '%s' to %s",
+		     myLogPrefix.c_str(), param->getName(), valBool ? "true" : "false" ));
+	  continue;
 	}
-	else if (param->getType() == ArConfigArg::FUNCTOR)
+	else
 	{
-	  if (param->setArgWithFunctor(arg))
-	  {
-      IFDEBUG(ArLog::log(ArLog::Verbose, "%sSet arg '%s' with '%s'",
-		       myLogPrefix.c_str(), param->getName(), arg->getFullString()));
-	    continue;
-	  }
-	  else
-	  {
-      ArLog::log(ArLog::Verbose, "ArConfig: Could not set parameter '%s' to '%s'",
-                 myLogPrefix.c_str(),
-		              param->getName(), arg->getFullString());
-	    // if it didn't put in an error message make one
-	    if (errorBuffer != NULL && errorBuffer[0] == '\0')
-	      snprintf(errorBuffer, errorBufferLen, "%s could not be set to '%s'.", param->getName(), arg->getFullString());
-	    ret = false;
-	    continue;
-	  }
+    ArLog::log(ArLog::Verbose, "%sCould not set parameter '%s' to %s",
+			  myLogPrefix.c_str(), param->getName(), valBool ? "true" : "false" );
+	  ret = false;
+	  continue;
+	}
+      }
+      else if (param->getType() == ArConfigArg::STRING)
+      {
+	changed = (param->getString() == NULL ||
+		   strcmp(param->getString(), arg->getFullString()) != 0);
+	if (param->setString(arg->getFullString()))
+	{
+	  if (changed)
+	    noteParamChanged(section, param);
+    IFDEBUG(ArLog::log(ArLog::Verbose, "%sSet parameter string '%s' to '%s'",
+                        myLogPrefix.c_str(),
+				    param->getName(), param->getString()));
+	  continue;
 	}
 	else
 	{
-    ArLog::log(ArLog::Terse, "%sHave no argument type for config '%s' in section, got string '%s', in section '%s'.", 
-      myLogPrefix.c_str(), arg->getExtraString(), arg->getFullString(), mySection.c_str());
+    ArLog::log(ArLog::Verbose, "%sCould not set string parameter '%s' to '%s'",
+         myLogPrefix.c_str(),
+		     param->getName(), param->getString());
+	  if (errorBuffer != NULL && errorBuffer[0] == '\0')
+	    snprintf(errorBuffer, errorBufferLen, "%s could not be set to '%s'.", param->getName(), arg->getFullString());
+
+	  ret = false;
+	  continue;
 	}
       }
+      else if (param->getType() == ArConfigArg::FUNCTOR)
+      {
+	if (param->setArgWithFunctor(arg))
+	{
+	  // we can't tell what the functor had before, so assume it changed
+	  noteParamChanged(section, param);
+    IFDEBUG(ArLog::log(ArLog::Verbose, "%sSet arg '%s' with '%s'",
+		     myLogPrefix.c_str(), param->getName(), arg->getFullString()));
+	  continue;
+	}
+	else
+	{
+    ArLog::log(ArLog::Verbose, "ArConfig: Could not set parameter '%s' to '%s'",
+               myLogPrefix.c_str(),
+			    param->getName(), arg->getFullString());
+	  // if it didn't put in an error message make one
+	  if (errorBuffer != NULL && errorBuffer[0] == '\0')
+	    snprintf(errorBuffer, errorBufferLen, "%s could not be set to '%s'.", param->getName(), arg->getFullString());
+	  ret = false;
+	  continue;
+	}
+      }
+      else
+      {
+  ArLog::log(ArLog::Terse, "%sHave no argument type for config '%s' in section, got string '%s', in section '%s'.", 
+    myLogPrefix.c_str(), arg->getExtraString(), arg->getFullString(), mySection.c_str());
+      }
     }
   }
   // if we didn't find this param its because its a parameter in another section, so pass this off to the parser for unknown things
@@ -1458,13 +1478,19 @@ AREXPORT const char *ArConfig::getFileName(void) const
    @param priority the functors are called in descending order, if two
    things have the same number the first one added is the first one
    called
+
+   @param sectionName if this is given the functor only depends on
+   the params in that section, so it can be skipped when something
+   like ArServerHandlerConfig only changed other sections
 **/
 AREXPORT void ArConfig::addProcessFileCB(ArRetFunctor<bool> *functor,
-					 int priority)
+					 int priority,
+					 const char *sectionName)
 {
+  ProcessFileCBType *cb = new ProcessFileCBType(functor);
+  cb->setSectionName(sectionName);
   myProcessFileCBList.insert(
-	  std::pair<int, ProcessFileCBType *>(-priority, 
-					      new ProcessFileCBType(functor)));
+	  std::pair<int, ProcessFileCBType *>(-priority, cb));
 }
 
 /** 
@@ -1538,14 +1564,20 @@ AREXPORT void ArConfig::addProcessFileCB(
    @param priority the functors are called in descending order, if two
    things have the same number the first one added is the first one
    called
+
+   @param sectionName if this is given the functor only depends on
+   the params in that section, so it can be skipped when something
+   like ArServerHandlerConfig only changed other sections
 **/
 AREXPORT void ArConfig::addProcessFileWithErrorCB(
 	ArRetFunctor2<bool, char *, size_t> *functor,
-	int priority)
+	int priority,
+	const char *sectionName)
 {
+  ProcessFileCBType *cb = new ProcessFileCBType(functor);
+  cb->setSectionName(sectionName);
   myProcessFileCBList.insert(
-	  std::pair<int, ProcessFileCBType *>(-priority, 
-				      new ProcessFileCBType(functor)));
+	  std::pair<int, ProcessFileCBType *>(-priority, cb));
 }
 
 /** 
@@ -1569,13 +1601,30 @@ AREXPORT void ArConfig::remProcessFileCB(
   }
 }
 
+/**
+   @param continueOnErrors whether to keep calling callbacks after one fails
+
+   @param errorBuffer where the first error is put, if not NULL
+
+   @param errorBufferLen the length of @a errorBuffer
+
+   @param onlyChangedSections if this is true then callbacks that were
+   added for a section are skipped unless a value in that section
+   changed after @a changedSince (see getChangeVersion()), callbacks
+   that weren't added for a section are always called
+
+   @param changedSince the change version to compare against
+**/
 AREXPORT bool ArConfig::callProcessFileCallBacks(bool continueOnErrors,
 						 char *errorBuffer,
-						 size_t errorBufferLen)
+						 size_t errorBufferLen,
+						 bool onlyChangedSections,
+						 unsigned int changedSince)
 {
   bool ret = true;
   std::multimap<int, ProcessFileCBType *>::iterator it;
   ProcessFileCBType *callback;
+  ArConfigSection *section;
   ArLog::LogLevel level = myProcessFileCallbacksLogLevel;
 
   // reset our section to nothing again
@@ -1594,6 +1643,16 @@ AREXPORT bool ArConfig::callProcessFileCallBacks(bool continueOnErrors,
        ++it)
   {
     callback = (*it).second;
+    if (onlyChangedSections && callback->getSectionName()[0] != '\0' &&
+	((section = findSection(callback->getSectionName())) == NULL ||
+	 section->getChangeVersion() <= changedSince))
+    {
+      ArLog::log(level, "%sSkipping functor '%s' (%d) since section '%s' didn't change", 
+		 myLogPrefix.c_str(), 
+		 callback->getName() != NULL ? callback->getName() : "",
+		 -(*it).first, callback->getSectionName());
+      continue;
+    }
     if (callback->getName() != NULL && callback->getName()[0] != '\0')
       ArLog::log(level, "%sProcessing functor '%s' (%d)", 
                  myLogPrefix.c_str(),
@@ -1650,6 +1709,8 @@ AREXPORT bool ArConfig::callProcessFileCallBacks(bool continueOnErrors,
 
 AREXPORT std::list<ArConfigSection *> *ArConfig::getSections(void)
 {
+  // whoever has this can change the list out from under the index
+  mySectionIndexDirty = true;
   return &mySections;
 }
 
@@ -1778,29 +1839,69 @@ AREXPORT bool ArConfig::parseArgumentParser(ArArgumentParser *parser,
   return true;
 }
 
-AREXPORT ArConfigSection *ArConfig::findSection(const char *sectionName) const
+void ArConfig::addSection(ArConfigSection *section)
 {
-  ArConfigSection *section = NULL;
-  ArConfigSection *tempSection = NULL;
+  mySections.push_back(section);
+  if (!mySectionIndexDirty)
+    mySectionIndex[section->getName()].push_back(section);
+}
 
-  for (std::list<ArConfigSection *>::const_iterator sectionIt = mySections.begin(); 
-       sectionIt != mySections.end(); 
-       sectionIt++)
-  {
-    tempSection = (*sectionIt);
-    if (tempSection == NULL) {
-      ArLog::log(ArLog::Normal,
-                 "ArConfig::findSection(%s) unexpected null section in config",
-                 sectionName);
-      continue;
-    }
+const std::list<ArConfigSection *> *ArConfig::findSections(
+	const char *sectionName) const
+{
+  std::map<std::string, std::list<ArConfigSection *>, 
+	   ArStrCaseCmpOp>::const_iterator indexIt;
 
-    if (ArUtil::strcasecmp(tempSection->getName(), sectionName) == 0)
+  if (mySectionIndexDirty)
+  {
+    mySectionIndex.clear();
+    for (std::list<ArConfigSection *>::const_iterator sectionIt = mySections.begin(); 
+	 sectionIt != mySections.end(); 
+	 sectionIt++)
     {
-      section = tempSection;
+      if ((*sectionIt) == NULL) {
+	ArLog::log(ArLog::Normal,
+		   "ArConfig::findSections(%s) unexpected null section in config",
+		   sectionName);
+	continue;
+      }
+      mySectionIndex[(*sectionIt)->getName()].push_back(*sectionIt);
     }
+    mySectionIndexDirty = false;
   }
-  return section;
+
+  if ((indexIt = mySectionIndex.find(sectionName)) == mySectionIndex.end())
+    return NULL;
+  return &(*indexIt).second;
+}
+
+void ArConfig::noteParamChanged(ArConfigSection *section, 
+				ArConfigArg *param)
+{
+  myChangeVersion++;
+  param->setChangeVersion(myChangeVersion);
+  section->setChangeVersion(myChangeVersion);
+}
+
+/**
+   This is so things that keep what they got from the config by the
+   change version (like ArServerHandlerConfig) know the config's
+   layout changed, not just its values.
+**/
+void ArConfig::noteSectionChanged(ArConfigSection *section)
+{
+  myChangeVersion++;
+  section->setChangeVersion(myChangeVersion);
+}
+
+AREXPORT ArConfigSection *ArConfig::findSection(const char *sectionName) const
+{
+  const std::list<ArConfigSection *> *sections;
+
+  // if there's more than one section with this name it's the last one
+  if ((sections = findSections(sectionName)) == NULL)
+    return NULL;
+  return sections->back();
 
 } // end method findSection
 
@@ -1910,6 +2011,8 @@ AREXPORT ArConfigSection::ArConfigSection(const char *name,
 
   myFlags = new ArArgumentBuilder(512, '|');
   //myFlags->setQuiet(myIsQuiet);
+  myParamIndexDirty = true;
+  myChangeVersion = 0;
 }
 
 
@@ -1917,6 +2020,7 @@ AREXPORT ArConfigSection::ArConfigSection(const ArConfigSection &section)
 {
   myName = section.myName;
   myComment = section.myComment;
+  myChangeVersion = section.myChangeVersion;
   myFlags = new ArArgumentBuilder(512, '|');
   // Since any messages were logged when the first section was created,
   // it doesn't seem necessary to log them again.
@@ -1929,6 +2033,9 @@ AREXPORT ArConfigSection::ArConfigSection(const ArConfigSection &section)
   {
     myParams.push_back(*it);
   }
+  // this is only built if something looks a param up, most copies
+  // never need it
+  myParamIndexDirty = true;
 }
 
 AREXPORT ArConfigSection &ArConfigSection::operator=(const ArConfigSection &section) 
@@ -1938,6 +2045,7 @@ AREXPORT ArConfigSection &ArConfigSection::operator=(const ArConfigSection &sect
     
     myName = section.getName();
     myComment = section.getComment();
+    myChangeVersion = section.myChangeVersion;
     delete myFlags;
     myFlags = new ArArgumentBuilder(512, '|');
     //myFlags->setQuiet(myIsQuiet);
@@ -1949,6 +2057,7 @@ AREXPORT ArConfigSection &ArConfigSection::operator=(const ArConfigSection &sect
     {
       myParams.push_back(*it);
     }
+    myParamIndexDirty = true;
   }
   return *this;
 }
@@ -1962,52 +2071,89 @@ AREXPORT ArConfigSection::~ArConfigSection()
 
 
 
-AREXPORT ArConfigArg *ArConfigSection::findParam(const char *paramName)
+void ArConfigSection::checkParamIndex(void)
 {
-  ArConfigArg *param = NULL;
-  ArConfigArg *tempParam = NULL;
+  if (!myParamIndexDirty)
+    return;
 
+  myParamIndex.clear();
   for (std::list<ArConfigArg>::iterator pIter = myParams.begin(); 
        pIter != myParams.end(); 
        pIter++)
+    myParamIndex[(*pIter).getName()].push_back(pIter);
+  myParamIndexDirty = false;
+}
+
+AREXPORT const std::list<std::list<ArConfigArg>::iterator> *
+ArConfigSection::findParams(const char *paramName)
+{
+  std::map<std::string, std::list<std::list<ArConfigArg>::iterator>, 
+	   ArStrCaseCmpOp>::iterator indexIt;
+
+  if (paramName == NULL)
+    return NULL;
+
+  checkParamIndex();
+  if ((indexIt = myParamIndex.find(paramName)) == myParamIndex.end())
+    return NULL;
+  return &(*indexIt).second;
+}
+
+AREXPORT ArConfigArg *ArConfigSection::findParam(const char *paramName)
+{
+  const std::list<std::list<ArConfigArg>::iterator> *params;
+  std::list<std::list<ArConfigArg>::iterator>::const_reverse_iterator pIter;
+
+  if ((params = findParams(paramName)) == NULL)
+    return NULL;
+
+  // if there's more than one it's the last one, ignoring string holders
+  for (pIter = params->rbegin(); pIter != params->rend(); pIter++)
   {
-    // TODO: Does this do what I'm hoping it does?
-    tempParam = &(*pIter);
-    // ignore string holders 
-    if (tempParam->getType() == ArConfigArg::STRING_HOLDER)
-      continue;
-    if (ArUtil::strcasecmp(tempParam->getName(), paramName) == 0)
-    {
-      param = tempParam;
-    }
+    if ((*(*pIter)).getType() != ArConfigArg::STRING_HOLDER)
+      return &(*(*pIter));
   }
-  return param;
+  return NULL;
 
 } // end method findParam
 
+AREXPORT ArConfigArg *ArConfigSection::addParam(const ArConfigArg &arg)
+{
+  myParams.push_back(arg);
+  if (!myParamIndexDirty)
+    myParamIndex[arg.getName()].push_back(--myParams.end());
+  return &myParams.back();
+}
 
 AREXPORT bool ArConfigSection::remStringHolder(const char *paramName)
 {
-  ArConfigArg *tempParam = NULL;
-  
-  for (std::list<ArConfigArg>::iterator pIter = myParams.begin(); 
-       pIter != myParams.end(); 
-       pIter++)
+  std::map<std::string, std::list<std::list<ArConfigArg>::iterator>, 
+	   ArStrCaseCmpOp>::iterator indexIt;
+  std::list<std::list<ArConfigArg>::iterator>::iterator pIter;
+  bool ret = false;
+
+  if (paramName == NULL || paramName[0] == '\0')
+    return false;
+
+  checkParamIndex();
+  if ((indexIt = myParamIndex.find(paramName)) == myParamIndex.end())
+    return false;
+
+  // pay attention to only string holders
+  for (pIter = (*indexIt).second.begin(); pIter != (*indexIt).second.end(); )
   {
-    // TODO: Does this do what I'm hoping it does?
-    tempParam = &(*pIter);
-    // pay attention to only string holders
-    if (tempParam->getType() != ArConfigArg::STRING_HOLDER ||
-	paramName == NULL || paramName[0] == '\0')
-      continue;
-    if (ArUtil::strcasecmp(tempParam->getName(), paramName) == 0)
+    if ((*(*pIter)).getType() == ArConfigArg::STRING_HOLDER)
     {
-      myParams.erase(pIter);
-      remStringHolder(paramName);
-      return true;
+      myParams.erase(*pIter);
+      pIter = (*indexIt).second.erase(pIter);
+      ret = true;
     }
+    else
+      pIter++;
   }
-  return false;
+  if ((*indexIt).second.empty())
+    myParamIndex.erase(indexIt);
+  return ret;
 }
 
 AREXPORT bool ArConfigSection::hasFlag(const char *flag) const
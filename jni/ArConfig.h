@@ -133,7 +133,8 @@ public:
   /// Adds a callback to be invoked when the configuration is loaded or
   /// reloaded.
   AREXPORT void addProcessFileCB(ArRetFunctor<bool> *functor, 
-				 int priority = 0);
+				 int priority = 0,
+				 const char *sectionName = NULL);
   /// Adds a callback to be invoked when the configuration is loaded
   /// or reloaded.... if you really want errors you should use
   /// addProcessFileWithErrorCB, this is just to catch mistakes
@@ -143,7 +144,8 @@ public:
   /// reloaded, which may also receive error messages
   AREXPORT void addProcessFileWithErrorCB(
 	  ArRetFunctor2<bool, char *, size_t> *functor, 
-	  int priority = 0);
+	  int priority = 0,
+	  const char *sectionName = NULL);
   /// Removes a processedFile callback
   AREXPORT void remProcessFileCB(ArRetFunctor<bool> *functor);
   /// Removes a processedFile callback
@@ -152,7 +154,12 @@ public:
   /// Call the processFileCBs
   AREXPORT bool callProcessFileCallBacks(bool continueOnError,
 					 char *errorBuffer = NULL,
-					 size_t errorBufferLen = 0);
+					 size_t errorBufferLen = 0,
+					 bool onlyChangedSections = false,
+					 unsigned int changedSince = 0);
+  /// Gets the change version, which goes up every time a parsed value changes
+  /// (or params or sections are added or removed)
+  unsigned int getChangeVersion(void) const { return myChangeVersion; }
   /// This parses the argument given (for parser or other use)
   AREXPORT bool parseArgument(ArArgumentBuilder *arg, 
 			      char *errorBuffer = NULL,
@@ -184,6 +191,10 @@ public:
 				    size_t errorBufferLen = 0);
 
   /// Get the sections themselves (use only if you know what to do)
+  /**
+     If you add or remove sections through this list the section
+     index is rebuilt the next time a section is looked up.
+  **/
   AREXPORT std::list<ArConfigSection *> *getSections(void);
 
   /// Find the section with the given name.  
@@ -225,6 +236,15 @@ protected:
 			     bool writePriorities);
 
   void copySectionsToParse(std::list<std::string> *from);
+  /// Adds a section to the end of our list and to the section index
+  void addSection(ArConfigSection *section);
+  /// Gets all the sections with the given name, NULL if there are none
+  const std::list<ArConfigSection *> *findSections(
+	  const char *sectionName) const;
+  /// Notes that parsing changed the value of param in section
+  void noteParamChanged(ArConfigSection *section, ArConfigArg *param);
+  /// Notes that section (its params, comment or flags) changed
+  void noteSectionChanged(ArConfigSection *section);
 
   /**
      This class's job is to make the two functor types largely look
@@ -250,6 +270,15 @@ protected:
       myCallback = functor;
     }
     ~ProcessFileCBType() {}
+    void setSectionName(const char *sectionName)
+    {
+      if (sectionName != NULL)
+	mySectionName = sectionName;
+      else
+	mySectionName = "";
+    }
+    /// The section this only cares about, empty if it cares about all of them
+    const char *getSectionName(void) { return mySectionName.c_str(); }
     bool call(char *errorBuffer, size_t errorBufferLen) 
     { 
       if (myCallbackWithError != NULL) 
@@ -287,6 +316,7 @@ protected:
     protected:
     ArRetFunctor2<bool, char *, size_t> *myCallbackWithError;
     ArRetFunctor<bool> *myCallback;
+    std::string mySectionName;
   };
   void addParserHandlers(void);
 
@@ -316,6 +346,13 @@ protected:
   ArLog::LogLevel myProcessFileCallbacksLogLevel;
   // our list of sections which has in it the argument list for each
   std::list<ArConfigSection *> mySections;
+  // the sections by name (in the order they're in mySections), built
+  // when a lookup needs it if mySectionIndexDirty is set
+  mutable std::map<std::string, std::list<ArConfigSection *>, 
+		   ArStrCaseCmpOp> mySectionIndex;
+  mutable bool mySectionIndexDirty;
+  // bumped every time parsing changes a value
+  unsigned int myChangeVersion;
   // callback for the file parser
   ArRetFunctor3C<bool, ArConfig, ArArgumentBuilder *, char *, size_t> myParserCB;
   // callback for the section in the file parser
@@ -344,21 +381,48 @@ public:
   const char *getComment(void) const { return myComment.c_str(); }
   const char *getFlags(void) const { return myFlags->getFullString(); }
   AREXPORT bool hasFlag(const char *flag) const;
-  std::list<ArConfigArg> *getParams(void) { return &myParams; }
+  /// Gets the params themselves
+  /**
+     If you add or remove params through this list the param index is
+     rebuilt the next time a param is looked up.
+  **/
+  std::list<ArConfigArg> *getParams(void) 
+    { myParamIndexDirty = true; return &myParams; }
   void setName(const char *name) { myName = name; }
   void setComment(const char *comment) { myComment = comment; }
   AREXPORT bool addFlags(const char *flags, bool isQuiet = false);
   AREXPORT bool remFlag(const char *dataFlag);
   /// Finds a parameter item in this section with the given name.  Returns NULL if not found.
   AREXPORT ArConfigArg *findParam(const char *paramName); 
+  /// Finds every param (string holders too) with the given name, in order. Returns NULL if there are none.
+  AREXPORT const std::list<std::list<ArConfigArg>::iterator> *findParams(
+	  const char *paramName);
+  /// Adds a copy of the param to the end of this section, returns the copy
+  AREXPORT ArConfigArg *addParam(const ArConfigArg &arg);
+  /// Gets the last param in this section, NULL if there are none
+  ArConfigArg *getLastParam(void)
+    { return myParams.empty() ? NULL : &myParams.back(); }
   /// Removes a string holder for this param, returns true if it found one
   AREXPORT bool remStringHolder(const char *paramName); 
+  /// Gets the ArConfig change version a param in this section last changed in
+  unsigned int getChangeVersion(void) const { return myChangeVersion; }
+  /// Sets the ArConfig change version a param in this section last changed in
+  void setChangeVersion(unsigned int version) { myChangeVersion = version; }
 
 protected:
+  /// Rebuilds myParamIndex if it is dirty
+  void checkParamIndex(void);
+
   std::string myName;
   std::string myComment;
   ArArgumentBuilder *myFlags;
   std::list<ArConfigArg> myParams;
+  // the params by name (in the order they're in myParams), built when
+  // a lookup needs it if myParamIndexDirty is set
+  std::map<std::string, std::list<std::list<ArConfigArg>::iterator>, 
+	   ArStrCaseCmpOp> myParamIndex;
+  bool myParamIndexDirty;
+  unsigned int myChangeVersion;
 };
 
 #endif // ARCONFIG
@@ -227,7 +227,7 @@ AREXPORT ArConfigArg::ArConfigArg(const char * str, Type type)
   if (type == DESCRIPTION_HOLDER)
   {
     myType = DESCRIPTION_HOLDER;
-    myDescription = str;
+    getWritableDescriptor()->myDescription = str;
   }
   else
   {
@@ -273,12 +273,21 @@ AREXPORT ArConfigArg &ArConfigArg::operator=(const ArConfigArg & arg)
   return *this;
 }
 
+/**
+   The name, description and display hint aren't copied, the copy
+   shares them with arg until one of them changes (which is rare, so
+   copying a config doesn't copy all of its strings).
+**/
 void ArConfigArg::copy(const ArConfigArg &arg)
 {
   clear(false);
-  set(arg.myType, 
-      arg.myName.c_str(), 
-      arg.myDescription.c_str());
+  myType = arg.myType;
+  if ((myDescriptor = arg.myDescriptor) != NULL)
+  {
+    myDescriptor->myRefMutex.lock();
+    myDescriptor->myRefCount++;
+    myDescriptor->myRefMutex.unlock();
+  }
 
   myIntType = arg.myIntType;
   myOwnPointedTo = arg.myOwnPointedTo;
@@ -348,7 +357,7 @@ void ArConfigArg::copy(const ArConfigArg &arg)
   myString = arg.myString;
   myConfigPriority = arg.myConfigPriority;
   myIgnoreBounds = arg.myIgnoreBounds;
-  myDisplayHint = arg.myDisplayHint;
+  myChangeVersion = arg.myChangeVersion;
 }
 
 AREXPORT ArConfigArg::~ArConfigArg()
@@ -367,9 +376,11 @@ void ArConfigArg::clear(bool initial)
     myIntUnsignedCharPointer = NULL;
     myDoublePointer = NULL;
     myBoolPointer = NULL;
+    myDescriptor = NULL;
   }
 
-  set(INVALID, "", "");
+  myType = INVALID;
+  releaseDescriptor();
 
   myIntType = INT_NOT;
   if (myOwnPointedTo && myIntPointer != NULL)
@@ -402,8 +413,8 @@ void ArConfigArg::clear(bool initial)
   myGetFunctor = NULL;  
   myConfigPriority = ArPriority::NORMAL;
   myIgnoreBounds = false;
-  myDisplayHint = "";
   myValueSet = false;
+  myChangeVersion = 0;
   myOwnPointedTo = false;
 }
 
@@ -411,9 +422,54 @@ void ArConfigArg::set(ArConfigArg::Type type,
                       const char *name,
                       const char *description)
 {
+  Descriptor *descriptor;
+
   myType = type;
-  myName = name;
-  myDescription = description;
+  if (myDescriptor == NULL && name[0] == '\0' && description[0] == '\0')
+    return;
+  descriptor = getWritableDescriptor();
+  descriptor->myName = name;
+  descriptor->myDescription = description;
+}
+
+ArConfigArg::Descriptor *ArConfigArg::getWritableDescriptor(void)
+{
+  Descriptor *descriptor;
+
+  if (myDescriptor == NULL)
+  {
+    myDescriptor = new Descriptor;
+    return myDescriptor;
+  }
+  myDescriptor->myRefMutex.lock();
+  if (myDescriptor->myRefCount == 1)
+  {
+    myDescriptor->myRefMutex.unlock();
+    return myDescriptor;
+  }
+  myDescriptor->myRefMutex.unlock();
+  // copy it while we still hold our reference to it
+  descriptor = new Descriptor;
+  descriptor->myName = myDescriptor->myName;
+  descriptor->myDescription = myDescriptor->myDescription;
+  descriptor->myDisplayHint = myDescriptor->myDisplayHint;
+  releaseDescriptor();
+  myDescriptor = descriptor;
+  return myDescriptor;
+}
+
+void ArConfigArg::releaseDescriptor(void)
+{
+  int refCount;
+
+  if (myDescriptor == NULL)
+    return;
+  myDescriptor->myRefMutex.lock();
+  refCount = --myDescriptor->myRefCount;
+  myDescriptor->myRefMutex.unlock();
+  if (refCount == 0)
+    delete myDescriptor;
+  myDescriptor = NULL;
 }
 
 /**
@@ -449,12 +505,16 @@ AREXPORT double ArConfigArg::getMaxDouble(void) const
 
 AREXPORT const char *ArConfigArg::getName(void) const
 {
-  return myName.c_str();
+  if (myDescriptor == NULL)
+    return "";
+  return myDescriptor->myName.c_str();
 }
 
 AREXPORT const char *ArConfigArg::getDescription(void) const
 {
-  return myDescription.c_str();
+  if (myDescriptor == NULL)
+    return "";
+  return myDescriptor->myDescription.c_str();
 }
 
 AREXPORT int ArConfigArg::getInt(void) const
@@ -767,8 +827,8 @@ AREXPORT void ArConfigArg::setConfigPriority(ArPriority::Priority priority)
 
 AREXPORT const char *ArConfigArg::getDisplayHint() const
 {
-  if (myDisplayHint.length() > 0) {
-    return myDisplayHint.c_str();
+  if (myDescriptor != NULL && myDescriptor->myDisplayHint.length() > 0) {
+    return myDescriptor->myDisplayHint.c_str();
   }
   else {
     return NULL;
@@ -827,10 +887,10 @@ AREXPORT const char *ArConfigArg::getDisplayHint() const
 AREXPORT void ArConfigArg::setDisplayHint(const char *hintText)
 {
   if (hintText != NULL) {
-    myDisplayHint = hintText;
+    getWritableDescriptor()->myDisplayHint = hintText;
   }
-  else {
-    myDisplayHint = "";
+  else if (myDescriptor != NULL) {
+    getWritableDescriptor()->myDisplayHint = "";
   }
 } // end method setDisplayHint
 
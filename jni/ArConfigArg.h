@@ -215,6 +215,11 @@ public:
   
   /// Tells the configArg that the value hasn't been set
   void clearValueSet(void) { myValueSet = false; }
+
+  /// Gets the ArConfig change version this value last changed in (0 if never)
+  unsigned int getChangeVersion(void) const { return myChangeVersion; }
+  /// Sets the ArConfig change version this value last changed in
+  void setChangeVersion(unsigned int version) { myChangeVersion = version; }
   
 private:
   /// Internal helper function
@@ -225,6 +230,22 @@ private:
            const char *name,
            const char *description);
 
+  /// The parts of an arg that don't change once it's made, shared by copies
+  class Descriptor
+  {
+  public:
+    Descriptor() { myRefCount = 1; }
+    std::string myName;
+    std::string myDescription;
+    std::string myDisplayHint;
+    ArMutex myRefMutex;
+    int myRefCount;
+  };
+  // gets the descriptor to change, making our own if it's shared
+  Descriptor *getWritableDescriptor(void);
+  // lets go of the descriptor (deleting it if we were the last)
+  void releaseDescriptor(void);
+
 protected:
   enum IntType {
     INT_NOT, ///< Not an int
@@ -235,8 +256,8 @@ protected:
   };
   
   ArConfigArg::Type myType;
-  std::string myName;
-  std::string myDescription;
+  // NULL when the name, description and display hint are all empty
+  Descriptor *myDescriptor;
   bool myOwnPointedTo;
   int *myIntPointer;
   short *myIntShortPointer;
@@ -255,8 +276,8 @@ protected:
   bool myIgnoreBounds;
   ArRetFunctor1<bool, ArArgumentBuilder *> *mySetFunctor;
   ArRetFunctor<const std::list<ArArgumentBuilder *> *> *myGetFunctor;
-  std::string myDisplayHint;
   bool myValueSet;
+  unsigned int myChangeVersion;
 };
 
 #endif // ARARGUMENT_H
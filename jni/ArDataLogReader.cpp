@@ -0,0 +1,400 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "ArExport.h"
+#include "ariaOSDef.h"
+#include "ArDataLogReader.h"
+#include "ArLog.h"
+#include "ariaUtil.h"
+#include <string.h>
+#include <zlib.h>
+
+AREXPORT ArDataLogReader::ArDataLogReader()
+{
+  myFile = NULL;
+  myColumnsChanged = false;
+  myHaveColumns = false;
+  myNumRows = 0;
+}
+
+AREXPORT ArDataLogReader::~ArDataLogReader()
+{
+  close();
+}
+
+AREXPORT bool ArDataLogReader::open(const char *fileName)
+{
+  char magic[8];
+  ArTypes::UByte4 version;
+
+  close();
+  myFileName = fileName;
+  if ((myFile = ArUtil::fopen(fileName, "rb")) == NULL)
+  {
+    ArLog::log(ArLog::Terse, "ArDataLogReader: Could not open %s", 
+	       fileName);
+    return false;
+  }
+  if (fread(magic, 8, 1, myFile) != 1 || 
+      strncmp(magic, getMagic(), 8) != 0 ||
+      fread(&version, 4, 1, myFile) != 1 || version != VERSION)
+  {
+    ArLog::log(ArLog::Terse, 
+	       "ArDataLogReader: %s is not a columnar data log (version %d)", 
+	       fileName, VERSION);
+    close();
+    return false;
+  }
+  return true;
+}
+
+AREXPORT void ArDataLogReader::close(void)
+{
+  if (myFile != NULL)
+    fclose(myFile);
+  myFile = NULL;
+  myColumns.clear();
+  myColumnsChanged = false;
+  myHaveColumns = false;
+  myNumRows = 0;
+  myInts.clear();
+  myStrings.clear();
+}
+
+/**
+   @return true if a block was read, false if the log is done (or is
+   cut off or corrupt, which is logged)
+**/
+AREXPORT bool ArDataLogReader::readBlock(void)
+{
+  char type;
+  ArTypes::UByte flags;
+  ArTypes::UByte4 numRows;
+  ArTypes::UByte4 len;
+  ArTypes::UByte4 rawLen;
+  uLongf inflatedLen;
+  const char *data;
+
+  if (myFile == NULL)
+    return false;
+
+  myColumnsChanged = false;
+  myNumRows = 0;
+  while (fread(&type, 1, 1, myFile) == 1)
+  {
+    if (type == RECORD_HEADER)
+    {
+      if (!readHeader())
+	break;
+      myColumnsChanged = true;
+      continue;
+    }
+    if (type != RECORD_BLOCK || !myHaveColumns ||
+	fread(&flags, 1, 1, myFile) != 1 || 
+	fread(&numRows, 4, 1, myFile) != 1 ||
+	fread(&len, 4, 1, myFile) != 1 || len > MAX_BLOCK_LENGTH)
+      break;
+    myBuf.resize(len);
+    if (len > 0 && fread(&myBuf[0], len, 1, myFile) != 1)
+      break;
+    data = myBuf.data();
+    if (flags & BLOCK_DEFLATED)
+    {
+      if (len < 4)
+	break;
+      memcpy(&rawLen, data, 4);
+      if (rawLen > MAX_BLOCK_LENGTH)
+	break;
+      myInflateBuf.resize(rawLen);
+      inflatedLen = rawLen;
+      if (rawLen > 0 && 
+	  (uncompress((Bytef *)&myInflateBuf[0], &inflatedLen, 
+		      (const Bytef *)data + 4, len - 4) != Z_OK ||
+	   inflatedLen != rawLen))
+	break;
+      data = myInflateBuf.data();
+      len = rawLen;
+    }
+    // every row takes at least a byte in every column, so more rows
+    // than that means it's corrupt (and would resize the columns to
+    // however many it says)
+    if (myColumns.size() > 0 && numRows > len / myColumns.size())
+      break;
+    myNumRows = numRows;
+    if (!decodeBlock(data, len, (flags & BLOCK_COMPRESSED) != 0))
+    {
+      myNumRows = 0;
+      break;
+    }
+    return true;
+  }
+  if (!feof(myFile))
+    ArLog::log(ArLog::Normal, "ArDataLogReader: %s is cut off or corrupt", 
+	       myFileName.c_str());
+  return false;
+}
+
+bool ArDataLogReader::readHeader(void)
+{
+  ArTypes::UByte2 numColumns;
+  ArTypes::UByte2 i;
+  ArTypes::UByte type;
+  ArTypes::UByte param;
+  ArTypes::UByte2 nameLen;
+  std::string name;
+
+  if (fread(&numColumns, 2, 1, myFile) != 1)
+    return false;
+  myColumns.clear();
+  for (i = 0; i < numColumns; i++)
+  {
+    if (fread(&type, 1, 1, myFile) != 1 || 
+	fread(&param, 1, 1, myFile) != 1 ||
+	fread(&nameLen, 2, 1, myFile) != 1 || type > COLUMN_STRING)
+      return false;
+    name.resize(nameLen);
+    if (nameLen > 0 && fread(&name[0], nameLen, 1, myFile) != 1)
+      return false;
+    myColumns.push_back(Column(name.c_str(), (ColumnType)type, param));
+  }
+  myInts.resize(myColumns.size());
+  myStrings.resize(myColumns.size());
+  myHaveColumns = true;
+  return true;
+}
+
+bool ArDataLogReader::readVarint(const char *buf, size_t len, size_t *pos,
+				 ArTypes::UByte4 *val)
+{
+  int shift;
+  unsigned char byte;
+
+  *val = 0;
+  for (shift = 0; shift < 35; shift += 7)
+  {
+    if (*pos >= len)
+      return false;
+    byte = buf[*pos];
+    (*pos)++;
+    *val |= (ArTypes::UByte4)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+/**
+   Each column is all of its rows, one column after the other.  When
+   compressed, ints are each the zigzag varint of the difference from
+   the row before (the first from 0), and strings are a varint that's
+   0 if the string is the same as the row before or its length plus
+   one followed by it.  Otherwise ints are 4 bytes each and strings are
+   a varint length followed by the string.
+**/
+bool ArDataLogReader::decodeBlock(const char *buf, size_t len, 
+				  bool compressed)
+{
+  size_t pos = 0;
+  size_t col;
+  size_t row;
+  ArTypes::UByte4 val;
+  ArTypes::UByte4 prev;
+  std::vector<ArTypes::Byte4> *ints;
+  std::vector<std::string> *strings;
+
+  for (col = 0; col < myColumns.size(); col++)
+  {
+    ints = &myInts[col];
+    strings = &myStrings[col];
+    ints->clear();
+    strings->resize(myNumRows);
+    if (myColumns[col].getType() == COLUMN_STRING)
+    {
+      for (row = 0; row < myNumRows; row++)
+      {
+	if (!readVarint(buf, len, &pos, &val))
+	  return false;
+	if (compressed && val == 0)
+	{
+	  (*strings)[row] = (row > 0) ? (*strings)[row - 1] : "";
+	  continue;
+	}
+	if (compressed)
+	  val--;
+	if (pos + val > len)
+	  return false;
+	(*strings)[row].assign(buf + pos, val);
+	pos += val;
+      }
+      continue;
+    }
+    strings->clear();
+    for (prev = 0, row = 0; row < myNumRows; row++)
+    {
+      if (!compressed)
+      {
+	if (pos + 4 > len)
+	  return false;
+	memcpy(&val, buf + pos, 4);
+	pos += 4;
+	ints->push_back(val);
+	continue;
+      }
+      if (!readVarint(buf, len, &pos, &val))
+	return false;
+      // undo the zigzag, then the delta (wrapping, like it was done)
+      val = (val >> 1) ^ (0 - (val & 1));
+      prev += val;
+      ints->push_back(prev);
+    }
+  }
+  return pos == len;
+}
+
+AREXPORT ArTypes::Byte4 ArDataLogReader::getInt(size_t column, 
+						size_t row) const
+{
+  if (column >= myInts.size() || row >= myInts[column].size())
+    return 0;
+  return myInts[column][row];
+}
+
+AREXPORT const char *ArDataLogReader::getString(size_t column, 
+						size_t row) const
+{
+  if (column >= myStrings.size() || row >= myStrings[column].size())
+    return "";
+  return myStrings[column][row].c_str();
+}
+
+AREXPORT void ArDataLogReader::getText(size_t column, size_t row, 
+				       std::string *text) const
+{
+  char buf[64];
+  ArTypes::Byte4 val;
+  double scaled;
+  int i;
+
+  text->clear();
+  if (column >= myColumns.size())
+    return;
+  switch (myColumns[column].getType())
+  {
+  case COLUMN_STRING:
+    *text = getString(column, row);
+    return;
+  case COLUMN_UINT:
+    snprintf(buf, sizeof(buf), "%u", (ArTypes::UByte4)getInt(column, row));
+    break;
+  case COLUMN_BITS:
+    val = getInt(column, row);
+    for (i = 0; i < myColumns[column].getParam(); i++)
+      *text += (val & (1 << i)) ? '1' : '0';
+    return;
+  case COLUMN_INT:
+  default:
+    val = getInt(column, row);
+    if (myColumns[column].getParam() == 0)
+    {
+      snprintf(buf, sizeof(buf), "%d", val);
+      break;
+    }
+    for (scaled = val, i = 0; i < myColumns[column].getParam(); i++)
+      scaled /= 10;
+    snprintf(buf, sizeof(buf), "%.*f", myColumns[column].getParam(), scaled);
+    break;
+  }
+  buf[sizeof(buf) - 1] = '\0';
+  *text = buf;
+}
+
+/**
+   The first line is the names of the columns, and the names are
+   written again whenever they change in the log.  Values are written
+   like the text data log writes them, strings are quoted if they need
+   to be.
+**/
+AREXPORT bool ArDataLogReader::exportCSV(const char *fileName, 
+					 const char *csvFileName)
+{
+  ArDataLogReader reader;
+  FILE *out;
+  size_t col;
+  size_t row;
+  std::string text;
+  std::string line;
+  size_t i;
+
+  if (!reader.open(fileName))
+    return false;
+  if ((out = ArUtil::fopen(csvFileName, "w")) == NULL)
+  {
+    ArLog::log(ArLog::Terse, "ArDataLogReader: Could not open %s", 
+	       csvFileName);
+    return false;
+  }
+
+  while (reader.readBlock())
+  {
+    if (reader.columnsChanged())
+    {
+      line.clear();
+      for (col = 0; col < reader.getColumns()->size(); col++)
+      {
+	if (col > 0)
+	  line += ",";
+	line += (*reader.getColumns())[col].getName();
+      }
+      line += "\n";
+      fwrite(line.data(), 1, line.size(), out);
+    }
+    for (row = 0; row < reader.getNumRows(); row++)
+    {
+      line.clear();
+      for (col = 0; col < reader.getColumns()->size(); col++)
+      {
+	if (col > 0)
+	  line += ",";
+	reader.getText(col, row, &text);
+	if (text.find_first_of(",\"\r\n") == std::string::npos)
+	{
+	  line += text;
+	  continue;
+	}
+	line += "\"";
+	for (i = 0; i < text.size(); i++)
+	{
+	  if (text[i] == '"')
+	    line += "\"";
+	  line += text[i];
+	}
+	line += "\"";
+      }
+      line += "\n";
+      fwrite(line.data(), 1, line.size(), out);
+    }
+  }
+  fclose(out);
+  return feof(reader.myFile) != 0;
+}
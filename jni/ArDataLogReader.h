@@ -0,0 +1,155 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#ifndef ARDATALOGREADER_H
+#define ARDATALOGREADER_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "ariaTypedefs.h"
+
+/// Reads the columnar logs ArDataLogger writes
+/**
+   When DataLogColumnar is set in its config, ArDataLogger writes its
+   log as blocks of rows that are stored a column at a time (and
+   unless DataLogColumnarCompressed is turned off each column is
+   delta encoded, so values that don't change much, like most of what
+   gets logged, take a byte or so a row, and then the block is deflated
+   with zlib).  This reads those logs back
+   a block at a time, and exportCSV() turns a whole log into a CSV
+   file.
+
+   The file starts with a magic and version, then has header records
+   (which list the columns) and block records (which have the rows).
+   A new header record is written whenever the data logger's config
+   changes, so check columnsChanged() after each readBlock().  Values
+   are in the byte order of the machine that wrote the log.
+
+   @code
+   ArDataLogReader reader;
+   reader.open("dataLog.dlc");
+   while (reader.readBlock())
+     for (size_t row = 0; row < reader.getNumRows(); row++)
+       printf("%u\n", (unsigned int)reader.getInt(0, row));
+   @endcode
+**/
+class ArDataLogReader
+{
+public:
+  /// The types of columns
+  enum ColumnType
+  {
+    COLUMN_INT, ///< An int, param is how many decimal places it was scaled by
+    COLUMN_UINT, ///< An unsigned int (like the time)
+    COLUMN_BITS, ///< Bits (written 1s and 0s, low bit first), param is how many
+    COLUMN_STRING ///< A string
+  };
+  /// A column in the log
+  class Column
+  {
+  public:
+    /// Constructor
+    Column(const char *name = "", ColumnType type = COLUMN_INT, 
+	   int param = 0) : myName(name), myType(type), myParam(param) {}
+    /// Gets the name of the column
+    const char *getName(void) const { return myName.c_str(); }
+    /// Gets the type of the column
+    ColumnType getType(void) const { return myType; }
+    /// Gets the decimal places (for ints) or number of bits (for bits)
+    int getParam(void) const { return myParam; }
+  protected:
+    std::string myName;
+    ColumnType myType;
+    int myParam;
+  };
+  /// The records in the file
+  enum Record
+  {
+    RECORD_HEADER = 'H', ///< The columns that the blocks after it have
+    RECORD_BLOCK = 'B' ///< A block of rows
+  };
+  /// Flags on a block
+  enum BlockFlags
+  {
+    BLOCK_COMPRESSED = 1, ///< Values are delta and varint encoded
+    BLOCK_DEFLATED = 2 ///< The data is deflated, after its length before
+  };
+  /// The most data a block can have (deflated or not), more is corrupt
+  enum { MAX_BLOCK_LENGTH = 64 * 1024 * 1024 };
+  /// The version of the file format
+  enum { VERSION = 1 };
+  /// The magic at the start of the file
+  static const char *getMagic(void) { return "ARIADLGC"; }
+
+  /// Constructor
+  AREXPORT ArDataLogReader();
+  /// Destructor
+  AREXPORT virtual ~ArDataLogReader();
+  /// Opens a log
+  AREXPORT bool open(const char *fileName);
+  /// Closes the log
+  AREXPORT void close(void);
+  /// Reads the next block, false at the end of the log (or if it's corrupt)
+  AREXPORT bool readBlock(void);
+  /// Gets whether the last readBlock() had a new header before it
+  bool columnsChanged(void) const { return myColumnsChanged; }
+  /// Gets the columns of the block that was read last
+  const std::vector<Column> *getColumns(void) const { return &myColumns; }
+  /// Gets the number of rows in the block that was read last
+  size_t getNumRows(void) const { return myNumRows; }
+  /// Gets a value from an int, uint or bits column
+  AREXPORT ArTypes::Byte4 getInt(size_t column, size_t row) const;
+  /// Gets a value from a string column
+  AREXPORT const char *getString(size_t column, size_t row) const;
+  /// Gets a value as text (the way the text data log writes it)
+  AREXPORT void getText(size_t column, size_t row, std::string *text) const;
+
+  /// Writes a whole columnar log out as CSV
+  AREXPORT static bool exportCSV(const char *fileName, 
+				 const char *csvFileName);
+protected:
+  /// Reads a header record (after its type)
+  bool readHeader(void);
+  /// Decodes the columns of a block
+  bool decodeBlock(const char *buf, size_t len, bool compressed);
+  /// Reads an unsigned varint out of a buffer
+  static bool readVarint(const char *buf, size_t len, size_t *pos,
+			 ArTypes::UByte4 *val);
+
+  FILE *myFile;
+  std::string myFileName;
+  std::vector<Column> myColumns;
+  bool myColumnsChanged;
+  bool myHaveColumns;
+  size_t myNumRows;
+  // the values for each column (only one of these is used per column)
+  std::vector<std::vector<ArTypes::Byte4> > myInts;
+  std::vector<std::vector<std::string> > myStrings;
+  // the block before it's decoded (and inflated)
+  std::string myBuf;
+  std::string myInflateBuf;
+};
+
+#endif // ARDATALOGREADER_H
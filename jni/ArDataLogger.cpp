@@ -28,6 +28,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArConfig.h"
 #include "ArDataLogger.h"
 #include <vector>
+#include <zlib.h>
 
 /**
    @param robot the robot to log information from
@@ -57,6 +58,12 @@ AREXPORT ArDataLogger::ArDataLogger(ArRobot *robot, const char *fileName) :
   myAddToConfigAtConnect = false;
   myAddedToConfig = false;
   myConfigLogging = false;
+  myConfigColumnar = false;
+  myConfigColumnarCompressed = true;
+  myColumnar = false;
+  myColumnarCompressed = false;
+  myColumnarFile = NULL;
+  myMaxMaxLength = 0;
   myConfigLogInterval = 0;
   myConfigFileName[0] = '\0';
   myOpenedFileName[0] = '\0';
@@ -92,7 +99,14 @@ AREXPORT ArDataLogger::ArDataLogger(ArRobot *robot, const char *fileName) :
 
 AREXPORT ArDataLogger::~ArDataLogger(void)
 {
+  ColumnarFile *closed;
 
+  myRobot->remUserTask(&myUserTaskCB);
+  myMutex.lock();
+  closed = closeFile();
+  myMutex.unlock();
+  if (closed != NULL)
+    delete closed;
 }
 
 AREXPORT void ArDataLogger::addToConfig(ArConfig *config)
@@ -132,6 +146,13 @@ AREXPORT void ArDataLogger::addToConfig(ArConfig *config)
 	    ArConfigArg("DataLogFileName", myConfigFileName, 
 			"File to log data into", sizeof(myConfigFileName)),
 	    section.c_str(), ArPriority::NORMAL);
+
+  myConfig->addParam(
+	  ArConfigArg("DataLogColumnar", &myConfigColumnar, "True to log data in binary columns instead of text, which is much smaller and quicker to write (ArDataLogReader reads these and can turn them into CSV), use a different file name than text logs"),
+	  section.c_str(), ArPriority::DETAILED);
+  myConfig->addParam(
+	  ArConfigArg("DataLogColumnarCompressed", &myConfigColumnarCompressed, "True to delta encode and deflate the columns in columnar logs, which makes them a lot smaller"),
+	  section.c_str(), ArPriority::DETAILED);
   
   for (i = 0; i < myStringsCount; i++)
   {
@@ -226,7 +247,8 @@ AREXPORT void ArDataLogger::addToConfig(ArConfig *config)
 	    section.c_str(), ArPriority::DETAILED);
   }
   myProcessFileCB.setName("ArDataLogger");
-  myConfig->addProcessFileWithErrorCB(&myProcessFileCB, 100);
+  myConfig->addProcessFileWithErrorCB(&myProcessFileCB, 100, 
+				      section.c_str());
 }
 
 AREXPORT void ArDataLogger::connectCallback(void)
@@ -316,11 +338,21 @@ AREXPORT bool ArDataLogger::processFile(char *errorBuffer,
   // file name or if we're disabled close the old one
   if ((strcmp(myOpenedFileName, myConfigFileName) != 0 && myFile != NULL && 
        myPermanentFileName.size() == 0) ||
-       (myFile != NULL && !myConfigLogging))
+      (myFile != NULL && !myConfigLogging) ||
+      (myFile != NULL && (myColumnar != myConfigColumnar || 
+			  myColumnarCompressed != myConfigColumnarCompressed)))
   {
+    ColumnarFile *closed;
     ArLog::log(ArLog::Normal, "Closed data log file '%s'", myOpenedFileName);
-    fclose(myFile);
-    myFile = NULL;
+    // a columnar file waits for its writer to write everything when
+    // it's deleted, so that's done with myMutex unlocked so the robot
+    // task isn't held up by the disk
+    if ((closed = closeFile()) != NULL)
+    {
+      myMutex.unlock();
+      delete closed;
+      myMutex.lock();
+    }
   }
   // try to open the file
   if (myConfigLogging && myFile == NULL)
@@ -334,7 +366,7 @@ AREXPORT bool ArDataLogger::processFile(char *errorBuffer,
     std::string fileName;
     if (myPermanentFileName.size() > 0)
     {
-      if ((myFile = ArUtil::fopen(myPermanentFileName.c_str(), "a")) != NULL)
+      if (openFile(myPermanentFileName.c_str(), "a"))
       {
 	ArLog::log(ArLog::Normal, "Opened data log file '%s'", 
 		   myPermanentFileName.c_str());
@@ -350,7 +382,7 @@ AREXPORT bool ArDataLogger::processFile(char *errorBuffer,
     else
     {
       // if we couldn't open it fail
-      if ((myFile = ArUtil::fopen(myConfigFileName, "w")) != NULL)
+      if (openFile(myConfigFileName, "w"))
       {
 	strcpy(myOpenedFileName, myConfigFileName);
 	ArLog::log(ArLog::Normal, "Opened data log file '%s'", 
@@ -373,6 +405,18 @@ AREXPORT bool ArDataLogger::processFile(char *errorBuffer,
     return true;
   }
   int i;
+  // columnar logs get a header record (after the rows from before)
+  if (myColumnar)
+  {
+    ColumnBlock *block;
+    buildColumns();
+    queueFillingBlock();
+    block = getFillingBlock(true);
+    encodeHeader(&myColumns, &block->myHeader);
+    queueFillingBlock();
+    myMutex.unlock();
+    return true;
+  }
   // if we could then dump in the header
   fprintf(myFile, ";%12s", "Time");
   std::map<std::string, bool *, ArStrCaseCmpOp>::iterator it;
@@ -458,6 +502,14 @@ AREXPORT void ArDataLogger::userTask(void)
   int j;
   int val;
 
+  if (myColumnar)
+  {
+    addColumnarRow();
+    myLastLogged.setToNow();
+    myMutex.unlock();
+    return;
+  }
+
   fprintf(myFile, "%ld", time(NULL));
 
   char *buf;
@@ -612,3 +664,507 @@ AREXPORT void ArDataLogger::addString(
     processFile(NULL, 0);
 }
 
+/**
+   Columnar logs are opened in binary and get the magic at their start
+   (unless we're appending to one that already has it), and the writer
+   thread is started for them.
+**/
+bool ArDataLogger::openFile(const char *fileName, const char *mode)
+{
+  char magic[8];
+  ArTypes::UByte4 version = ArDataLogReader::VERSION;
+  bool append = (mode[0] == 'a');
+
+  myColumnar = myConfigColumnar;
+  myColumnarCompressed = myConfigColumnarCompressed;
+  if (!myColumnar)
+    return (myFile = ArUtil::fopen(fileName, mode)) != NULL;
+
+  if ((myFile = ArUtil::fopen(fileName, append ? "ab+" : "wb")) == NULL)
+    return false;
+  fseek(myFile, 0, SEEK_END);
+  if (ftell(myFile) > 0)
+  {
+    fseek(myFile, 0, SEEK_SET);
+    if (fread(magic, 8, 1, myFile) != 1 || 
+	strncmp(magic, ArDataLogReader::getMagic(), 8) != 0)
+    {
+      ArLog::log(ArLog::Normal, 
+		 "ArDataLogger: '%s' isn't a columnar data log, won't add columns to it", 
+		 fileName);
+      fclose(myFile);
+      myFile = NULL;
+      return false;
+    }
+    fseek(myFile, 0, SEEK_END);
+  }
+  else
+  {
+    fwrite(ArDataLogReader::getMagic(), 1, 8, myFile);
+    fwrite(&version, 4, 1, myFile);
+    fflush(myFile);
+  }
+  myColumnarFile = new ColumnarFile(myFile, myColumnarCompressed);
+  return true;
+}
+
+/**
+   Text logs are just closed.  For columnar logs this hands off the
+   rows that haven't been yet, and then the columnar file is taken off
+   and returned, so that it can be deleted (which waits for the writer
+   to write everything and then closes the file) once myMutex is
+   unlocked.
+
+   @return the columnar file to delete, or NULL if there isn't one
+**/
+ArDataLogger::ColumnarFile *ArDataLogger::closeFile(void)
+{
+  ColumnarFile *closed = myColumnarFile;
+
+  if (myFile == NULL)
+    return NULL;
+  if (closed != NULL)
+    queueFillingBlock();
+  else
+    fclose(myFile);
+  myFile = NULL;
+  myColumnarFile = NULL;
+  return closed;
+}
+
+/**
+   These have to be in the same order addColumnarRow adds the values.
+**/
+void ArDataLogger::buildColumns(void)
+{
+  char name[512];
+  int i;
+
+  myColumns.clear();
+  myColumns.push_back(
+	  ArDataLogReader::Column("Time", ArDataLogReader::COLUMN_UINT));
+  for (i = 0; i < myStringsCount; i++)
+    if (*(myStringsEnabled[i]))
+      myColumns.push_back(
+	      ArDataLogReader::Column(myStrings[i]->getName(), 
+				      ArDataLogReader::COLUMN_STRING));
+  if (myLogVoltage)
+    myColumns.push_back(ArDataLogReader::Column("Volt", 
+				      ArDataLogReader::COLUMN_INT, 2));
+  if (myLogChargeState)
+  {
+    myColumns.push_back(ArDataLogReader::Column("ChargeStateName", 
+				      ArDataLogReader::COLUMN_STRING));
+    myColumns.push_back(ArDataLogReader::Column("csNum"));
+  }
+  if (myLogPose)
+  {
+    myColumns.push_back(ArDataLogReader::Column("X"));
+    myColumns.push_back(ArDataLogReader::Column("Y"));
+    myColumns.push_back(ArDataLogReader::Column("Th"));
+  }
+  if (myLogEncoderPose)
+  {
+    myColumns.push_back(ArDataLogReader::Column("encX"));
+    myColumns.push_back(ArDataLogReader::Column("encY"));
+    myColumns.push_back(ArDataLogReader::Column("encTh"));
+  }
+  if (myLogCorrectedEncoderPose)
+  {
+    myColumns.push_back(ArDataLogReader::Column("corrEncX"));
+    myColumns.push_back(ArDataLogReader::Column("corrEncY"));
+    myColumns.push_back(ArDataLogReader::Column("corrEncTh"));
+  }
+  if (myLogEncoders)
+  {
+    myColumns.push_back(ArDataLogReader::Column("encL"));
+    myColumns.push_back(ArDataLogReader::Column("encR"));
+    myRobot->requestEncoderPackets();
+  }
+  if (myLogLeftVel)
+    myColumns.push_back(ArDataLogReader::Column("LeftV"));
+  if (myLogRightVel)
+    myColumns.push_back(ArDataLogReader::Column("RightV"));
+  if (myLogTransVel)
+    myColumns.push_back(ArDataLogReader::Column("TransV"));
+  if (myLogRotVel)
+    myColumns.push_back(ArDataLogReader::Column("RotV"));
+  if (myLogLeftStalled)
+    myColumns.push_back(ArDataLogReader::Column("LStall"));
+  if (myLogRightStalled)
+    myColumns.push_back(ArDataLogReader::Column("RStall"));
+  if (myLogStallBits)
+    myColumns.push_back(ArDataLogReader::Column("StllBts", 
+				      ArDataLogReader::COLUMN_BITS, 16));
+  if (myLogFlags)
+    myColumns.push_back(ArDataLogReader::Column("Flags", 
+				      ArDataLogReader::COLUMN_BITS, 16));
+  if (myLogFaultFlags)
+    myColumns.push_back(ArDataLogReader::Column("Fault Flags", 
+				      ArDataLogReader::COLUMN_BITS, 16));
+  for (i = 0; i < myAnalogCount; i++)
+  {
+    if (!myAnalogEnabled[i])
+      continue;
+    snprintf(name, sizeof(name), "An%d", i);
+    myColumns.push_back(ArDataLogReader::Column(name));
+  }
+  for (i = 0; i < myAnalogVoltageCount; i++)
+  {
+    if (!myAnalogVoltageEnabled[i])
+      continue;
+    snprintf(name, sizeof(name), "AnV%d", i);
+    myColumns.push_back(ArDataLogReader::Column(name, 
+				      ArDataLogReader::COLUMN_INT, 2));
+  }
+  for (i = 0; i < myDigInCount; i++)
+  {
+    if (!myDigInEnabled[i])
+      continue;
+    snprintf(name, sizeof(name), "DigIn%d", i);
+    myColumns.push_back(ArDataLogReader::Column(name, 
+				      ArDataLogReader::COLUMN_BITS, 8));
+  }
+  for (i = 0; i < myDigOutCount; i++)
+  {
+    if (!myDigOutEnabled[i])
+      continue;
+    snprintf(name, sizeof(name), "DigOut%d", i);
+    myColumns.push_back(ArDataLogReader::Column(name, 
+				      ArDataLogReader::COLUMN_BITS, 8));
+  }
+}
+
+/**
+   This only copies values into the block (the ints and strings keep
+   their space from the last time the block was used), the writer
+   thread does the rest.  Values that the text log writes with decimals are scaled so
+   they can be ints.
+**/
+void ArDataLogger::addColumnarRow(void)
+{
+  ColumnBlock *block;
+  ArStringInfoHolder *infoHolder;
+  int i;
+
+  // the writer's fallen behind and has no block for us, so the row
+  // gets dropped (the writer counts it)
+  if ((block = getFillingBlock()) == NULL)
+    return;
+
+  block->myInts.push_back(time(NULL));
+  if (myStringBuf.size() < (size_t)myMaxMaxLength + 1)
+    myStringBuf.resize(myMaxMaxLength + 1);
+  for (i = 0; i < myStringsCount; i++)
+  {
+    if (*(myStringsEnabled[i]))
+    {
+      infoHolder = myStrings[i];
+      myStringBuf[0] = '\0';
+      infoHolder->getFunctor()->invoke(&myStringBuf[0], 
+				       infoHolder->getMaxLength());
+      myStringBuf[myStringBuf.size() - 1] = '\0';
+      block->addString(&myStringBuf[0]);
+    }
+  }
+  if (myLogVoltage)
+    block->myInts.push_back(
+	    ArMath::roundInt(myRobot->getRealBatteryVoltageNow() * 100));
+  if (myLogChargeState)
+  {  
+    ArRobot::ChargeState chargeState = myRobot->getChargeState();
+    if (chargeState == ArRobot::CHARGING_UNKNOWN)
+      block->addString("Unknowable");
+    else if (chargeState == ArRobot::CHARGING_NOT)
+      block->addString("Not");
+    else if (chargeState == ArRobot::CHARGING_BULK)
+      block->addString("Bulk");
+    else if (chargeState == ArRobot::CHARGING_OVERCHARGE)
+      block->addString("Overcharge");
+    else if (chargeState == ArRobot::CHARGING_FLOAT)
+      block->addString("Float");
+    else
+      block->addString("Unknown");
+    block->myInts.push_back(chargeState);
+  }
+  if (myLogPose)
+  {
+    block->myInts.push_back(ArMath::roundInt(myRobot->getX()));
+    block->myInts.push_back(ArMath::roundInt(myRobot->getY()));
+    block->myInts.push_back(ArMath::roundInt(myRobot->getTh()));
+  }
+  if (myLogEncoderPose)
+  {
+    block->myInts.push_back(
+	    ArMath::roundInt(myRobot->getRawEncoderPose().getX()));
+    block->myInts.push_back(
+	    ArMath::roundInt(myRobot->getRawEncoderPose().getY()));
+    block->myInts.push_back(
+	    ArMath::roundInt(myRobot->getRawEncoderPose().getTh()));
+  }
+  if (myLogCorrectedEncoderPose)
+  {
+    block->myInts.push_back(
+	    ArMath::roundInt(myRobot->getEncoderPose().getX()));
+    block->myInts.push_back(
+	    ArMath::roundInt(myRobot->getEncoderPose().getY()));
+    block->myInts.push_back(
+	    ArMath::roundInt(myRobot->getEncoderPose().getTh()));
+  }
+  if (myLogEncoders)
+  {
+    block->myInts.push_back(myRobot->getLeftEncoder());
+    block->myInts.push_back(myRobot->getRightEncoder());
+  }
+  if (myLogLeftVel)
+    block->myInts.push_back(ArMath::roundInt(myRobot->getLeftVel()));
+  if (myLogRightVel)
+    block->myInts.push_back(ArMath::roundInt(myRobot->getRightVel()));
+  if (myLogTransVel)
+    block->myInts.push_back(ArMath::roundInt(myRobot->getVel()));
+  if (myLogRotVel)
+    block->myInts.push_back(ArMath::roundInt(myRobot->getRotVel()));
+  if (myLogLeftStalled)
+    block->myInts.push_back((bool)myRobot->isLeftMotorStalled());
+  if (myLogRightStalled)
+    block->myInts.push_back((bool)myRobot->isRightMotorStalled());
+  if (myLogStallBits)
+    block->myInts.push_back(myRobot->getStallValue() & 0xffff);
+  if (myLogFlags)
+    block->myInts.push_back(myRobot->getFlags() & 0xffff);
+  if (myLogFaultFlags)
+    block->myInts.push_back(myRobot->getFaultFlags() & 0xffff);
+  for (i = 0; i < myAnalogCount; i++)
+    if (myAnalogEnabled[i])
+      block->myInts.push_back(myRobot->getIOAnalog(i));
+  for (i = 0; i < myAnalogVoltageCount; i++)
+    if (myAnalogVoltageEnabled[i])
+      block->myInts.push_back(
+	      ArMath::roundInt(myRobot->getIOAnalogVoltage(i) * 100));
+  for (i = 0; i < myDigInCount; i++)
+    if (myDigInEnabled[i])
+      block->myInts.push_back(myRobot->getIODigIn(i) & 0xff);
+  for (i = 0; i < myDigOutCount; i++)
+    if (myDigOutEnabled[i])
+      block->myInts.push_back(myRobot->getIODigOut(i) & 0xff);
+
+  block->myRows++;
+  if (block->myRows >= BLOCK_ROWS || 
+      block->myStarted.secSince() >= BLOCK_SECONDS)
+    queueFillingBlock();
+}
+
+/**
+   @param mustHave if true the writer makes another block if all of
+   them are waiting to be written, otherwise NULL is returned then
+**/
+ArDataLogger::ColumnBlock *ArDataLogger::getFillingBlock(bool mustHave)
+{
+  ColumnBlock *block;
+  bool isNew;
+  std::vector<ArDataLogReader::Column>::iterator it;
+
+  block = myColumnarFile->getWriter()->getFilling(&isNew, mustHave);
+  if (block == NULL || !isNew)
+    return block;
+
+  block->myHeader.clear();
+  block->myTypes.clear();
+  for (it = myColumns.begin(); it != myColumns.end(); it++)
+    block->myTypes.push_back((*it).getType());
+  block->myRows = 0;
+  block->myInts.clear();
+  block->myStringData.clear();
+  block->myStringEnds.clear();
+  block->myStarted.setToNow();
+  return block;
+}
+
+void ArDataLogger::queueFillingBlock(void)
+{
+  myColumnarFile->getWriter()->queueFilling();
+}
+
+void ArDataLogger::appendVarint(std::string *buf, ArTypes::UByte4 val)
+{
+  while (val >= 0x80)
+  {
+    *buf += (char)((val & 0x7f) | 0x80);
+    val >>= 7;
+  }
+  *buf += (char)val;
+}
+
+void ArDataLogger::encodeHeader(
+	const std::vector<ArDataLogReader::Column> *columns, 
+	std::string *buf)
+{
+  std::vector<ArDataLogReader::Column>::const_iterator it;
+  ArTypes::UByte2 num;
+  ArTypes::UByte byte;
+
+  *buf += (char)ArDataLogReader::RECORD_HEADER;
+  num = columns->size();
+  buf->append((const char *)&num, 2);
+  for (it = columns->begin(); it != columns->end(); it++)
+  {
+    byte = (*it).getType();
+    buf->append((const char *)&byte, 1);
+    byte = (*it).getParam();
+    buf->append((const char *)&byte, 1);
+    num = strlen((*it).getName());
+    buf->append((const char *)&num, 2);
+    buf->append((*it).getName(), num);
+  }
+}
+
+/**
+   See ArDataLogReader::decodeBlock for how the columns are encoded.
+   When compressing, the encoded columns are then deflated (with
+   deflateBuf to deflate into), unless that fails or doesn't make them
+   smaller in which case they're left as they are.
+**/
+void ArDataLogger::encodeBlock(const ColumnBlock *block, bool compress,
+			       std::string *buf, std::string *deflateBuf)
+{
+  size_t start = buf->size();
+  size_t numInts = 0;
+  size_t numStrings = 0;
+  size_t col;
+  size_t intCol;
+  size_t stringCol;
+  size_t row;
+  ArTypes::UByte flags = compress ? ArDataLogReader::BLOCK_COMPRESSED : 0;
+  ArTypes::UByte4 num;
+  ArTypes::UByte4 prev;
+  ArTypes::UByte4 diff;
+  ArTypes::Byte4 val;
+  const char *str;
+  size_t len;
+  const char *prevStr;
+  size_t prevLen;
+  bool same;
+  uLongf deflatedLen;
+
+  for (col = 0; col < block->myTypes.size(); col++)
+  {
+    if (block->myTypes[col] == ArDataLogReader::COLUMN_STRING)
+      numStrings++;
+    else
+      numInts++;
+  }
+
+  *buf += (char)ArDataLogReader::RECORD_BLOCK;
+  buf->append((const char *)&flags, 1);
+  num = block->myRows;
+  buf->append((const char *)&num, 4);
+  // the length goes in once we know it
+  buf->append(4, '\0');
+
+  for (col = 0, intCol = 0, stringCol = 0; col < block->myTypes.size(); col++)
+  {
+    if (block->myTypes[col] == ArDataLogReader::COLUMN_STRING)
+    {
+      for (row = 0; row < block->myRows; row++)
+      {
+	str = block->getString(row * numStrings + stringCol, &len);
+	if (!compress)
+	{
+	  appendVarint(buf, len);
+	  buf->append(str, len);
+	  continue;
+	}
+	if (row == 0)
+	{
+	  same = (len == 0);
+	}
+	else
+	{
+	  prevStr = block->getString((row - 1) * numStrings + stringCol,
+				     &prevLen);
+	  same = (prevLen == len && memcmp(str, prevStr, len) == 0);
+	}
+	if (same)
+	{
+	  appendVarint(buf, 0);
+	  continue;
+	}
+	appendVarint(buf, len + 1);
+	buf->append(str, len);
+      }
+      stringCol++;
+      continue;
+    }
+    for (prev = 0, row = 0; row < block->myRows; row++)
+    {
+      val = block->myInts[row * numInts + intCol];
+      if (!compress)
+      {
+	buf->append((const char *)&val, 4);
+	continue;
+      }
+      // zigzag the (wrapping) difference so small changes either way
+      // are small varints
+      diff = (ArTypes::UByte4)val - prev;
+      prev = val;
+      appendVarint(buf, (diff << 1) ^ ((diff & 0x80000000) ? 0xffffffff : 0));
+    }
+    intCol++;
+  }
+
+  num = buf->size() - start - 10;
+  if (compress)
+  {
+    deflateBuf->resize(compressBound(num));
+    deflatedLen = deflateBuf->size();
+    if (compress2((Bytef *)&(*deflateBuf)[0], &deflatedLen, 
+		  (const Bytef *)buf->data() + start + 10, num, 
+		  Z_DEFAULT_COMPRESSION) == Z_OK && deflatedLen + 4 < num)
+    {
+      // the deflated data goes after how long it was before
+      flags |= ArDataLogReader::BLOCK_DEFLATED;
+      buf->replace(start + 1, 1, (const char *)&flags, 1);
+      buf->resize(start + 10);
+      buf->append((const char *)&num, 4);
+      buf->append(deflateBuf->data(), deflatedLen);
+      num = buf->size() - start - 10;
+    }
+  }
+  buf->replace(start + 6, 4, (const char *)&num, 4);
+}
+
+ArDataLogger::ColumnarFile::ColumnarFile(FILE *file, bool compressed) :
+  myWriteBlockCB(this, &ArDataLogger::ColumnarFile::writeBlock),
+  myFlushFileCB(this, &ArDataLogger::ColumnarFile::flushFile),
+  // each block holds up to BLOCK_ROWS rows, so a few is plenty
+  myWriter("ArDataLogger::writer", &myWriteBlockCB, &myFlushFileCB, 4)
+{
+  myFile = file;
+  myCompressed = compressed;
+}
+
+ArDataLogger::ColumnarFile::~ColumnarFile()
+{
+  myWriter.stop();
+  if (myWriter.getDropped() > 0)
+    ArLog::log(ArLog::Normal, 
+	       "ArDataLogger: Dropped %lu rows the writer fell behind on",
+	       (unsigned long)myWriter.getDropped());
+  fclose(myFile);
+}
+
+void ArDataLogger::ColumnarFile::writeBlock(ColumnBlock *block)
+{
+  if (!block->myHeader.empty())
+    fwrite(block->myHeader.data(), 1, block->myHeader.size(), myFile);
+  if (block->myRows == 0)
+    return;
+  myWriteBuf.clear();
+  encodeBlock(block, myCompressed, &myWriteBuf, &myDeflateBuf);
+  fwrite(myWriteBuf.data(), 1, myWriteBuf.size(), myFile);
+}
+
+void ArDataLogger::ColumnarFile::flushFile(void)
+{
+  fflush(myFile);
+}
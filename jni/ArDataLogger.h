@@ -28,6 +28,8 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ariaUtil.h"
 #include "ArMutex.h"
 #include "ArFunctor.h"
+#include "ArBackgroundWriter.h"
+#include "ArDataLogReader.h"
 #include <vector>
 
 class ArRobot;
@@ -41,6 +43,13 @@ class ArConfig;
    do an addToConfig it'll automatically be enabled (since right now
    we don't want to change config after loading since the values would
    wind up wierd).
+
+   If DataLogColumnar is set in the config the log is written as
+   binary columns instead of text (see ArDataLogReader, which can read
+   them and turn them into CSV).  Then the robot task just copies the
+   values for each row into a block, and whole blocks are encoded,
+   deflated and written by a thread, so logging doesn't do any
+   formatting, compression or disk writes in the robot's cycle.
  **/
 class ArDataLogger
 {
@@ -64,6 +73,87 @@ protected:
   AREXPORT void connectCallback(void);
   AREXPORT bool processFile(char *errorBuffer, size_t errorBufferLen);
   AREXPORT void userTask(void);
+
+  enum { 
+    BLOCK_ROWS = 1024, ///< Most rows in a columnar block
+    BLOCK_SECONDS = 30 ///< Longest a columnar block waits to be written
+  };
+  /// Rows for the columnar log, filled in the robot task then written
+  class ColumnBlock
+  {
+  public:
+    ColumnBlock() : myRows(0) {}
+    // a header record to write before the rows (if not empty)
+    std::string myHeader;
+    // the types of the columns of the rows
+    std::vector<ArDataLogReader::ColumnType> myTypes;
+    size_t myRows;
+    // the values for each row, in column order (ints and strings
+    // are kept apart)
+    std::vector<ArTypes::Byte4> myInts;
+    // the strings are put end to end in myStringData (which keeps its
+    // space when the block is reused, so adding them doesn't allocate)
+    // and myStringEnds has where each one ends
+    std::vector<char> myStringData;
+    std::vector<ArTypes::UByte4> myStringEnds;
+    /// Adds a string onto the row being filled in
+    void addString(const char *str)
+      { myStringData.insert(myStringData.end(), str, str + strlen(str));
+	myStringEnds.push_back(myStringData.size()); }
+    /// Gets the string at index (and its length)
+    const char *getString(size_t index, size_t *len) const
+      { size_t start = (index == 0) ? 0 : myStringEnds[index - 1];
+	*len = myStringEnds[index] - start;
+	return (*len == 0) ? "" : &myStringData[start]; }
+    ArTime myStarted;
+  };
+
+  /// A columnar log file and the thread that writes the blocks to it
+  class ColumnarFile
+  {
+  public:
+    /// Constructor, takes over the file
+    ColumnarFile(FILE *file, bool compressed);
+    /// Destructor, writes everything queued then closes the file
+    ~ColumnarFile(void);
+    /// Gets the writer to hand blocks to
+    ArBackgroundWriter<ColumnBlock> *getWriter(void) { return &myWriter; }
+  protected:
+    /// Writes a block, for the writer
+    void writeBlock(ColumnBlock *block);
+    /// Flushes the file, for the writer
+    void flushFile(void);
+    FILE *myFile;
+    bool myCompressed;
+    // what the blocks are encoded into, kept so they don't reallocate
+    std::string myWriteBuf;
+    std::string myDeflateBuf;
+    ArFunctor1C<ColumnarFile, ColumnBlock *> myWriteBlockCB;
+    ArFunctorC<ColumnarFile> myFlushFileCB;
+    ArBackgroundWriter<ColumnBlock> myWriter;
+  };
+  friend class ArDataLogger::ColumnarFile;
+
+  /// Opens the log file (myMutex must be locked)
+  bool openFile(const char *fileName, const char *mode);
+  /// Closes the log file, or hands back the columnar file to be deleted
+  ColumnarFile *closeFile(void);
+  /// Makes the list of columns from what's being logged
+  void buildColumns(void);
+  /// Adds a row of values to the columnar log
+  void addColumnarRow(void);
+  /// Gets the block being filled, starting one if there isn't one
+  ColumnBlock *getFillingBlock(bool mustHave = false);
+  /// Hands the block being filled (if any) to the writer thread
+  void queueFillingBlock(void);
+  /// Encodes the columns as a header record
+  static void encodeHeader(const std::vector<ArDataLogReader::Column> *columns,
+			   std::string *buf);
+  /// Encodes a block as a block record
+  static void encodeBlock(const ColumnBlock *block, bool compress,
+			  std::string *buf, std::string *deflateBuf);
+  /// Adds an unsigned varint onto buf
+  static void appendVarint(std::string *buf, ArTypes::UByte4 val);
   ArRobot *myRobot;
   ArTime myLastLogged;
   ArConfig *myConfig;
@@ -72,6 +162,12 @@ protected:
 
   FILE *myFile;
   bool myConfigLogging;
+  bool myConfigColumnar;
+  bool myConfigColumnarCompressed;
+  // whether the file that's open is columnar (and compressed)
+  bool myColumnar;
+  bool myColumnarCompressed;
+  std::vector<ArDataLogReader::Column> myColumns;
   int myConfigLogInterval;
   char myOpenedFileName[512];
   char myConfigFileName[512];
@@ -111,6 +207,12 @@ protected:
 		    ArFunctor2<char *, ArTypes::UByte2> *> myAddStringFunctor;
   
 
+  // the columnar log and its writer (only while a columnar log is
+  // open, then myFile is its file)
+  ColumnarFile *myColumnarFile;
+  // where the string infos are put for the columnar log
+  std::vector<char> myStringBuf;
+
   ArFunctorC<ArDataLogger> myConnectCB;  
   ArRetFunctor2C<bool, ArDataLogger, char *, size_t> myProcessFileCB;
   ArFunctorC<ArDataLogger> myUserTaskCB;
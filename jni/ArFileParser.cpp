@@ -34,6 +34,7 @@ AREXPORT ArFileParser::ArFileParser(const char *baseDirectory) :
   myCommentDelimiterList(),
   myPreParseFunctor(NULL),
   myMap(),
+  myHashTable(),
   myRemainderHandler(NULL),
   myIsQuiet(false)
 {
@@ -53,6 +54,7 @@ AREXPORT ArFileParser::~ArFileParser(void)
 {
   ArUtil::deleteSetPairs(myMap.begin(), myMap.end());
   myMap.clear();
+  myHashTable.clear();
 
   delete myRemainderHandler;
 
@@ -88,6 +90,7 @@ AREXPORT bool ArFileParser::addHandler(
     ArLog::log(ArLog::Verbose, "keyword '%s' handler added", keyword);
   }
   myMap[keyword] = new HandlerCBType(functor);
+  rebuildHashTable();
   return true;
 }
 
@@ -128,6 +131,7 @@ AREXPORT bool ArFileParser::addHandlerWithError(
     ArLog::log(ArLog::Verbose, "keyword '%s' handler added", keyword);
   }
   myMap[keyword] = new HandlerCBType(functor);
+  rebuildHashTable();
   return true;
 }
 
@@ -169,6 +173,7 @@ AREXPORT bool ArFileParser::remHandler(const char *keyword,
   }
   handler = (*it).second;
   myMap.erase(it);
+  rebuildHashTable();
   delete handler;
   remHandler(keyword, false);
   return true;
@@ -199,6 +204,7 @@ AREXPORT bool ArFileParser::remHandler(
       }
       handler = (*it).second;
       myMap.erase(it);
+      rebuildHashTable();
       delete handler;
       remHandler(functor);
       return true;
@@ -232,6 +238,7 @@ AREXPORT bool ArFileParser::remHandler(
       }
       handler = (*it).second;
       myMap.erase(it);
+      rebuildHashTable();
       delete handler;
       remHandler(functor);
       return true;
@@ -241,6 +248,79 @@ AREXPORT bool ArFileParser::remHandler(
 
 }
 
+/**
+   The table is sized to keep the buckets to a couple entries at
+   most, adding and removing handlers is rare compared to parsing
+   lines so this just rebuilds it from scratch.
+**/
+AREXPORT void ArFileParser::rebuildHashTable(void)
+{
+  std::map<std::string, HandlerCBType *, ArStrCaseCmpOp>::iterator it;
+  size_t numBuckets;
+  char lowered[512];
+
+  myHashTable.clear();
+  if (myMap.empty())
+    return;
+
+  // keep it a power of two so we can mask instead of mod
+  for (numBuckets = 16; numBuckets < myMap.size() * 2; numBuckets *= 2);
+  myHashTable.resize(numBuckets);
+
+  for (it = myMap.begin(); it != myMap.end(); it++)
+  {
+    ArUtil::lower(lowered, (*it).first.c_str(), sizeof(lowered));
+    myHashTable[hashKeyword(lowered) & (numBuckets - 1)].push_back(
+	    std::pair<std::string, HandlerCBType *>(lowered, (*it).second));
+  }
+}
+
+AREXPORT ArFileParser::HandlerCBType *ArFileParser::findHandler(
+	const char *lowerKeyword)
+{
+  std::vector<std::pair<std::string, HandlerCBType *> > *bucket;
+  size_t i;
+
+  if (myHashTable.empty())
+    return NULL;
+
+  bucket = &myHashTable[hashKeyword(lowerKeyword) & 
+			(myHashTable.size() - 1)];
+  for (i = 0; i < bucket->size(); i++)
+  {
+    if (strcmp((*bucket)[i].first.c_str(), lowerKeyword) == 0)
+      return (*bucket)[i].second;
+  }
+  return NULL;
+}
+
+/**
+   This finds the earliest any of the comment delimiters start, which
+   is where chopping them one at a time would have left the line.
+   It also stops at the first new line since that is chopped off too.
+**/
+AREXPORT char *ArFileParser::findComment(char *line)
+{
+  std::list<std::string>::iterator iter;
+  char *pos;
+
+  for (pos = line; *pos != '\0' && *pos != '\n'; pos++)
+  {
+    if (!myCommentStarts[(unsigned char)*pos])
+      continue;
+    for (iter = myCommentDelimiterList.begin();
+	 iter != myCommentDelimiterList.end();
+	 iter++)
+    {
+      if (strncmp(pos, (*iter).c_str(), (*iter).size()) == 0)
+	return pos;
+    }
+  }
+  if (*pos == '\n')
+    return pos;
+  return NULL;
+}
+
 /*
 AREXPORT ArRetFunctor1<bool, ArArgumentBuilder *> *ArFileParser::getHandler(const char *keyword)
 {
@@ -279,6 +359,7 @@ AREXPORT const char *ArFileParser::getBaseDirectory(void) const
 AREXPORT void ArFileParser::setCommentDelimiters(const std::list<std::string> &delimiters)
 {
   myCommentDelimiterList.clear();
+  memset(myCommentStarts, 0, sizeof(myCommentStarts));
 
   int i = 0;
   for (std::list<std::string>::const_iterator iter = delimiters.begin();
@@ -287,6 +368,7 @@ AREXPORT void ArFileParser::setCommentDelimiters(const std::list<std::string> &d
     std::string curDelimiter = *iter;
     if (!ArUtil::isStrEmpty(curDelimiter.c_str())) {
       myCommentDelimiterList.push_back(curDelimiter);
+      myCommentStarts[(unsigned char)curDelimiter[0]] = true;
     }
     else {
       ArLog::log(ArLog::Normal,
@@ -304,6 +386,7 @@ AREXPORT void ArFileParser::setCommentDelimiters(const std::list<std::string> &d
 AREXPORT void ArFileParser::clearCommentDelimiters()
 {
   myCommentDelimiterList.clear();
+  memset(myCommentStarts, 0, sizeof(myCommentStarts));
 
 } // end method clearCommentDelimiters
 
@@ -323,7 +406,6 @@ AREXPORT bool ArFileParser::parseLine(char *line,
   size_t len;
   size_t i;
   bool noArgs;
-  std::map<std::string, HandlerCBType *, ArStrCaseCmpOp>::iterator it;
   HandlerCBType *handler;
 
   myLineNumber++;
@@ -335,27 +417,20 @@ AREXPORT bool ArFileParser::parseLine(char *line,
   }
 
 
-  // chop out the comments
-  for (std::list<std::string>::iterator iter = myCommentDelimiterList.begin();
-        iter != myCommentDelimiterList.end();
-        iter++) {
-    std::string commentDel = *iter;
-    if ((choppingPos = strstr(line, commentDel.c_str())) != NULL) {
-      line[choppingPos-line] = '\0';
-    }
-  }
-  
-  int chopCount = 0;
+  // chop out the comments and the new line, if they're there
+  if ((choppingPos = findComment(line)) != NULL)
+    *choppingPos = '\0';
 
-  // chop out the new line if its there
-  if ((choppingPos = strstr(line, "\n")) != NULL) {
-    chopCount++;
-    line[choppingPos-line] = '\0';
-  }
-  // chop out the windows new line if its there
-  while ((choppingPos = strstr(line, "\r")) != NULL) {
-    chopCount++;
-    memmove(choppingPos, choppingPos + 1, strlen(line));
+  // chop out the windows new lines if they're there, in one pass
+  if ((choppingPos = strchr(line, '\r')) != NULL)
+  {
+    char *copyTo = choppingPos;
+    for (; *choppingPos != '\0'; choppingPos++)
+    {
+      if (*choppingPos != '\r')
+	*copyTo++ = *choppingPos;
+    }
+    *copyTo = '\0';
   }
 
   // see how long the line is
@@ -435,18 +510,17 @@ AREXPORT bool ArFileParser::parseLine(char *line,
     };
   }
   // lower that keyword
-  ArUtil::lower(keyword, keyword, 512);
+  for (char *lowerPos = keyword; *lowerPos != '\0'; lowerPos++)
+    *lowerPos = tolower(*lowerPos);
 
   // a variable for if we're using the remainder handler or not (don't
   // do a test just because someone could set the remainder handler to
   // some other handler they're using)
   bool usingRemainder = false;
   // see if we have a handler for the keyword
-  if ((it = myMap.find(keyword)) != myMap.end())
+  if ((handler = findHandler(keyword)) != NULL)
   {
     //printf("have handler for keyword %s\n", keyword);
-    // we have a handler, so pull that out
-    handler = (*it).second;
     // valueStart was set above but make sure there's an argument
     if (i == len)
       noArgs = true;
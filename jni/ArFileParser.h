@@ -29,6 +29,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArArgumentParser.h"
 #include "ArFunctor.h"
 #include "ariaUtil.h"
+#include <vector>
 
 /// Class for parsing files more easily
 /**
@@ -190,14 +191,36 @@ protected:
     ArRetFunctor3<bool, ArArgumentBuilder *, char *, size_t> *myCallbackWithError;
     ArRetFunctor1<bool, ArArgumentBuilder *> *myCallback;
   };
+  /// Hash of an already lowered keyword (FNV-1a)
+  static unsigned int hashKeyword(const char *lowerKeyword)
+    {
+      unsigned int hash = 2166136261u;
+      for (; *lowerKeyword != '\0'; lowerKeyword++)
+	hash = (hash ^ (unsigned char)*lowerKeyword) * 16777619u;
+      return hash;
+    }
+  /// Rebuilds the keyword hash table from myMap
+  AREXPORT void rebuildHashTable(void);
+  /// Finds the handler for an already lowered keyword, NULL if none
+  AREXPORT HandlerCBType *findHandler(const char *lowerKeyword);
+  /// Finds where the first comment starts in line, NULL if none
+  AREXPORT char *findComment(char *line);
+
   size_t myMaxNumArguments;
   int myLineNumber;
   std::string myBaseDir;
   std::list<std::string> myCommentDelimiterList;
+  // which characters can start a comment delimiter, so most
+  // characters in a line only cost one lookup
+  bool myCommentStarts[256];
 
   ArFunctor1<const char *> *myPreParseFunctor;
 
   std::map<std::string, HandlerCBType *, ArStrCaseCmpOp> myMap;
+  // lowered copies of the keywords in myMap bucketed by
+  // hashKeyword, rebuilt whenever myMap changes so parseLine doesn't
+  // have to do case insensitive compares all the way down the map
+  std::vector<std::vector<std::pair<std::string, HandlerCBType *> > > myHashTable;
   // handles that NULL case
   HandlerCBType *myRemainderHandler;
   bool myIsQuiet;
@@ -41,7 +41,7 @@ AREXPORT ArGripper::ArGripper(ArRobot *robot, int gripperType) :
   myType = gripperType;
   if (myRobot != NULL) 
   {
-    myRobot->addPacketHandler(&myPacketHandlerCB, ArListPos::FIRST);
+    myRobot->addPacketHandlerForID(&myPacketHandlerCB, 0xE0);
     myRobot->addConnectCB(&myConnectCB, ArListPos::LAST);
     if (myRobot->isConnected() && (myType == GRIPPAC || myType == QUERYTYPE))
       myRobot->comInt(ArCommands::GRIPPERPACREQUEST, 2);
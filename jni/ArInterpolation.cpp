@@ -29,6 +29,9 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 AREXPORT ArInterpolation::ArInterpolation(size_t numberOfReadings)
 {
   mySize = numberOfReadings;
+  myReadings.resize(mySize);
+  myOldest = 0;
+  myNumReadings = 0;
   myDataMutex.setLogName("ArInterpolation");
 }
 
@@ -40,14 +43,24 @@ AREXPORT ArInterpolation::~ArInterpolation()
 AREXPORT bool ArInterpolation::addReading(ArTime timeOfReading, 
 					  ArPose position)
 {
+  Reading *reading;
+
   myDataMutex.lock();
-  if (myTimes.size() >= mySize)
+  if (mySize == 0)
   {
-    myTimes.pop_back();
-    myPoses.pop_back();
+    myDataMutex.unlock();
+    return true;
   }
-  myTimes.push_front(timeOfReading);
-  myPoses.push_front(position);
+  // if we're full the newest one goes over the oldest one
+  if (myNumReadings >= mySize)
+  {
+    myOldest = (myOldest + 1) % mySize;
+    myNumReadings--;
+  }
+  reading = getReading(myNumReadings);
+  reading->myTime = timeOfReading;
+  reading->myPose = position;
+  myNumReadings++;
   myDataMutex.unlock();
   return true;
 }
@@ -63,121 +76,106 @@ AREXPORT bool ArInterpolation::addReading(ArTime timeOfReading,
 AREXPORT int ArInterpolation::getPose(ArTime timeStamp,
 					  ArPose *position)
 {
-  std::list<ArTime>::iterator tit;
-  std::list<ArPose>::iterator pit;
-  
-  ArPose thisPose;
-  ArTime thisTime;
-  ArPose lastPose;
-  ArTime lastTime;
-
   ArTime nowTime;
+  int ret;
+
+  myDataMutex.lock();
+  ret = internalGetPose(timeStamp, position, nowTime);
+  myDataMutex.unlock();
+  return ret;
+}
+
+int ArInterpolation::internalGetPose(ArTime timeStamp, ArPose *position,
+				     ArTime nowTime)
+{
+  Reading *thisReading;
+  Reading *lastReading;
+  size_t low;
+  size_t high;
+  size_t mid;
+
   long total;
   long toStamp;
   double percentage;
   ArPose retPose;
   
-  myDataMutex.lock();
-  // find the time we want
-  for (tit = myTimes.begin(), pit = myPoses.begin();
-       tit != myTimes.end() && pit != myPoses.end(); 
-       ++tit, ++pit)
+  // find the newest reading that isn't after the time we want, low
+  // ends up one past it
+  low = 0;
+  high = myNumReadings;
+  while (low < high)
   {
-    lastTime = thisTime;
-    lastPose = thisPose;
-
-    thisTime = (*tit);
-    thisPose = (*pit);
-
-    //printf("## %d %d %d b %d at %d after %d\n", timeStamp.getMSec(), thisTime.getMSec(), timeStamp.mSecSince(thisTime), timeStamp.isBefore(thisTime), timeStamp.isAt(thisTime), timeStamp.isAfter(thisTime));
-    //if (timeStamp.isBefore(thisTime) || timeStamp.isAt(thisTime))
-    if (!timeStamp.isAfter(thisTime))
-    {
-      //printf("Found one!\n");
-      break;
-    } 
-
+    mid = (low + high) / 2;
+    if (timeStamp.isAfter(getReading(mid)->myTime))
+      high = mid;
+    else
+      low = mid + 1;
   }
-  // if we're at the end then it was too long ago
-  if (tit == myTimes.end() || pit == myPoses.end())
+  // if there isn't one then it was too long ago
+  if (low == 0)
   {
     //printf("Too old\n");
-    myDataMutex.unlock();
     return -2;
   }
+  thisReading = getReading(low - 1);
   
   // this is for forecasting (for the brave)
-  if ((tit == myTimes.begin() || pit == myPoses.begin()) && 
-      !timeStamp.isAt((*tit)))
+  if (low == myNumReadings && !timeStamp.isAt(thisReading->myTime))
   {
-    //printf("Too new %d %d\n", tit == myTimes.begin(), pit == myPoses.begin());
-  
-    thisTime = (*tit);
-    thisPose = (*pit);
-    tit++;
-    pit++;  
-    if (tit == myTimes.end() || pit == myPoses.end())
+    if (myNumReadings < 2)
     {
       //printf("Not enough data\n");
-      myDataMutex.unlock();
       return -3;
     }
-    lastTime = (*tit);
-    lastPose = (*pit);
-    nowTime.setToNow();
-    total = thisTime.mSecSince(lastTime);
+    lastReading = getReading(low - 2);
+    total = thisReading->myTime.mSecSince(lastReading->myTime);
     if (total == 0)
       total = 100;
-    toStamp = nowTime.mSecSince(thisTime);
+    toStamp = nowTime.mSecSince(thisReading->myTime);
     percentage = (double)toStamp/(double)total;
     //printf("Total time %d, to stamp %d, percentage %.2f\n", total, toStamp, percentage);
     if (percentage > 50)
-    {
-      myDataMutex.unlock();
       return -1;
-    }
 
-    retPose.setX(thisPose.getX() + 
-		 (thisPose.getX() - lastPose.getX()) * percentage);
-    retPose.setY(thisPose.getY() + 
-		 (thisPose.getY() - lastPose.getY()) * percentage);
-    retPose.setTh(ArMath::addAngle(thisPose.getTh(),
-				   ArMath::subAngle(thisPose.getTh(),
-						    lastPose.getTh())
+    retPose.setX(thisReading->myPose.getX() + 
+		 (thisReading->myPose.getX() - 
+		  lastReading->myPose.getX()) * percentage);
+    retPose.setY(thisReading->myPose.getY() + 
+		 (thisReading->myPose.getY() - 
+		  lastReading->myPose.getY()) * percentage);
+    retPose.setTh(ArMath::addAngle(thisReading->myPose.getTh(),
+				   ArMath::subAngle(thisReading->myPose.getTh(),
+						    lastReading->myPose.getTh())
 				   * percentage));
     *position = retPose;
-    myDataMutex.unlock();
     return 0;
   }
 
-  // this is the actual interpolation
-
-  //printf("Woo hoo!\n");
+  // right on a reading (which also covers it being the newest one)
+  if (timeStamp.isAt(thisReading->myTime))
+  {
+    *position = thisReading->myPose;
+    return 1;
+  }
 
-  total = thisTime.mSecSince(lastTime);
-  toStamp = thisTime.mSecSince(timeStamp);
+  // this is the actual interpolation, between this one and the one after it
+  lastReading = getReading(low);
+  total = thisReading->myTime.mSecSince(lastReading->myTime);
+  toStamp = thisReading->myTime.mSecSince(timeStamp);
   percentage = (double)toStamp/(double)total;
   //printf("Total time %d, to stamp %d, percentage %.2f\n", 	 total, toStamp, percentage);
-  retPose.setX(thisPose.getX() + 
-	      (lastPose.getX() - thisPose.getX()) * percentage); 
-  retPose.setY(thisPose.getY() + 
-	      (lastPose.getY() - thisPose.getY()) * percentage); 
-  retPose.setTh(ArMath::addAngle(thisPose.getTh(),
-				ArMath::subAngle(lastPose.getTh(), 
-						 thisPose.getTh())
+  retPose.setX(thisReading->myPose.getX() + 
+	      (lastReading->myPose.getX() - 
+	       thisReading->myPose.getX()) * percentage); 
+  retPose.setY(thisReading->myPose.getY() + 
+	      (lastReading->myPose.getY() - 
+	       thisReading->myPose.getY()) * percentage); 
+  retPose.setTh(ArMath::addAngle(thisReading->myPose.getTh(),
+				ArMath::subAngle(lastReading->myPose.getTh(), 
+						 thisReading->myPose.getTh())
 				* percentage));
-/*
-  printf("original:");
-  thisPose.log();
-  printf("After:");
-  lastPose.log();
-  printf("ret:");
-  retPose.log();
-*/
   *position = retPose;
-  myDataMutex.unlock();
   return 1;
-  
 }
 
 AREXPORT size_t ArInterpolation::getNumberOfReadings(void) const
@@ -187,12 +185,21 @@ AREXPORT size_t ArInterpolation::getNumberOfReadings(void) const
 
 AREXPORT void ArInterpolation::setNumberOfReadings(size_t numberOfReadings)
 {
+  std::vector<Reading> readings;
+  size_t keep;
+  size_t i;
+
   myDataMutex.lock();
-  while (myTimes.size() > numberOfReadings)
-  {
-    myTimes.pop_back();
-    myPoses.pop_back();
-  }
+  // keep the newest ones that fit
+  keep = myNumReadings;
+  if (keep > numberOfReadings)
+    keep = numberOfReadings;
+  readings.resize(numberOfReadings);
+  for (i = 0; i < keep; i++)
+    readings[i] = *getReading(myNumReadings - keep + i);
+  myReadings.swap(readings);
+  myOldest = 0;
+  myNumReadings = keep;
   mySize = numberOfReadings;  
   myDataMutex.unlock();
 }
@@ -200,11 +207,7 @@ AREXPORT void ArInterpolation::setNumberOfReadings(size_t numberOfReadings)
 AREXPORT void ArInterpolation::reset(void)
 {
   myDataMutex.lock();
-  while (myTimes.size() > 0)
-    myTimes.pop_back();
-  while (myPoses.size() > 0)
-    myPoses.pop_back();
+  myOldest = 0;
+  myNumReadings = 0;
   myDataMutex.unlock();
 }
-
-
@@ -28,15 +28,17 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ariaTypedefs.h"
 #include "ariaUtil.h"
 
+#include <vector>
+
 /** 
     This class takes care of storing in readings of position vs time, and then
     interpolating between them to find where the robot was at a particular 
-    point in time.  It has two lists, one containing the times, and one 
-    containing the positions at those same times (per position), they must be 
-    walked through jointly to maintain cohesion.  The new entries are at the
-    front of the list, while the old ones are at the back.  
+    point in time.  The readings are kept in a ring of (time, position)
+    pairs, oldest to newest, and are found with a binary search on the
+    time, so readings must be added in time order (which they are when
+    they come from the robot's packets).
     numberOfReadings and the setNumberOfReadings control the number of entries
-    in the list.  If a size is set that is smaller than the current size, then
+    in the ring.  If a size is set that is smaller than the current size, then
     the old ones are chopped off.
 **/
 class ArInterpolation
@@ -57,9 +59,24 @@ public:
   /// Empties the interpolated positions
   AREXPORT void reset(void);
 protected:
+  /// One reading, a position and when it was there
+  class Reading
+  {
+  public:
+    ArTime myTime;
+    ArPose myPose;
+  };
+  /// Gets a reading, 0 is the oldest
+  Reading *getReading(size_t i) 
+    { return &myReadings[(myOldest + i) % myReadings.size()]; }
+  /// Finds a position, must be called with myDataMutex locked
+  int internalGetPose(ArTime timeStamp, ArPose *position, ArTime nowTime);
   ArMutex myDataMutex;
-  std::list<ArTime> myTimes;
-  std::list<ArPose> myPoses;
+  std::vector<Reading> myReadings;
+  // where the oldest reading is in myReadings
+  size_t myOldest;
+  // how many readings there are
+  size_t myNumReadings;
   size_t mySize;
 };
 
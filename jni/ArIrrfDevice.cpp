@@ -61,7 +61,7 @@ AREXPORT void ArIrrfDevice::setRobot(ArRobot *robot)
 {
   myRobot = robot;
   if (myRobot != NULL)
-    myRobot->addPacketHandler(&myPacketHandler, ArListPos::LAST);
+    myRobot->addPacketHandlerForID(&myPacketHandler, 0x10);
 }
 
 AREXPORT void ArIrrfDevice::processReadings(void)
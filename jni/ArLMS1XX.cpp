@@ -31,7 +31,8 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include <time.h>
 
 AREXPORT ArLMS1XXPacket::ArLMS1XXPacket() : 
-  ArBasePacket(10000, 1, NULL, 1)
+  ArBasePacket(10000, 1, NULL, 1),
+  myTimeReceived(0, 0)
 {
   myFirstAdd = true;
   myCommandType[0] = '\0';
@@ -445,9 +446,9 @@ ArLMS1XXPacket *ArLMS1XXPacketReceiver::receivePacket(unsigned int msWait,
   ArLMS1XXPacket *packet;
   unsigned char c;
   long timeToRunFor;
-  ArTime timeDone;
-  ArTime lastDataRead;
-  ArTime packetReceived;
+  ArTime timeDone(0, 0);
+  ArTime lastDataRead(0, 0);
+  ArTime packetReceived(0, 0);
   int numRead;
   int i;
 
@@ -684,7 +685,7 @@ AREXPORT ArLMS1XX::~ArLMS1XX()
   {
     myRobot->remRangeDevice(this);
     myRobot->remLaser(this);
-    myRobot->remSensorInterpTask(&mySensorInterpTask);
+    laserRemSensorInterpTask();
   }
   if (myRawReadings != NULL)
   {
@@ -743,8 +744,7 @@ AREXPORT void ArLMS1XX::setRobot(ArRobot *robot)
 
   if (myRobot != NULL)
   {
-    myRobot->remSensorInterpTask(&mySensorInterpTask);
-    myRobot->addSensorInterpTask("lms1XX", 90, &mySensorInterpTask);
+    laserAddSensorInterpTask("lms1XX", 90, &mySensorInterpTask);
   }
   ArLaser::setRobot(robot);
 }
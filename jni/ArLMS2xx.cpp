@@ -125,7 +125,7 @@ AREXPORT ArLMS2xx::~ArLMS2xx()
     myRobot->remRangeDevice(this);
     myRobot->remLaser(this);
     myRobot->remPacketHandler(&mySimPacketHandler);
-    myRobot->remSensorInterpTask(&mySensorInterpCB);
+    laserRemSensorInterpTask();
   }
   lockDevice();
   if (isConnected())
@@ -172,8 +172,8 @@ AREXPORT void ArLMS2xx::setRobot(ArRobot *robot)
   myRobot = robot;
   if (myRobot != NULL)
   {
-    myRobot->addPacketHandler(&mySimPacketHandler, ArListPos::LAST);
-    myRobot->addSensorInterpTask("sick", 90, &mySensorInterpCB);
+    myRobot->addPacketHandlerForID(&mySimPacketHandler, 0x60, 0xfe);
+    laserAddSensorInterpTask("sick", 90, &mySensorInterpCB);
   }
   ArRangeDevice::setRobot(robot);
 }
@@ -28,7 +28,8 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "stdio.h"
 
 AREXPORT ArLMS2xxPacket::ArLMS2xxPacket(unsigned char sendingAddress) :
-  ArBasePacket(2048, 4)
+  ArBasePacket(2048, 4),
+  myTimeReceived(0, 0)
 {
   mySendingAddress = sendingAddress;
 }
@@ -101,9 +101,9 @@ AREXPORT ArLMS2xxPacket *ArLMS2xxPacketReceiver::receivePacket(
   //unsigned int curTime;
   long timeToRunFor;
   long packetLength;
-  ArTime timeDone;
-  ArTime lastDataRead;
-  ArTime packetReceived;
+  ArTime timeDone(0, 0);
+  ArTime lastDataRead(0, 0);
+  ArTime packetReceived(0, 0);
   int numRead;
 
 
@@ -33,9 +33,13 @@ AREXPORT ArLaser::ArLaser(
 	bool appendLaserNumberToName) :
   ArRangeDeviceThreaded(
 	  361, 200, name, absoluteMaxRange,
-	  0, 0, 0, locationDependent)
+	  0, 0, 0, locationDependent),
+  myParallelSensorInterpCB(this, &ArLaser::parallelSensorInterp),
+  myDeferredCallbacksCB(this, &ArLaser::invokeDeferredCallbacks)
 {
   myLaserNumber = laserNumber;
+  mySensorInterpTaskCB = NULL;
+  myDeferCallbacks = false;
 
   if (appendLaserNumberToName)
   {
@@ -698,25 +702,92 @@ AREXPORT void ArLaser::laserConnect(void)
   setCurrentBufferSize(size);
   
   ArLog::log(myInfoLogLevel, "%s: Connected", getName());
-  myConnectCBList.invoke();
+  invokeOrDefer(&myConnectCBList);
 }
 
 AREXPORT void ArLaser::laserFailedConnect(void)
 {
   ArLog::log(myInfoLogLevel, "%s: Failed to connect", getName());
-  myFailedConnectCBList.invoke();
+  invokeOrDefer(&myFailedConnectCBList);
 }
 
 AREXPORT void ArLaser::laserDisconnectNormally(void)
 {
   ArLog::log(myInfoLogLevel, "%s: Disconnected normally", getName());
-  myDisconnectNormallyCBList.invoke();
+  invokeOrDefer(&myDisconnectNormallyCBList);
 }
 
 AREXPORT void ArLaser::laserDisconnectOnError(void)
 {
   ArLog::log(ArLog::Normal, "%s: Disconnected because of error", getName());
-  myDisconnectOnErrorCBList.invoke();
+  invokeOrDefer(&myDisconnectOnErrorCBList);
+}
+
+/**
+   This adds the task to the robot's sensor interp tasks as a parallel
+   one (see ArRobot::addSensorInterpTask), so it has to follow the
+   rules for those, but the laser's callbacks (data, connect and
+   disconnect) that happen while it runs are held and run from the
+   robot's thread by a task right after it (at position - 1), so they
+   can still lock the robot.  Call this after myRobot is set.
+
+   @param name the name to give the task
+   @param position the position of the task
+   @param functor the laser's sensor interp functor
+**/
+AREXPORT void ArLaser::laserAddSensorInterpTask(const char *name, 
+						int position, 
+						ArFunctor *functor)
+{
+  if (myRobot == NULL)
+    return;
+  laserRemSensorInterpTask();
+  mySensorInterpTaskCB = functor;
+  myDeferredCallbacksName = name;
+  myDeferredCallbacksName += " callbacks";
+  myRobot->addSensorInterpTask(name, position, &myParallelSensorInterpCB, 
+			       NULL, true);
+  myRobot->addSensorInterpTask(myDeferredCallbacksName.c_str(), position - 1, 
+			       &myDeferredCallbacksCB);
+}
+
+AREXPORT void ArLaser::laserRemSensorInterpTask(void)
+{
+  if (myRobot == NULL)
+    return;
+  myRobot->remSensorInterpTask(&myParallelSensorInterpCB);
+  myRobot->remSensorInterpTask(&myDeferredCallbacksCB);
+}
+
+AREXPORT void ArLaser::parallelSensorInterp(void)
+{
+  if (mySensorInterpTaskCB == NULL)
+    return;
+  myDeferThread = ArThread::osSelf();
+  myDeferCallbacks = true;
+  mySensorInterpTaskCB->invoke();
+  myDeferCallbacks = false;
+}
+
+AREXPORT void ArLaser::invokeDeferredCallbacks(void)
+{
+  size_t i;
+
+  // the parallel task is done by now, so nothing's adding to these
+  for (i = 0; i < myDeferredCBLists.size(); i++)
+    myDeferredCBLists[i]->invoke();
+  // clear keeps the capacity, so this doesn't allocate each cycle
+  myDeferredCBLists.clear();
+}
+
+void ArLaser::invokeOrDefer(ArCallbackList *cbList)
+{
+  // the laser's own thread can call these while the parallel task
+  // runs, it still invokes them right away
+  if (myDeferCallbacks && myDeferThread == ArThread::osSelf())
+    myDeferredCBLists.push_back(cbList);
+  else
+    cbList->invoke();
 }
 
 AREXPORT void ArLaser::internalGotReading(void)
@@ -731,7 +802,7 @@ AREXPORT void ArLaser::internalGotReading(void)
 
   myLastReading.setToNow();
   
-  myDataCBList.invoke();
+  invokeOrDefer(&myDataCBList);
 }
 
 AREXPORT int ArLaser::getReadingCount()
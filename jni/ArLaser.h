@@ -606,6 +606,12 @@ protected:
   /// Function for a laser to call when it loses connection
   AREXPORT virtual void laserDisconnectOnError(void);
 
+  /// Adds the laser's sensor interp task to the robot as a parallel one
+  AREXPORT void laserAddSensorInterpTask(const char *name, int position,
+					 ArFunctor *functor);
+  /// Removes the task added with laserAddSensorInterpTask
+  AREXPORT void laserRemSensorInterpTask(void);
+
   // processes the individual reading, helper for base class
   AREXPORT void internalProcessReading(double x, double y, unsigned int range,
 				    bool clean, bool onlyClean);
@@ -627,6 +633,14 @@ protected:
   // reading was received
   AREXPORT virtual void internalGotReading(void);
 
+  // invokes the list, or saves it for invokeDeferredCallbacks if
+  // this thread is running the parallel sensor interp task
+  void invokeOrDefer(ArCallbackList *cbList);
+  // runs the sensor interp task with the callbacks deferred
+  AREXPORT void parallelSensorInterp(void);
+  // runs the callbacks that were deferred, in the robot's thread
+  AREXPORT void invokeDeferredCallbacks(void);
+
   int myLaserNumber;
 
 
@@ -724,6 +738,18 @@ protected:
   ArCallbackList myDisconnectNormallyCBList;
   ArCallbackList myDataCBList;
 
+  // the parallel sensor interp task might run on one of the robot's
+  // worker threads, which don't own the robot's lock, so the callbacks
+  // (which can lock the robot) are run afterwards from the robot's
+  // thread
+  ArFunctor *mySensorInterpTaskCB;
+  ArFunctorC<ArLaser> myParallelSensorInterpCB;
+  ArFunctorC<ArLaser> myDeferredCallbacksCB;
+  std::string myDeferredCallbacksName;
+  bool myDeferCallbacks;
+  ArThread::ThreadType myDeferThread;
+  std::vector<ArCallbackList *> myDeferredCBLists;
+
   ArLog::LogLevel myInfoLogLevel;
 
   ArTime myLastReading;
@@ -150,6 +150,16 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
  *  etc.).  This goal will be added to the final map at the position of the
  *  robot to define a goal or other point of interest in the map.
  *
+ *  An ArLaserLogger made with writeBinary writes each scan as a binary
+ *  record instead (everything else is written as text records), which
+ *  is much smaller and quicker to write.  These files start with
+ *  "ARIA2DLB" instead of "LaserOdometryLog", and need to be turned into
+ *  the text format above with ArLaserLogger::convertBinaryLog before
+ *  other programs can use them.  The binary format is in the byte order
+ *  of the machine that wrote it, and keeps the values the text is
+ *  formatted from, so the converted text is exactly what a text log
+ *  would have had.
+ *
  */
 
 /**
@@ -173,6 +183,13 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
    happen, into any keyhandler thats around (for a keypress of G), it
    pays attention to the flag bit of the robot, and it puts in a
    button press callback for the joyhandler passed in (if any)
+
+   @param writeInBackground if true then the robot task just copies
+   the readings and a thread writes them to the file, otherwise the
+   robot task writes them
+
+   @param writeBinary if true then scans are written in binary (see
+   convertBinaryLog), otherwise everything is written as text
 **/
 AREXPORT ArLaserLogger::ArLaserLogger(
 	ArRobot *robot, ArLaser *laser, 
@@ -181,15 +198,22 @@ AREXPORT ArLaserLogger::ArLaserLogger(
 	const char *baseDirectory, bool useReflectorValues,
 	ArRobotJoyHandler *robotJoyHandler,
 	const std::map<std::string, ArRetFunctor2<int, ArTime, ArPose *> *, 
-	ArStrCaseCmpOp> *extraLocationData) :
+	ArStrCaseCmpOp> *extraLocationData,
+	bool writeInBackground, bool writeBinary) :
   mySectors(18), 
   myTaskCB(this, &ArLaserLogger::robotTask),
+  myWriteRecordCB(this, &ArLaserLogger::writeRecord),
+  myFlushFileCB(this, &ArLaserLogger::flushFile),
   myGoalKeyCB(this, &ArLaserLogger::goalKeyCallback), 
   myLoopPacketHandlerCB(this, &ArLaserLogger::loopPacketHandler)
 {
   ArKeyHandler *keyHandler;
   
 
+  myWriter = NULL;
+  myDroppingRecord = false;
+  myWriteBinary = writeBinary;
+  myEnded = false;
   myOldReadings = false;
   myNewReadings = true;
   myUseReflectorValues = useReflectorValues;
@@ -220,7 +244,16 @@ AREXPORT ArLaserLogger::ArLaserLogger(
   if (extraLocationData != NULL)
     myExtraLocationData = *extraLocationData;
 
-  myFile = ArUtil::fopen(realFileName.c_str(), "w+");
+  std::map<std::string, ArRetFunctor2<int, ArTime, ArPose *> *, ArStrCaseCmpOp>::iterator it;
+  for (it = myExtraLocationData.begin(); 
+       it != myExtraLocationData.end(); 
+       it++)
+    myExtraNames.push_back((*it).first);
+
+  if (myWriteBinary)
+    myFile = ArUtil::fopen(realFileName.c_str(), "wb+");
+  else
+    myFile = ArUtil::fopen(realFileName.c_str(), "w+");
 
   /*
   double deg, incr;
@@ -272,11 +305,12 @@ AREXPORT ArLaserLogger::ArLaserLogger(
       
   if (myFile != NULL)
   {
+    std::string header;
     //const ArRobotParams *params;
     //params = robot->getRobotParams();
-    fprintf(myFile, "LaserOdometryLog\n");
-    fprintf(myFile, "#Created by ARIA's ArLaserLogger\n");
-    fprintf(myFile, "version: 3\n");
+    appendText(&header, "LaserOdometryLog\n");
+    appendText(&header, "#Created by ARIA's ArLaserLogger\n");
+    appendText(&header, "version: 3\n");
     //fprintf(myFile, "sick1pose: %d %d %.2f\n", params->getLaserX(), 
     //params->getLaserY(), params->getLaserTh());
     /*
@@ -288,26 +322,50 @@ AREXPORT ArLaserLogger::ArLaserLogger(
 	    ArMath::roundInt(0.0 - deg / 2.0),
 	    ArMath::roundInt(deg / 2.0), ArMath::roundInt(deg / incr + 1.0));
     */
-    fprintf(myFile, "sick1pose: %.0f %.0f %.2f\n", 
-	    myLaser->getSensorPositionX(),
-	    myLaser->getSensorPositionY(),
-	    myLaser->getSensorPositionTh());
-    fprintf(myFile, "sick1conf: %d %d %d\n", 
-	    ArMath::roundInt(minAngle),
-	    ArMath::roundInt(maxAngle), 
-	    readings->size());
+    appendText(&header, "sick1pose: %.0f %.0f %.2f\n", 
+	       myLaser->getSensorPositionX(),
+	       myLaser->getSensorPositionY(),
+	       myLaser->getSensorPositionTh());
+    appendText(&header, "sick1conf: %d %d %d\n", 
+	       ArMath::roundInt(minAngle),
+	       ArMath::roundInt(maxAngle), 
+	       (int)readings->size());
     std::string available;
     available = "robot robotGlobal";
     if (myIncludeRawEncoderPose)
       available += " robotRaw";
 
-    std::map<std::string, ArRetFunctor2<int, ArTime, ArPose *> *, ArStrCaseCmpOp>::iterator it;
-    for (it = myExtraLocationData.begin(); 
-	 it != myExtraLocationData.end(); 
-	 it++)
-      available += " " + (*it).first;
+    std::vector<std::string>::iterator nameIt;
+    for (nameIt = myExtraNames.begin(); 
+	 nameIt != myExtraNames.end(); 
+	 nameIt++)
+      available += " " + (*nameIt);
 
-    fprintf(myFile, "locationTypes: %s\n", available.c_str());
+    appendText(&header, "locationTypes: %s\n", available.c_str());
+
+    // binary logs start with the names of the extra locations, since
+    // the scans only have their poses
+    if (myWriteBinary)
+    {
+      ArTypes::UByte4 version = BINARY_VERSION;
+      ArTypes::UByte2 len;
+      myWriteBuf.assign(getBinaryMagic(), 8);
+      myWriteBuf.append((const char *)&version, 4);
+      len = myExtraNames.size();
+      myWriteBuf.append((const char *)&len, 2);
+      for (nameIt = myExtraNames.begin(); 
+	   nameIt != myExtraNames.end(); 
+	   nameIt++)
+      {
+	len = (*nameIt).size();
+	myWriteBuf.append((const char *)&len, 2);
+	myWriteBuf.append((*nameIt).c_str(), len);
+      }
+      fwrite(myWriteBuf.data(), 1, myWriteBuf.size(), myFile);
+    }
+    myRecord.myType = RECORD_TEXT;
+    myRecord.myText = header;
+    writeRecord(&myRecord);
   }
   else
   {
@@ -322,6 +380,9 @@ AREXPORT ArLaserLogger::ArLaserLogger(
   myScanNumber = 0;
   myLastVel = 0;
   myStartTime.setToNow();
+  if (writeInBackground)
+    myWriter = new ArBackgroundWriter<LogRecord>(
+	    "ArLaserLogger::writer", &myWriteRecordCB, &myFlushFileCB);
   myRobot->addUserTask("Sick Logger", 1, &myTaskCB);
 
   char uCFileName[21];
@@ -359,16 +420,43 @@ AREXPORT ArLaserLogger::ArLaserLogger(
 
 AREXPORT ArLaserLogger::~ArLaserLogger()
 {
+  endLog();
+  // the writer writes everything that's left before it exits
+  if (myWriter != NULL)
+  {
+    if (myWriter->getDropped() > 0)
+      ArLog::log(ArLog::Normal, 
+		 "ArLaserLogger: Dropped %lu scans the writer fell behind on",
+		 (unsigned long)myWriter->getDropped());
+    delete myWriter;
+    myWriter = NULL;
+  }
+  if (myFile != NULL)
+    fclose(myFile);
+}
+  
+/**
+   The robot must be locked when this is called.  The destructor calls
+   this if it hasn't been, but deleting the logger waits for the log to
+   be written out, so if the logger is writing in the background it's
+   better to call this with the robot locked and then delete the logger
+   after unlocking it.
+**/
+AREXPORT void ArLaserLogger::endLog(void)
+{
+  if (myEnded)
+    return;
+  myEnded = true;
   myRobot->remUserTask(&myTaskCB);
   myRobot->remPacketHandler(&myLoopPacketHandlerCB);
   myRobot->comStr(94, "");
   if (myFile != NULL)
   {
-    fprintf(myFile, "# End of log\n");
-    fclose(myFile);
+    startRecord(RECORD_TEXT)->myText = "# End of log\n";
+    finishRecord();
   }
 }
-  
+
 AREXPORT bool ArLaserLogger::loopPacketHandler(ArRobotPacket *packet)
 {
   unsigned char loops;
@@ -525,15 +613,17 @@ void ArLaserLogger::internalAddGoal(void)
 
 void ArLaserLogger::internalWriteTags(void)
 {
-  time_t msec;
+  LogRecord *record;
 
   // now put the tags into the file
   while (myInfos.size() > 0)
   {
     if (myFile != NULL)
     {
-      myWrote = true;
-      fprintf(myFile, "%s\n", (*myInfos.begin()).c_str());
+      record = startRecord(RECORD_TEXT);
+      record->myText = (*myInfos.begin());
+      record->myText += "\n";
+      finishRecord();
     }
     myInfos.pop_front();
   }
@@ -544,12 +634,12 @@ void ArLaserLogger::internalWriteTags(void)
   {
     if (myFile != NULL)
     {
-      myWrote = true;
-      msec = myStartTime.mSecSince();
-      fprintf(myFile, "time: %ld.%ld\n", msec / 1000, msec % 1000);
-      internalPrintPos(myRobot->getEncoderPose(), myRobot->getPose(), 
-		       myStartTime);
-      fprintf(myFile, "%s\n", (*myTags.begin()).c_str());
+      record = startRecord(RECORD_TAG);
+      record->myMSec = myStartTime.mSecSince();
+      fillRecordPos(record, myRobot->getEncoderPose(), myRobot->getPose(), 
+		    myStartTime);
+      record->myText = (*myTags.begin());
+      finishRecord();
     }
     myTags.pop_front();
   }
@@ -563,9 +653,10 @@ void ArLaserLogger::internalTakeReading(void)
   ArPose encoderPoseTaken;
   ArPose globalPoseTaken;
   ArTime timeTaken;
-  time_t msec;
-  ArSensorReading *reading;
   bool usingAdjustedReadings;
+  LogRecord *record;
+  double sensorX;
+  double sensorY;
 
   // we take readings in any of the following cases if we haven't
   // taken one yet or if we've been explicitly told to take one or if
@@ -616,159 +707,566 @@ void ArLaserLogger::internalTakeReading(void)
     globalPoseTaken = (*readings->begin())->getPoseTaken();
     timeTaken = (*readings->begin())->getTimeTaken();
     myLastVel = myRobot->getVel();
-    msec = myStartTime.mSecSince();
-    fprintf(myFile, "scan1Id: %d\n", myScanNumber);
-    fprintf(myFile, "time: %ld.%ld\n", msec / 1000, msec % 1000);
-    fprintf(myFile, "velocities: %.2f %.2f %.2f\n", 
-	    myRobot->getVel(), myRobot->getRotVel(), myRobot->getLatVel());
-    internalPrintPos(encoderPoseTaken, globalPoseTaken, timeTaken);
-
-    if (myUseReflectorValues)
-    {
-      fprintf(myFile, "reflector1: ");
-      
-      if (!myFlipped) //myLaser->isLaserFlipped())
-      {
-	// make sure that the list is in increasing order
-	for (it = readings->begin(); it != readings->end(); it++)
-	{
-	  reading = (*it);
-	  if (!reading->getIgnoreThisReading())
-	    fprintf(myFile, "%d ", reading->getExtraInt());
-	  else
-	    fprintf(myFile, "0 ");
-	}
-      }
-      else
-      {
-	for (rit = readings->rbegin(); rit != readings->rend(); rit++)
-	{
-	  reading = (*rit);
-	  if (!reading->getIgnoreThisReading())
-	    fprintf(myFile, "%d ", reading->getExtraInt());
-	  else
-	    fprintf(myFile, "0 ");
-	}
-      }
-      fprintf(myFile, "\n");
-    }
+
+    record = startRecord(RECORD_SCAN);
+    record->myScanNumber = myScanNumber;
+    record->myMSec = myStartTime.mSecSince();
+    record->myVel = myRobot->getVel();
+    record->myRotVel = myRobot->getRotVel();
+    record->myLatVel = myRobot->getLatVel();
+    fillRecordPos(record, encoderPoseTaken, globalPoseTaken, timeTaken);
+
+    // the vectors keep their space from the last time the record was
+    // used, so this doesn't allocate once things get going
+    record->myHasReflectors = myUseReflectorValues;
+    record->myHasRanges = myOldReadings;
+    record->myHasPoints = myNewReadings;
+    record->myReflectors.clear();
+    record->myRanges.clear();
+    record->myX.clear();
+    record->myY.clear();
+    sensorX = myLaser->getSensorPositionX();
+    sensorY = myLaser->getSensorPositionY();
     /**
        Note that the the sick1: or scan1: must be the last thing in
        that timestamp, ie that you should put any other data before
-       it.
+       it.  Also make sure that the readings are in increasing order.
      **/
-    if (myOldReadings)
+    if (!myFlipped) //myLaser->isLaserFlipped())
     {
-      fprintf(myFile, "sick1: ");
-      
-      if (!myFlipped) //myLaser->isLaserFlipped())
-      {
-	// make sure that the list is in increasing order
-	for (it = readings->begin(); it != readings->end(); it++)
-	{
-	  reading = (*it);
-	  fprintf(myFile, "%d ", reading->getRange());
-	}
-      }
-      else
-      {
-	for (rit = readings->rbegin(); rit != readings->rend(); rit++)
-	{
-	  reading = (*rit);
-	  fprintf(myFile, "%d ", reading->getRange());
-	}
-      }
-      fprintf(myFile, "\n");
+      for (it = readings->begin(); it != readings->end(); it++)
+	addReadingToRecord(record, (*it), sensorX, sensorY);
     }
-    if (myNewReadings)
+    else
     {
-      fprintf(myFile, "scan1: ");
-      
-      if (!myFlipped) //myLaser->isLaserFlipped())
-      {
-	// make sure that the list is in increasing order
-	for (it = readings->begin(); it != readings->end(); it++)
-	{
-	  reading = (*it);
-	  if (!reading->getIgnoreThisReading())
-	    fprintf(myFile, "%.0f %.0f  ", 
-		    reading->getLocalX() - myLaser->getSensorPositionX(), 
-		    reading->getLocalY() - myLaser->getSensorPositionY());
-	  else
-	    fprintf(myFile, "0 0  ");
-	}
-      }
-      else
-      {
-	for (rit = readings->rbegin(); rit != readings->rend(); rit++)
-	{
-	  reading = (*rit);
-	  if (!reading->getIgnoreThisReading())
-	    fprintf(myFile, "%.0f %.0f  ", 
-		    reading->getLocalX() - myLaser->getSensorPositionX(), 
-		    reading->getLocalY() - myLaser->getSensorPositionY());
-	  else
-	    fprintf(myFile, "0 0  ");
-	}
-      }
-      fprintf(myFile, "\n");
+      for (rit = readings->rbegin(); rit != readings->rend(); rit++)
+	addReadingToRecord(record, (*rit), sensorX, sensorY);
     }
+    finishRecord();
     myLaser->unlockDevice();
   }
 }
 
-void ArLaserLogger::internalPrintPos(ArPose encoderPoseTaken, 
-				    ArPose globalPoseTaken, ArTime timeTaken)
+void ArLaserLogger::addReadingToRecord(LogRecord *record, 
+				       ArSensorReading *reading,
+				       double sensorX, double sensorY)
 {
-  if (myFile == NULL)
-    return;
-
-  fprintf(myFile, "robot: %.0f %.0f %.2f\n", 
-	  encoderPoseTaken.getX(), 
-	  encoderPoseTaken.getY(), 
-	  encoderPoseTaken.getTh());
+  if (record->myHasReflectors)
+  {
+    if (!reading->getIgnoreThisReading())
+      record->myReflectors.push_back(reading->getExtraInt());
+    else
+      record->myReflectors.push_back(0);
+  }
+  if (record->myHasRanges)
+    record->myRanges.push_back(reading->getRange());
+  if (record->myHasPoints)
+  {
+    if (!reading->getIgnoreThisReading())
+    {
+      record->myX.push_back(reading->getLocalX() - sensorX);
+      record->myY.push_back(reading->getLocalY() - sensorY);
+    }
+    else
+    {
+      record->myX.push_back(0);
+      record->myY.push_back(0);
+    }
+  }
+}
 
-  fprintf(myFile, "robotGlobal: %.0f %.0f %.2f\n", 
-	  globalPoseTaken.getX(), 
-	  globalPoseTaken.getY(), 
-	  globalPoseTaken.getTh());
+void ArLaserLogger::fillRecordPos(LogRecord *record, 
+				  ArPose encoderPoseTaken, 
+				  ArPose globalPoseTaken, ArTime timeTaken)
+{
+  size_t i;
 
+  record->myEncoderPose = encoderPoseTaken;
+  record->myGlobalPose = globalPoseTaken;
+  record->myHasRawPose = myIncludeRawEncoderPose;
   if (myIncludeRawEncoderPose)
   {
     ArPose encoderPose = myRobot->getEncoderPose();
     ArPose rawEncoderPose = myRobot->getRawEncoderPose();
     ArTransform normalToRaw(rawEncoderPose, encoderPose);
     
-    ArPose rawPose;
-    rawPose = normalToRaw.doInvTransform(encoderPoseTaken);
-    fprintf(myFile, "robotRaw: %.0f %.0f %.2f\n", 
-	    rawPose.getX(), 
-	    rawPose.getY(), 
-	    rawPose.getTh());
+    record->myRawPose = normalToRaw.doInvTransform(encoderPoseTaken);
   }
   
+  record->myExtraValid.resize(myExtraNames.size());
+  record->myExtraPoses.resize(myExtraNames.size());
   std::map<std::string, ArRetFunctor2<int, ArTime, ArPose *> *, 
 	   ArStrCaseCmpOp>::iterator it;
-  for (it = myExtraLocationData.begin(); it != myExtraLocationData.end(); it++)
+  for (i = 0, it = myExtraLocationData.begin(); 
+       it != myExtraLocationData.end(); 
+       i++, it++)
   {
     ArPose pose;
     int ret;
     if ((ret = (*it).second->invokeR(timeTaken, &pose)) >= 0)
     {
-      fprintf(myFile, "%s: %.0f %.0f %.2f\n", 
-	      (*it).first.c_str(),
-	      pose.getX(), 
-	      pose.getY(), 
-	      pose.getTh());
+      record->myExtraValid[i] = true;
+      record->myExtraPoses[i] = pose;
     }
     else
     {
       ArLog::log(ArLog::Verbose, "Could not use %s it returned %d",
 		 (*it).first.c_str(), ret);
-      fprintf(myFile, "%s: \n", 
-	      (*it).first.c_str());
+      record->myExtraValid[i] = false;
+    }
+  }
+}
+
+/**
+   If we're writing in the background this takes a record from the
+   writer, otherwise it's just our one record.  If the writer has
+   fallen behind and has no record free a scan gets filled into our
+   one record and thrown away in finishRecord (text and tags are always
+   kept, the writer makes another record for them).  Only the robot task
+   (or our destructor) should call this, and finishRecord must be
+   called before it's called again.
+**/
+ArLaserLogger::LogRecord *ArLaserLogger::startRecord(RecordType type)
+{
+  LogRecord *record;
+
+  if (myWriter == NULL)
+  {
+    record = &myRecord;
+  }
+  else
+  {
+    record = myWriter->getFilling(NULL, type != RECORD_SCAN);
+    myDroppingRecord = (record == NULL);
+    if (myDroppingRecord)
+      record = &myRecord;
+  }
+  record->myType = type;
+  return record;
+}
+
+void ArLaserLogger::finishRecord(void)
+{
+  if (myWriter == NULL)
+  {
+    myWrote = true;
+    writeRecord(&myRecord);
+    return;
+  }
+  if (myDroppingRecord)
+  {
+    myDroppingRecord = false;
+    return;
+  }
+  myWriter->queueFilling();
+}
+
+void ArLaserLogger::writeRecord(LogRecord *record)
+{
+  ArTypes::UByte4 len;
+
+  if (myFile == NULL)
+    return;
+
+  myWriteBuf.clear();
+  if (myWriteBinary && record->myType == RECORD_SCAN)
+  {
+    myWriteBuf += 'S';
+    encodeBinaryScan(record, &myWriteBuf);
+  }
+  else if (myWriteBinary)
+  {
+    myWriteBuf += 'T';
+    // the length goes in once we know it
+    myWriteBuf.append(4, '\0');
+    formatRecord(record, &myExtraNames, &myWriteBuf);
+    len = myWriteBuf.size() - 5;
+    myWriteBuf.replace(1, 4, (const char *)&len, 4);
+  }
+  else
+  {
+    formatRecord(record, &myExtraNames, &myWriteBuf);
+  }
+  fwrite(myWriteBuf.data(), 1, myWriteBuf.size(), myFile);
+}
+
+void ArLaserLogger::flushFile(void)
+{
+  if (myFile == NULL)
+    return;
+  fflush(myFile);
+#ifndef WIN32
+  fsync(fileno(myFile));
+#endif
+}
+
+void ArLaserLogger::appendText(std::string *str, const char *format, ...)
+{
+  char buf[2048];
+  va_list ptr;
+  va_start(ptr, format);
+  vsnprintf(buf, sizeof(buf), format, ptr);
+  buf[sizeof(buf) - 1] = '\0';
+  va_end(ptr);
+  *str += buf;
+}
+
+/**
+   This is the text that's always been in the .2d files, so it's used
+   both for writing text logs and turning binary ones into text.
+**/
+void ArLaserLogger::formatRecord(const LogRecord *record, 
+				 const std::vector<std::string> *extraNames,
+				 std::string *text)
+{
+  size_t i;
+
+  if (record->myType == RECORD_TEXT)
+  {
+    *text += record->myText;
+    return;
+  }
+
+  if (record->myType == RECORD_SCAN)
+    appendText(text, "scan1Id: %d\n", record->myScanNumber);
+  appendText(text, "time: %ld.%ld\n", record->myMSec / 1000, 
+	     record->myMSec % 1000);
+  if (record->myType == RECORD_SCAN)
+    appendText(text, "velocities: %.2f %.2f %.2f\n", 
+	       record->myVel, record->myRotVel, record->myLatVel);
+
+  appendText(text, "robot: %.0f %.0f %.2f\n", 
+	     record->myEncoderPose.getX(), 
+	     record->myEncoderPose.getY(), 
+	     record->myEncoderPose.getTh());
+  appendText(text, "robotGlobal: %.0f %.0f %.2f\n", 
+	     record->myGlobalPose.getX(), 
+	     record->myGlobalPose.getY(), 
+	     record->myGlobalPose.getTh());
+  if (record->myHasRawPose)
+    appendText(text, "robotRaw: %.0f %.0f %.2f\n", 
+	       record->myRawPose.getX(), 
+	       record->myRawPose.getY(), 
+	       record->myRawPose.getTh());
+  for (i = 0; i < extraNames->size() && i < record->myExtraValid.size(); i++)
+  {
+    if (record->myExtraValid[i])
+      appendText(text, "%s: %.0f %.0f %.2f\n", 
+		 (*extraNames)[i].c_str(),
+		 record->myExtraPoses[i].getX(), 
+		 record->myExtraPoses[i].getY(), 
+		 record->myExtraPoses[i].getTh());
+    else
+      appendText(text, "%s: \n", (*extraNames)[i].c_str());
+  }
+
+  if (record->myType == RECORD_TAG)
+  {
+    *text += record->myText;
+    *text += "\n";
+    return;
+  }
+
+  if (record->myHasReflectors)
+  {
+    *text += "reflector1: ";
+    for (i = 0; i < record->myReflectors.size(); i++)
+      appendText(text, "%d ", record->myReflectors[i]);
+    *text += "\n";
+  }
+  if (record->myHasRanges)
+  {
+    *text += "sick1: ";
+    for (i = 0; i < record->myRanges.size(); i++)
+      appendText(text, "%d ", record->myRanges[i]);
+    *text += "\n";
+  }
+  if (record->myHasPoints)
+  {
+    *text += "scan1: ";
+    for (i = 0; i < record->myX.size() && i < record->myY.size(); i++)
+      appendText(text, "%.0f %.0f  ", record->myX[i], record->myY[i]);
+    *text += "\n";
+  }
+}
+
+/**
+   A scan is the scan number, the time, the velocities and poses, then
+   a byte saying which readings there are (1 for reflectors, 2 for
+   ranges and 4 for points), how many readings there are, and each set
+   of readings that is there (ints, except the points which are the
+   doubles the text is formatted from).
+**/
+void ArLaserLogger::encodeBinaryScan(const LogRecord *record, 
+				     std::string *buf)
+{
+  ArTypes::Byte4 val;
+  ArTypes::UByte4 num;
+  ArTypes::UByte flags;
+  double poses[3];
+  size_t i;
+
+  val = record->myScanNumber;
+  buf->append((const char *)&val, 4);
+  num = record->myMSec;
+  buf->append((const char *)&num, 4);
+  buf->append((const char *)&record->myVel, 8);
+  buf->append((const char *)&record->myRotVel, 8);
+  buf->append((const char *)&record->myLatVel, 8);
+
+  poses[0] = record->myEncoderPose.getX();
+  poses[1] = record->myEncoderPose.getY();
+  poses[2] = record->myEncoderPose.getTh();
+  buf->append((const char *)poses, sizeof(poses));
+  poses[0] = record->myGlobalPose.getX();
+  poses[1] = record->myGlobalPose.getY();
+  poses[2] = record->myGlobalPose.getTh();
+  buf->append((const char *)poses, sizeof(poses));
+  flags = record->myHasRawPose ? 1 : 0;
+  buf->append((const char *)&flags, 1);
+  if (record->myHasRawPose)
+  {
+    poses[0] = record->myRawPose.getX();
+    poses[1] = record->myRawPose.getY();
+    poses[2] = record->myRawPose.getTh();
+    buf->append((const char *)poses, sizeof(poses));
+  }
+  for (i = 0; i < record->myExtraValid.size(); i++)
+  {
+    flags = record->myExtraValid[i] ? 1 : 0;
+    buf->append((const char *)&flags, 1);
+    if (!record->myExtraValid[i])
+      continue;
+    poses[0] = record->myExtraPoses[i].getX();
+    poses[1] = record->myExtraPoses[i].getY();
+    poses[2] = record->myExtraPoses[i].getTh();
+    buf->append((const char *)poses, sizeof(poses));
+  }
+
+  flags = 0;
+  num = 0;
+  if (record->myHasReflectors)
+  {
+    flags |= 1;
+    num = record->myReflectors.size();
+  }
+  if (record->myHasRanges)
+  {
+    flags |= 2;
+    num = record->myRanges.size();
+  }
+  if (record->myHasPoints)
+  {
+    flags |= 4;
+    num = record->myX.size();
+  }
+  buf->append((const char *)&flags, 1);
+  buf->append((const char *)&num, 4);
+  if (record->myHasReflectors)
+    for (i = 0; i < num; i++)
+    {
+      val = record->myReflectors[i];
+      buf->append((const char *)&val, 4);
+    }
+  if (record->myHasRanges)
+    for (i = 0; i < num; i++)
+    {
+      val = record->myRanges[i];
+      buf->append((const char *)&val, 4);
+    }
+  if (record->myHasPoints)
+    for (i = 0; i < num; i++)
+    {
+      buf->append((const char *)&record->myX[i], 8);
+      buf->append((const char *)&record->myY[i], 8);
+    }
+}
+
+bool ArLaserLogger::decodeBinaryScan(FILE *file, LogRecord *record, 
+				     size_t numExtras)
+{
+  ArTypes::Byte4 val;
+  ArTypes::UByte4 num;
+  ArTypes::UByte flags;
+  double poses[3];
+  double point[2];
+  size_t i;
+
+  record->myType = RECORD_SCAN;
+  if (fread(&val, 4, 1, file) != 1)
+    return false;
+  record->myScanNumber = val;
+  if (fread(&num, 4, 1, file) != 1)
+    return false;
+  record->myMSec = num;
+  if (fread(&record->myVel, 8, 1, file) != 1 ||
+      fread(&record->myRotVel, 8, 1, file) != 1 ||
+      fread(&record->myLatVel, 8, 1, file) != 1)
+    return false;
+
+  if (fread(poses, sizeof(poses), 1, file) != 1)
+    return false;
+  record->myEncoderPose.setPose(poses[0], poses[1], poses[2]);
+  if (fread(poses, sizeof(poses), 1, file) != 1)
+    return false;
+  record->myGlobalPose.setPose(poses[0], poses[1], poses[2]);
+  if (fread(&flags, 1, 1, file) != 1)
+    return false;
+  record->myHasRawPose = (flags != 0);
+  if (record->myHasRawPose)
+  {
+    if (fread(poses, sizeof(poses), 1, file) != 1)
+      return false;
+    record->myRawPose.setPose(poses[0], poses[1], poses[2]);
+  }
+  record->myExtraValid.resize(numExtras);
+  record->myExtraPoses.resize(numExtras);
+  for (i = 0; i < numExtras; i++)
+  {
+    if (fread(&flags, 1, 1, file) != 1)
+      return false;
+    record->myExtraValid[i] = (flags != 0);
+    if (!record->myExtraValid[i])
+      continue;
+    if (fread(poses, sizeof(poses), 1, file) != 1)
+      return false;
+    record->myExtraPoses[i].setPose(poses[0], poses[1], poses[2]);
+  }
+
+  if (fread(&flags, 1, 1, file) != 1 || fread(&num, 4, 1, file) != 1)
+    return false;
+  record->myHasReflectors = (flags & 1) != 0;
+  record->myHasRanges = (flags & 2) != 0;
+  record->myHasPoints = (flags & 4) != 0;
+  record->myReflectors.clear();
+  record->myRanges.clear();
+  record->myX.clear();
+  record->myY.clear();
+  if (record->myHasReflectors)
+    for (i = 0; i < num; i++)
+    {
+      if (fread(&val, 4, 1, file) != 1)
+	return false;
+      record->myReflectors.push_back(val);
+    }
+  if (record->myHasRanges)
+    for (i = 0; i < num; i++)
+    {
+      if (fread(&val, 4, 1, file) != 1)
+	return false;
+      record->myRanges.push_back(val);
     }
+  if (record->myHasPoints)
+    for (i = 0; i < num; i++)
+    {
+      if (fread(point, sizeof(point), 1, file) != 1)
+	return false;
+      record->myX.push_back(point[0]);
+      record->myY.push_back(point[1]);
+    }
+  return true;
+}
+
+/**
+   This writes the text log that an ArLaserLogger without writeBinary
+   would have written, so that the mapping tools can use it.
+
+   @param binaryFileName the log written with writeBinary
+
+   @param textFileName the .2d file to write
+
+   @return true if the whole log was converted, false if a file
+   couldn't be opened or the binary log isn't one or is cut off (in
+   which case everything up to where it's cut off is still written)
+**/
+AREXPORT bool ArLaserLogger::convertBinaryLog(const char *binaryFileName,
+					      const char *textFileName)
+{
+  FILE *in;
+  FILE *out;
+  char magic[8];
+  ArTypes::UByte4 version;
+  ArTypes::UByte2 numNames, len, i;
+  ArTypes::UByte4 textLen;
+  char type;
+  char buf[1024];
+  std::vector<std::string> extraNames;
+  LogRecord record;
+  std::string text;
+  bool ret = true;
+
+  if ((in = ArUtil::fopen(binaryFileName, "rb")) == NULL)
+  {
+    ArLog::log(ArLog::Terse, "ArLaserLogger::convertBinaryLog: Could not open %s", binaryFileName);
+    return false;
   }
+  if (fread(magic, 8, 1, in) != 1 || 
+      strncmp(magic, getBinaryMagic(), 8) != 0 ||
+      fread(&version, 4, 1, in) != 1 || version != BINARY_VERSION ||
+      fread(&numNames, 2, 1, in) != 1)
+  {
+    ArLog::log(ArLog::Terse, "ArLaserLogger::convertBinaryLog: %s is not a binary laser log (version %d)", binaryFileName, BINARY_VERSION);
+    fclose(in);
+    return false;
+  }
+  for (i = 0; i < numNames; i++)
+  {
+    if (fread(&len, 2, 1, in) != 1 || len >= sizeof(buf) || 
+	(len > 0 && fread(buf, len, 1, in) != 1))
+    {
+      ArLog::log(ArLog::Terse, "ArLaserLogger::convertBinaryLog: %s is cut off", binaryFileName);
+      fclose(in);
+      return false;
+    }
+    extraNames.push_back(std::string(buf, len));
+  }
+
+  if ((out = ArUtil::fopen(textFileName, "w")) == NULL)
+  {
+    ArLog::log(ArLog::Terse, "ArLaserLogger::convertBinaryLog: Could not open %s", textFileName);
+    fclose(in);
+    return false;
+  }
+
+  while (fread(&type, 1, 1, in) == 1)
+  {
+    if (type == 'T')
+    {
+      if (fread(&textLen, 4, 1, in) != 1)
+      {
+	ret = false;
+	break;
+      }
+      text.resize(textLen);
+      if (textLen > 0 && fread(&text[0], textLen, 1, in) != 1)
+      {
+	ret = false;
+	break;
+      }
+    }
+    else if (type == 'S')
+    {
+      if (!decodeBinaryScan(in, &record, extraNames.size()))
+      {
+	ret = false;
+	break;
+      }
+      text.clear();
+      formatRecord(&record, &extraNames, &text);
+    }
+    else
+    {
+      ret = false;
+      break;
+    }
+    fwrite(text.data(), 1, text.size(), out);
+  }
+  if (!ret)
+    ArLog::log(ArLog::Terse, "ArLaserLogger::convertBinaryLog: %s is cut off or corrupt", binaryFileName);
+
+  fclose(in);
+  fclose(out);
+  return ret;
 }
 
 AREXPORT void ArLaserLogger::robotTask(void)
@@ -783,14 +1281,10 @@ AREXPORT void ArLaserLogger::robotTask(void)
   // call our function to take a reading
   internalTakeReading();
 
-  // now make sure the files all out to disk
-  if (myWrote)
-  {
-    fflush(myFile);
-#ifndef WIN32
-    fsync(fileno(myFile));
-#endif
-  }
+  // now make sure the files all out to disk (the writer thread does
+  // this if we have one)
+  if (myWrote && myWriter == NULL)
+    flushFile();
   myWrote = false;
 }
 
@@ -26,15 +26,18 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #define ARLASERLOGGER_H
 
 #include <stdio.h>
+#include <vector>
 
 #include "ariaUtil.h"
 #include "ArFunctor.h"
+#include "ArBackgroundWriter.h"
 
 class ArLaser;
 class ArRobot;
 class ArJoyHandler;
 class ArRobotJoyHandler;
 class ArRobotPacket;
+class ArSensorReading;
 
 /// This class can be used to create log files for the laser mapper
 /**
@@ -49,6 +52,19 @@ class ArRobotPacket;
    information about that... you can also explicitly have it add a
    goal by calling addGoal.
 
+   If writeInBackground is given to the constructor then the robot task
+   only copies each scan (and its poses) into a record that is handed
+   to a thread that formats it and writes it out, so mapping doesn't
+   add formatting and disk syncs to the robot's cycle.  The records are
+   made up front and reused, so this doesn't allocate anything either;
+   if the thread falls so far behind that none are free the scan is
+   dropped (the count is logged when the logger is deleted).
+
+   If writeBinary is given then scans are written in a compact binary
+   format instead of as text (everything else still goes in as text);
+   convertBinaryLog() turns those files into the usual .2d text for
+   the mapping tools.
+
    @see @ref LaserLogFileFormat for details on the laser scan log output file format.
 **/
 class ArLaserLogger
@@ -64,10 +80,20 @@ public:
 	  bool useReflectorValues = false,
 	  ArRobotJoyHandler *robotJoyHandler = NULL,
 	  const std::map<std::string, ArRetFunctor2<int, ArTime, ArPose *> *, 
-	  ArStrCaseCmpOp> *extraLocationData = NULL);
+	  ArStrCaseCmpOp> *extraLocationData = NULL,
+	  bool writeInBackground = false,
+	  bool writeBinary = false);
   /// Destructor
   AREXPORT virtual ~ArLaserLogger();
 
+  /// Turns a log written with writeBinary into a .2d text log
+  AREXPORT static bool convertBinaryLog(const char *binaryFileName,
+					const char *textFileName);
+  /// The version of the binary format this writes
+  enum { BINARY_VERSION = 2 };
+  /// The magic at the start of binary logs
+  static const char *getBinaryMagic(void) { return "ARIA2DLB"; }
+
 #ifndef SWIG
   /** @brief Adds a string to the log file with a tag at the given moment
    *  @swigomit
@@ -110,7 +136,79 @@ public:
   bool takingNewReadings(void) { return myNewReadings; }
   /// Sets if we're taking old (scan1:) readings
   void takeNewReadings(bool takeNew) { myNewReadings = takeNew; }
+  /// Gets if the log is being written by a background thread
+  bool isWritingInBackground(void) { return myWriter != NULL; }
+  /// Gets if scans are being written in binary
+  bool isWritingBinary(void) { return myWriteBinary; }
+  /// Takes the logger off the robot and ends the log
+  AREXPORT void endLog(void);
 protected:
+  /// What a LogRecord holds
+  enum RecordType
+  {
+    RECORD_TEXT, ///< Text to write as is
+    RECORD_TAG, ///< A tag (with when and where it was added)
+    RECORD_SCAN ///< A scan
+  };
+  /// Something for the log, filled in by the robot task then written
+  class LogRecord
+  {
+  public:
+    LogRecord() {}
+    RecordType myType;
+    // the text (for text and tags)
+    std::string myText;
+    int myScanNumber;
+    long myMSec;
+    double myVel;
+    double myRotVel;
+    double myLatVel;
+    ArPose myEncoderPose;
+    ArPose myGlobalPose;
+    bool myHasRawPose;
+    ArPose myRawPose;
+    // whether we got each of the extra locations (in order) and what
+    // they were
+    std::vector<bool> myExtraValid;
+    std::vector<ArPose> myExtraPoses;
+    // which of the readings we have, these are already in the order
+    // they're written and ignored readings are already 0
+    bool myHasReflectors;
+    bool myHasRanges;
+    bool myHasPoints;
+    std::vector<int> myReflectors;
+    std::vector<int> myRanges;
+    std::vector<double> myX;
+    std::vector<double> myY;
+  };
+
+  /// Gets a record for the robot task to fill in
+  LogRecord *startRecord(RecordType type);
+  /// Writes the record from startRecord (or hands it to the writer)
+  void finishRecord(void);
+  /// Adds a reading onto a scan record
+  void addReadingToRecord(LogRecord *record, ArSensorReading *reading,
+			  double sensorX, double sensorY);
+  /// Fills in the poses for a record
+  void fillRecordPos(LogRecord *record, ArPose encoderPoseTaken, 
+		     ArPose globalPoseTaken, ArTime timeTaken);
+  /// Writes a record to the file
+  void writeRecord(LogRecord *record);
+  /// Flushes the file out to the disk
+  void flushFile(void);
+  /// Adds the text for a record onto text
+  static void formatRecord(const LogRecord *record, 
+			   const std::vector<std::string> *extraNames,
+			   std::string *text);
+  /// Adds the binary for a scan onto buf
+  static void encodeBinaryScan(const LogRecord *record, std::string *buf);
+  /// Reads a binary scan (after its type) from a file
+  static bool decodeBinaryScan(FILE *file, LogRecord *record, 
+			       size_t numExtras);
+  /// Adds printf style text onto str
+  static void appendText(std::string *str, const char *format, ...);
+
+
   /// The task which gets attached to the robot
   AREXPORT void robotTask(void);
   // internal function that adds goals if needed (and specified)
@@ -119,9 +217,6 @@ protected:
   void internalWriteTags(void);
   // internal function that takes a reading
   void internalTakeReading(void);
-  // internal function that prints the position
-  void internalPrintPos(ArPose encoderPoseTaken, ArPose goalPoseTaken, 
-			ArTime timeTaken);
   // internal packet for handling the loop packets
   AREXPORT bool loopPacketHandler(ArRobotPacket *packet);
 
@@ -172,6 +267,22 @@ protected:
   bool myIncludeRawEncoderPose;
   std::map<std::string, ArRetFunctor2<int, ArTime, ArPose *> *, 
 	   ArStrCaseCmpOp> myExtraLocationData;
+  // the names of the extra location data, in the order they're written
+  std::vector<std::string> myExtraNames;
+
+  bool myWriteBinary;
+  bool myEnded;
+  // the record we use when not writing in the background (or to fill
+  // in and throw away when the writer didn't have one for us)
+  LogRecord myRecord;
+  // if the record being filled in is one the writer didn't have
+  bool myDroppingRecord;
+  // the text (or binary) for a record, kept so it doesn't reallocate
+  std::string myWriteBuf;
+  // the writer thread (NULL if we aren't writing in the background)
+  ArBackgroundWriter<LogRecord> *myWriter;
+  ArFunctor1C<ArLaserLogger, LogRecord *> myWriteRecordCB;
+  ArFunctorC<ArLaserLogger> myFlushFileCB;
 
   ArFunctorC<ArLaserLogger> myGoalKeyCB;
   ArRetFunctor1C<bool, ArLaserLogger, ArRobotPacket *> myLoopPacketHandlerCB;
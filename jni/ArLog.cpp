@@ -27,6 +27,8 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ariaOSDef.h"
 #include "ArLog.h"
 #include "ArConfig.h"
+#include "ArASyncTask.h"
+#include "ariaUtil.h"
 #include <time.h>
 #include <stdarg.h>
 #include <ctype.h>
@@ -64,6 +66,43 @@ ArGlobalRetFunctor<bool> ArLog::ourAramConfigProcessFileCB(
 	&ArLog::aramProcessFile);
 std::string ArLog::ourAramPrefix = "";
 
+ArMutex ArLog::ourAsyncMutex;
+volatile bool ArLog::ourAsync = false;
+ArLog::AsyncFullPolicy ArLog::ourAsyncFullPolicy = ArLog::AsyncDrop;
+ArLog::AsyncLine *ArLog::ourAsyncLines = NULL;
+int ArLog::ourAsyncSize = 0;
+volatile int ArLog::ourAsyncEnqueuePos = 0;
+int ArLog::ourAsyncDequeuePos = 0;
+volatile int ArLog::ourAsyncDropped = 0;
+int ArLog::ourAsyncDroppedReported = 0;
+volatile int ArLog::ourAsyncInFlight = 0;
+ArLog::AsyncWriter *ArLog::ourAsyncWriter = NULL;
+
+/// The thread that writes out the lines logged while ArLog is async
+class ArLog::AsyncWriter : public ArASyncTask
+{
+public:
+  AsyncWriter() 
+    { 
+      setThreadName("ArLog::AsyncWriter"); 
+      runAsync(); 
+    }
+  virtual ~AsyncWriter() {}
+  virtual void *runThread(void *arg)
+    {
+      threadStarted();
+      while (getRunning())
+      {
+	// if there wasn't anything then give some more time to build up
+	if (!ArLog::asyncWrite())
+	  ArUtil::sleep(10);
+      }
+      ArLog::asyncWrite();
+      threadFinished();
+      return NULL;
+    }
+};
+
 AREXPORT void ArLog::logPlain(LogLevel level, const char *str)
 {
   log(level, str);
@@ -80,6 +119,28 @@ AREXPORT void ArLog::log(LogLevel level, const char *str, ...)
   if (level > ourLevel)
     return;
 
+  va_list ptr;
+  va_start(ptr, str);
+  vlog(level, str, ptr);
+  va_end(ptr);
+}
+
+/**
+   This is log() for when the arguments are already in a va_list (like
+   vprintf).
+   @param level level of logging
+   @param str printf() like formating string
+   @param ptr the arguments for str
+*/
+AREXPORT void ArLog::vlog(LogLevel level, const char *str, va_list ptr)
+{
+  if (level > ourLevel)
+    return;
+
+  // asyncLog only uses ptr if it logs the line
+  if (ourAsync && asyncLog(str, ptr))
+    return;
+
   //printf("logging %s\n", str);
 
   char buf[10000];
@@ -104,13 +165,17 @@ AREXPORT void ArLog::log(LogLevel level, const char *str, ...)
   }
   else
     bufPtr = buf;
-  va_list ptr;
-  va_start(ptr, str);
-  
   vsnprintf(bufPtr, sizeof(buf) - timeLen - 2, str, ptr);
   bufPtr[sizeof(buf) - timeLen - 1] = '\0';
   //vsprintf(bufPtr, str, ptr);
   // can do whatever you want with the buf now
+  writeLine(buf, true);
+  
+  ourMutex.unlock();
+}
+
+void ArLog::writeLine(const char *buf, bool flush)
+{
   if (ourType == Colbert)
   {
     if (colbertPrint)		// check if we have a print routine
@@ -121,12 +186,14 @@ AREXPORT void ArLog::log(LogLevel level, const char *str, ...)
     int written;
     if ((written = fprintf(ourFP, "%s\n", buf)) > 0)
       ourCharsLogged += written;
-    fflush(ourFP);
+    if (flush)
+      fflush(ourFP);
   }
   else if (ourType != None)
   {
     printf("%s\n", buf);
-    fflush(stdout);
+    if (flush)
+      fflush(stdout);
   }
   if (ourAlsoPrint)
     printf("%s\n", buf);
@@ -142,9 +209,189 @@ AREXPORT void ArLog::log(LogLevel level, const char *str, ...)
 #ifdef HAVEATL
   ATLTRACE2("%s\n", buf);
 #endif
+}
+
+/**
+   When ArLog is async, log() only formats the line into a buffer, then
+   a background thread writes lines out (flushing after each batch), so
+   the thread logging never waits on ourMutex or the disk.  Putting a
+   line into the buffer doesn't take a lock either.  This is meant for
+   the robot loop and other threads that shouldn't slow down when the
+   logging gets heavy (like with Verbose on).
+
+   Lines that are longer than 1023 characters are cut off when
+   async.  The time (if logging time) is taken when the line is logged
+   but formatted by the background thread.
+
+   Turning async off (including calling this again to change the
+   settings) waits for everything in the buffer to be written out,
+   Aria::uninit does this too.
+
+   @param async true to write lines out in the background, false to
+   write them out as they're logged
+
+   @param numLines how many lines the buffer holds (this is rounded up
+   to a power of two)
+
+   @param fullPolicy what to do when the buffer is full, AsyncDrop (the
+   default) throws the line away and counts it (see getAsyncDropped),
+   AsyncBlock waits for room, which means logging can be slowed down
+   by the disk again
+**/
+AREXPORT bool ArLog::setAsync(bool async, int numLines, 
+			      AsyncFullPolicy fullPolicy)
+{
+  int i;
+
+  ourAsyncMutex.lock();
+  if (ourAsync)
+  {
+    ourAsync = false;
+    ArUtil::memoryBarrier();
+    // wait for anyone still putting lines in, help them along since
+    // they could be waiting for room
+    while (ourAsyncInFlight > 0)
+    {
+      if (!asyncWrite())
+	ArUtil::sleep(1);
+    }
+    ourAsyncWriter->stopRunning();
+    ourAsyncWriter->join();
+    delete ourAsyncWriter;
+    ourAsyncWriter = NULL;
+    asyncWrite();
+    delete [] ourAsyncLines;
+    ourAsyncLines = NULL;
+    ourAsyncSize = 0;
+  }
   
-  va_end(ptr);
+  if (!async)
+  {
+    ourAsyncMutex.unlock();
+    return true;
+  }
+
+  for (ourAsyncSize = 2; ourAsyncSize < numLines; ourAsyncSize *= 2);
+  ourAsyncLines = new AsyncLine[ourAsyncSize];
+  for (i = 0; i < ourAsyncSize; i++)
+    ourAsyncLines[i].mySeq = i;
+  ourAsyncEnqueuePos = 0;
+  ourAsyncDequeuePos = 0;
+  ourAsyncFullPolicy = fullPolicy;
+  ourAsyncWriter = new AsyncWriter;
+  ArUtil::memoryBarrier();
+  ourAsync = true;
+  ourAsyncMutex.unlock();
+  return true;
+}
+
+/**
+   This claims the next line in the ring by moving the enqueue
+   position up with a compare and swap, fills it in, then marks it
+   ready for asyncWrite with its sequence number.
+**/
+bool ArLog::asyncLog(const char *str, va_list ptr)
+{
+  AsyncLine *line;
+  int pos;
+  int dif;
+
+  // setAsync waits for this to be 0 before it gets rid of the buffer
+  ArUtil::atomicAdd(&ourAsyncInFlight, 1);
+  if (!ourAsync)
+  {
+    ArUtil::atomicAdd(&ourAsyncInFlight, -1);
+    return false;
+  }
+
+  pos = ourAsyncEnqueuePos;
+  while (1)
+  {
+    line = &ourAsyncLines[pos & (ourAsyncSize - 1)];
+    dif = (int) ((unsigned int) line->mySeq - (unsigned int) pos);
+    // it's free, try to take it
+    if (dif == 0)
+    {
+      if (ArUtil::atomicCompareAndSwap(&ourAsyncEnqueuePos, pos, pos + 1))
+	break;
+    }
+    // it hasn't been written out yet, so we're full
+    else if (dif < 0)
+    {
+      if (ourAsyncFullPolicy == AsyncDrop)
+      {
+	ArUtil::atomicAdd(&ourAsyncDropped, 1);
+	ArUtil::atomicAdd(&ourAsyncInFlight, -1);
+	return true;
+      }
+      ArUtil::sleep(1);
+    }
+    // otherwise someone else took it first
+    pos = ourAsyncEnqueuePos;
+  }
+
+  if (ourLoggingTime)
+    line->myTime = time(NULL);
+  else
+    line->myTime = 0;
+  vsnprintf(line->myText, sizeof(line->myText), str, ptr);
+  line->myText[sizeof(line->myText) - 1] = '\0';
+  ArUtil::memoryBarrier();
+  line->mySeq = pos + 1;
+
+  ArUtil::atomicAdd(&ourAsyncInFlight, -1);
+  return true;
+}
+
+bool ArLog::asyncWrite(void)
+{
+  AsyncLine *line;
+  char buf[ASYNC_LINE_LENGTH + 21];
+  bool wrote = false;
+
+  ourMutex.lock();
+  while (ourAsyncLines != NULL)
+  {
+    line = &ourAsyncLines[ourAsyncDequeuePos & (ourAsyncSize - 1)];
+    if (line->mySeq != ourAsyncDequeuePos + 1)
+      break;
+    ArUtil::memoryBarrier();
+    if (line->myTime != 0)
+    {
+      // same format as log uses
+      strncpy(buf, ctime(&line->myTime), 20);
+      buf[20] = '\0';
+    }
+    else
+      buf[0] = '\0';
+    strcat(buf, line->myText);
+    ArUtil::memoryBarrier();
+    // free for the next time around the ring
+    line->mySeq = ourAsyncDequeuePos + ourAsyncSize;
+    ourAsyncDequeuePos++;
+
+    writeLine(buf, false);
+    wrote = true;
+  }
+  // say so when lines were dropped, so the gap in the log is explained
+  if (ourAsyncDropped != ourAsyncDroppedReported)
+  {
+    snprintf(buf, sizeof(buf), 
+	     "ArLog: %d lines dropped since the async log buffer was full",
+	     ourAsyncDropped - ourAsyncDroppedReported);
+    ourAsyncDroppedReported = ourAsyncDropped;
+    writeLine(buf, false);
+    wrote = true;
+  }
+  if (wrote)
+  {
+    if (ourFP)
+      fflush(ourFP);
+    else if (ourType != None && ourType != Colbert)
+      fflush(stdout);
+  }
   ourMutex.unlock();
+  return wrote;
 }
 
 /**
@@ -29,6 +29,8 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include <stdio.h>
 #endif
 #include <string>
+#include <stdarg.h>
+#include <time.h>
 #include "ariaTypedefs.h"
 #include "ArMutex.h"
 #include "ArFunctor.h"
@@ -69,6 +71,12 @@ public:
    */
   AREXPORT static void log(LogLevel level, const char *str, ...);
 #endif
+#ifndef SWIG
+  /// Log a message, with formatting and the arguments in a va_list
+  AREXPORT static void vlog(LogLevel level, const char *str, va_list ptr);
+#endif
+  /// Gets the level of logging
+  static LogLevel getLogLevel(void) { return ourLevel; }
   /// Log a message containing just a plain string
   AREXPORT static void logPlain(LogLevel level, const char *str);
   /// Initialize the logging utility with options
@@ -91,6 +99,19 @@ public:
   /// Use an ArConfig object to control ArLog's options
   AREXPORT static void addToConfig(ArConfig *config);
 
+  /// What logging asynchronously does when its buffer is full
+  typedef enum {
+    AsyncDrop, ///< Throw the line away (it is counted, see getAsyncDropped)
+    AsyncBlock ///< Wait for there to be room
+  } AsyncFullPolicy;
+  /// Sets whether lines are written out by a background thread
+  AREXPORT static bool setAsync(bool async, int numLines = 1024,
+				AsyncFullPolicy fullPolicy = AsyncDrop);
+  /// Gets whether lines are written out by a background thread
+  AREXPORT static bool isAsync(void) { return ourAsync; }
+  /// Gets how many lines have been thrown away since the async buffer was full
+  AREXPORT static int getAsyncDropped(void) { return ourAsyncDropped; }
+
 #ifndef ARINTERFACE
   /// Init for aram behavior
   AREXPORT static void aramInit(const char *prefix, 
@@ -99,6 +120,12 @@ public:
 #endif
 protected:
   AREXPORT static bool processFile(void);
+  /// Writes a line out wherever it is going (ourMutex must be locked)
+  static void writeLine(const char *buf, bool flush);
+  /// Puts a line in the async buffer, false if we aren't async anymore
+  static bool asyncLog(const char *str, va_list ptr);
+  /// Writes what's in the async buffer, returns whether there was anything
+  static bool asyncWrite(void);
 #ifndef ARINTERFACE
   AREXPORT static bool aramProcessFile(void);
   AREXPORT static void filledAramLog(void);
@@ -129,6 +156,30 @@ protected:
   static bool ourUseAramBehavior;
   static double ourAramLogSize;
   static std::string ourAramPrefix;
+
+  // the async buffer is a ring of lines, each with a sequence number
+  // that says whether it is free for the next writer to fill or ready
+  // for the background thread to write out
+  enum { ASYNC_LINE_LENGTH = 1024 };
+  struct AsyncLine
+  {
+    volatile int mySeq;
+    time_t myTime;
+    char myText[ASYNC_LINE_LENGTH];
+  };
+  class AsyncWriter;
+  friend class ArLog::AsyncWriter;
+  static ArMutex ourAsyncMutex;
+  static volatile bool ourAsync;
+  static AsyncFullPolicy ourAsyncFullPolicy;
+  static AsyncLine *ourAsyncLines;
+  static int ourAsyncSize;
+  static volatile int ourAsyncEnqueuePos;
+  static int ourAsyncDequeuePos;
+  static volatile int ourAsyncDropped;
+  static int ourAsyncDroppedReported;
+  static volatile int ourAsyncInFlight;
+  static AsyncWriter *ourAsyncWriter;
 };
 
 
@@ -262,6 +262,5 @@ AREXPORT bool ArLogFileConnection::isTimeStamping(void)
 AREXPORT ArTime ArLogFileConnection::getTimeRead(int index)
 {
   ArTime now;
-  now.setToNow();
   return now;
 }
@@ -2077,7 +2077,7 @@ bool ArMapChanger::addPointsPackets
     
     if (currentCount >= MAX_POINTS_IN_PACKET) {
 
-      ArNetPacket *packet = new ArNetPacket();
+      packet = new ArNetPacket();
 
       addHeaderToPacket(CONTINUE_CHANGES, POINTS_DATA, changeType, scanType, packet);
 
@@ -2137,7 +2137,7 @@ bool ArMapChanger::addLinesPackets
     
     if (currentCount >= MAX_LINES_IN_PACKET) {
 
-      ArNetPacket *packet = new ArNetPacket();
+      packet = new ArNetPacket();
 
       addHeaderToPacket(CONTINUE_CHANGES, LINES_DATA, changeType, scanType, packet);
       packet->byte4ToBuf(-1); // for a continuation...
@@ -2591,26 +2591,34 @@ bool ArMapChanger::unpackPoints(ArNetPacket *packet,
 
   std::vector<ArPose> *pointList = changeDetails->getChangedPoints(changeType, scanType);
 
-  for (int i = 0; i < MAX_POINTS_IN_PACKET; i++) {
+  int inPacketCount = *numPoints;
+  if (inPacketCount > MAX_POINTS_IN_PACKET) {
+    inPacketCount = MAX_POINTS_IN_PACKET;
+  }
+  // Check for all of the points in the packet at once
+  ArBasePacket::Reader reader(packet, 8 * inPacketCount);
+  if (!reader.isValid()) {
+    ArLog::log(ArLog::Normal,
+               "ArMapChanger::unpackPoints() packet is too short for %i points",
+               inPacketCount);
+    return false;
+  }
 
-    long int x = packet->bufToByte4();
-    long int y = packet->bufToByte4();
+  for (int i = 0; i < inPacketCount; i++) {
 
-    ArPose p(x, y);
-    pointList->push_back(p);
+    long int x = reader.bufToByte4();
+    long int y = reader.bufToByte4();
+
+    pointList->push_back(ArPose(x, y));
 
     /***
     ArLog::log(ArLog::Normal,
       "Unpacked: %li %li",
-      (long int) p.getX(),
-      (long int) p.getY());
+      x,
+      y);
     ***/
 
     *numPoints = *numPoints - 1;
-    if (*numPoints == 0) {
-      // TODO: Make sure packet is empty?
-      return true;
-    }
   } // end for each point in packet
 
   // TODO: Make sure packet is empty?
@@ -2642,20 +2650,29 @@ bool ArMapChanger::unpackLines(ArNetPacket *packet,
   std::vector<ArLineSegment> *lineSegmentList = 
                                   changeDetails->getChangedLineSegments(changeType, scanType);
 
-  for (int i = 0; i < MAX_LINES_IN_PACKET; i++) {
+  int inPacketCount = *numLines;
+  if (inPacketCount > MAX_LINES_IN_PACKET) {
+    inPacketCount = MAX_LINES_IN_PACKET;
+  }
+  // Check for all of the lines in the packet at once
+  ArBasePacket::Reader reader(packet, 16 * inPacketCount);
+  if (!reader.isValid()) {
+    ArLog::log(ArLog::Normal,
+               "ArMapChanger::unpackLines() packet is too short for %i lines",
+               inPacketCount);
+    return false;
+  }
 
-    long int x1 = packet->bufToByte4();
-    long int y1 = packet->bufToByte4();
-    long int x2 = packet->bufToByte4();
-    long int y2 = packet->bufToByte4();
+  for (int i = 0; i < inPacketCount; i++) {
+
+    long int x1 = reader.bufToByte4();
+    long int y1 = reader.bufToByte4();
+    long int x2 = reader.bufToByte4();
+    long int y2 = reader.bufToByte4();
 
     lineSegmentList->push_back(ArLineSegment(x1, y1, x2, y2));
     *numLines = *numLines - 1;
-    if (*numLines == 0) {
-      // TODO: Make sure packet is empty?
-      return true;
-    }
-  } // end for each point in packet
+  } // end for each line in packet
 
   // TODO: Make sure packet is empty?
 
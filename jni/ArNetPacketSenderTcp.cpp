@@ -26,35 +26,79 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArExport.h"
 #include "ArNetPacketSenderTcp.h"
 
+// the debug logging for each packet, these are logged in binary if
+// there is a binary log open since there are so many of them
+static ArBinaryLog::Message ourStartingSendingMsg(
+	ArLog::Normal, "%s %s Starting sending tcp command %d");
+static ArBinaryLog::Message ourFinishedSendingMsg(
+	ArLog::Normal, "%s%sFinished sending tcp command %d");
+static ArBinaryLog::Message ourContinueSendingMsg(
+	ArLog::Normal, "%s%sContinue sending tcp command %d, sent %d");
+
 AREXPORT ArNetPacketSenderTcp::ArNetPacketSenderTcp() :
   mySocket(NULL),
-  myPacketList(),
+  myCurrentQueue(0),
+  myBandwidthLimit(0),
+  myBandwidthAvailable(0),
   myPacket(NULL),
+  myShared(NULL),
+  mySourcePacket(NULL),
   myAlreadySent(false),
   myBuf(NULL),
   myLength(0)
 {
+  int i;
   myDataMutex.setLogName("ArNetPacketSenderTcp::myDataMutex");
   setDebugLogging(false);
   myBackupTimeout = -1;
   myLastGoodSend.setToNow();
+  for (i = 0; i < PRIORITY_COUNT; i++)
+  {
+    myDeficits[i] = 0;
+    myQueueDepths[i] = 0;
+    myQueueBytes[i] = 0;
+  }
+  myWeights[PRIORITY_CONTROL] = 16;
+  myWeights[PRIORITY_STATUS] = 4;
+  myWeights[PRIORITY_BULK] = 1;
+  resetQueueStats();
 }
 
 AREXPORT ArNetPacketSenderTcp::~ArNetPacketSenderTcp()
 {
-  ArNetPacket *packet;
+  QueuedPacket queued;
   int i = 0;
+  int queue;
   long bytes = 0;
-  while (myPacketList.begin() != myPacketList.end())
+  if (myPacket != NULL)
+    finishedPacket();
+  for (queue = 0; queue < PRIORITY_COUNT; queue++)
   {
-    i++;
-    packet = myPacketList.front();
-    bytes += packet->getLength();
-    myPacketList.pop_front();
-    delete packet;
+    while (myPacketLists[queue].begin() != myPacketLists[queue].end())
+    {
+      i++;
+      queued = myPacketLists[queue].front();
+      myPacketLists[queue].pop_front();
+      if (queued.mySource != NULL)
+      {
+	delete queued.mySource;
+      }
+      else if (queued.myShared != NULL)
+      {
+	bytes += queued.myShared->getLength();
+	queued.myShared->release();
+      }
+      else
+      {
+	bytes += queued.myPacket->getLength();
+	delete queued.myPacket;
+      }
+    }
   }
   if (i > 0)
     ArLog::log(ArLog::Normal, "Deleted %d packets of %d bytes", i, bytes);
+  if (mySourcePacket != NULL)
+    delete mySourcePacket;
 }
 
 /**
@@ -104,16 +148,21 @@ AREXPORT ArSocket *ArNetPacketSenderTcp::getSocket(void)
 }
 
 AREXPORT void ArNetPacketSenderTcp::sendPacket(ArNetPacket *packet,
-					       const char *loggingString)
+					       const char *loggingString,
+					       Priority priority)
 {
   ArNetPacket *sendPacket;
+  QueuedPacket queued;
   sendPacket = new ArNetPacket(packet->getLength() + 5);
   sendPacket->duplicatePacket(packet);
   if (myDebugLogging && sendPacket->getCommand() <= 255 && 
       loggingString != NULL && loggingString[0] != '\0')
     sendPacket->setArbitraryString(loggingString);
+  queued.myPacket = sendPacket;
+  queued.myShared = NULL;
+  queued.mySource = NULL;
   myDataMutex.lock();
-  myPacketList.push_back(sendPacket);
+  queuePacket(&queued, priority);
   /* this shouldn't really ever be in doubt
   if (myDebugLogging && sendPacket->getCommand() <= 255 && 
       loggingString != NULL && loggingString[0] != '\0')
@@ -124,31 +173,284 @@ AREXPORT void ArNetPacketSenderTcp::sendPacket(ArNetPacket *packet,
   myDataMutex.unlock();
 }
 
+/**
+   This takes a reference to the packet (which is released once the
+   packet has been sent), the packet must already be finalized.  This
+   lets one packet go out to many clients without each sender making
+   its own copy.
+**/
+AREXPORT void ArNetPacketSenderTcp::sendSharedPacket(
+	ArNetSharedPacket *packet, Priority priority)
+{
+  QueuedPacket queued;
+  packet->addRef();
+  queued.myPacket = packet->getPacket();
+  queued.myShared = packet;
+  queued.mySource = NULL;
+  myDataMutex.lock();
+  queuePacket(&queued, priority);
+  myDataMutex.unlock();
+}
+
+/**
+   The source stays at the front of the queue for its priority (with
+   everything sent after it at that priority waiting behind it) until
+   it says it has no more packets, each of its packets is only made
+   once the one before it has been written.  This takes ownership of
+   the source and deletes it when it's done (or when this sender is
+   destroyed).
+**/
+AREXPORT void ArNetPacketSenderTcp::sendPacketSource(
+	ArNetPacketSource *source, Priority priority)
+{
+  QueuedPacket queued;
+  queued.myPacket = NULL;
+  queued.myShared = NULL;
+  queued.mySource = source;
+  myDataMutex.lock();
+  queuePacket(&queued, priority);
+  myDataMutex.unlock();
+}
+
+/// Must be called with myDataMutex locked
+void ArNetPacketSenderTcp::queuePacket(QueuedPacket *queued, 
+				       Priority priority)
+{
+  if (priority < 0 || priority >= PRIORITY_COUNT)
+    priority = PRIORITY_STATUS;
+  queued->myQueued.setToNow();
+  queued->myStarted = false;
+  myPacketLists[priority].push_back(*queued);
+  myQueueDepths[priority]++;
+  if (queued->myPacket != NULL)
+    myQueueBytes[priority] += queued->myPacket->getLength();
+}
+
+/**
+   This is deficit round robin, each queue gets its weight times the
+   quantum added to its deficit when its turn comes, and sends while
+   its deficit is positive (the whole packet gets taken off, so it can
+   go negative, it then has to wait more turns to make that up).  Must
+   be called with myDataMutex locked.
+
+   @return the queue to send from, or -1 if they're all empty
+**/
+int ArNetPacketSenderTcp::pickQueue(void)
+{
+  const long quantum = 1500;
+  int i;
+  bool anything = false;
+
+  for (i = 0; i < PRIORITY_COUNT; i++)
+  {
+    if (myQueueDepths[i] > 0)
+      anything = true;
+    // empty queues don't get to save up
+    else if (myDeficits[i] > 0)
+      myDeficits[i] = 0;
+  }
+  if (!anything)
+    return -1;
+
+  while (myQueueDepths[myCurrentQueue] == 0 || 
+	 myDeficits[myCurrentQueue] <= 0)
+  {
+    myCurrentQueue = (myCurrentQueue + 1) % PRIORITY_COUNT;
+    if (myQueueDepths[myCurrentQueue] > 0)
+      myDeficits[myCurrentQueue] += quantum * myWeights[myCurrentQueue];
+  }
+  return myCurrentQueue;
+}
+
+void ArNetPacketSenderTcp::finishedPacket(void)
+{
+  if (myShared != NULL)
+    myShared->release();
+  else if (myPacket != mySourcePacket)
+    delete myPacket;
+  myPacket = NULL;
+  myShared = NULL;
+}
+
+/**
+   When there's a limit, bytes are let out at that rate, and up to
+   half a second worth of unused sending can be saved up.
+**/
+AREXPORT void ArNetPacketSenderTcp::setBandwidthLimit(long bytesPerSecond)
+{
+  myDataMutex.lock();
+  if (bytesPerSecond < 0)
+    bytesPerSecond = 0;
+  myBandwidthLimit = bytesPerSecond;
+  myBandwidthAvailable = 0;
+  myBandwidthLastFilled.setToNow();
+  myDataMutex.unlock();
+}
+
+AREXPORT long ArNetPacketSenderTcp::getBandwidthLimit(void)
+{
+  return myBandwidthLimit;
+}
+
+AREXPORT void ArNetPacketSenderTcp::setPriorityWeight(Priority priority, 
+						      int weight)
+{
+  if (priority < 0 || priority >= PRIORITY_COUNT)
+    return;
+  myDataMutex.lock();
+  if (weight < 1)
+    weight = 1;
+  myWeights[priority] = weight;
+  myDataMutex.unlock();
+}
+
+AREXPORT long ArNetPacketSenderTcp::getQueueDepth(Priority priority)
+{
+  long ret;
+  if (priority < 0 || priority >= PRIORITY_COUNT)
+    return 0;
+  myDataMutex.lock();
+  ret = myQueueDepths[priority];
+  myDataMutex.unlock();
+  return ret;
+}
+
+AREXPORT long ArNetPacketSenderTcp::getQueueBytes(Priority priority)
+{
+  long ret;
+  if (priority < 0 || priority >= PRIORITY_COUNT)
+    return 0;
+  myDataMutex.lock();
+  ret = myQueueBytes[priority];
+  myDataMutex.unlock();
+  return ret;
+}
+
+AREXPORT double ArNetPacketSenderTcp::getAverageQueueDelay(Priority priority)
+{
+  double ret = 0;
+  if (priority < 0 || priority >= PRIORITY_COUNT)
+    return 0;
+  myDataMutex.lock();
+  if (myQueueDelayCounts[priority] > 0)
+    ret = (myQueueDelayTotals[priority] / 
+	   (double)myQueueDelayCounts[priority]);
+  myDataMutex.unlock();
+  return ret;
+}
+
+AREXPORT long ArNetPacketSenderTcp::getMaxQueueDelay(Priority priority)
+{
+  long ret;
+  if (priority < 0 || priority >= PRIORITY_COUNT)
+    return 0;
+  myDataMutex.lock();
+  ret = myQueueDelayMaxes[priority];
+  myDataMutex.unlock();
+  return ret;
+}
+
+AREXPORT void ArNetPacketSenderTcp::logQueueStats(void)
+{
+  const char *names[PRIORITY_COUNT] = { "Control", "Status", "Bulk" };
+  int i;
+
+  myDataMutex.lock();
+  for (i = 0; i < PRIORITY_COUNT; i++)
+    ArLog::log(ArLog::Terse, 
+	       "%s%-10s queue %5ld pkts %10ld B, waited %7.1f ms avg %7ld ms max (%ld sent)",
+	       myLoggingPrefix.c_str(), names[i], myQueueDepths[i],
+	       myQueueBytes[i],
+	       (myQueueDelayCounts[i] > 0 ? 
+		myQueueDelayTotals[i] / myQueueDelayCounts[i] : 0.0),
+	       myQueueDelayMaxes[i], myQueueDelayCounts[i]);
+  if (myBandwidthLimit > 0)
+    ArLog::log(ArLog::Terse, "%sLimited to %ld B/sec", 
+	       myLoggingPrefix.c_str(), myBandwidthLimit);
+  myDataMutex.unlock();
+}
+
+AREXPORT void ArNetPacketSenderTcp::resetQueueStats(void)
+{
+  int i;
+  myDataMutex.lock();
+  for (i = 0; i < PRIORITY_COUNT; i++)
+  {
+    myQueueDelayTotals[i] = 0;
+    myQueueDelayCounts[i] = 0;
+    myQueueDelayMaxes[i] = 0;
+  }
+  myDataMutex.unlock();
+}
+
 AREXPORT bool ArNetPacketSenderTcp::sendData(void)
 {
   int ret;
   ArTime start;
   start.setToNow();
   //printf("sendData %g\n", start.mSecSince() / 1000.0);
+  int queue;
+  int toWrite;
+  long delay;
+  ArPreciseTime now;
+  double secs;
+  QueuedPacket *front;
   myDataMutex.lock();
   // if we have no data to send count it as a good send
-  if (myPacketList.begin() == myPacketList.end() && myPacket == NULL)
+  if (myPacket == NULL && pickQueue() < 0)
     myLastGoodSend.setToNow();
 
-  while (myPacketList.begin() != myPacketList.end() || myPacket != NULL)
+  for (;;)
   {
     if (myPacket == NULL)
     {
       //printf("!startedSending %g\n", start.mSecSince() / 1000.0);
-      myPacket = myPacketList.front();
-      myPacketList.pop_front();
+      if ((queue = pickQueue()) < 0)
+	break;
+      front = &myPacketLists[queue].front();
+      // the time it waited is until it started going out
+      if (!front->myStarted)
+      {
+	front->myStarted = true;
+	delay = front->myQueued.uSecSince();
+	myQueueDelayTotals[queue] += delay / 1000.0;
+	myQueueDelayCounts[queue]++;
+	if (delay / 1000 > myQueueDelayMaxes[queue])
+	  myQueueDelayMaxes[queue] = delay / 1000;
+      }
+      // sources stay at the front until they're out of packets
+      if (front->mySource != NULL)
+      {
+	if (mySourcePacket == NULL)
+	  mySourcePacket = new ArNetPacket;
+	mySourcePacket->empty();
+	if (!front->mySource->getNextPacket(mySourcePacket))
+	{
+	  delete front->mySource;
+	  myPacketLists[queue].pop_front();
+	  myQueueDepths[queue]--;
+	  continue;
+	}
+	mySourcePacket->finalizePacket();
+	myPacket = mySourcePacket;
+	myShared = NULL;
+      }
+      else
+      {
+	myPacket = front->myPacket;
+	myShared = front->myShared;
+	myPacketLists[queue].pop_front();
+	myQueueDepths[queue]--;
+	myQueueBytes[queue] -= myPacket->getLength();
+      }
       myAlreadySent = 0;
       myBuf = myPacket->getBuf();
       myLength = myPacket->getLength();
+      myDeficits[queue] -= myLength;
       if (myDebugLogging && myPacket->getCommand() <= 255)
-	ArLog::log(ArLog::Normal, "%s %s Starting sending tcp command %d",
-		   myLoggingPrefix.c_str(), 
-		   myPacket->getArbitraryString(), myPacket->getCommand());
+	ArBinaryLog::log(&ourStartingSendingMsg,
+			 myLoggingPrefix.c_str(), 
+			 myPacket->getArbitraryString(), myPacket->getCommand());
       if (myPacket->getCommand() == 0)// || myPacket->getCommand() > 1000)
       {
 	ArLog::log(ArLog::Normal, "%sgetCommand is %d when it probably shouldn't be", myLoggingPrefix.c_str(), myPacket->getCommand());
@@ -158,14 +460,37 @@ AREXPORT bool ArNetPacketSenderTcp::sendData(void)
     {
       ArLog::log(ArLog::Terse, "%sArNetPacketSenderTcp: getLength for command %d packet is bad at %d", 
 		 myLoggingPrefix.c_str(), myPacket->getCommand(), myLength);
-      delete myPacket;
-      myPacket = NULL;
+      finishedPacket();
       continue;
     }
     if (myLength - myAlreadySent == 0)
       ArLog::log(ArLog::Normal, "%sHave no data to send... but ...",
 		 myLoggingPrefix.c_str());
-    ret = mySocket->write(&myBuf[myAlreadySent], myLength - myAlreadySent);
+    toWrite = myLength - myAlreadySent;
+    if (myBandwidthLimit > 0)
+    {
+      // this is in seconds (not microseconds in a long) so a long
+      // idle can't overflow it, and the fill time always moves up so
+      // a bad reading can't stop the refilling
+      now.setToNow();
+      if ((secs = myBandwidthLastFilled.secSince(now)) > 0)
+      {
+	myBandwidthAvailable += secs * myBandwidthLimit;
+	if (myBandwidthAvailable > myBandwidthLimit / 2.0)
+	  myBandwidthAvailable = myBandwidthLimit / 2.0;
+      }
+      myBandwidthLastFilled = now;
+      // we're holding back, so the connection isn't backed up
+      if (myBandwidthAvailable < 1)
+      {
+	myLastGoodSend.setToNow();
+	myDataMutex.unlock();
+	return true;
+      }
+      if (toWrite > myBandwidthAvailable)
+	toWrite = (int)myBandwidthAvailable;
+    }
+    ret = mySocket->write(&myBuf[myAlreadySent], toWrite);
     if (ret < 0)
     {
       // we didn't send any data so make sure we've sent some recently enough
@@ -246,22 +571,24 @@ AREXPORT bool ArNetPacketSenderTcp::sendData(void)
       // we sent some data, count it as a good send
       myLastGoodSend.setToNow();
       myAlreadySent += ret;
+      if (myBandwidthLimit > 0)
+	myBandwidthAvailable -= ret;
       if (myAlreadySent == myLength)
       {
 	if (myDebugLogging && myPacket->getCommand() <= 255)
-	  ArLog::log(ArLog::Normal, "%s%sFinished sending tcp command %d",
-		     myLoggingPrefix.c_str(), myPacket->getArbitraryString(), 
-		     myPacket->getCommand());
+	  ArBinaryLog::log(&ourFinishedSendingMsg,
+			   myLoggingPrefix.c_str(), 
+			   myPacket->getArbitraryString(), 
+			   myPacket->getCommand());
 	//printf("sent one %g\n", start.mSecSince() / 1000.0);
-	delete myPacket;
-	myPacket = NULL;
+	finishedPacket();
 	continue;
       }
       else if (myDebugLogging && myPacket->getCommand() <= 255)
-	ArLog::log(ArLog::Normal, 
-		   "%s%sContinue sending tcp command %d, sent %d",
-		   myLoggingPrefix.c_str(), myPacket->getArbitraryString(), 
-		   myPacket->getCommand(), ret);
+	ArBinaryLog::log(&ourContinueSendingMsg,
+			 myLoggingPrefix.c_str(), 
+			 myPacket->getArbitraryString(), 
+			 myPacket->getCommand(), ret);
 
     }
     else
@@ -27,10 +27,56 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 
 #include "Aria.h"
 #include "ArNetPacket.h"
+#include "ArNetSharedPacket.h"
 
+/// Makes packets for an ArNetPacketSenderTcp as its socket drains
+/**
+   This is for sending big things (like files) without putting all of
+   their packets in the send list at once, the sender asks for the
+   next packet only once the one before it has been written to the
+   socket, so only one packet's worth of memory is used no matter how
+   big the thing being sent is.
+**/
+class ArNetPacketSource
+{
+public:
+  /// Constructor
+  ArNetPacketSource() {}
+  /// Destructor
+  virtual ~ArNetPacketSource() {}
+  /// Fills in the next packet (including its command), false if done
+  /**
+     The packet is empty when this is called, this should put the data
+     in it and set its command, the sender will finalize it.  If this
+     returns false the sender deletes this source.
+  **/
+  virtual bool getNextPacket(ArNetPacket *packet) = 0;
+};
+
+/// Sends packets out a TCP socket
+/**
+   Packets are queued by priority (see Priority) and the queues are
+   drained with deficit round robin, each priority gets to send its
+   weight in bytes (times a quantum) in turn.  So status updates and
+   commands get out right away even when there's a big transfer being
+   sent, but the big transfer still gets its share.  A packet that has
+   started going out is always finished before the next one is started
+   since they share the one stream.
+
+   The sending can also be capped at a number of bytes per second with
+   setBandwidthLimit().
+**/
 class ArNetPacketSenderTcp
 {
 public:
+  /// The priorities packets can be sent with
+  enum Priority
+  {
+    PRIORITY_CONTROL = 0, ///< Commands and acknowledgements (weight 16)
+    PRIORITY_STATUS, ///< Status updates and most other data (weight 4)
+    PRIORITY_BULK, ///< Big transfers like files and maps (weight 1)
+    PRIORITY_COUNT ///< How many priorities there are
+  };
   /// Constructor
   AREXPORT ArNetPacketSenderTcp();
   /// Destructor
@@ -52,18 +98,82 @@ public:
 
   /// Sends a packet
   AREXPORT void sendPacket(ArNetPacket *packet, 
-			   const char *loggingString = "");
+			   const char *loggingString = "",
+			   Priority priority = PRIORITY_STATUS);
+
+  /// Sends a packet that is shared with other senders (without copying it)
+  AREXPORT void sendSharedPacket(ArNetSharedPacket *packet,
+				 Priority priority = PRIORITY_STATUS);
+
+  /// Sends packets from a source as the socket drains (takes ownership)
+  AREXPORT void sendPacketSource(ArNetPacketSource *source,
+				 Priority priority = PRIORITY_BULK);
 
   /// Tries to send the data there is to be sent
   AREXPORT bool sendData(void);
+
+  /// Caps how many bytes a second are sent (0 or less for no cap)
+  AREXPORT void setBandwidthLimit(long bytesPerSecond);
+  /// Gets the cap on how many bytes a second are sent (0 for no cap)
+  AREXPORT long getBandwidthLimit(void);
+  /// Sets how much of the link a priority gets compared to the others
+  AREXPORT void setPriorityWeight(Priority priority, int weight);
+
+  /// Gets how many packets (or sources) are waiting at a priority
+  AREXPORT long getQueueDepth(Priority priority);
+  /// Gets how many bytes are waiting at a priority (not counting sources)
+  AREXPORT long getQueueBytes(Priority priority);
+  /// Gets the average msecs packets at a priority waited before going out
+  AREXPORT double getAverageQueueDelay(Priority priority);
+  /// Gets the most msecs a packet at a priority waited before going out
+  AREXPORT long getMaxQueueDelay(Priority priority);
+  /// Logs the queue depths and delays
+  AREXPORT void logQueueStats(void);
+  /// Resets the queue delay stats
+  AREXPORT void resetQueueStats(void);
 protected:
+  /// A packet waiting to be sent, either one we own, a shared one,
+  /// or a source that makes packets
+  struct QueuedPacket
+  {
+    ArNetPacket *myPacket;
+    ArNetSharedPacket *myShared;
+    ArNetPacketSource *mySource;
+    // when it was queued, for the stats
+    ArPreciseTime myQueued;
+    // if a source has started making packets
+    bool myStarted;
+  };
+  /// Puts a packet on the queue for its priority
+  void queuePacket(QueuedPacket *queued, Priority priority);
+  /// Picks the next queue to send from (with round robin)
+  int pickQueue(void);
+  /// Drops our hold on the packet currently being sent
+  void finishedPacket(void);
   ArMutex myDataMutex;
   bool myDebugLogging;
   std::string myLoggingPrefix;
   ArLog::LogLevel myVerboseLogLevel;
   ArSocket *mySocket;
-  std::list<ArNetPacket *> myPacketList;
+  std::list<QueuedPacket> myPacketLists[PRIORITY_COUNT];
+  // how many bytes each priority can send before it's the next one's turn
+  long myDeficits[PRIORITY_COUNT];
+  int myWeights[PRIORITY_COUNT];
+  int myCurrentQueue;
+  // std::list::size is slow so we count these ourselves
+  long myQueueDepths[PRIORITY_COUNT];
+  long myQueueBytes[PRIORITY_COUNT];
+  double myQueueDelayTotals[PRIORITY_COUNT];
+  long myQueueDelayCounts[PRIORITY_COUNT];
+  long myQueueDelayMaxes[PRIORITY_COUNT];
+  // the bandwidth limit and how many bytes we can send now
+  long myBandwidthLimit;
+  double myBandwidthAvailable;
+  ArPreciseTime myBandwidthLastFilled;
   ArNetPacket *myPacket;
+  ArNetSharedPacket *myShared;
+  // the packet sources put their packets in, made when first needed
+  ArNetPacket *mySourcePacket;
   int myAlreadySent;
   const char *myBuf;
   int myLength;
@@ -0,0 +1,75 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "Aria.h"
+#include "ArExport.h"
+#include "ArNetSharedPacket.h"
+
+/**
+   If the packet came in off the wire (so it already has its footer)
+   and its command is the one we want then the bytes are used as they
+   are, otherwise the header is rewritten and the checksum redone
+   here, once, instead of for every client it goes out to.
+
+   @param packet the packet to copy
+
+   @param command the command this should go out as, 0 means to use
+   the command the packet already has
+**/
+AREXPORT ArNetSharedPacket::ArNetSharedPacket(ArNetPacket *packet,
+					      ArTypes::UByte2 command) :
+  myRefCount(1),
+  myPacket(packet->getLength() + 5)
+{
+  myRefMutex.setLogName("ArNetSharedPacket::myRefMutex");
+  myPacket.duplicatePacket(packet);
+  if (command != 0 && command != myPacket.getCommand())
+  {
+    myPacket.setCommand(command);
+    myPacket.finalizePacket();
+  }
+  else if (!myPacket.getAddedFooter())
+    myPacket.finalizePacket();
+}
+
+AREXPORT ArNetSharedPacket::~ArNetSharedPacket()
+{
+}
+
+AREXPORT void ArNetSharedPacket::addRef(void)
+{
+  myRefMutex.lock();
+  myRefCount++;
+  myRefMutex.unlock();
+}
+
+AREXPORT void ArNetSharedPacket::release(void)
+{
+  int refCount;
+  myRefMutex.lock();
+  refCount = --myRefCount;
+  myRefMutex.unlock();
+  if (refCount <= 0)
+    delete this;
+}
@@ -0,0 +1,70 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#ifndef ARNETSHAREDPACKET_H
+#define ARNETSHAREDPACKET_H
+
+#include "Aria.h"
+#include "ArNetPacket.h"
+
+/// A finalized network packet whose wire bytes are shared between senders
+/**
+   This is used when the same packet goes out to many clients (mostly
+   by the forwarders), so that the packet is copied and checksummed
+   once and then each ArNetPacketSenderTcp just holds a reference to
+   it instead of duplicating it.
+
+   The packet is created with a reference count of one, everyone that
+   keeps a pointer to it must call addRef() and then release() when
+   done with it, the creator must release() it too.  When the count
+   reaches zero the packet deletes itself, so never delete one of
+   these directly.
+**/
+class ArNetSharedPacket
+{
+public:
+  /// Constructor, copies the packet and sets its command to command
+  AREXPORT ArNetSharedPacket(ArNetPacket *packet, 
+			     ArTypes::UByte2 command = 0);
+  /// Adds a reference to this packet
+  AREXPORT void addRef(void);
+  /// Releases a reference to this packet (deleting it if it was the last)
+  AREXPORT void release(void);
+  /// Gets the packet (which must not be modified)
+  ArNetPacket *getPacket(void) { return &myPacket; }
+  /// Gets the command of the packet
+  ArTypes::UByte2 getCommand(void) { return myPacket.getCommand(); }
+  /// Gets the total length of the packet as it goes on the wire
+  ArTypes::UByte2 getLength(void) { return myPacket.getLength(); }
+  /// Gets the wire bytes of the packet
+  const char *getBuf(void) { return myPacket.getBuf(); }
+protected:
+  /// Destructor, protected since release() is what deletes
+  AREXPORT ~ArNetSharedPacket();
+  ArMutex myRefMutex;
+  int myRefCount;
+  ArNetPacket myPacket;
+};
+
+#endif // ARNETSHAREDPACKET_H
@@ -39,6 +39,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArServerInfoDrawings.h"
 #include "ArServerInfoRobot.h"
 #include "ArServerInfoSensor.h"
+#include "ArServerInfoSyncTasks.h"
 #include "ArServerHandlerMap.h"
 #include "ArServerMode.h"
 #include "ArServerModeDrive.h"
@@ -165,6 +166,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
    <ul>
     <li>ArServerInfoRobot - Supplies clients with basic robot state information (current position and velocity, active server mode and status, battery voltage)</li>
     <li>ArServerInfoSensor - Supplies clients with current sensor readings (Sonar or Laser)</li>
+    <li>ArServerInfoSyncTasks - Supplies clients with how long each of the robot's sync tasks takes to run</li>
     <li>ArServerHandlerMap - Supplies clients with data from an ArMap</li>
     <li>ArServerInfoDrawings - Supplies clients with a set of graphical figures to be displayed with the map (e.g. point sets, lines, circles)</li>
     <li>ArServerHandlerCamera - Allows clients to control a pan-tilt camera and provides information about its current position</li>
@@ -331,11 +331,12 @@ AREXPORT void ArRangeBuffer::reset(void)
 AREXPORT void ArRangeBuffer::clearOlderThan(int milliSeconds)
 {
   std::list<ArPoseWithTime *>::iterator it;
+  ArTime now;
 
   beginInvalidationSweep();
   for (it = myBuffer.begin(); it != myBuffer.end(); ++it)
   {
-    if ((*it)->getTime().mSecSince() > milliSeconds)
+    if ((*it)->getTime().mSecSince(now) > milliSeconds)
       invalidateReading(it);
   }
   endInvalidationSweep();
@@ -450,7 +451,7 @@ AREXPORT void ArRangeBuffer::addReading(double x, double y)
       myInvalidBuffer.pop_front();
     }
     else
-      myBuffer.push_front(new ArPoseWithTime(x, y));
+      myBuffer.push_front(new ArPoseWithTime(x, y, 0, ArTime()));
   }
   else if ((myRevIterator = myBuffer.rbegin()) != myBuffer.rend())
   {
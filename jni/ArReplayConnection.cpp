@@ -0,0 +1,333 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "ArExport.h"
+#include "ariaOSDef.h"
+#include "ArReplayConnection.h"
+#include "ArRobotPacketRecorder.h"
+#include "ArBasePacket.h"
+#include "ArLog.h"
+
+AREXPORT ArReplayConnection::ArReplayConnection()
+{
+  myStatus = STATUS_NEVER_OPENED;
+  myFile = NULL;
+  mySpeed = 0;
+  myPacketLength = 0;
+  myPacketUsed = 0;
+  myPacketSec = 0;
+  myPacketNSec = 0;
+  myStartedUSec = 0;
+  myNumReplayed = 0;
+  myDrivingClock = false;
+  setReplayFile(NULL);
+  buildStrMap();
+}
+
+AREXPORT ArReplayConnection::~ArReplayConnection()
+{
+  close();
+}
+
+/**
+   @param fileName the recording to play back, if NULL then
+   robotPackets.rec
+**/
+AREXPORT void ArReplayConnection::setReplayFile(const char *fileName)
+{
+  if (fileName == NULL)
+    myFileName = "robotPackets.rec";
+  else
+    myFileName = fileName;
+}
+
+AREXPORT bool ArReplayConnection::openSimple(void)
+{
+  if (internalOpen() == 0)
+    return true;
+  else
+    return false;
+}
+
+/**
+   @param fileName the recording to play back, if NULL (default) then
+   robotPackets.rec
+   @return 0 for success, otherwise one of the open enums
+   @see getOpenMessage
+**/
+AREXPORT int ArReplayConnection::open(const char *fileName)
+{
+  setReplayFile(fileName);
+  return internalOpen();
+}
+
+int ArReplayConnection::internalOpen(void)
+{
+  const char *magic = ArRobotPacketRecorder::getMagic();
+  char buf[1024];
+  unsigned char lengthBuf[2];
+  ArTypes::UByte2 headerLength = 0;
+  ArTypes::UByte4 version;
+
+  close();
+  if ((myFile = ArUtil::fopen(myFileName.c_str(), "rb")) == NULL)
+  {
+    myStatus = STATUS_OPEN_FAILED;
+    return OPEN_FILE_NOT_FOUND;
+  }
+
+  if (fread(buf, 1, strlen(magic), myFile) != strlen(magic) ||
+      strncmp(buf, magic, strlen(magic)) != 0 ||
+      fread(lengthBuf, 1, 2, myFile) != 2 ||
+      (headerLength = lengthBuf[0] | (lengthBuf[1] << 8)) > sizeof(buf) ||
+      fread(buf, 1, headerLength, myFile) != headerLength)
+  {
+    fclose(myFile);
+    myFile = NULL;
+    myStatus = STATUS_OPEN_FAILED;
+    return OPEN_NOT_A_RECORDING;
+  }
+
+  ArBasePacket header(headerLength, 0, buf);
+  header.setLength(headerLength);
+  version = header.bufToUByte4();
+  if (version != ArRobotPacketRecorder::VERSION)
+  {
+    ArLog::log(ArLog::Terse, 
+	       "ArReplayConnection: %s is version %u, only version %d can be played back",
+	       myFileName.c_str(), version, ArRobotPacketRecorder::VERSION);
+    fclose(myFile);
+    myFile = NULL;
+    myStatus = STATUS_OPEN_FAILED;
+    return OPEN_BAD_VERSION;
+  }
+  char str[256];
+  header.bufToStr(str, sizeof(str));
+  myName = str;
+  header.bufToStr(str, sizeof(str));
+  myType = str;
+  header.bufToStr(str, sizeof(str));
+  mySubType = str;
+  double x = header.bufToByte4();
+  double y = header.bufToByte4();
+  double th = header.bufToByte4();
+  myPose.setPose(x, y, th);
+
+  myPacketLength = 0;
+  myPacketUsed = 0;
+  myPacketSec = 0;
+  myPacketNSec = 0;
+  myNumReplayed = 0;
+
+  // get the real time before switching over to the virtual clock
+  ArTime::setVirtualClock(false);
+  myStarted.setToNow();
+  myStartedUSec = ArUtil::getTimeUSec();
+  ArTime::setVirtualNow(myStarted.getSec(), myStarted.getNSec());
+  ArTime::setVirtualClock(true);
+  myDrivingClock = true;
+  myPacketTime.setToNow();
+
+  ArLog::log(ArLog::Normal, 
+	     "ArReplayConnection: Playing back %s (recorded from %s %s %s) at %s",
+	     myFileName.c_str(), myName.c_str(), myType.c_str(), 
+	     mySubType.c_str(), 
+	     mySpeed > 0 ? "recorded speed" : "full speed");
+  myStatus = STATUS_OPEN;
+  return 0;
+}
+
+void ArReplayConnection::buildStrMap(void)
+{
+  myStrMap[OPEN_FILE_NOT_FOUND] = "File not found.";
+  myStrMap[OPEN_NOT_A_RECORDING] = "File is not a packet recording.";
+  myStrMap[OPEN_BAD_VERSION] = "Recording is a version that can't be played back.";
+}
+
+AREXPORT const char * ArReplayConnection::getOpenMessage(int messageNumber)
+{
+  return myStrMap[messageNumber].c_str();
+}
+
+AREXPORT int ArReplayConnection::getStatus(void)
+{
+  return myStatus;
+}
+
+/**
+   This also puts ArTime back on the real clock.
+**/
+AREXPORT bool ArReplayConnection::close(void)
+{
+  if (myFile != NULL)
+  {
+    fclose(myFile);
+    myFile = NULL;
+  }
+  if (myStatus == STATUS_OPEN)
+    myStatus = STATUS_CLOSED_NORMALLY;
+  if (myDrivingClock)
+  {
+    ArTime::setVirtualClock(false);
+    myDrivingClock = false;
+  }
+  return true;
+}
+
+bool ArReplayConnection::readNextPacket(void)
+{
+  char buf[10];
+  ArTypes::UByte2 length;
+
+  if (myFile == NULL || fread(buf, 1, sizeof(buf), myFile) != sizeof(buf))
+    return false;
+  ArBasePacket record(sizeof(buf), 0, buf);
+  record.setLength(sizeof(buf));
+  myPacketSec = record.bufToUByte4();
+  myPacketNSec = record.bufToUByte4();
+  length = record.bufToUByte2();
+  if (length > sizeof(myPacketBuf) ||
+      fread(myPacketBuf, 1, length, myFile) != length)
+  {
+    ArLog::log(ArLog::Normal, 
+	       "ArReplayConnection: %s ends in the middle of a packet",
+	       myFileName.c_str());
+    return false;
+  }
+  myPacketLength = length;
+  myPacketUsed = 0;
+  return true;
+}
+
+/**
+   When playing back as fast as it can this is always true, otherwise
+   this sleeps until the packet is due, unless that is more than msWait
+   away.
+**/
+bool ArReplayConnection::waitForPacket(unsigned int msWait)
+{
+  long dueUSec;
+  long waitUSec;
+
+  if (mySpeed <= 0)
+    return true;
+  dueUSec = (long) ((myPacketSec * 1000000.0 + myPacketNSec / 1000) / 
+		    mySpeed);
+  waitUSec = dueUSec - (long) (ArUtil::getTimeUSec() - myStartedUSec);
+  if (waitUSec <= 0)
+    return true;
+  if (waitUSec > (long) msWait * 1000)
+  {
+    if (msWait > 0)
+      ArUtil::sleep(msWait);
+    return false;
+  }
+  ArUtil::sleep((waitUSec + 999) / 1000);
+  return true;
+}
+
+void ArReplayConnection::setClockToPacket(void)
+{
+  time_t sec = myStarted.getSec() + myPacketSec;
+  long nSec = myStarted.getNSec() + myPacketNSec;
+
+  if (nSec >= 1000000000)
+  {
+    nSec -= 1000000000;
+    sec++;
+  }
+  ArTime::setVirtualNow(sec, nSec);
+  myPacketTime.setToNow();
+}
+
+void ArReplayConnection::finished(void)
+{
+  ArLog::log(ArLog::Normal, 
+	     "ArReplayConnection: Finished playing back %s, %lu packets covering %ld.%03ld seconds in %.3f seconds",
+	     myFileName.c_str(), myNumReplayed, myPacketSec, 
+	     myPacketNSec / 1000000,
+	     (ArUtil::getTimeUSec() - myStartedUSec) / 1000000.0);
+  // leave the virtual clock where it is until we're closed, so the
+  // robot doesn't see time jump around while it notices we're done
+  if (myFile != NULL)
+  {
+    fclose(myFile);
+    myFile = NULL;
+  }
+  myStatus = STATUS_CLOSED_NORMALLY;
+}
+
+/**
+   This only gives back data from one packet at a time.  When a new
+   packet is started the virtual clock is set to when it was recorded.
+**/
+AREXPORT int ArReplayConnection::read(const char *data, unsigned int size,
+				      unsigned int msWait)
+{
+  unsigned int num;
+
+  if (myStatus != STATUS_OPEN)
+    return -1;
+
+  if (myPacketUsed >= myPacketLength && !readNextPacket())
+  {
+    finished();
+    return -1;
+  }
+  if (myPacketUsed == 0)
+  {
+    if (!waitForPacket(msWait))
+      return 0;
+    setClockToPacket();
+    myNumReplayed++;
+  }
+
+  num = myPacketLength - myPacketUsed;
+  if (size < num)
+    num = size;
+  memcpy((char *)data, myPacketBuf + myPacketUsed, num);
+  myPacketUsed += num;
+  return num;
+}
+
+/**
+   The recording already has what the robot sent back, so this just
+   throws away what it is given.
+**/
+AREXPORT int ArReplayConnection::write(const char *data, unsigned int size)
+{
+  if (myStatus != STATUS_OPEN)
+    return -1;
+  return size;
+}
+
+AREXPORT ArTime ArReplayConnection::getTimeRead(int index)
+{
+  return myPacketTime;
+}
+
+AREXPORT bool ArReplayConnection::isTimeStamping(void)
+{
+  return true;
+}
@@ -0,0 +1,144 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#ifndef ARREPLAYCONNECTION_H
+#define ARREPLAYCONNECTION_H
+
+#include <stdio.h>
+#include <string>
+#include "ariaTypedefs.h"
+#include "ariaUtil.h"
+#include "ArDeviceConnection.h"
+
+/// Plays back packets recorded with ArRobotPacketRecorder
+/**
+   This is a connection that reads its data from a recording made by
+   ArRobotPacketRecorder, so that a robot loop can be rerun on the same
+   data for debugging or for benchmarking (see
+   ArSyncTask::setStatsEnabled for timing the tasks).
+
+   While it is open this drives the virtual clock (ArTime::setVirtualClock)
+   so that ArTime and ArPreciseTime give the time each packet was
+   recorded at (offset from when the replay started), which means the
+   robot loop sees the same time between packets whether the replay is
+   going at the recorded speed or as fast as it can (setSpeed).
+
+   Each read only gives back data from one packet, so the packet
+   receiver timestamps each packet with its own time.  Anything written
+   to the connection is thrown away.  When the recording runs out the
+   connection closes itself, and ArRobot will then drop the
+   connection (so ArRobot::run returns).
+
+   Since there is only one virtual clock only one of these should be
+   open at a time.
+**/
+class ArReplayConnection: public ArDeviceConnection
+{
+ public:
+  /// Constructor
+  AREXPORT ArReplayConnection();
+  /// Destructor also closes connection
+  AREXPORT virtual ~ArReplayConnection();
+
+  /// Opens the recording to play back
+  AREXPORT int open(const char *fileName = NULL);
+  /// Sets the recording to play back
+  AREXPORT void setReplayFile(const char *fileName);
+  /// Gets the recording to play back
+  AREXPORT const char *getReplayFile(void) { return myFileName.c_str(); }
+  /// Sets how fast to play back (1 is as recorded, 0 is as fast as it can)
+  AREXPORT void setSpeed(double speed) { mySpeed = speed; }
+  /// Gets how fast to play back (1 is as recorded, 0 is as fast as it can)
+  AREXPORT double getSpeed(void) const { return mySpeed; }
+  /// Gets how many packets have been played back
+  AREXPORT unsigned long getNumReplayed(void) const { return myNumReplayed; }
+
+  AREXPORT virtual bool openSimple(void);  
+  AREXPORT virtual int getStatus(void);
+  AREXPORT virtual bool close(void);
+  AREXPORT virtual int read(const char *data, unsigned int size, 
+			    unsigned int msWait = 0);
+  AREXPORT virtual int write(const char *data, unsigned int size);
+  AREXPORT virtual const char * getOpenMessage(int messageNumber);
+  AREXPORT virtual ArTime getTimeRead(int index);
+  AREXPORT virtual bool isTimeStamping(void);
+
+  /// Gets the name of the robot that was recorded
+  AREXPORT const char *getRobotName(void) const { return myName.c_str(); }
+  /// Gets the type of the robot that was recorded
+  AREXPORT const char *getRobotType(void) const { return myType.c_str(); }
+  /// Gets the subtype of the robot that was recorded
+  AREXPORT const char *getRobotSubType(void) const 
+    { return mySubType.c_str(); }
+  /// Gets the robot's pose when the recording started
+  AREXPORT ArPose getRobotPose(void) const { return myPose; }
+
+  enum Open { 
+      OPEN_FILE_NOT_FOUND = 1,  ///< Can't find the file
+      OPEN_NOT_A_RECORDING,     ///< Doesn't look like a recording
+      OPEN_BAD_VERSION          ///< Recording is a version we can't read
+  };
+
+protected:
+  /// Internal function used by open and openSimple
+  int internalOpen(void);
+  /// Reads the next packet from the recording
+  bool readNextPacket(void);
+  /// Waits until the packet we have is due (returns false if it isn't by then)
+  bool waitForPacket(unsigned int msWait);
+  /// Sets the virtual clock to when the packet we have came in
+  void setClockToPacket(void);
+  /// Closes the file and logs how it went
+  void finished(void);
+  void buildStrMap(void);
+
+  ArStrMap myStrMap;
+  int myStatus;
+  std::string myFileName;
+  FILE *myFile;
+  double mySpeed;
+
+  std::string myName;
+  std::string myType;
+  std::string mySubType;
+  ArPose myPose;
+
+  // the packet we're playing back, when it was recorded, and how much
+  // of it has been given out
+  char myPacketBuf[1024];
+  unsigned int myPacketLength;
+  unsigned int myPacketUsed;
+  long myPacketSec;
+  long myPacketNSec;
+  ArTime myPacketTime;
+
+  // when the replay started, the virtual clock starts there too (the
+  // usec one is real time, for pacing the replay)
+  ArPreciseTime myStarted;
+  unsigned long myStartedUSec;
+  bool myDrivingClock;
+  unsigned long myNumReplayed;
+};
+
+#endif // ARREPLAYCONNECTION_H
@@ -33,6 +33,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArTcpConnection.h"
 #include "ArSerialConnection.h"
 #include "ArLogFileConnection.h"
+#include "ArReplayConnection.h"
 #include "ariaUtil.h"
 #include "ArSocket.h"
 #include "ArCommands.h"
@@ -44,6 +45,22 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArRobotConfigPacketReader.h"
 #include "ariaInternal.h"
 #include "ArLaser.h"
+#include "ArBinaryLog.h"
+
+// the packet tracking messages, these are logged in binary if there
+// is a binary log open since there are so many of them
+static ArBinaryLog::Message ourRcvdPrePacketMsg(
+	ArLog::Normal, "Rcvd: prePacket (%ld) 0x%x at %ld (%ld)");
+static ArBinaryLog::Message ourRcvdPacketMsg(
+	ArLog::Normal, "Rcvd: Packet (%ld) 0x%x at %ld (%ld)");
+static ArBinaryLog::Message ourRcvdTimeTakenMsg(
+	ArLog::Normal, "Rcvd: time taken %ld");
+static ArBinaryLog::Message ourSentComMsg(
+	ArLog::Normal, "Sent: com(%d)");
+static ArBinaryLog::Message ourSentComIntMsg(
+	ArLog::Normal, "Sent: comInt(%d, %d)");
+static ArBinaryLog::Message ourSentCom2BytesMsg(
+	ArLog::Normal, "Sent: com2Bytes(%d, %d, %d)");
 
 /**
  * The parameters only rarely need to be specified.
@@ -90,6 +107,7 @@ AREXPORT ArRobot::ArRobot(const char *name, bool obsolete,
 {
   myMutex.setLogName("ArRobot::myMutex");
   setName(name);
+  resetPacketIDStats();
   myAriaExitCB.setName("ArRobotExit");
   myNoTimeWarningThisCycle = false;
   myGlobalPose.setPose(0, 0, 0);
@@ -131,6 +149,8 @@ AREXPORT ArRobot::ArRobot(const char *name, bool obsolete,
   myTimeoutTime = 8000;
   myStabilizingTime = 0;
   myCounter = 1;
+  myStateSnapshotSeq = 0;
+  mySensorInterpWorkers = NULL;
   myResolver = NULL;
   myNumSonar = 0;
 
@@ -174,6 +194,8 @@ AREXPORT ArRobot::~ArRobot()
 
   stopRunning();
   delete mySyncTaskRoot;
+  if (mySensorInterpWorkers != NULL)
+    delete mySensorInterpWorkers;
   ArUtil::deleteSetPairs(mySonars.begin(), mySonars.end());
   Aria::delRobot(this);
 
@@ -302,9 +324,9 @@ AREXPORT void ArRobot::setUpSyncList(void)
 
 AREXPORT void ArRobot::setUpPacketHandlers(void)
 {
-  addPacketHandler(&myMotorPacketCB, ArListPos::FIRST);
-  addPacketHandler(&myEncoderPacketCB, ArListPos::LAST);
-  addPacketHandler(&myIOPacketCB, ArListPos::LAST);
+  addPacketHandlerForID(&myMotorPacketCB, 0x32, 0xfe, ArListPos::FIRST);
+  addPacketHandlerForID(&myEncoderPacketCB, 0x90);
+  addPacketHandlerForID(&myIOPacketCB, 0xf0);
 }
 
 void ArRobot::reset(void)
@@ -805,6 +827,21 @@ AREXPORT int ArRobot::asyncConnectHandler(bool tryHarderToConnect)
       return 1;
     }
 
+    // a recording already has the connection in it, so there's
+    // nothing to say to the robot, but unlike the log file the cycle
+    // stays chained to the (recorded) sips
+    if (dynamic_cast<ArReplayConnection *>(myConn))
+    {
+      ArReplayConnection *con = dynamic_cast<ArReplayConnection *>(myConn);
+      myRobotName = con->getRobotName();
+      myRobotType = con->getRobotType();
+      myRobotSubType = con->getRobotSubType();
+      moveTo(con->getRobotPose());
+      madeConnection();
+      finishedConnection();
+      return 1;
+    }
+
 
     if (dynamic_cast<ArSerialConnection *>(myConn))
     {
@@ -819,20 +856,10 @@ AREXPORT int ArRobot::asyncConnectHandler(bool tryHarderToConnect)
 
   if (myAsyncConnectState >= 3)
   {
-    bool handled;
-    std::list<ArRetFunctor1<bool, ArRobotPacket *> *>::iterator it;
     while ((packet = myReceiver.receivePacket(0)) != NULL)
     {
       //printf("0x%x\n", packet->getID());
-      for (handled = false, it = myPacketHandlerList.begin(); 
-	   it != myPacketHandlerList.end() && handled == false; 
-	   it++)
-      {
-	if ((*it) != NULL && (*it)->invokeR(packet)) 
-	  handled = true;
-	else
-	  packet->resetRead();
-      }
+      dispatchPacket(packet);
     }
   }
 
@@ -1372,7 +1399,7 @@ AREXPORT bool ArRobot::madeConnection(void)
   paramFileName += "params/";
   paramFileName += myRobotSubType;
   paramFileName += ".p";
-  if ((loadedSubTypeParam = myParams->parseFile(paramFileName.c_str(), true, true)))
+  if ((loadedSubTypeParam = myParams->parseFileWithCache(paramFileName.c_str(), true, true)))
       ArLog::log(ArLog::Normal, 
 		 "Loaded robot parameters from %s.p", 
 		 myRobotSubType.c_str());
@@ -1385,8 +1412,8 @@ AREXPORT bool ArRobot::madeConnection(void)
   paramFileName += "params/";
   paramFileName += myRobotName;
   paramFileName += ".p";
-  if ((loadedNameParam = myParams->parseFile(paramFileName.c_str(),
-					     true, true)))
+  if ((loadedNameParam = myParams->parseFileWithCache(paramFileName.c_str(),
+						      true, true)))
   {
     if (loadedSubTypeParam)
       ArLog::log(ArLog::Normal, 
@@ -2063,13 +2090,14 @@ AREXPORT const ArRobotConfigPacketReader *ArRobot::getOrigRobotConfig(void) cons
    @param functor the functor to call when the packet comes in
    @param position whether to place the functor first or last
    @see remPacketHandler
+   @see addPacketHandlerForID
 **/
 AREXPORT void ArRobot::addPacketHandler(
 	ArRetFunctor1<bool, ArRobotPacket *> *functor, 
 	ArListPos::Pos position) 
 {
   if (position == ArListPos::FIRST)
-    myPacketHandlerList.push_front(functor);
+    myFirstPacketHandlerList.push_front(functor);
   else if (position == ArListPos::LAST)
     myPacketHandlerList.push_back(functor);
   else
@@ -2077,14 +2105,95 @@ AREXPORT void ArRobot::addPacketHandler(
 
 }
 
+/**
+   Adds a packet handler that is only offered packets whose IDs match
+   id in the bits set in idMask, (so 0x32 with a mask of 0xfe gets
+   0x32 and 0x33).  These handlers are offered their packets after
+   the handlers added with addPacketHandler at ArListPos::FIRST and
+   before the ones added at ArListPos::LAST (which are still offered
+   the packets none of these handle), and without going through all
+   the handlers for other packets, so this should be used for any
+   handler that only cares about certain packet IDs.  The handler
+   works the same as with addPacketHandler otherwise.
+
+   @param functor the functor to call when the packet comes in
+   @param id the packet ID to get
+   @param idMask which bits of the ID have to match
+   @param position whether to place the functor first or last for
+   each ID
+   @see remPacketHandler
+**/
+AREXPORT void ArRobot::addPacketHandlerForID(
+	ArRetFunctor1<bool, ArRobotPacket *> *functor, 
+	ArTypes::UByte id, ArTypes::UByte idMask, ArListPos::Pos position) 
+{
+  int i;
+
+  if (position != ArListPos::FIRST && position != ArListPos::LAST)
+  {
+    ArLog::log(ArLog::Terse, "ArRobot::addPacketHandlerForID: Invalid position.");
+    return;
+  }
+  for (i = 0; i < 256; i++)
+  {
+    if ((i & idMask) != (id & idMask))
+      continue;
+    if (position == ArListPos::FIRST)
+      myPacketHandlersByID[i].push_front(functor);
+    else
+      myPacketHandlersByID[i].push_back(functor);
+  }
+}
+
 /**
    @param functor the functor to remove from the list of packet handlers
    @see addPacketHandler
+   @see addPacketHandlerForID
 **/
 AREXPORT void ArRobot::remPacketHandler(
 	ArRetFunctor1<bool, ArRobotPacket *> *functor)
 {
+  int i;
+
+  myFirstPacketHandlerList.remove(functor);
   myPacketHandlerList.remove(functor);
+  for (i = 0; i < 256; i++)
+    myPacketHandlersByID[i].remove(functor);
+}
+
+AREXPORT unsigned long ArRobot::getPacketIDCount(ArTypes::UByte id) const
+{
+  return myPacketIDCounts[id];
+}
+
+AREXPORT double ArRobot::getPacketIDHandleUSecs(ArTypes::UByte id) const
+{
+  return myPacketIDHandleUSecs[id];
+}
+
+AREXPORT void ArRobot::resetPacketIDStats(void)
+{
+  int i;
+  for (i = 0; i < 256; i++)
+  {
+    myPacketIDCounts[i] = 0;
+    myPacketIDHandleUSecs[i] = 0;
+  }
+}
+
+AREXPORT void ArRobot::logPacketIDStats(void)
+{
+  int i;
+  ArLog::log(ArLog::Terse, "Packets received by %s:", getName());
+  for (i = 0; i < 256; i++)
+  {
+    if (myPacketIDCounts[i] == 0)
+      continue;
+    ArLog::log(ArLog::Terse, 
+	       "\t0x%02x %10lu pkts %12.0f usecs handling %8.1f usecs avg",
+	       i, myPacketIDCounts[i], myPacketIDHandleUSecs[i],
+	       myPacketIDHandleUSecs[i] / myPacketIDCounts[i]);
+  }
 }
 
 /**
@@ -2550,11 +2659,17 @@ AREXPORT void ArRobot::remUserTask(ArFunctor *functor)
    function to call.
    @param state Optional pointer to external ArSyncTask state variable; normally not needed
    and may be NULL or omitted.
+   @param parallel true if this task can run at the same time as the
+   other parallel sensor interp tasks next to it (see
+   setSensorInterpThreads), which means it must not depend on them, must
+   not lock the robot or change its state, and should only lock what it
+   owns (like its own range device)
    @see remSensorInterpTask
 **/
 AREXPORT bool ArRobot::addSensorInterpTask(const char *name, int position, 
 					      ArFunctor *functor,
-					      ArTaskState::State *state)
+					      ArTaskState::State *state,
+					      bool parallel)
 {
   ArSyncTask *proc;
   if (mySyncTaskRoot == NULL)
@@ -2565,9 +2680,63 @@ AREXPORT bool ArRobot::addSensorInterpTask(const char *name, int position,
     return false;
   
   proc->addNewLeaf(name, position, functor, state);
+  if (parallel && (proc = proc->findNonRecursive(functor)) != NULL)
+    proc->setParallel(true);
   return true;	
 }
 
+/**
+   The sensor interp tasks that were added as parallel (and are next
+   to each other in the list) are run at the same time on this many
+   threads plus the robot's own thread, then the rest of the cycle
+   goes on once they're all done.  The robot stays locked while they
+   run, so nothing else changes the robot's state, and the state
+   snapshot (getStateSnapshot) is taken right before they run (instead
+   of at the end of the cycle) so they can use it.  The threads don't
+   own the robot's lock, so the tasks must not lock the robot or call
+   anything that does (ArLaser holds its callbacks and runs them from
+   the robot's thread once the parallel tasks are done).  By default
+   this is 0, which runs everything one after another in the robot's
+   thread.
+
+   @param numThreads how many threads to use, 0 for none
+**/
+AREXPORT void ArRobot::setSensorInterpThreads(int numThreads)
+{
+  ArSyncTask *proc;
+  ArWorkerPool *oldWorkers;
+
+  if (numThreads < 0)
+    numThreads = 0;
+  if (mySyncTaskRoot == NULL || 
+      (proc = mySyncTaskRoot->findNonRecursive("Sensor Interp")) == NULL)
+    return;
+
+  lock();
+  oldWorkers = mySensorInterpWorkers;
+  if (numThreads > 0)
+    mySensorInterpWorkers = new ArWorkerPool(numThreads, 
+					     "ArRobot::SensorInterp");
+  else
+    mySensorInterpWorkers = NULL;
+  proc->setWorkerPool(mySensorInterpWorkers);
+  unlock();
+
+  // the cycle doesn't use the old ones once we've set the new ones
+  // (since it runs them with the robot locked)
+  if (oldWorkers != NULL)
+    delete oldWorkers;
+  ArLog::log(ArLog::Normal, "Running parallel sensor interp tasks on %d threads",
+	     numThreads);
+}
+
+AREXPORT int ArRobot::getSensorInterpThreads(void)
+{
+  if (mySensorInterpWorkers == NULL)
+    return 0;
+  return mySensorInterpWorkers->getNumWorkers();
+}
+
 /**
    @see addSensorInterpTask
    @see remSensorInterpTask(ArFunctor *functor)
@@ -3767,7 +3936,6 @@ AREXPORT void ArRobot::stateReflector(void)
 
 AREXPORT bool ArRobot::handlePacket(ArRobotPacket *packet)
 {
-  std::list<ArRetFunctor1<bool, ArRobotPacket *> *>::iterator it;
   bool handled;
 
   lock();
@@ -3781,8 +3949,34 @@ AREXPORT bool ArRobot::handlePacket(ArRobotPacket *packet)
     return false;
   }
 
-  for (handled = false, it = myPacketHandlerList.begin(); 
-       it != myPacketHandlerList.end() && handled == false; 
+  if (!(handled = dispatchPacket(packet)))
+    ArLog::log(ArLog::Normal, 
+	       "No packet handler wanted packet with ID: 0x%x", 
+	       packet->getID());
+  unlock();
+  return handled;
+}
+
+/**
+   @internal
+   Offers the packet to the handlers added first, then to the handlers
+   for its ID, then to the handlers added last, until one of them
+   handles it (so the handlers added first can still see or take any
+   packet, like when they were all in one list).  The robot should be
+   locked when this is called.
+**/
+bool ArRobot::dispatchPacket(ArRobotPacket *packet)
+{
+  std::list<ArRetFunctor1<bool, ArRobotPacket *> *>::iterator it;
+  std::list<ArRetFunctor1<bool, ArRobotPacket *> *> *idList;
+  ArTypes::UByte id;
+  ArPreciseTime started;
+  bool handled = false;
+
+  started.setToNow();
+  id = packet->getID();
+  for (it = myFirstPacketHandlerList.begin(); 
+       it != myFirstPacketHandlerList.end() && !handled; 
        it++)
   {
     if ((*it) != NULL && (*it)->invokeR(packet)) 
@@ -3790,11 +3984,25 @@ AREXPORT bool ArRobot::handlePacket(ArRobotPacket *packet)
     else
       packet->resetRead();
   }
-  if (!handled)
-    ArLog::log(ArLog::Normal, 
-	       "No packet handler wanted packet with ID: 0x%x", 
-	       packet->getID());
-  unlock();
+  idList = &myPacketHandlersByID[id];
+  for (it = idList->begin(); it != idList->end() && !handled; it++)
+  {
+    if ((*it) != NULL && (*it)->invokeR(packet)) 
+      handled = true;
+    else
+      packet->resetRead();
+  }
+  for (it = myPacketHandlerList.begin(); 
+       it != myPacketHandlerList.end() && !handled; 
+       it++)
+  {
+    if ((*it) != NULL && (*it)->invokeR(packet)) 
+      handled = true;
+    else
+      packet->resetRead();
+  }
+  myPacketIDCounts[id]++;
+  myPacketIDHandleUSecs[id] += started.uSecSince();
   return handled;
 }
 
@@ -3823,6 +4031,10 @@ AREXPORT long int ArRobot::getRightEncoder()
 AREXPORT void ArRobot::robotLocker(void)
 {
   lock();
+  // the parallel sensor interp tasks use the snapshot from this
+  // cycle, so it's taken here instead of in robotUnlocker
+  if (mySensorInterpWorkers != NULL)
+    publishStateSnapshot();
 }
 
 /**
@@ -3831,9 +4043,98 @@ AREXPORT void ArRobot::robotLocker(void)
 **/
 AREXPORT void ArRobot::robotUnlocker(void)
 {
+  // the workers can't change while we're locked, so this is the
+  // same check robotLocker made
+  if (mySensorInterpWorkers == NULL)
+    publishStateSnapshot();
   unlock();
 }
 
+/**
+   This fills in the snapshot that isn't being read from (with the
+   robot locked, since it runs at the end of the cycle), then makes it
+   the current one.  Since only the robot's thread publishes there's
+   only ever one writer.
+**/
+AREXPORT void ArRobot::publishStateSnapshot(void)
+{
+  ArRobotStateSnapshot *snapshot;
+  std::map<int, ArSensorReading *>::iterator it;
+  unsigned int next;
+
+  next = myStateSnapshotSeq + 1;
+  // make sure anyone who saw the last sequence number started
+  // reading before we start writing
+  ArUtil::memoryBarrier();
+  snapshot = &myStateSnapshots[next & 1];
+  snapshot->myTime.setToNow();
+  snapshot->myCounter = myCounter;
+  snapshot->myPose = myGlobalPose;
+  snapshot->myEncoderPose = myEncoderPose;
+  snapshot->myVel = myVel;
+  snapshot->myRotVel = myRotVel;
+  snapshot->myLatVel = myLatVel;
+  snapshot->myLeftVel = myLeftVel;
+  snapshot->myRightVel = myRightVel;
+  snapshot->myBatteryVoltage = getBatteryVoltage();
+  snapshot->myRealBatteryVoltage = getRealBatteryVoltage();
+  snapshot->myHaveStateOfCharge = myHaveStateOfCharge;
+  snapshot->myStateOfCharge = getStateOfCharge();
+  snapshot->myTemperature = myTemperature;
+  snapshot->myFlags = myFlags;
+  snapshot->myFaultFlags = myFaultFlags;
+  snapshot->myHasFaultFlags = myHasFaultFlags;
+  snapshot->myStallValue = myStallValue;
+  snapshot->myIsConnected = myIsConnected;
+  snapshot->myNumSonar = 0;
+  for (it = mySonars.begin(); it != mySonars.end(); ++it)
+  {
+    if ((*it).first < 0 || (*it).first >= ArRobotStateSnapshot::MAX_SONAR)
+      continue;
+    // fill in any we skipped
+    while (snapshot->myNumSonar < (*it).first)
+      snapshot->mySonarRanges[snapshot->myNumSonar++] = -1;
+    snapshot->mySonarRanges[snapshot->myNumSonar++] = 
+      (*it).second->getRange();
+  }
+  // make sure everything is written before we say it is there
+  ArUtil::memoryBarrier();
+  myStateSnapshotSeq = next;
+}
+
+/**
+   This doesn't lock the robot, so it won't hold up the robot's cycle
+   and the robot's cycle won't hold it up, but everything in the
+   snapshot is from the same cycle.  The snapshot is taken once a
+   cycle, at the end (after the user tasks), so it's what the robot's
+   state was when the robot was last unlocked.  If there are sensor
+   interp threads (see setSensorInterpThreads) it's taken right after
+   the robot is locked instead, so the parallel sensor interp tasks
+   can use it.
+
+   @param snapshot where to put the copy
+
+   @return false if there hasn't been a cycle yet (so the snapshot is
+   empty), true otherwise
+**/
+AREXPORT bool ArRobot::getStateSnapshot(ArRobotStateSnapshot *snapshot) const
+{
+  unsigned int seq;
+
+  // the robot doesn't write the snapshot we're copying until it's
+  // published another one, so if the sequence number didn't change
+  // while we were copying it, the copy is good
+  while (1)
+  {
+    seq = myStateSnapshotSeq;
+    ArUtil::memoryBarrier();
+    *snapshot = myStateSnapshots[seq & 1];
+    ArUtil::memoryBarrier();
+    if (seq == myStateSnapshotSeq)
+      return (seq != 0);
+  }
+}
+
 /**
    Reads in all of the packets that are available to read in, then runs through
    the list of packet handlers and tries to get each packet handled.
@@ -3877,11 +4178,10 @@ AREXPORT void ArRobot::packetHandler(void)
   {
     if (myPacketsReceivedTracking)
     {
-      ArLog::log(ArLog::Normal, 
-		 "Rcvd: prePacket (%ld) 0x%x at %ld (%ld)", 
-		 myPacketsReceivedTrackingCount, 
-		 packet->getID(), start.mSecSince(), 
-		 myPacketsReceivedTrackingStarted.mSecSince());
+      ArBinaryLog::log(&ourRcvdPrePacketMsg, 
+		       myPacketsReceivedTrackingCount, 
+		       packet->getID(), start.mSecSince(), 
+		       myPacketsReceivedTrackingStarted.mSecSince());
       myPacketsReceivedTrackingCount++;
     }
 
@@ -3909,10 +4209,10 @@ AREXPORT void ArRobot::packetHandler(void)
   {
     if (myPacketsReceivedTracking)
     {
-      ArLog::log(ArLog::Normal, "Rcvd: Packet (%ld) 0x%x at %ld (%ld)", 
-		 myPacketsReceivedTrackingCount, 
-		 packet->getID(), start.mSecSince(), 
-		 myPacketsReceivedTrackingStarted.mSecSince());
+      ArBinaryLog::log(&ourRcvdPacketMsg, 
+		       myPacketsReceivedTrackingCount, 
+		       packet->getID(), start.mSecSince(), 
+		       myPacketsReceivedTrackingStarted.mSecSince());
       myPacketsReceivedTrackingCount++;
     }
 
@@ -3924,6 +4224,17 @@ AREXPORT void ArRobot::packetHandler(void)
       timeToWait = 0;
   }
 
+  // when a recording runs out there won't be any more packets
+  if (myConn != NULL && 
+      myConn->getStatus() != ArDeviceConnection::STATUS_OPEN &&
+      dynamic_cast<ArReplayConnection *>(myConn) != NULL)
+  {
+    ArLog::log(ArLog::Normal, 
+	       "Losing connection because the recording being played back ended.");
+    dropConnection();
+    return;
+  }
+
   if (myTimeoutTime > 0 && 
       ((-myLastPacketReceivedTime.mSecTo()) > myTimeoutTime))
   {
@@ -3935,7 +4246,7 @@ AREXPORT void ArRobot::packetHandler(void)
   }
 
   if (myPacketsReceivedTracking)
-    ArLog::log(ArLog::Normal, "Rcvd: time taken %ld", start.mSecSince());
+    ArBinaryLog::log(&ourRcvdTimeTakenMsg, start.mSecSince());
 
 }
 
@@ -4610,8 +4921,8 @@ AREXPORT ArSensorReading *ArRobot::getSonarReading(int num) const
 AREXPORT bool ArRobot::com(unsigned char command)
 {
   if (myPacketsSentTracking)
-    ArLog::log(ArLog::Normal, "Sent: com(%d)", command);
-  return mySender.com(command);
+    ArBinaryLog::log(&ourSentComMsg, command);
+  return mySender.comFast(command);
 }
 
 /**
@@ -4623,8 +4934,8 @@ AREXPORT bool ArRobot::com(unsigned char command)
 AREXPORT bool ArRobot::comInt(unsigned char command, short int argument)
 {
   if (myPacketsSentTracking)
-    ArLog::log(ArLog::Normal, "Sent: comInt(%d, %d)", command, argument);
-  return mySender.comInt(command, argument);
+    ArBinaryLog::log(&ourSentComIntMsg, command, argument);
+  return mySender.comIntFast(command, argument);
 }
 
 /**
@@ -4637,9 +4948,8 @@ AREXPORT bool ArRobot::comInt(unsigned char command, short int argument)
 AREXPORT bool ArRobot::com2Bytes(unsigned char command, char high, char low)
 {
   if (myPacketsSentTracking)
-    ArLog::log(ArLog::Normal, "Sent: com2Bytes(%d, %d, %d)", command, 
-	       high, low);
-  return mySender.com2Bytes(command, high, low);
+    ArBinaryLog::log(&ourSentCom2BytesMsg, command, high, low);
+  return mySender.com2BytesFast(command, high, low);
 }
 
 /**
@@ -40,6 +40,8 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArResolver.h"
 #include "ArTransform.h"
 #include "ArInterpolation.h"
+#include "ArRobotStateSnapshot.h"
+#include "ArWorkerPool.h"
 #include "ArKeyHandler.h"
 #include <list>
 
@@ -745,10 +747,25 @@ public:
 	  ArRetFunctor1<bool, ArRobotPacket *> *functor, 
 	  ArListPos::Pos position = ArListPos::LAST);
   
+  /// Adds a packet handler that is only offered packets with some IDs
+  AREXPORT void addPacketHandlerForID(
+	  ArRetFunctor1<bool, ArRobotPacket *> *functor, 
+	  ArTypes::UByte id, ArTypes::UByte idMask = 0xff,
+	  ArListPos::Pos position = ArListPos::LAST);
+
   /// Removes a packet handler from the list of packet handlers
   AREXPORT void remPacketHandler(
 	  ArRetFunctor1<bool, ArRobotPacket *> *functor);
 
+  /// Gets how many packets with this ID have come in
+  AREXPORT unsigned long getPacketIDCount(ArTypes::UByte id) const;
+  /// Gets how many microseconds have gone into handling packets with this ID
+  AREXPORT double getPacketIDHandleUSecs(ArTypes::UByte id) const;
+  /// Resets the packet ID counts and handling times
+  AREXPORT void resetPacketIDStats(void);
+  /// Logs the packet ID counts and handling times
+  AREXPORT void logPacketIDStats(void);
+
   /// Adds a connect callback
   AREXPORT void addConnectCB(ArFunctor *functor, 
 			     ArListPos::Pos position = ArListPos::LAST);
@@ -817,11 +834,16 @@ public:
   /// Adds a task under the sensor interp part of the syncronous tasks
   AREXPORT bool addSensorInterpTask(const char *name, int position, 
 				       ArFunctor *functor,
-	       			       ArTaskState::State *state = NULL);
+	       			       ArTaskState::State *state = NULL,
+				       bool parallel = false);
   /// Removes a sensor interp tasks by name
   AREXPORT void remSensorInterpTask(const char *name);
   /// Removes a sensor interp tasks by functor
   AREXPORT void remSensorInterpTask(ArFunctor *functor);
+  /// Sets how many threads run the parallel sensor interp tasks, 0 for none
+  AREXPORT void setSensorInterpThreads(int numThreads);
+  /// Gets how many threads run the parallel sensor interp tasks
+  AREXPORT int getSensorInterpThreads(void);
 
   /// Finds a task by name
   AREXPORT ArSyncTask *findTask(const char *name);
@@ -918,6 +940,9 @@ public:
   /// Gets the Counter for the time through the loop
   unsigned int getCounter(void) const { return myCounter; }
 
+  /// Gets a copy of the robot's state from the last cycle, without locking
+  AREXPORT bool getStateSnapshot(ArRobotStateSnapshot *snapshot) const;
+
   /// Gets the parameters the robot is using
   AREXPORT const ArRobotParams *getRobotParams(void) const;
 
@@ -1091,6 +1116,8 @@ public:
   AREXPORT void robotLocker(void);
   /// Robot unlocker, internal
   AREXPORT void robotUnlocker(void);
+  /// Publishes the state snapshot, internal (called with the robot locked)
+  AREXPORT void publishStateSnapshot(void);
 
   /// For the key handler, escape calls this to exit, internal
   AREXPORT void keyHandlerExit(void);
@@ -1240,7 +1267,16 @@ protected:
   bool myPacketsSentTracking;
   ArMutex myMutex;
   ArSyncTask *mySyncTaskRoot;
+  // the handlers added first, these get packets before the ID handlers
+  std::list<ArRetFunctor1<bool, ArRobotPacket *> *> myFirstPacketHandlerList;
+  // the handlers added last, these get packets after the ID handlers
   std::list<ArRetFunctor1<bool, ArRobotPacket *> *> myPacketHandlerList;
+  // the handlers that only want some packet IDs, by ID
+  std::list<ArRetFunctor1<bool, ArRobotPacket *> *> myPacketHandlersByID[256];
+  unsigned long myPacketIDCounts[256];
+  double myPacketIDHandleUSecs[256];
+  // offers a packet to the handlers until one takes it
+  bool dispatchPacket(ArRobotPacket *packet);
 
   ArSyncLoop mySyncLoop;
 
@@ -1268,6 +1304,15 @@ protected:
   
   unsigned int myCounter;
   bool myIsConnected;
+
+  // the snapshot being read is myStateSnapshots[myStateSnapshotSeq & 1],
+  // the next one is written into the other one
+  ArRobotStateSnapshot myStateSnapshots[2];
+  volatile unsigned int myStateSnapshotSeq;
+
+  // runs the parallel sensor interp tasks, NULL if they aren't run
+  // in parallel
+  ArWorkerPool *mySensorInterpWorkers;
   bool myIsStabilizing;
 
   bool myBlockingConnectRun;
@@ -61,7 +61,7 @@ AREXPORT ArRobotConfig::ArRobotConfig(ArRobot *robot) :
   myProcessFileCB.setName("ArRobotConfig");
 
   myRobot->addConnectCB(&myConnectCB, ArListPos::FIRST);
-  Aria::getConfig()->addProcessFileCB(&myProcessFileCB, 98);
+  Aria::getConfig()->addProcessFileCB(&myProcessFileCB, 98, "Robot config");
 
   if (myRobot->isConnected())
     connectCallback();
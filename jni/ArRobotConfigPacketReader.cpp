@@ -46,7 +46,7 @@ AREXPORT ArRobotConfigPacketReader::ArRobotConfigPacketReader(
 {
   myRobot = robot;
   myPacketHandlerCB.setName("ArRobotConfigPacketReader");
-  myRobot->addPacketHandler(&myPacketHandlerCB);
+  myRobot->addPacketHandlerForID(&myPacketHandlerCB, 0x20);
   myRobot->addConnectCB(&myConnectedCB);
   myOnlyOneRequest = onlyOneRequest;
   myPacketRequested = false;
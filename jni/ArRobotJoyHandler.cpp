@@ -36,7 +36,8 @@ AREXPORT ArRobotJoyHandler::ArRobotJoyHandler(ArRobot *robot) :
 
   myHandleJoystickPacketCB.setName("ArRobotJoyHandler");
   myRobot->addConnectCB(&myConnectCB);
-  myRobot->addPacketHandler(&myHandleJoystickPacketCB, ArListPos::FIRST);
+  myRobot->addPacketHandlerForID(&myHandleJoystickPacketCB, 0xF8, 0xff, 
+				 ArListPos::FIRST);
   if (myRobot->isConnected())
     connectCallback();
 
@@ -35,7 +35,8 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
  */
 AREXPORT ArRobotPacket::ArRobotPacket(unsigned char sync1,
 				      unsigned char sync2) :
-    ArBasePacket(265, 4, NULL, 2)
+    ArBasePacket(265, 4, NULL, 2),
+    myTimeReceived(0, 0)
 {
   mySync1 = sync1;
   mySync2 = sync2;
@@ -50,6 +50,9 @@ AREXPORT ArRobotPacketReceiver::ArRobotPacketReceiver(bool allocatePackets,
   myDeviceConn = NULL;
   mySync1 = sync1;
   mySync2 = sync2;
+  myReadStart = 0;
+  myReadEnd = 0;
+  myNewDataStart = 0;
 }
 
 /**
@@ -72,6 +75,9 @@ AREXPORT ArRobotPacketReceiver::ArRobotPacketReceiver(
   myAllocatePackets = allocatePackets;
   mySync1 = sync1;
   mySync2 = sync2;
+  myReadStart = 0;
+  myReadEnd = 0;
+  myNewDataStart = 0;
 }
 
 AREXPORT ArRobotPacketReceiver::~ArRobotPacketReceiver() 
@@ -83,6 +89,10 @@ AREXPORT void ArRobotPacketReceiver::setDeviceConnection(
 	ArDeviceConnection *deviceConnection)
 {
   myDeviceConn = deviceConnection;
+  // anything we had was from the old connection
+  myReadStart = 0;
+  myReadEnd = 0;
+  myNewDataStart = 0;
 }
 
 AREXPORT ArDeviceConnection *ArRobotPacketReceiver::getDeviceConnection(void)
@@ -90,6 +100,135 @@ AREXPORT ArDeviceConnection *ArRobotPacketReceiver::getDeviceConnection(void)
   return myDeviceConn;
 }
 
+/**
+   This reads everything the connection has available at once instead
+   of a byte at a time, so that a whole packet (or several) takes one
+   read instead of one per byte.
+
+   @param msWait how long to wait for the first byte, 0 to only take
+   what's already there
+
+   @return the number of bytes read
+**/
+int ArRobotPacketReceiver::fillBuffer(unsigned int msWait)
+{
+  int numRead;
+  int total = 0;
+
+  // move what's left to the front to make room
+  if (myReadStart > 0)
+  {
+    if (myReadEnd > myReadStart)
+      memmove(myReadBuffer, myReadBuffer + myReadStart, 
+	      myReadEnd - myReadStart);
+    myReadEnd -= myReadStart;
+    myReadStart = 0;
+  }
+  if (myReadEnd >= READ_BUFFER_SIZE)
+    return 0;
+
+  // the connections keep reading until they've gotten everything
+  // asked for or until the time runs out, so only wait for one byte,
+  // then take whatever else is there without waiting
+  if (msWait > 0)
+  {
+    numRead = myDeviceConn->read((char *)myReadBuffer + myReadEnd, 1, msWait);
+    if (numRead <= 0)
+      return 0;
+    total += numRead;
+  }
+  if (myReadEnd + total < READ_BUFFER_SIZE)
+  {
+    numRead = myDeviceConn->read((char *)myReadBuffer + myReadEnd + total,
+				 READ_BUFFER_SIZE - myReadEnd - total, 0);
+    if (numRead > 0)
+      total += numRead;
+  }
+  if (total <= 0)
+    return 0;
+
+  myOldDataTime = myNewDataTime;
+  myNewDataTime = myDeviceConn->getTimeRead(0);
+  myNewDataStart = myReadEnd;
+  myReadEnd += total;
+  return total;
+}
+
+/**
+   Throws away anything in the buffer that can't be the start of a
+   packet, then if there's a whole packet at the start of the buffer
+   puts it into the given packet and takes it out of the buffer.
+
+   @param packet the packet to put the data in
+
+   @param started set to true if there's the start of a packet in the
+   buffer (so more data should be waited for), false if not
+
+   @return true if there was a packet with a good checksum, false otherwise
+**/
+bool ArRobotPacketReceiver::findPacket(ArRobotPacket *packet, bool *started)
+{
+  int count;
+
+  *started = false;
+  while (myReadStart < myReadEnd)
+  {
+    if (myReadBuffer[myReadStart] != mySync1)
+    {
+      //printf("Bad sync1 %d\n", myReadBuffer[myReadStart]);
+      myReadStart++;
+      continue;
+    }
+    if (myReadStart + 1 < myReadEnd && 
+	myReadBuffer[myReadStart + 1] != mySync2)
+    {
+      //printf("Bad sync2 %d\n", myReadBuffer[myReadStart + 1]);
+      myReadStart++;
+      continue;
+    }
+    // the byte after the sync is the count of the bytes remaining
+    if (myReadStart + 2 >= myReadEnd || 
+	myReadStart + 3 + myReadBuffer[myReadStart + 2] > myReadEnd)
+    {
+      *started = true;
+      return false;
+    }
+    count = myReadBuffer[myReadStart + 2];
+
+    packet->empty();
+    packet->setLength(0);
+    packet->uByteToBuf(mySync1);
+    packet->uByteToBuf(mySync2);
+    packet->uByteToBuf(count);
+    packet->dataToBuf((char *)myReadBuffer + myReadStart + 3, count);
+    if (myReadStart < myNewDataStart)
+      packet->setTimeReceived(myOldDataTime);
+    else
+      packet->setTimeReceived(myNewDataTime);
+    if (packet->verifyCheckSum()) 
+    {
+      myReadStart += 3 + count;
+      packet->resetRead();
+      /* put this in if you want to see the packets received
+	 printf("Input ");
+	 packet->printHex();
+      */
+      // you can also do this next line if you only care about type
+      //printf("Input %x\n", packet->getID());
+      return true;
+    }
+    /* put this in if you want to see bad checksum packets 
+       printf("Bad Input ");
+       packet->printHex();
+    */
+    ArLog::log(ArLog::Normal, 
+	       "ArRobotPacketReceiver::receivePacket: bad packet, bad checksum");
+    // look for the next packet starting after this sync
+    myReadStart++;
+  }
+  return false;
+}
+
 /**
     @param msWait how long to block for the start of a packet, nonblocking if 0
     @return NULL if there are no packets in alloted time, otherwise a pointer
@@ -103,17 +242,13 @@ AREXPORT ArRobotPacket *ArRobotPacketReceiver::receivePacket(
 	unsigned int msWait)
 {
   ArRobotPacket *packet;
-  unsigned char c;
   char buf[256];
-  int count = 0;
-  // state can be one of the STATE_ enums in the class
-  int state = STATE_SYNC1;
-  //unsigned int timeDone;
-  //unsigned int curTime;
   long timeToRunFor;
-  ArTime timeDone;
-  ArTime lastDataRead;
-  ArTime packetReceived;
+  bool started;
+  bool triedRead = false;
+  ArTime timeDone(0, 0);
+  ArTime lastDataRead(0, 0);
+  ArTime packetReceived(0, 0);
   int numRead;
 
   if (myAllocatePackets)
@@ -155,115 +290,43 @@ AREXPORT ArRobotPacket *ArRobotPacketReceiver::receivePacket(
   }      
   
 
-  do
+  // take packets out of what we've already read, and when there
+  // isn't a whole one, read more (waiting up to msWait if there's no
+  // packet started, or until we go 100 ms without data if one is
+  // started... its arbitrary but it doesn't happen often and it'll
+  // mean a bad packet anyways)
+  lastDataRead.setToNow();
+  while (1)
+  {
+    if (findPacket(packet, &started))
+      return packet;
+
+    if (started)
     {
-      timeToRunFor = timeDone.mSecTo();
+      timeToRunFor = 100 - lastDataRead.mSecSince();
       if (timeToRunFor < 0)
-        timeToRunFor = 0;
-
-      if (myDeviceConn->read((char *)&c, 1, timeToRunFor) == 0) 
-        {
-          if (state == STATE_SYNC1)
-            {
-              if (myAllocatePackets)
-                delete packet;
-              return NULL;
-            }
-          else
-            {
-              //ArUtil::sleep(1);
-              continue;
-            }
-        }
-
-      switch (state) {
-      case STATE_SYNC1:
-        if (c == mySync1) // move on, resetting packet
-          {
-            state = STATE_SYNC2;
-            packet->empty();
-            packet->setLength(0);
-            packet->uByteToBuf(c);
-            packetReceived = myDeviceConn->getTimeRead(0);
-            packet->setTimeReceived(packetReceived);
-          }
-        else
-	{
-          //printf("Bad sync1 %d\n", c);
-	}
-        break;
-      case STATE_SYNC2:
-        if (c == mySync2) // move on, adding this byte
-          {
-            state = STATE_ACQUIRE_DATA;
-            packet->uByteToBuf(c);
-          }
-        else // go back to beginning, packet hosed
-          {
-	    //printf("Bad sync2 %d\n", c);
-            state = STATE_SYNC1;
-          }
-        break;
-      case STATE_ACQUIRE_DATA:
-        // the character c is the count of the packets remianing at this point
-        // so we'll just put it into the packet then get the rest of the data
-        packet->uByteToBuf(c);
-        // if c > 200 than there is a problem, spec says packet max size is 200
-        count = 0;
-	/** this case can't happen since c can't be over that so taking it out
-        if (c > 255) 
-          {
-            ArLog::log(ArLog::Normal, "ArRobotPacketReceiver::receivePacket: bad packet, more than 255 bytes");
-            state = STATE_SYNC1;
-            break;
-          }
-	*/
-        // here we read until we get as much as we want, OR until
-        // we go 100 ms without data... its arbitrary but it doesn't happen often
-        // and it'll mean a bad packet anyways
-        lastDataRead.setToNow();
-        while (count < c)
-          {
-            numRead = myDeviceConn->read(buf + count, c - count, 1);
-            if (numRead > 0)
-              lastDataRead.setToNow();
-            if (lastDataRead.mSecTo() < -100)
-              {
-                if (myAllocatePackets)
-                  delete packet;
-		//printf("Bad time taken reading\n");
-                return NULL;
-              }
-            count += numRead;
-          }
-        packet->dataToBuf(buf, c);
-        if (packet->verifyCheckSum()) 
-          {
-            packet->resetRead();
-	    /* put this in if you want to see the packets received
-	       printf("Input ");
-               packet->printHex();
-	       */
-	    // you can also do this next line if you only care about type
-	    //printf("Input %x\n", packet->getID());
-            return packet;
-          }
-        else 
-          {
-	    /* put this in if you want to see bad checksum packets 
-               printf("Bad Input ");
-               packet->printHex();
-	       */
-            ArLog::log(ArLog::Normal, 
-                       "ArRobotPacketReceiver::receivePacket: bad packet, bad checksum");
-            state = STATE_SYNC1;
-            break;
-          }
-        break;
-      default:
-        break;
+      {
+	//printf("Bad time taken reading\n");
+	// skip the sync so we look for the next one
+	myReadStart++;
+	break;
       }
-    } while (timeDone.mSecTo() >= 0 || state != STATE_SYNC1);
+    }
+    else
+    {
+      timeToRunFor = timeDone.mSecTo();
+      // we always look once, even when not waiting
+      if (timeToRunFor < 0 && triedRead)
+	break;
+      if (timeToRunFor < 0)
+	timeToRunFor = 0;
+    }
+    triedRead = true;
+    if (fillBuffer(timeToRunFor) > 0)
+      lastDataRead.setToNow();
+    else if (!started)
+      break;
+  }
 
   //printf("finished the loop...\n");
   if (myAllocatePackets)
@@ -58,12 +58,27 @@ public:
   AREXPORT bool isAllocatingPackets(void) { return myAllocatePackets; }
 
 protected:
+  /// Reads whatever is available into the buffer, waiting msWait for the first byte
+  int fillBuffer(unsigned int msWait);
+  /// Finds a packet in the buffer, if there is a whole one
+  bool findPacket(ArRobotPacket *packet, bool *started);
   ArDeviceConnection *myDeviceConn;
   bool myAllocatePackets;
   ArRobotPacket myPacket;
-  enum { STATE_SYNC1, STATE_SYNC2, STATE_ACQUIRE_DATA };
   unsigned char mySync1;
   unsigned char mySync2;
+
+  enum { READ_BUFFER_SIZE = 1024 };
+  // data read from the connection that hasn't been made into packets
+  // yet is from myReadStart up to myReadEnd
+  unsigned char myReadBuffer[READ_BUFFER_SIZE];
+  int myReadStart;
+  int myReadEnd;
+  // where the data from the last read starts and when it was read,
+  // anything before that came in on the read before
+  int myNewDataStart;
+  ArTime myNewDataTime;
+  ArTime myOldDataTime;
 };
 
 #endif // ARROBOTPACKETRECEIVER_H
@@ -0,0 +1,183 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "ArExport.h"
+#include "ariaOSDef.h"
+#include "ArRobotPacketRecorder.h"
+#include "ArRobot.h"
+#include "ArRobotPacket.h"
+#include "ArLog.h"
+
+AREXPORT ArRobotPacketRecorder::ArRobotPacketRecorder(ArRobot *robot) :
+  myRecord(1024),
+  myPacketCB(this, &ArRobotPacketRecorder::packetHandler)
+{
+  myMutex.setLogName("ArRobotPacketRecorder::myMutex");
+  myRobot = robot;
+  myFile = NULL;
+  myNumRecorded = 0;
+  myPacketCB.setName("ArRobotPacketRecorder");
+}
+
+AREXPORT ArRobotPacketRecorder::~ArRobotPacketRecorder()
+{
+  stop();
+}
+
+/**
+   Writes the header and starts recording every packet the robot gets.
+   This locks the robot, so don't call it with the robot locked.
+
+   @param fileName the file to record into (it is truncated)
+   @return true if the file could be opened and recording started
+**/
+AREXPORT bool ArRobotPacketRecorder::start(const char *fileName)
+{
+  ArPose pose;
+
+  stop();
+
+  myRobot->lock();
+  myMutex.lock();
+  if ((myFile = ArUtil::fopen(fileName, "wb")) == NULL)
+  {
+    ArLog::log(ArLog::Terse, 
+	       "ArRobotPacketRecorder: Could not open '%s' to record to", 
+	       fileName);
+    myMutex.unlock();
+    myRobot->unlock();
+    return false;
+  }
+  myFileName = fileName;
+  pose = myRobot->getPose();
+
+  myRecord.empty();
+  myRecord.uByte4ToBuf(VERSION);
+  myRecord.strToBuf(myRobot->getRobotName());
+  myRecord.strToBuf(myRobot->getRobotType());
+  myRecord.strToBuf(myRobot->getRobotSubType());
+  myRecord.byte4ToBuf(ArMath::roundInt(pose.getX()));
+  myRecord.byte4ToBuf(ArMath::roundInt(pose.getY()));
+  myRecord.byte4ToBuf(ArMath::roundInt(pose.getTh()));
+  // little endian, like everything in the records
+  unsigned char headerLength[2];
+  headerLength[0] = myRecord.getLength() & 0xff;
+  headerLength[1] = (myRecord.getLength() >> 8) & 0xff;
+
+  fwrite(getMagic(), 1, strlen(getMagic()), myFile);
+  fwrite(headerLength, 1, 2, myFile);
+  fwrite(myRecord.getBuf(), 1, myRecord.getLength(), myFile);
+
+  myNumRecorded = 0;
+  myStarted.setToNow();
+  myRobot->addPacketHandler(&myPacketCB, ArListPos::FIRST);
+  myMutex.unlock();
+  myRobot->unlock();
+  ArLog::log(ArLog::Normal, "ArRobotPacketRecorder: Recording packets to %s",
+	     fileName);
+  return true;
+}
+
+/**
+   This locks the robot, so don't call it with the robot locked.
+**/
+AREXPORT void ArRobotPacketRecorder::stop(void)
+{
+  myRobot->lock();
+  myRobot->remPacketHandler(&myPacketCB);
+  myMutex.lock();
+  if (myFile != NULL)
+  {
+    fclose(myFile);
+    myFile = NULL;
+    ArLog::log(ArLog::Normal, 
+	       "ArRobotPacketRecorder: Recorded %lu packets to %s",
+	       myNumRecorded, myFileName.c_str());
+  }
+  myMutex.unlock();
+  myRobot->unlock();
+}
+
+AREXPORT bool ArRobotPacketRecorder::isRecording(void)
+{
+  bool ret;
+  myMutex.lock();
+  ret = (myFile != NULL);
+  myMutex.unlock();
+  return ret;
+}
+
+AREXPORT unsigned long ArRobotPacketRecorder::getNumRecorded(void)
+{
+  unsigned long ret;
+  myMutex.lock();
+  ret = myNumRecorded;
+  myMutex.unlock();
+  return ret;
+}
+
+/**
+   This is added first in the packet handler list (so it sees the
+   packets before anything else does) and never handles the packet,
+   it just writes it out.
+**/
+AREXPORT bool ArRobotPacketRecorder::packetHandler(ArRobotPacket *packet)
+{
+  ArPreciseTime now;
+  long sec;
+  long nSec;
+
+  myMutex.lock();
+  if (myFile == NULL)
+  {
+    myMutex.unlock();
+    return false;
+  }
+  now.setToNow();
+  sec = now.getSec() - myStarted.getSec();
+  nSec = now.getNSec() - myStarted.getNSec();
+  if (nSec < 0)
+  {
+    nSec += 1000000000;
+    sec--;
+  }
+  myRecord.empty();
+  myRecord.uByte4ToBuf(sec);
+  myRecord.uByte4ToBuf(nSec);
+  myRecord.uByte2ToBuf(packet->getLength());
+  myRecord.dataToBuf(packet->getBuf(), packet->getLength());
+  if (fwrite(myRecord.getBuf(), 1, myRecord.getLength(), myFile) != 
+      myRecord.getLength())
+  {
+    ArLog::log(ArLog::Terse, 
+	       "ArRobotPacketRecorder: Could not write to %s, stopping recording",
+	       myFileName.c_str());
+    fclose(myFile);
+    myFile = NULL;
+  }
+  else
+    myNumRecorded++;
+  myMutex.unlock();
+  return false;
+}
@@ -0,0 +1,87 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#ifndef ARROBOTPACKETRECORDER_H
+#define ARROBOTPACKETRECORDER_H
+
+#include <stdio.h>
+#include <string>
+#include "ariaTypedefs.h"
+#include "ariaUtil.h"
+#include "ArFunctor.h"
+#include "ArMutex.h"
+#include "ArBasePacket.h"
+
+class ArRobot;
+class ArRobotPacket;
+
+/// Records every packet the robot gets so it can be replayed later
+/**
+   This writes each packet the robot gets (before any of the robot's
+   packet handlers see it) to a file along with when it came in, so
+   that the run can be played back later through an
+   ArReplayConnection.  The time is kept to the nanosecond, so the
+   replay can give the same timestamps the robot loop saw.
+
+   The file is binary (built with ArBasePacket).  It starts with the
+   magic "ARIAPKTS" and a ubyte2 length of the rest of the header,
+   which is a ubyte4 version, the robot's name, type and subtype as
+   strings, and the robot's pose (x, y, th) when the recording started
+   as byte4s.  Then each packet is a ubyte4 of seconds and a ubyte4 of
+   nanoseconds since the recording started, a ubyte2 length, then the
+   packet itself (sync bytes and checksum included).
+**/
+class ArRobotPacketRecorder
+{
+public:
+  /// Constructor
+  AREXPORT ArRobotPacketRecorder(ArRobot *robot);
+  /// Destructor (stops recording)
+  AREXPORT virtual ~ArRobotPacketRecorder();
+  /// Starts recording packets to the given file
+  AREXPORT bool start(const char *fileName);
+  /// Stops recording
+  AREXPORT void stop(void);
+  /// Gets whether we're recording
+  AREXPORT bool isRecording(void);
+  /// Gets how many packets have been recorded
+  AREXPORT unsigned long getNumRecorded(void);
+  /// The version of the file format this writes
+  enum { VERSION = 1 };
+  /// The magic at the start of the file
+  static const char *getMagic(void) { return "ARIAPKTS"; }
+protected:
+  AREXPORT bool packetHandler(ArRobotPacket *packet);
+
+  ArRobot *myRobot;
+  ArMutex myMutex;
+  FILE *myFile;
+  std::string myFileName;
+  ArPreciseTime myStarted;
+  unsigned long myNumRecorded;
+  ArBasePacket myRecord;
+  ArRetFunctor1C<bool, ArRobotPacketRecorder, ArRobotPacket *> myPacketCB;
+};
+
+#endif // ARROBOTPACKETRECORDER_H
@@ -41,6 +41,8 @@ AREXPORT ArRobotPacketSender::ArRobotPacketSender(unsigned char sync1,
   myPacket(sync1, sync2)
 {
   myDeviceConn = NULL;
+  mySync1 = sync1;
+  mySync2 = sync2;
 }
 
 /**
@@ -59,6 +61,8 @@ AREXPORT ArRobotPacketSender::ArRobotPacketSender(
   myPacket(sync1, sync2)
 {
   myDeviceConn = deviceConnection;
+  mySync1 = sync1;
+  mySync2 = sync2;
 }
 
 AREXPORT ArRobotPacketSender::~ArRobotPacketSender()
@@ -77,27 +81,13 @@ AREXPORT ArDeviceConnection *ArRobotPacketSender::getDeviceConnection(void)
   return myDeviceConn;
 }
 
-bool ArRobotPacketSender::connValid(void)
-{
-  return (myDeviceConn != NULL && 
-	  myDeviceConn->getStatus() == ArDeviceConnection::STATUS_OPEN);
-}
-
 /**
    @param command the command number to send
    @return whether the command could be sent or not
 */
 AREXPORT bool ArRobotPacketSender::com(unsigned char command)
 {
-  if (!connValid())
-    return false;
-
-  myPacket.empty();
-  myPacket.setID(command);
-
-  myPacket.finalizePacket();
-  
-  return myDeviceConn->write(myPacket.getBuf(), myPacket.getLength());
+  return comFast(command);
 }
 
 /**
@@ -108,30 +98,7 @@ AREXPORT bool ArRobotPacketSender::com(unsigned char command)
 AREXPORT bool ArRobotPacketSender::comInt(unsigned char command, 
 					  short int argument)
 {
-
-  if (!connValid())
-    return false;
-
-  myPacket.empty();
-  myPacket.setID(command);
-  if (argument >= 0) 
-  {
-    myPacket.uByteToBuf(INTARG);
-  }
-  else 
-  {
-    myPacket.uByteToBuf(NINTARG);
-    argument = -argument;
-  }
-  myPacket.uByte2ToBuf(argument);
-
-  myPacket.finalizePacket();
-
-  if (myDeviceConn->write(myPacket.getBuf(), myPacket.getLength()) >= 0)
-    return true;
-
-  return false;
-
+  return comIntFast(command, argument);
 }
 
 /**
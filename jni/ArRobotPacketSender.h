@@ -27,8 +27,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 
 #include "ariaTypedefs.h"
 #include "ArRobotPacket.h"
-
-class ArDeviceConnection;
+#include "ArDeviceConnection.h"
 
 /// Given a device connection this sends commands through it to the robot
 
@@ -57,6 +56,25 @@ public:
   AREXPORT bool comStrN(unsigned char command, const char *str, int size);
   /// Sends a command containing exactly the data in the given buffer as argument
   AREXPORT bool comDataN(unsigned char command, const char *data, int size);
+
+  /// Sends a command with no arguments, built straight into a buffer
+  bool comFast(unsigned char command)
+    {
+      if (!connValid())
+	return false;
+      return myDeviceConn->write(myFastBuf, buildCom(myFastBuf, command)) != 0;
+    }
+  /// Sends a command with an int for argument, built straight into a buffer
+  bool comIntFast(unsigned char command, short int argument)
+    {
+      if (!connValid())
+	return false;
+      return myDeviceConn->write(myFastBuf, 
+				 buildComInt(myFastBuf, command, argument)) >= 0;
+    }
+  /// Sends a command with two bytes for argument, built straight into a buffer
+  bool com2BytesFast(unsigned char command, char high, char low)
+    { return comIntFast(command, ((high & 0xff)<<8) + (low & 0xff)); }
   
   /// Sets the device this instance sends commands to
   AREXPORT void setDeviceConnection(ArDeviceConnection *deviceConnection);
@@ -64,9 +82,57 @@ public:
   AREXPORT ArDeviceConnection *getDeviceConnection(void);
 
 protected:
-  bool connValid(void);
+  /**
+     Puts a command with no argument into buf (which needs room for
+     6), returning how long it is.  Packets are the two sync bytes,
+     the number of bytes after the length, the command, the argument,
+     then the checksum (the sum of the bytes after the length taken as
+     big endian shorts, with an odd byte left over xored in).
+  **/
+  int buildCom(char *buf, unsigned char command)
+    {
+      buf[0] = mySync1;
+      buf[1] = mySync2;
+      buf[2] = 3;
+      buf[3] = command;
+      buf[4] = 0;
+      buf[5] = command;
+      return 6;
+    }
+  /// Puts a command with an int argument into buf (which needs room for 9), returning how long it is
+  int buildComInt(char *buf, unsigned char command, short int argument)
+    {
+      unsigned char argType = INTARG;
+      unsigned int chkSum;
+      if (argument < 0)
+      {
+	argType = NINTARG;
+	argument = -argument;
+      }
+      unsigned char low = argument & 0xff;
+      unsigned char high = (argument >> 8) & 0xff;
+      buf[0] = mySync1;
+      buf[1] = mySync2;
+      buf[2] = 6;
+      buf[3] = command;
+      buf[4] = argType;
+      buf[5] = low;
+      buf[6] = high;
+      chkSum = ((command << 8) | argType) + ((low << 8) | high);
+      buf[7] = (chkSum >> 8) & 0xff;
+      buf[8] = chkSum & 0xff;
+      return 9;
+    }
+  bool connValid(void)
+    {
+      return (myDeviceConn != NULL && 
+	      myDeviceConn->getStatus() == ArDeviceConnection::STATUS_OPEN);
+    }
   ArDeviceConnection * myDeviceConn;
   ArRobotPacket myPacket;
+  unsigned char mySync1;
+  unsigned char mySync2;
+  char myFastBuf[16];
   enum { INTARG = 0x3B, NINTARG = 0x1B, STRARG = 0x2B };
 };
 
@@ -29,6 +29,15 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArRobotParams.h"
 #include "ariaInternal.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <stdio.h>
+
 AREXPORT ArRobotParams::ArRobotParams() :
   ArConfig(NULL, true),
   mySonarUnitGetFunctor(this, &ArRobotParams::getSonarUnits),
@@ -367,7 +376,8 @@ AREXPORT ArRobotParams::ArRobotParams() :
 
 AREXPORT ArRobotParams::~ArRobotParams()
 {
-
+  ArUtil::deleteSet(myGetSonarUnitList.begin(), myGetSonarUnitList.end());
+  ArUtil::deleteSet(myGetIRUnitList.begin(), myGetIRUnitList.end());
 }
 
 
@@ -394,6 +404,9 @@ AREXPORT const std::list<ArArgumentBuilder *> *ArRobotParams::getSonarUnits(void
   int num, x, y, th;
   ArArgumentBuilder *builder;
 
+  // get rid of the ones from last time so they don't pile up
+  ArUtil::deleteSet(myGetSonarUnitList.begin(), myGetSonarUnitList.end());
+  myGetSonarUnitList.clear();
   for (it = mySonarMap.begin(); it != mySonarMap.end(); it++)
   {
     num = (*it).first;
@@ -437,6 +450,9 @@ AREXPORT const std::list<ArArgumentBuilder *> *ArRobotParams::getIRUnits(void)
   int num, type, cycles,  x, y;
   ArArgumentBuilder *builder;
 
+  // get rid of the ones from last time so they don't pile up
+  ArUtil::deleteSet(myGetIRUnitList.begin(), myGetIRUnitList.end());
+  myGetIRUnitList.clear();
   for (it = myIRMap.begin(); it != myIRMap.end(); it++)
   {
     num = (*it).first;
@@ -467,3 +483,458 @@ AREXPORT bool ArRobotParams::save(void)
   sprintf(buf, "%s.p", getSubClassName());
   return writeFile(buf, false, NULL, false);
 }
+
+/// Magic the binary param cache starts with
+static const char ourCacheMagic[8] = { 'A', 'R', 'I', 'A', 'P', 'R', 'M', 'B' };
+/// Size of the cache header up to (but not including) the record count
+static const size_t ourCacheHeaderLen = 8 + 4 * 5;
+
+/**
+   Copies @a size bytes from the cache at @a pos, returns false
+   instead if the cache is too short for them.
+**/
+static bool readCacheBytes(const char *buf, size_t len, size_t *pos,
+			   void *data, size_t size)
+{
+  if (*pos + size > len)
+    return false;
+  memcpy(data, buf + *pos, size);
+  *pos += size;
+  return true;
+}
+
+/**
+   FNV-1a over the whole file, so an edit that keeps the size and
+   lands in the same second as the last one still misses the cache.
+   Reading the file through once is still far cheaper than parsing it.
+**/
+static bool hashCacheFile(const char *fileName, ArTypes::UByte4 *hash)
+{
+  FILE *file;
+  char buf[8192];
+  size_t len;
+  size_t i;
+
+  if ((file = ArUtil::fopen(fileName, "rb")) == NULL)
+    return false;
+  *hash = 2166136261u;
+  while ((len = fread(buf, 1, sizeof(buf), file)) > 0)
+  {
+    for (i = 0; i < len; i++)
+      *hash = (*hash ^ (unsigned char)buf[i]) * 16777619u;
+  }
+  if (ferror(file))
+  {
+    fclose(file);
+    return false;
+  }
+  fclose(file);
+  return true;
+}
+
+/**
+   This works just like ArConfig::parseFile (and the values end up the
+   same) but after the text file parses cleanly the values read out of
+   it are written into a binary cache next to it (the file name with a
+   'b' on the end, so p3dx-sh.p gets p3dx-sh.pb).  The next time the
+   same file is loaded the values are mapped in from that cache and set
+   straight into the params, which skips all of the tokenizing and
+   keyword lookups the text parse does.
+
+   The cache is only used if the text file has the same modification
+   time, size and contents (a hash of them) it had when the cache was
+   written, and if the names
+   and types of the params haven't changed since then (so a cache
+   written by a different version of ARIA is just ignored), otherwise
+   this falls back to parsing the text file and rewrites the cache.
+   If the cache can't be written (say the params directory isn't
+   writable) that is only logged at verbose, it just means the text
+   file will be parsed every time like it used to be.
+**/
+AREXPORT bool ArRobotParams::parseFileWithCache(const char *fileName, 
+						bool continueOnError,
+						bool noFileNotFoundMessage)
+{
+  struct stat fileStat;
+  std::string cacheName;
+  std::vector<ArConfigArg *> params;
+  ArTypes::UByte4 schemaHash;
+  ArTypes::UByte4 fileHash;
+
+  if (fileName == NULL || fileName[0] == '\0' || 
+      stat(fileName, &fileStat) != 0 || !hashCacheFile(fileName, &fileHash))
+    return parseFile(fileName, continueOnError, noFileNotFoundMessage);
+
+  cacheName = fileName;
+  cacheName += "b";
+
+  getCacheParams(&params);
+  schemaHash = getCacheSchemaHash(&params);
+  if (loadCache(cacheName.c_str(), schemaHash, fileStat.st_mtime, 
+		fileStat.st_size, fileHash))
+  {
+    ArLog::log(ArLog::Verbose, "ArRobotParams: Loaded %s from %s",
+	       fileName, cacheName.c_str());
+    myFileName = fileName;
+    return callProcessFileCallBacks(continueOnError);
+  }
+
+  // so that we only cache what came out of this file
+  clearAllValueSet();
+  if (!parseFile(fileName, continueOnError, noFileNotFoundMessage))
+    return false;
+  writeCache(cacheName.c_str(), schemaHash, fileStat.st_mtime, 
+	     fileStat.st_size, fileHash);
+  return true;
+}
+
+/**
+   The string holders are left out since they're only there to keep
+   unknown lines for writing the file back out, and they're added
+   while parsing, so leaving them out keeps the indexes the same no
+   matter what was parsed before.
+**/
+void ArRobotParams::getCacheParams(std::vector<ArConfigArg *> *params)
+{
+  std::list<ArConfigSection *> *sections = getSections();
+  std::list<ArConfigSection *>::iterator sectionIt;
+  std::list<ArConfigArg>::iterator paramIt;
+  std::list<ArConfigArg> *sectionParams;
+
+  params->clear();
+  for (sectionIt = sections->begin(); sectionIt != sections->end(); sectionIt++)
+  {
+    sectionParams = (*sectionIt)->getParams();
+    for (paramIt = sectionParams->begin(); 
+	 paramIt != sectionParams->end(); 
+	 paramIt++)
+    {
+      if ((*paramIt).getType() == ArConfigArg::INT ||
+	  (*paramIt).getType() == ArConfigArg::DOUBLE ||
+	  (*paramIt).getType() == ArConfigArg::BOOL ||
+	  (*paramIt).getType() == ArConfigArg::STRING ||
+	  (*paramIt).getType() == ArConfigArg::FUNCTOR)
+	params->push_back(&(*paramIt));
+    }
+  }
+}
+
+/**
+   Since the functor params (like SonarUnit) add on to what the files
+   before this one set instead of replacing it, and the cache has their
+   whole value, their values going in are part of this too.
+**/
+ArTypes::UByte4 ArRobotParams::getCacheSchemaHash(
+	std::vector<ArConfigArg *> *params)
+{
+  std::vector<ArConfigArg *>::iterator it;
+  std::list<ArArgumentBuilder *>::const_iterator argIt;
+  const std::list<ArArgumentBuilder *> *argList;
+  ArTypes::UByte4 hash = 2166136261u;
+  const char *str;
+  
+  for (it = params->begin(); it != params->end(); it++)
+  {
+    // the name, then a 0 so "ab" "c" isn't the same as "a" "bc"
+    for (str = (*it)->getName(); *str != '\0'; str++)
+      hash = (hash ^ (unsigned char)*str) * 16777619u;
+    hash = (hash ^ 0) * 16777619u;
+    hash = (hash ^ (unsigned char)(*it)->getType()) * 16777619u;
+    if ((*it)->getType() != ArConfigArg::FUNCTOR || 
+	(argList = (*it)->getArgsWithFunctor()) == NULL)
+      continue;
+    for (argIt = argList->begin(); argIt != argList->end(); argIt++)
+    {
+      for (str = (*argIt)->getFullString(); *str != '\0'; str++)
+	hash = (hash ^ (unsigned char)*str) * 16777619u;
+      hash = (hash ^ 0) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+bool ArRobotParams::loadCache(const char *cacheName, 
+			      ArTypes::UByte4 schemaHash,
+			      ArTypes::UByte4 fileTime,
+			      ArTypes::UByte4 fileSize,
+			      ArTypes::UByte4 fileHash)
+{
+  std::vector<ArConfigArg *> params;
+  const char *buf = NULL;
+  size_t len = 0;
+  size_t pos = 0;
+  char magic[8];
+  ArTypes::UByte4 version, cacheSchemaHash, cacheFileTime, cacheFileSize;
+  ArTypes::UByte4 cacheFileHash;
+  bool ret = false;
+
+#ifndef WIN32
+  int fd;
+  struct stat cacheStat;
+
+  if ((fd = open(cacheName, O_RDONLY)) < 0)
+    return false;
+  if (fstat(fd, &cacheStat) == 0 && cacheStat.st_size > 0)
+  {
+    len = cacheStat.st_size;
+    if ((buf = (const char *)mmap(NULL, len, PROT_READ, MAP_PRIVATE, 
+				  fd, 0)) == MAP_FAILED)
+      buf = NULL;
+  }
+  close(fd);
+#else
+  FILE *file;
+  long size;
+  std::vector<char> contents;
+
+  if ((file = ArUtil::fopen(cacheName, "rb")) == NULL)
+    return false;
+  if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) > 0 &&
+      fseek(file, 0, SEEK_SET) == 0)
+  {
+    contents.resize(size);
+    if (fread(&contents[0], 1, size, file) == (size_t)size)
+    {
+      buf = &contents[0];
+      len = size;
+    }
+  }
+  fclose(file);
+#endif
+
+  if (buf == NULL)
+    return false;
+
+  getCacheParams(&params);
+  // check everything before setting anything, so that a bad cache
+  // doesn't leave the params half set
+  if (readCacheBytes(buf, len, &pos, magic, sizeof(magic)) &&
+      memcmp(magic, ourCacheMagic, sizeof(magic)) == 0 &&
+      readCacheBytes(buf, len, &pos, &version, 4) && 
+      version == CACHE_VERSION &&
+      readCacheBytes(buf, len, &pos, &cacheSchemaHash, 4) &&
+      cacheSchemaHash == schemaHash &&
+      readCacheBytes(buf, len, &pos, &cacheFileTime, 4) &&
+      cacheFileTime == fileTime &&
+      readCacheBytes(buf, len, &pos, &cacheFileSize, 4) &&
+      cacheFileSize == fileSize &&
+      readCacheBytes(buf, len, &pos, &cacheFileHash, 4) &&
+      cacheFileHash == fileHash &&
+      readCacheRecords(buf + pos, len - pos, &params, false))
+    ret = readCacheRecords(buf + pos, len - pos, &params, true);
+  
+#ifndef WIN32
+  munmap((void *)buf, len);
+#endif
+  return ret;
+}
+
+/**
+   The records are a ubyte4 count, then for each param that was set a
+   ubyte2 index (into getCacheParams), a ubyte1 type and the value; ints
+   are 4 bytes, doubles 8, bools 1, strings are a ubyte2 length and the
+   bytes and functors are a ubyte2 count of those strings.
+**/
+bool ArRobotParams::readCacheRecords(const char *buf, size_t len, 
+				     std::vector<ArConfigArg *> *params, 
+				     bool apply)
+{
+  size_t pos = 0;
+  ArTypes::UByte4 numRecords, i;
+  ArTypes::UByte2 index, strLen, count, j;
+  ArTypes::UByte type;
+  ArTypes::Byte4 intVal;
+  double doubleVal;
+  ArTypes::UByte boolVal;
+  ArConfigArg *param;
+  ArArgumentBuilder *builder;
+  bool ok = true;
+
+  if (!readCacheBytes(buf, len, &pos, &numRecords, 4))
+    return false;
+  for (i = 0; i < numRecords; i++)
+  {
+    if (!readCacheBytes(buf, len, &pos, &index, 2) || 
+	!readCacheBytes(buf, len, &pos, &type, 1) ||
+	index >= params->size() || (*params)[index]->getType() != type)
+      return false;
+    param = (*params)[index];
+    switch (type)
+    {
+    case ArConfigArg::INT:
+      if (!readCacheBytes(buf, len, &pos, &intVal, 4))
+	return false;
+      if (apply)
+	ok = param->setInt(intVal) && ok;
+      break;
+    case ArConfigArg::DOUBLE:
+      if (!readCacheBytes(buf, len, &pos, &doubleVal, 8))
+	return false;
+      if (apply)
+	ok = param->setDouble(doubleVal) && ok;
+      break;
+    case ArConfigArg::BOOL:
+      if (!readCacheBytes(buf, len, &pos, &boolVal, 1))
+	return false;
+      if (apply)
+	ok = param->setBool(boolVal != 0) && ok;
+      break;
+    case ArConfigArg::STRING:
+      if (!readCacheBytes(buf, len, &pos, &strLen, 2) || pos + strLen > len)
+	return false;
+      if (apply)
+	ok = param->setString(std::string(buf + pos, strLen).c_str()) && ok;
+      pos += strLen;
+      break;
+    case ArConfigArg::FUNCTOR:
+      if (!readCacheBytes(buf, len, &pos, &count, 2))
+	return false;
+      for (j = 0; j < count; j++)
+      {
+	if (!readCacheBytes(buf, len, &pos, &strLen, 2) || 
+	    pos + strLen > len)
+	  return false;
+	if (apply)
+	{
+	  builder = new ArArgumentBuilder;
+	  builder->addPlain(std::string(buf + pos, strLen).c_str());
+	  builder->setExtraString(param->getName());
+	  ok = param->setArgWithFunctor(builder) && ok;
+	  delete builder;
+	}
+	pos += strLen;
+      }
+      break;
+    default:
+      return false;
+    }
+  }
+  if (!ok)
+    ArLog::log(ArLog::Normal, 
+	       "ArRobotParams: Some values from the param cache could not be set");
+  return pos == len;
+}
+
+void ArRobotParams::writeCache(const char *cacheName, 
+			       ArTypes::UByte4 schemaHash,
+			       ArTypes::UByte4 fileTime,
+			       ArTypes::UByte4 fileSize,
+			       ArTypes::UByte4 fileHash)
+{
+  std::vector<ArConfigArg *> params;
+  std::string out;
+  std::string tmpName;
+  std::list<ArArgumentBuilder *>::const_iterator argIt;
+  const std::list<ArArgumentBuilder *> *argList;
+  const char *str;
+  ArTypes::UByte4 version = CACHE_VERSION;
+  ArTypes::UByte4 numRecords = 0;
+  ArTypes::UByte2 index, strLen, count;
+  ArTypes::UByte type;
+  ArTypes::Byte4 intVal;
+  double doubleVal;
+  ArTypes::UByte boolVal;
+  FILE *file;
+  
+  getCacheParams(&params);
+  if (params.size() > 65535)
+    return;
+
+  out.append(ourCacheMagic, sizeof(ourCacheMagic));
+  out.append((const char *)&version, 4);
+  out.append((const char *)&schemaHash, 4);
+  out.append((const char *)&fileTime, 4);
+  out.append((const char *)&fileSize, 4);
+  out.append((const char *)&fileHash, 4);
+  // the count goes in once we know it
+  out.append((const char *)&numRecords, 4);
+
+  for (index = 0; index < params.size(); index++)
+  {
+    if (!params[index]->isValueSet())
+      continue;
+    type = params[index]->getType();
+    out.append((const char *)&index, 2);
+    out.append((const char *)&type, 1);
+    switch (params[index]->getType())
+    {
+    case ArConfigArg::INT:
+      intVal = params[index]->getInt();
+      out.append((const char *)&intVal, 4);
+      break;
+    case ArConfigArg::DOUBLE:
+      doubleVal = params[index]->getDouble();
+      out.append((const char *)&doubleVal, 8);
+      break;
+    case ArConfigArg::BOOL:
+      boolVal = params[index]->getBool() ? 1 : 0;
+      out.append((const char *)&boolVal, 1);
+      break;
+    case ArConfigArg::STRING:
+      str = params[index]->getString();
+      if (str == NULL)
+	str = "";
+      if (strlen(str) > 65535)
+	return;
+      strLen = strlen(str);
+      out.append((const char *)&strLen, 2);
+      out.append(str, strLen);
+      break;
+    case ArConfigArg::FUNCTOR:
+      argList = params[index]->getArgsWithFunctor();
+      if (argList == NULL)
+      {
+	count = 0;
+	out.append((const char *)&count, 2);
+	break;
+      }
+      if (argList->size() > 65535)
+	return;
+      count = argList->size();
+      out.append((const char *)&count, 2);
+      for (argIt = argList->begin(); argIt != argList->end(); argIt++)
+      {
+	str = (*argIt)->getFullString();
+	if (strlen(str) > 65535)
+	  return;
+	strLen = strlen(str);
+	out.append((const char *)&strLen, 2);
+	out.append(str, strLen);
+      }
+      break;
+    default:
+      break;
+    }
+    numRecords++;
+  }
+  out.replace(ourCacheHeaderLen, 4, (const char *)&numRecords, 4);
+
+  // write it to the side and move it over so that nothing ever maps a
+  // half written cache
+  tmpName = cacheName;
+  tmpName += ".tmp";
+  if ((file = ArUtil::fopen(tmpName.c_str(), "wb")) == NULL)
+  {
+    ArLog::log(ArLog::Verbose, "ArRobotParams: Could not open %s to write the param cache", tmpName.c_str());
+    return;
+  }
+  if (fwrite(out.data(), 1, out.size(), file) != out.size())
+  {
+    fclose(file);
+    remove(tmpName.c_str());
+    ArLog::log(ArLog::Verbose, "ArRobotParams: Could not write the param cache %s", tmpName.c_str());
+    return;
+  }
+  fclose(file);
+#ifdef WIN32
+  // rename won't replace a file that's there on windows
+  remove(cacheName);
+#endif
+  if (rename(tmpName.c_str(), cacheName) != 0)
+  {
+    remove(tmpName.c_str());
+    ArLog::log(ArLog::Verbose, "ArRobotParams: Could not move the param cache into %s", cacheName);
+    return;
+  }
+  ArLog::log(ArLog::Verbose, "ArRobotParams: Wrote %u values to the param cache %s", numRecords, cacheName);
+}
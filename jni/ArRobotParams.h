@@ -27,6 +27,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 
 #include "ariaTypedefs.h"
 #include "ArConfig.h"
+#include <vector>
 
 ///Stores parameters read from the robot's parameter files
 /** 
@@ -415,6 +416,10 @@ public:
   int getLatDecel(void) const { return myTransDecel; }
   /// Saves it to the subtype.p in Aria::getDirectory/params
   AREXPORT bool save(void);
+  /// Parses the file, using (and refreshing) a binary cache of it if it can
+  AREXPORT bool parseFileWithCache(const char *fileName, 
+				   bool continueOnError = true,
+				   bool noFileNotFoundMessage = true);
 
   /// The X (forward-back) location of the GPS (antenna) on the robot
   int getGPSX() const { return myGPSX; }
@@ -431,6 +436,24 @@ public:
   const char *getCompassPort() const { return myCompassPort; }
 
 protected:
+  /// Version of the binary param cache format, bump it if it changes
+  enum { CACHE_VERSION = 2 };
+  /// Gets the params we cache, in the order the cache indexes them
+  void getCacheParams(std::vector<ArConfigArg *> *params);
+  /// Hashes the names and types of the params we cache
+  ArTypes::UByte4 getCacheSchemaHash(std::vector<ArConfigArg *> *params);
+  /// Loads the cache, returns false (changing nothing) if it isn't valid
+  bool loadCache(const char *cacheName, ArTypes::UByte4 schemaHash,
+		 ArTypes::UByte4 fileTime, ArTypes::UByte4 fileSize,
+		 ArTypes::UByte4 fileHash);
+  /// Checks (or if apply is true applies) the records from the cache
+  bool readCacheRecords(const char *buf, size_t len, 
+			std::vector<ArConfigArg *> *params, bool apply);
+  /// Writes the cache of the values that came out of the file
+  void writeCache(const char *cacheName, ArTypes::UByte4 schemaHash,
+		  ArTypes::UByte4 fileTime, ArTypes::UByte4 fileSize,
+		  ArTypes::UByte4 fileHash);
+
   char myClass[1024];
   char mySubClass[1024];
   double myRobotRadius;
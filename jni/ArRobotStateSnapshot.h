@@ -0,0 +1,128 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#ifndef ARROBOTSTATESNAPSHOT_H
+#define ARROBOTSTATESNAPSHOT_H
+
+#include "ariaTypedefs.h"
+#include "ariaUtil.h"
+
+/// A copy of the robot's state from one cycle
+/**
+   ArRobot fills one of these in at the end of each cycle (before it
+   unlocks) and publishes it, other threads can then get a copy of it
+   with ArRobot::getStateSnapshot without locking the robot, and so
+   without waiting for (or holding up) the robot's cycle.  Everything
+   in one snapshot is from the same cycle.
+**/
+class ArRobotStateSnapshot
+{
+public:
+  enum {
+    MAX_SONAR = 32 ///< The most sonar ranges a snapshot holds
+  };
+  /// Constructor
+  ArRobotStateSnapshot() 
+    { myCounter = 0; myVel = 0; myRotVel = 0; myLatVel = 0; 
+      myLeftVel = 0; myRightVel = 0; myBatteryVoltage = 0; 
+      myRealBatteryVoltage = 0; myHaveStateOfCharge = false; 
+      myStateOfCharge = 0; myTemperature = -128; myFlags = 0; 
+      myFaultFlags = 0; myHasFaultFlags = false; myStallValue = 0; 
+      myIsConnected = false; myNumSonar = 0; }
+  /// Destructor
+  ~ArRobotStateSnapshot() {}
+  /// Gets when this snapshot was taken
+  ArTime getTime(void) const { return myTime; }
+  /// Gets which cycle (ArRobot::getCounter) this snapshot was taken on
+  unsigned int getCounter(void) const { return myCounter; }
+  /// Gets the robot's pose (ArRobot::getPose)
+  ArPose getPose(void) const { return myPose; }
+  /// Gets the robot's encoder pose (ArRobot::getEncoderPose)
+  ArPose getEncoderPose(void) const { return myEncoderPose; }
+  /// Gets the translational velocity (ArRobot::getVel)
+  double getVel(void) const { return myVel; }
+  /// Gets the rotational velocity (ArRobot::getRotVel)
+  double getRotVel(void) const { return myRotVel; }
+  /// Gets the lateral velocity (ArRobot::getLatVel)
+  double getLatVel(void) const { return myLatVel; }
+  /// Gets the left wheel velocity (ArRobot::getLeftVel)
+  double getLeftVel(void) const { return myLeftVel; }
+  /// Gets the right wheel velocity (ArRobot::getRightVel)
+  double getRightVel(void) const { return myRightVel; }
+  /// Gets the averaged battery voltage (ArRobot::getBatteryVoltage)
+  double getBatteryVoltage(void) const { return myBatteryVoltage; }
+  /// Gets the real battery voltage (ArRobot::getRealBatteryVoltage)
+  double getRealBatteryVoltage(void) const { return myRealBatteryVoltage; }
+  /// Gets if the robot had a state of charge (ArRobot::haveStateOfCharge)
+  bool haveStateOfCharge(void) const { return myHaveStateOfCharge; }
+  /// Gets the state of charge (ArRobot::getStateOfCharge)
+  double getStateOfCharge(void) const { return myStateOfCharge; }
+  /// Gets the temperature (ArRobot::getTemperature)
+  int getTemperature(void) const { return myTemperature; }
+  /// Gets the flags (ArRobot::getFlags)
+  int getFlags(void) const { return myFlags; }
+  /// Gets the fault flags (ArRobot::getFaultFlags)
+  int getFaultFlags(void) const { return myFaultFlags; }
+  /// Gets if the robot had fault flags (ArRobot::hasFaultFlags)
+  bool hasFaultFlags(void) const { return myHasFaultFlags; }
+  /// Gets the stall value (ArRobot::getStallValue)
+  int getStallValue(void) const { return myStallValue; }
+  /// Gets if the motors were enabled (ArRobot::areMotorsEnabled)
+  bool areMotorsEnabled(void) const { return (myFlags & ArUtil::BIT0); }
+  /// Gets if the estop was pressed (ArRobot::isEStopPressed)
+  bool isEStopPressed(void) const { return (myFlags & ArUtil::BIT5); }
+  /// Gets if the robot was connected (ArRobot::isConnected)
+  bool isConnected(void) const { return myIsConnected; }
+  /// Gets the number of sonar ranges in this snapshot
+  int getNumSonar(void) const { return myNumSonar; }
+  /// Gets a sonar range (ArRobot::getSonarRange), -1 if there isn't one
+  int getSonarRange(int num) const 
+    { if (num < 0 || num >= myNumSonar) return -1; 
+      return mySonarRanges[num]; }
+protected:
+  friend class ArRobot;
+  ArTime myTime;
+  unsigned int myCounter;
+  ArPose myPose;
+  ArPose myEncoderPose;
+  double myVel;
+  double myRotVel;
+  double myLatVel;
+  double myLeftVel;
+  double myRightVel;
+  double myBatteryVoltage;
+  double myRealBatteryVoltage;
+  bool myHaveStateOfCharge;
+  double myStateOfCharge;
+  int myTemperature;
+  int myFlags;
+  int myFaultFlags;
+  bool myHasFaultFlags;
+  int myStallValue;
+  bool myIsConnected;
+  int myNumSonar;
+  int mySonarRanges[MAX_SONAR];
+};
+
+#endif
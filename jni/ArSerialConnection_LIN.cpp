@@ -451,7 +451,7 @@ AREXPORT int ArSerialConnection::getStatus(void)
 
 AREXPORT ArTime ArSerialConnection::getTimeRead(int index)
 {
-  ArTime ret;
+  ArTime ret(0, 0);
   struct timeval timeStamp;
   if (myPort <= 0)
   {
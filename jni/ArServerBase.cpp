@@ -91,6 +91,7 @@ AREXPORT ArServerBase::ArServerBase(bool addAriaExitCB,
 
   myLogPrefix = myServerName + "Base: ";
   myDebugLogging = false;
+  myClientSendBandwidthLimit = 0;
   myVerboseLogLevel = ArLog::Verbose;
 
   setThreadName(myServerName.c_str());
@@ -424,6 +425,8 @@ AREXPORT ArServerClient *ArServerBase::finishAcceptingSocket(
 			      myDebugLogging, serverClientName.c_str(),
 			      myLogPasswordFailureVerbosely,
 			      myAllowSlowPackets, myAllowIdlePackets);
+  if (myClientSendBandwidthLimit > 0)
+    client->setSendBandwidthLimit(myClientSendBandwidthLimit);
   //client->setUdpAddress(socket->sockAddrIn());
   // put the client onto our list of clients...
   //myClients.push_front(client);
@@ -609,6 +612,46 @@ AREXPORT bool ArServerBase::broadcastPacketTcpByCommandWithExclusion(
   return true;
 }
 
+/**
+   This will broadcast this packet to any client that wants this
+   data, without each client copying or re-finalizing the packet.
+   This is mostly for the forwarders, which get packets off the wire
+   and just need to pass them along.
+   
+   @param packet the finalized shared packet to send, its command
+   must already be command
+
+   @param command the command number of the data to send
+
+   @return false if the server isn't open or the packet's command
+   doesn't match
+**/
+AREXPORT bool ArServerBase::broadcastSharedPacketTcpByCommand(
+	ArNetSharedPacket *packet, unsigned int command)
+{
+  std::list<ArServerClient *>::iterator lit;
+
+  if (packet == NULL || packet->getCommand() != command)
+  {
+    ArLog::log(ArLog::Normal, "ArServerBase::broadcastSharedPacket: shared packet does not have command %u", command);
+    return false;
+  }
+
+  myClientsMutex.lock();  
+
+  if (!myOpened)
+  {
+    ArLog::log(ArLog::Verbose, "ArServerBase::broadcastSharedPacket: server not open to send packet.");
+    myClientsMutex.unlock();  
+    return false;
+  }
+
+  for (lit = myClients.begin(); lit != myClients.end(); ++lit)
+    (*lit)->broadcastSharedPacketTcp(packet);
+
+  myClientsMutex.unlock();  
+  return true;
+}
 
 /**
    This will broadcast this packet to any client that wants this
@@ -1462,6 +1505,25 @@ AREXPORT void ArServerBase::setBackupTimeout(double timeoutInMins)
   myClientsMutex.unlock();
 }
 
+/**
+   This applies to each client separately, so a client downloading a
+   big file can't take the whole link.  Packets still go out by
+   priority within the cap (see ArNetPacketSenderTcp).
+
+   @param bytesPerSecond the most bytes a second to send each client,
+   0 or less for no cap
+**/
+AREXPORT void ArServerBase::setClientSendBandwidthLimit(long bytesPerSecond)
+{
+  std::list<ArServerClient *>::iterator it;
+
+  myClientSendBandwidthLimit = bytesPerSecond;
+  myClientsMutex.lock();
+  for (it = myClients.begin(); it != myClients.end(); it++)
+    (*it)->setSendBandwidthLimit(myClientSendBandwidthLimit);
+  myClientsMutex.unlock();
+}
+
 AREXPORT void ArServerBase::logTracking(bool terse)
 {
   std::list<ArServerClient *>::iterator lit;
@@ -166,6 +166,9 @@ public:
   /// Sets the backup timeout
   AREXPORT void setBackupTimeout(double timeoutInMins);
 
+  /// Caps how many bytes a second are sent to each client (0 for no cap)
+  AREXPORT void setClientSendBandwidthLimit(long bytesPerSecond);
+
   /// Runs the server in this thread
   AREXPORT virtual void run(void);
   
@@ -281,6 +284,10 @@ public:
 	  ArServerClientIdentifier identifier = ArServerClientIdentifier(), 
 	  bool matchConnectionID = false);
 
+  /// Broadcasts a shared packet to any client wanting this data (no copying)
+  AREXPORT bool broadcastSharedPacketTcpByCommand(
+	  ArNetSharedPacket *packet, unsigned int command);
+
   /// Broadcasts packets to any client wanting this data
   AREXPORT bool broadcastPacketUdpByCommand(
 	  ArNetPacket *packet, unsigned int command);
@@ -370,6 +377,7 @@ protected:
   int myRejecting;
   std::string myRejectingString;
   double myBackupTimeout;
+  long myClientSendBandwidthLimit;
   // the number we're on for the current data
   unsigned int myNextDataNumber;
   std::string myAdditionalDataFlags;
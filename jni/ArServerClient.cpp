@@ -836,6 +836,28 @@ AREXPORT void ArServerClient::broadcastPacketTcp(ArNetPacket *packet)
   // we didn't have the data to send
 }
 
+AREXPORT void ArServerClient::broadcastSharedPacketTcp(
+	ArNetSharedPacket *packet)
+{
+  std::list<ArServerClientData *>::iterator it;
+  ArServerClientData *data;  
+  ArServerData *serverData;
+
+  // walk through our list
+  for (it = myRequested.begin(); it != myRequested.end(); ++it)
+  {
+    data = (*it);
+    serverData = data->getServerData();
+    // see if this is our data, if it is send the packet
+    if (serverData->getCommand() == packet->getCommand())
+    {
+      sendSharedPacketTcp(packet);
+      return;
+    }
+  }
+  // we didn't have the data to send
+}
+
 AREXPORT void ArServerClient::broadcastPacketUdp(ArNetPacket *packet)
 {
   std::list<ArServerClientData *>::iterator it;
@@ -876,7 +898,8 @@ AREXPORT bool ArServerClient::sendPacketTcp(ArNetPacket *packet)
       ArLog::log(ArLog::Normal, "%sSending tcp command %d", 
 		 myLogPrefix.c_str(), packet->getCommand());
 
-    myTcpSender.sendPacket(packet, myLogPrefix.c_str());
+    myTcpSender.sendPacket(packet, myLogPrefix.c_str(), 
+			   findSendPriority(packet->getCommand()));
     return true;
   }
 }
@@ -911,6 +934,73 @@ AREXPORT bool ArServerClient::sendPacketUdp(ArNetPacket *packet)
   }
 }
 
+/**
+   The packet is already finalized (it has its command, header and
+   footer) so unlike sendPacketTcp this doesn't touch it at all, the
+   sender just keeps a reference to it until it has gone out.
+**/
+AREXPORT bool ArServerClient::sendSharedPacketTcp(ArNetSharedPacket *packet)
+{
+  if (myState == STATE_DISCONNECTED)
+  {
+    if (myDebugLogging && packet->getCommand() <= 255)
+      ArLog::log(myVerboseLogLevel, "%s sendPacket: command %s trying to be sent while disconnected", myLogPrefix.c_str(), findCommandName(packet->getCommand()));
+    return false;
+  }
+
+  trackPacketSent(packet->getPacket(), true);
+
+  if (myDebugLogging && packet->getCommand() <= 255)
+    ArLog::log(ArLog::Normal, "%sSending shared tcp command %d", 
+	       myLogPrefix.c_str(), packet->getCommand());
+
+  myTcpSender.sendSharedPacket(packet, 
+			       findSendPriority(packet->getCommand()));
+  return true;
+}
+
+/**
+   The source is asked for each packet only once the one before it
+   has gone out, so big transfers don't sit in memory.  The source
+   must set the command on the packets it makes.  This takes ownership
+   of the source (and deletes it right away if we're disconnected).
+**/
+AREXPORT bool ArServerClient::sendPacketSourceTcp(ArNetPacketSource *source)
+{
+  if (myState == STATE_DISCONNECTED)
+  {
+    if (myDebugLogging)
+      ArLog::log(myVerboseLogLevel, "%s sendPacketSource: trying to send while disconnected", myLogPrefix.c_str());
+    delete source;
+    return false;
+  }
+
+  if (myDebugLogging)
+    ArLog::log(ArLog::Normal, "%sSending tcp packet source", 
+	       myLogPrefix.c_str());
+
+  myTcpSender.sendPacketSource(source);
+  return true;
+}
+
+/**
+   The server's own commands (the ones without data entries) are
+   control, everything else goes by the flags on its data.
+**/
+ArNetPacketSenderTcp::Priority ArServerClient::findSendPriority(
+	unsigned int command) const
+{
+  std::map<unsigned int, ArServerData *>::const_iterator it;
+
+  if ((it = myDataMap->find(command)) == myDataMap->end())
+  {
+    if (command <= 255)
+      return ArNetPacketSenderTcp::PRIORITY_CONTROL;
+    return ArNetPacketSenderTcp::PRIORITY_STATUS;
+  }
+  return (*it).second->getSendPriority();
+}
+
 AREXPORT  bool ArServerClient::setupPacket(ArNetPacket *packet)
 {
   if (packet->getCommand() == 0)
@@ -1305,6 +1395,13 @@ AREXPORT void ArServerClient::logTracking(bool terse)
 	       (bytesSentUdp + bytesReceivedUdp) / seconds);
   }
 
+  if (!terse)
+  {
+    ArLog::log(ArLog::Terse, "");
+    ArLog::log(ArLog::Terse, "Send queues for %s:", getIPString());
+    myTcpSender.logQueueStats();
+  }
+
   ArLog::log(ArLog::Terse, "");
 }
 
@@ -1324,6 +1421,7 @@ AREXPORT void ArServerClient::resetTracking(void)
     (*it).second->reset();
 
   myTcpSocket.resetTracking();
+  myTcpSender.resetQueueStats();
 }
 
 AREXPORT bool ArServerClient::hasGroupAccess(const char *group)
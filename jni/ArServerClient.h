@@ -92,6 +92,10 @@ public:
   /// The command ID of the outgoing packet will be set to the current command ID 
   /// (from the incoming packet).
   AREXPORT bool sendPacketUdp(ArNetPacket *packet);
+  /// Send an already finalized shared packet over TCP (without copying it)
+  AREXPORT bool sendSharedPacketTcp(ArNetSharedPacket *packet);
+  /// Send packets from a source over TCP as the socket drains (takes ownership)
+  AREXPORT bool sendPacketSourceTcp(ArNetPacketSource *source);
 
   /// Sees if this client has access to a given group
   AREXPORT bool hasGroupAccess(const char *group);
@@ -107,6 +111,12 @@ public:
    */
   AREXPORT void broadcastPacketUdp(ArNetPacket *packet);
 
+  /** Broadcasts a shared packet over TCP if this client wants this data -- For internal
+   * use only!
+   * @internal 
+   */
+  AREXPORT void broadcastSharedPacketTcp(ArNetSharedPacket *packet); 
+
   /// Logs the tracking information (packet and byte counts)
   AREXPORT void logTracking(bool terse);
   
@@ -142,6 +152,11 @@ public:
 
   /// Internal function to get the tcp socket
   AREXPORT ArSocket *getTcpSocket(void) { return &myTcpSocket; }
+  /// Internal function to get the tcp sender (for its queue stats)
+  AREXPORT ArNetPacketSenderTcp *getTcpSender(void) { return &myTcpSender; }
+  /// Caps how many bytes a second are sent to this client (0 for no cap)
+  AREXPORT void setSendBandwidthLimit(long bytesPerSecond)
+    { myTcpSender.setBandwidthLimit(bytesPerSecond); }
   /// Forcibly disconnect a client (for client/server switching)
   AREXPORT void forceDisconnect(bool quiet);
   /// Gets how often a command is asked for
@@ -171,6 +186,8 @@ protected:
   std::list<bool> mySlowIdleForceTcpStack;  
 
   AREXPORT bool setupPacket(ArNetPacket *packet);
+  // Gets the priority to send a command with
+  ArNetPacketSenderTcp::Priority findSendPriority(unsigned int command) const;
   // Pushes a new number onto our little stack of numbers
   void pushCommand(unsigned int num);
   // Pops the command off the stack
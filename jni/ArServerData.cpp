@@ -60,6 +60,22 @@ AREXPORT ArServerData::ArServerData(
 
   mySlowPacket = hasDataFlag("SLOW_PACKET");
   myIdlePacket = hasDataFlag("IDLE_PACKET");
+  findSendPriority();
+}
+
+/**
+   The CONTROL_PRIORITY and BULK_PRIORITY flags say what priority this
+   data goes out to clients with, SLOW_PACKET and IDLE_PACKET data is
+   bulk unless it says otherwise, everything else is status.
+**/
+void ArServerData::findSendPriority(void)
+{
+  if (hasDataFlag("CONTROL_PRIORITY"))
+    mySendPriority = ArNetPacketSenderTcp::PRIORITY_CONTROL;
+  else if (hasDataFlag("BULK_PRIORITY") || mySlowPacket || myIdlePacket)
+    mySendPriority = ArNetPacketSenderTcp::PRIORITY_BULK;
+  else
+    mySendPriority = ArNetPacketSenderTcp::PRIORITY_STATUS;
 }
 
 AREXPORT ArServerData::~ArServerData()
@@ -89,6 +105,7 @@ AREXPORT bool ArServerData::addDataFlags(const char *dataFlags)
   myDataMutex.lock();
   myDataFlagsBuilder.add(dataFlags);
   myDataMutex.unlock();
+  findSendPriority();
   return true;
 }
 
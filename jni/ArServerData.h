@@ -32,6 +32,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 **/
 
 #include "Aria.h"
+#include "ArNetPacketSenderTcp.h"
 
 class ArServerClient;
 class ArNetPacket;
@@ -70,6 +71,9 @@ public:
   AREXPORT bool remDataFlag(const char *dataFlag);
   bool isSlowPacket(void) { return mySlowPacket; }
   bool isIdlePacket(void) { return myIdlePacket; }
+  /// Gets the priority this data is sent to clients with
+  ArNetPacketSenderTcp::Priority getSendPriority(void) 
+    { return mySendPriority; }
   const char *getDataFlagsString(void) 
     { return myDataFlagsBuilder.getFullString(); }
   AREXPORT void callRequestChangedFunctor(void);
@@ -89,6 +93,8 @@ protected:
   ArFunctor2<ArServerClient *, ArNetPacket *> *myRequestOnceFunctor;
   bool mySlowPacket;
   bool myIdlePacket;
+  ArNetPacketSenderTcp::Priority mySendPriority;
+  void findSendPriority(void);
 };
 
 #endif // ARSERVERDATA_H
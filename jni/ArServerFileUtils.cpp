@@ -28,8 +28,12 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArServerFileUtils.h"
 
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <dirent.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/inotify.h>
 
 
 AREXPORT ArServerFileLister::ArServerFileLister(
@@ -37,6 +41,7 @@ AREXPORT ArServerFileLister::ArServerFileLister(
 	const char *defaultUploadDownloadDir) :
   myGetDirListingCB(this, &ArServerFileLister::getDirListing),
   myGetDirListingMultiplePacketsCB(this, &ArServerFileLister::getDirListingMultiplePackets),
+  myGetDirListingFilteredCB(this, &ArServerFileLister::getDirListingFiltered),
   myGetDefaultUploadDownloadDirCB(
 	  this, 
 	  &ArServerFileLister::getDefaultUploadDownloadDir)
@@ -55,6 +60,13 @@ AREXPORT ArServerFileLister::ArServerFileLister(
 		    "ubyte2: return code, 0 = good, 1 = tried to go outside allowed area, 2 = no such directory (or can't read); string: directoryListed;  IF return was 0 then ubyte2: numEntries; repeating numEntries (byte: type (1 for dir or 2 for file) string: name; ubyte4: access_time; ubyte4: modified_time)", 
 		    "FileAccess", "RETURN_UNTIL_EMPTY|SLOW_PACKET");
 
+  myServer->addData("getDirListingFiltered", 
+		    "Gets a page of the directory listing of a given directory with only the entries matching a filter, possibly broken up into multiple packets (from the current working directory), you should probably use a class from ArClientFileUtils instead of calling this directly",
+		    &myGetDirListingFilteredCB, 
+		    "string: directory to get listing of; ubyte4: index of the first matching entry to send; ubyte4: max entries to send (0 for all); byte: type (0 for both, 1 for dirs, 2 for files); string: name pattern (shell style without case, empty for all)",
+		    "ubyte2: return code, 0 = good, 1 = tried to go outside allowed area, 2 = no such directory (or can't read); string: directoryListed;  IF return was 0 then ubyte4: total number of matching entries; ubyte4: index of the first entry; ubyte2: numEntries; repeating numEntries (byte: type (1 for dir or 2 for file) string: name; ubyte4: access_time; ubyte4: modified_time; ubyte4: size)", 
+		    "FileAccess", "RETURN_UNTIL_EMPTY|SLOW_PACKET");
+
   if (defaultUploadDownloadDir == NULL)
     myDefaultUploadDownloadDir = "";
   else
@@ -75,27 +87,41 @@ AREXPORT ArServerFileLister::ArServerFileLister(
   ArUtil::appendSlash(myBaseDir, sizeof(myBaseDir));
   // make sure the slashes go the right direction
   ArUtil::fixSlashes(myBaseDir, sizeof(myBaseDir));  
+
+  myCacheMutex.setLogName("ArServerFileLister::myCacheMutex");
+  myCachePollInterval = 2000;
+  myMaxCachedDirs = 32;
+  // if we can't watch directories the listings are just polled
+  if ((myInotifyFD = inotify_init()) >= 0)
+  {
+    fcntl(myInotifyFD, F_SETFL, O_NONBLOCK);
+    fcntl(myInotifyFD, F_SETFD, FD_CLOEXEC);
+  }
+  else
+    ArLog::log(ArLog::Verbose, 
+	       "ArServerFileLister: Cannot watch directories, will poll them");
 }
 
 AREXPORT ArServerFileLister::~ArServerFileLister()
 {
-
+  while (!myDirCaches.empty())
+    removeDirCache((*myDirCaches.begin()).second);
+  if (myInotifyFD >= 0)
+    close(myInotifyFD);
 }
 
-AREXPORT void ArServerFileLister::getDirListing(ArServerClient *client,
-						ArNetPacket *packet)
+/**
+   Cleans up the directory the client asked for and puts it on our
+   base directory.
+
+   @return 0 if it's good, 1 if it tries to go outside our base directory
+**/
+AREXPORT int ArServerFileLister::findDir(const char *directory, 
+					 std::string *wholeDir)
 {
-  ArNetPacket sendPacket;
   size_t ui;
   size_t len;
 
-  bool printing = false;
-
-  char directory[2048];
-  packet->bufToStr(directory, sizeof(directory));
-  
-  if (printing)
-    printf("'%s' requested\n", directory);
   len = strlen(directory);
   // first advance to the first non space
   for (ui = 0; 
@@ -105,7 +131,7 @@ AREXPORT void ArServerFileLister::getDirListing(ArServerClient *client,
   char *dirStr = new char[len + 3];
 
   // now copy in the rest
-  strncpy(dirStr, directory, len - ui);
+  strncpy(dirStr, &directory[ui], len - ui);
   // make sure its null terminated
   dirStr[len - ui] = '\0';
     
@@ -114,12 +140,7 @@ AREXPORT void ArServerFileLister::getDirListing(ArServerClient *client,
   {
     ArLog::log(ArLog::Normal, "ArServerFileLister: '%s' tried to access outside allowed area", dirStr);
     delete[] dirStr;
-    sendPacket.uByte2ToBuf(1);
-    // put in the directory name
-    sendPacket.strToBuf(directory);
-    if (client != NULL)
-      client->sendPacketTcp(&sendPacket);
-    return;
+    return 1;
   }
 
   // if its not empty make sure its set up right
@@ -132,203 +153,339 @@ AREXPORT void ArServerFileLister::getDirListing(ArServerClient *client,
   }
 
   // put our base and where we want to go together
-  std::string wholeDir;
-  wholeDir = myBaseDir;
-  wholeDir += dirStr;
+  *wholeDir = myBaseDir;
+  *wholeDir += dirStr;
+  delete[] dirStr;
+  return 0;
+}
+
+/**
+   Reads the directory and stats everything in it into the cache, and
+   starts watching the directory if it isn't watched already.
 
+   @return true if the directory could be read
+**/
+AREXPORT bool ArServerFileLister::scanDir(DirCache *cache)
+{
   DIR *dir;
   struct dirent *ent;
   struct stat statBuf;
-  std::set<std::string, ArStrCaseCmpOp> dirs;
-  std::map<std::string, ArTypes::UByte4> dirToATime;
-  std::map<std::string, ArTypes::UByte4> dirToMTime;
-  std::map<std::string, ArTypes::UByte4> dirToSize;
-  std::set<std::string, ArStrCaseCmpOp> files;
-  std::map<std::string, ArTypes::UByte4> fileToATime;
-  std::map<std::string, ArTypes::UByte4> fileToMTime;
-  std::map<std::string, ArTypes::UByte4> fileToSize;
-  std::set<std::string, ArStrCaseCmpOp>::iterator it;
+  std::map<std::string, DirEntry, ArStrCaseCmpOp> dirs;
+  std::map<std::string, DirEntry, ArStrCaseCmpOp> files;
+  std::map<std::string, DirEntry, ArStrCaseCmpOp>::iterator it;
   std::string str;
-  
-  if ((dir = opendir(wholeDir.c_str())) == NULL)
-  {
-    ArLog::log(ArLog::Normal, "ArServerFileLister: No such directory '%s' from base '%s' plus directory '%s'", 
-	       directory, myBaseDir, dirStr);
-    delete[] dirStr;
-    sendPacket.uByte2ToBuf(2);
-    // put in the directory name
-    sendPacket.strToBuf(directory);
-    if (client != NULL)
-      client->sendPacketTcp(&sendPacket);
-    return;
-  }
+  DirEntry entry;
+
+  cache->myValid = false;
+  cache->myEntries.clear();
+  cache->myNumDirs = 0;
+
+  // watch it before we read it so nothing that changes while we're
+  // reading gets missed
+  if (myInotifyFD >= 0 && myMaxCachedDirs > 0 && cache->myWatch < 0 && 
+      (cache->myWatch = inotify_add_watch(
+	      myInotifyFD, cache->myWholeDir.c_str(), 
+	      IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_MOVED_FROM |
+	      IN_MOVED_TO | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF |
+	      IN_ONLYDIR)) >= 0)
+    myWatchToDirCache[cache->myWatch] = cache;
+
+  if (stat(cache->myWholeDir.c_str(), &statBuf) != 0 || 
+      (dir = opendir(cache->myWholeDir.c_str())) == NULL)
+    return false;
+  cache->myDirMTime = statBuf.st_mtime;
+
   while ((ent = readdir(dir)) != NULL)
   {
+    if (ent->d_name[0] == '.')
+      continue;
     // this works because if the first one goes it short circuits the second
     if ((it = dirs.find(ent->d_name)) != dirs.end() || 
 	(it = files.find(ent->d_name)) != files.end())
     {
       ArLog::log(ArLog::Normal, 
 		 "ArServerFileLister: %s duplicates '%s'", 
-		 ent->d_name, (*it).c_str());
+		 ent->d_name, (*it).first.c_str());
       continue;
     }      
-    if (ent->d_name[0] == '.')
-      continue;
-    str = wholeDir.c_str();
+    str = cache->myWholeDir;
     str += ent->d_name;
-    if (printing)
-      printf("name %s\n", str.c_str());
-    if (stat(str.c_str(), &statBuf) == 0)
+    if (stat(str.c_str(), &statBuf) != 0)
+    {
+      ArLog::log(ArLog::Normal, "Cannot stat %s in %s", ent->d_name, cache->myWholeDir.c_str());
+      continue;
+    }
+    if (S_ISREG(statBuf.st_mode))
+      entry.myType = 2;
+    else if (S_ISDIR(statBuf.st_mode))
+      entry.myType = 1;
+    else
+      continue;
+    entry.myName = ent->d_name;
+    entry.myATime = statBuf.st_atime;
+    entry.myMTime = statBuf.st_mtime;
+    entry.mySize = statBuf.st_size;
+    if (entry.myType == 1)
+      dirs[entry.myName] = entry;
+    else
+      files[entry.myName] = entry;
+  }
+  closedir(dir);
+
+  cache->myEntries.reserve(dirs.size() + files.size());
+  for (it = dirs.begin(); it != dirs.end(); it++)
+    cache->myEntries.push_back((*it).second);
+  for (it = files.begin(); it != files.end(); it++)
+    cache->myEntries.push_back((*it).second);
+  cache->myNumDirs = dirs.size();
+  cache->myValid = true;
+  cache->myLastScan.setToNow();
+  return true;
+}
+
+/// Reads any changes from inotify and marks those listings as stale
+AREXPORT void ArServerFileLister::readWatches(void)
+{
+  char buf[4096];
+  ssize_t len;
+  ssize_t i;
+  struct inotify_event *event;
+  std::map<int, DirCache *>::iterator wIt;
+  std::map<std::string, DirCache *>::iterator cIt;
+
+  if (myInotifyFD < 0)
+    return;
+
+  while ((len = read(myInotifyFD, buf, sizeof(buf))) > 0)
+  {
+    for (i = 0; i + (ssize_t)sizeof(struct inotify_event) <= len; 
+	 i += sizeof(struct inotify_event) + event->len)
     {
-      if (S_ISREG(statBuf.st_mode))
+      event = (struct inotify_event *)&buf[i];
+      // if we missed some then we don't know what changed
+      if (event->mask & IN_Q_OVERFLOW)
       {
-	files.insert(ent->d_name);
-	fileToATime[ent->d_name] = statBuf.st_atime;
-	fileToMTime[ent->d_name] = statBuf.st_mtime;
-	fileToSize[ent->d_name] = statBuf.st_size;
-	//printf("File %s\n", ent.d_name);
+	for (cIt = myDirCaches.begin(); cIt != myDirCaches.end(); cIt++)
+	  (*cIt).second->myValid = false;
+	continue;
       }
-      if (S_ISDIR(statBuf.st_mode))
+      if ((wIt = myWatchToDirCache.find(event->wd)) == myWatchToDirCache.end())
+	continue;
+      (*wIt).second->myValid = false;
+      // the watch is gone so rescanning will have to make a new one
+      if (event->mask & IN_IGNORED)
       {
-	dirs.insert(ent->d_name);
-	dirToATime[ent->d_name] = statBuf.st_atime;
-	dirToMTime[ent->d_name] = statBuf.st_mtime;
-	dirToSize[ent->d_name] = statBuf.st_size;
-	//printf("Dir %s\n", ent.d_name);
+	(*wIt).second->myWatch = -1;
+	myWatchToDirCache.erase(wIt);
       }
     }
-    else
-    {
-      ArLog::log(ArLog::Normal, "Cannot stat %s in %s", ent->d_name, wholeDir.c_str());
-    }
   }
-  // we got here so the return is 0 (good)
-  sendPacket.uByte2ToBuf(0);
-  // put in the directory name
-  sendPacket.strToBuf(directory);
-  if (printing)
-    printf("Sending %s\n", directory);
-  if (printing)
-    printf("Dirs:\n");
-  // put in how many directories we have
-  sendPacket.uByte2ToBuf(dirs.size());
-  for (it = dirs.begin(); it != dirs.end(); it++)
+}
+
+/**
+   Gets the cached listing of a directory, reading it again if it
+   changed.  If we aren't caching then uncached is filled in and
+   returned.  Call this with myCacheMutex locked.
+
+   @return the listing, or NULL if the directory can't be read
+**/
+AREXPORT ArServerFileLister::DirCache *ArServerFileLister::getDirCache(
+	const std::string &wholeDir, DirCache *uncached)
+{
+  std::map<std::string, DirCache *>::iterator it;
+  DirCache *cache;
+  struct stat statBuf;
+
+  if (myMaxCachedDirs == 0)
   {
-    sendPacket.strToBuf((*it).c_str());
-    sendPacket.uByte4ToBuf(dirToATime[(*it)]);
-    sendPacket.uByte4ToBuf(dirToMTime[(*it)]);
-    sendPacket.uByte4ToBuf(dirToSize[(*it)]);
+    uncached->myWholeDir = wholeDir;
+    uncached->myWatch = -1;
+    if (!scanDir(uncached))
+      return NULL;
+    return uncached;
   }
-  
-  if (printing)
+
+  readWatches();
+
+  if ((it = myDirCaches.find(wholeDir)) != myDirCaches.end())
   {
-    printf("\n");
-    printf("Files:\n");
+    cache = (*it).second;
+    // if it isn't watched then only trust it for a little while
+    // (unless the directory itself changed)
+    if (cache->myValid && cache->myWatch < 0 &&
+	(cache->myLastScan.mSecSince() >= myCachePollInterval ||
+	 stat(wholeDir.c_str(), &statBuf) != 0 || 
+	 statBuf.st_mtime != cache->myDirMTime))
+      cache->myValid = false;
   }
-  sendPacket.uByte2ToBuf(files.size());
-  for (it = files.begin(); it != files.end(); it++)
+  else
   {
-    sendPacket.strToBuf((*it).c_str());
-    sendPacket.uByte4ToBuf(fileToATime[(*it)]);
-    sendPacket.uByte4ToBuf(fileToMTime[(*it)]);
-    sendPacket.uByte4ToBuf(fileToSize[(*it)]);
-    if (printing)
+    // make room by dropping the one used longest ago
+    while (myDirCaches.size() >= myMaxCachedDirs)
     {
-      time_t atime = fileToATime[(*it)];
-      time_t mtime = fileToMTime[(*it)];
-      printf("\tname: %s\n", (*it).c_str());
-      printf("\t\tlastAccessed: %s", ctime(&atime));
-      printf("\t\tlastModified: %s", ctime(&mtime));
-      printf("\t\tsize: %d", fileToSize[(*it)]);
+      std::map<std::string, DirCache *>::iterator oldest;
+      oldest = myDirCaches.begin();
+      for (it = myDirCaches.begin(); it != myDirCaches.end(); it++)
+	if ((*it).second->myLastUsed.isBefore((*oldest).second->myLastUsed))
+	  oldest = it;
+      removeDirCache((*oldest).second);
     }
+    cache = new DirCache;
+    cache->myWholeDir = wholeDir;
+    cache->myNumDirs = 0;
+    cache->myValid = false;
+    cache->myWatch = -1;
+    cache->myDirMTime = 0;
+    myDirCaches[wholeDir] = cache;
   }
-  delete[] dirStr;
-  if (client != NULL)
-    client->sendPacketTcp(&sendPacket);
-  closedir(dir);
+  cache->myLastUsed.setToNow();
+
+  if (!cache->myValid && !scanDir(cache))
+  {
+    removeDirCache(cache);
+    return NULL;
+  }
+  return cache;
 }
 
-AREXPORT void ArServerFileLister::getDirListingMultiplePackets(
-	ArServerClient *client, ArNetPacket *packet)
+/// Stops watching and forgets a cached listing
+AREXPORT void ArServerFileLister::removeDirCache(DirCache *cache)
 {
-  ArNetPacket sendPacket;
-  size_t ui;
-  size_t len;
-
-  bool printing = false;
+  if (cache->myWatch >= 0)
+  {
+    inotify_rm_watch(myInotifyFD, cache->myWatch);
+    myWatchToDirCache.erase(cache->myWatch);
+  }
+  myDirCaches.erase(cache->myWholeDir);
+  delete cache;
+}
 
+AREXPORT void ArServerFileLister::getDirListing(ArServerClient *client,
+						ArNetPacket *packet)
+{
+  ArNetPacket sendPacket;
   char directory[2048];
+  std::string wholeDir;
+  DirCache uncached;
+  DirCache *cache;
+  std::vector<DirEntry>::iterator it;
+
   packet->bufToStr(directory, sizeof(directory));
   
-  if (printing)
-    printf("'%s' requested\n", directory);
-  len = strlen(directory);
-  // first advance to the first non space
-  for (ui = 0; 
-       ui < len && directory[ui] != '\0' && isspace(directory[ui]); 
-       ui++);
-
-  char *dirStr = new char[len + 3];
-
-  // now copy in the rest
-  strncpy(dirStr, directory, len - ui);
-  // make sure its null terminated
-  dirStr[len - ui] = '\0';
-    
-  if (dirStr[0] == '/' || dirStr[0] == '~' ||
-      dirStr[0] == '\\' || strstr(dirStr, "..") != NULL)
+  if (findDir(directory, &wholeDir) != 0)
   {
-    ArLog::log(ArLog::Normal, "ArServerFileLister: '%s' tried to access outside allowed area", dirStr);
-    delete[] dirStr;
     sendPacket.uByte2ToBuf(1);
     // put in the directory name
     sendPacket.strToBuf(directory);
     if (client != NULL)
-    {
       client->sendPacketTcp(&sendPacket);
-      sendPacket.empty();
-      client->sendPacketTcp(&sendPacket);
-    }
     return;
   }
 
-  // if its not empty make sure its set up right
-  if (strlen(dirStr) > 0)
+  myCacheMutex.lock();
+  if ((cache = getDirCache(wholeDir, &uncached)) == NULL)
   {
-    // make sure it has a slash
-    ArUtil::appendSlash(dirStr, len + 2);
-    // make sure the slashes go the right direction
-    ArUtil::fixSlashes(dirStr, len + 2);
+    myCacheMutex.unlock();
+    ArLog::log(ArLog::Normal, "ArServerFileLister: No such directory '%s' from base '%s'", 
+	       directory, myBaseDir);
+    sendPacket.uByte2ToBuf(2);
+    // put in the directory name
+    sendPacket.strToBuf(directory);
+    if (client != NULL)
+      client->sendPacketTcp(&sendPacket);
+    return;
   }
+  // we got here so the return is 0 (good)
+  sendPacket.uByte2ToBuf(0);
+  // put in the directory name
+  sendPacket.strToBuf(directory);
+  // put in the directories then the files
+  sendPacket.uByte2ToBuf(cache->myNumDirs);
+  for (it = cache->myEntries.begin(); it != cache->myEntries.end(); it++)
+  {
+    if (it - cache->myEntries.begin() == (int)cache->myNumDirs)
+      sendPacket.uByte2ToBuf(cache->myEntries.size() - cache->myNumDirs);
+    sendPacket.strToBuf((*it).myName.c_str());
+    sendPacket.uByte4ToBuf((*it).myATime);
+    sendPacket.uByte4ToBuf((*it).myMTime);
+    sendPacket.uByte4ToBuf((*it).mySize);
+  }
+  if (cache->myNumDirs == cache->myEntries.size())
+    sendPacket.uByte2ToBuf(0);
+  myCacheMutex.unlock();
+  if (client != NULL)
+    client->sendPacketTcp(&sendPacket);
+}
 
-  // put our base and where we want to go together
-  std::string wholeDir;
-  wholeDir = myBaseDir;
-  wholeDir += dirStr;
+AREXPORT void ArServerFileLister::getDirListingMultiplePackets(
+	ArServerClient *client, ArNetPacket *packet)
+{
+  char directory[2048];
+  packet->bufToStr(directory, sizeof(directory));
+  sendListing(client, directory, false, 0, 0, 0, "");
+}
 
-  DIR *dir;
-  struct dirent *ent;
-  struct stat statBuf;
-  std::set<std::string, ArStrCaseCmpOp> dirs;
-  std::map<std::string, ArTypes::UByte4> dirToATime;
-  std::map<std::string, ArTypes::UByte4> dirToMTime;
-  std::map<std::string, ArTypes::UByte4> dirToSize;
-  std::set<std::string, ArStrCaseCmpOp> files;
-  std::map<std::string, ArTypes::UByte4> fileToATime;
-  std::map<std::string, ArTypes::UByte4> fileToMTime;
-  std::map<std::string, ArTypes::UByte4> fileToSize;
-  std::set<std::string, ArStrCaseCmpOp>::iterator it;
-  std::string str;
-  ArTypes::UByte2 numEntries = 0;
+AREXPORT void ArServerFileLister::getDirListingFiltered(
+	ArServerClient *client, ArNetPacket *packet)
+{
+  char directory[2048];
+  char pattern[1024];
+  ArTypes::UByte4 start;
+  ArTypes::UByte4 maxEntries;
   int type;
 
-  if ((dir = opendir(wholeDir.c_str())) == NULL)
+  packet->bufToStr(directory, sizeof(directory));
+  start = packet->bufToUByte4();
+  maxEntries = packet->bufToUByte4();
+  type = packet->bufToByte();
+  packet->bufToStr(pattern, sizeof(pattern));
+  sendListing(client, directory, true, start, maxEntries, type, pattern);
+}
+
+/**
+   Sends the listing of a directory broken up into as many packets as
+   it takes, then an empty packet to say it's done.  If filtered is
+   true then only the entries of the given type (0 for any) whose
+   names match the pattern are counted, and only maxEntries (0 for
+   all) of those starting at start are sent.
+**/
+AREXPORT void ArServerFileLister::sendListing(
+	ArServerClient *client, const char *directory, bool filtered, 
+	ArTypes::UByte4 start, ArTypes::UByte4 maxEntries, int type,
+	const char *pattern)
+{
+  ArNetPacket sendPacket;
+  std::string wholeDir;
+  DirCache uncached;
+  DirCache *cache;
+  std::vector<DirEntry>::iterator it;
+  std::vector<DirEntry *> matches;
+  std::vector<DirEntry *>::iterator mIt;
+  ArTypes::UByte4 total;
+  ArTypes::UByte2 numEntriesLen;
+  ArTypes::UByte2 realLen;
+  ArTypes::UByte2 numEntries = 0;
+  int flags = 0;
+  int ret;
+
+#ifdef FNM_CASEFOLD
+  flags = FNM_CASEFOLD;
+#endif
+
+  if ((ret = findDir(directory, &wholeDir)) == 0)
   {
-    ArLog::log(ArLog::Normal, "ArServerFileLister: No such directory '%s' from base '%s' plus directory '%s'", 
-	       directory, myBaseDir, dirStr);
-    delete[] dirStr;
-    sendPacket.uByte2ToBuf(2);
+    myCacheMutex.lock();
+    if ((cache = getDirCache(wholeDir, &uncached)) == NULL)
+    {
+      myCacheMutex.unlock();
+      ArLog::log(ArLog::Normal, "ArServerFileLister: No such directory '%s' from base '%s'", 
+		 directory, myBaseDir);
+      ret = 2;
+    }
+  }
+  if (ret != 0)
+  {
+    sendPacket.uByte2ToBuf(ret);
     // put in the directory name
     sendPacket.strToBuf(directory);
     if (client != NULL)
@@ -340,84 +497,70 @@ AREXPORT void ArServerFileLister::getDirListingMultiplePackets(
     return;
   }
 
-  // we got here so the return is 0 (good)
+  // find the slice of the listing to send
+  for (it = cache->myEntries.begin(); it != cache->myEntries.end(); it++)
+  {
+    if (filtered && 
+	((type != 0 && (*it).myType != type) ||
+	 (pattern[0] != '\0' && 
+	  fnmatch(pattern, (*it).myName.c_str(), flags) != 0)))
+      continue;
+    matches.push_back(&(*it));
+  }
+  total = matches.size();
+  if (start > total)
+    start = total;
+  mIt = matches.begin() + start;
+
+  // the good header that goes on each packet
   sendPacket.uByte2ToBuf(0);
-  // put in the directory name
   sendPacket.strToBuf(directory);
-
-  ArTypes::UByte2 numEntriesLen = sendPacket.getLength();
-  ArTypes::UByte2 realLen;
-  // put in a placeholder for how many directories we have
+  if (filtered)
+  {
+    sendPacket.uByte4ToBuf(total);
+    sendPacket.uByte4ToBuf(start);
+  }
+  numEntriesLen = sendPacket.getLength();
+  // put in a placeholder for how many entries we have
   sendPacket.uByte2ToBuf(0);
 
-  while ((ent = readdir(dir)) != NULL)
+  for (; mIt != matches.end() && 
+	 (maxEntries == 0 || 
+	  (ArTypes::UByte4)(mIt - matches.begin()) < start + maxEntries); 
+       mIt++)
   {
-    // this works because if the first one goes it short circuits the second
-    if ((it = dirs.find(ent->d_name)) != dirs.end() || 
-	(it = files.find(ent->d_name)) != files.end())
+    if (sendPacket.getDataLength() + (*mIt)->myName.size() + 14 >= 
+	ArNetPacket::MAX_DATA_LENGTH)
     {
-      ArLog::log(ArLog::Normal, 
-		 "ArServerFileLister: %s duplicates '%s'", 
-		 ent->d_name, (*it).c_str());
-      continue;
-    }      
-    if (ent->d_name[0] == '.')
-      continue;
-    str = wholeDir.c_str();
-    str += ent->d_name;
-    if (printing)
-      printf("name %s\n", str.c_str());
-    if (stat(str.c_str(), &statBuf) == 0)
-    {
-      if (S_ISREG(statBuf.st_mode))
-	type = 2;
-      else if (S_ISDIR(statBuf.st_mode))
-	type = 1;
-      else
-	type = 0;
-
-      if (type == 0)
-	continue;
-
-      if (sendPacket.getDataLength() + strlen(ent->d_name) + 12 >= 
-	  ArNetPacket::MAX_DATA_LENGTH)
+      // put in the number of entries in that packet
+      realLen = sendPacket.getLength();
+      sendPacket.setLength(numEntriesLen);
+      sendPacket.uByte2ToBuf(numEntries);
+      sendPacket.setLength(realLen);
+      if (client != NULL)
+	client->sendPacketTcp(&sendPacket);	
+
+      // then rebuild the start of it
+      sendPacket.empty();
+      sendPacket.uByte2ToBuf(0);
+      sendPacket.strToBuf(directory);
+      if (filtered)
       {
-	// put in the number of entries in that packet
-	realLen = sendPacket.getLength();
-	sendPacket.setLength(numEntriesLen);
-	sendPacket.uByte2ToBuf(numEntries);
-	sendPacket.setLength(realLen);
-
-	// and send it
-	if (client != NULL)
-	  client->sendPacketTcp(&sendPacket);	
-
-	sendPacket.empty();
-	// then rebuild the start of it
-	sendPacket.uByte2ToBuf(0);
-	// put in the directory name
-	sendPacket.strToBuf(directory);
-	
-	numEntriesLen = sendPacket.getLength();
-	// put in a placeholder for how many directories we have
-	sendPacket.uByte2ToBuf(0);
-	
-	// and reset our counter
-	numEntries = 0;
+	sendPacket.uByte4ToBuf(total);
+	sendPacket.uByte4ToBuf(mIt - matches.begin());
       }
-      numEntries++;
-      sendPacket.byteToBuf(type);
-      sendPacket.strToBuf(ent->d_name);
-      sendPacket.uByte4ToBuf(statBuf.st_atime);
-      sendPacket.uByte4ToBuf(statBuf.st_mtime);
-      sendPacket.uByte4ToBuf(statBuf.st_size);
-    }
-    else
-    {
-      ArLog::log(ArLog::Normal, "Cannot stat %s in %s", ent->d_name, wholeDir.c_str());
+      numEntriesLen = sendPacket.getLength();
+      sendPacket.uByte2ToBuf(0);
+      numEntries = 0;
     }
+    numEntries++;
+    sendPacket.byteToBuf((*mIt)->myType);
+    sendPacket.strToBuf((*mIt)->myName.c_str());
+    sendPacket.uByte4ToBuf((*mIt)->myATime);
+    sendPacket.uByte4ToBuf((*mIt)->myMTime);
+    sendPacket.uByte4ToBuf((*mIt)->mySize);
   }
-
+  myCacheMutex.unlock();
 
   // put in the number of entries in that packet
   realLen = sendPacket.getLength();
@@ -425,18 +568,13 @@ AREXPORT void ArServerFileLister::getDirListingMultiplePackets(
   sendPacket.uByte2ToBuf(numEntries);
   sendPacket.setLength(realLen);
   
-  // and send it
+  // and send it, then our empty packet to say we're done
   if (client != NULL)
+  {
     client->sendPacketTcp(&sendPacket);	
-
-  delete[] dirStr;
-
-  // then send our empty packet to say we're done
-  sendPacket.empty();
-  if (client != NULL)
+    sendPacket.empty();
     client->sendPacketTcp(&sendPacket);
-
-  closedir(dir);
+  }
 }
 
 AREXPORT void ArServerFileLister::getDefaultUploadDownloadDir(
@@ -457,9 +595,11 @@ AREXPORT void ArServerFileLister::getDefaultUploadDownloadDir(
 AREXPORT ArServerFileToClient::ArServerFileToClient(ArServerBase *server, 
 						                                        const char *topDir) :
   myGetFileCB(this, &ArServerFileToClient::getFile),
-  myGetFileWithTimestampCB(this, &ArServerFileToClient::getFileWithTimestamp)
+  myGetFileWithTimestampCB(this, &ArServerFileToClient::getFileWithTimestamp),
+  myGetFileChunkCB(this, &ArServerFileToClient::getFileChunk)
 {
   myServer = server;
+  myStreamFiles = true;
   myServer->addData("getFile", 
 		    "Gets a file (use ArClientFileToClient instead of calling this directly since this interface may change)",
 		    &myGetFileCB, "string: file to get; byte2: operation, 0 == get, 1 == cancel (these aren't implemented yet but will be)",
@@ -473,6 +613,13 @@ AREXPORT ArServerFileToClient::ArServerFileToClient(ArServerBase *server,
 		    "ubyte2: return code, 0 = good (sending file), 1 = tried to go outside allowed area, 2 = no such file (or can't read), 3 = empty file name, 4 = error reading file (can happen after some good values) ; string: fileGotten; IF return was 0 then byte4: time_t that file was last modified; ubyte4: numBytes (number of bytes in the file buffer in this packet, 0 means end of file); data buffer that is numBytes in length", 
 		    "FileAccess", "RETURN_UNTIL_EMPTY|SLOW_PACKET");
 
+  myServer->addData("getFileChunk", 
+		    "Gets part of a file, for resumable transfers (use ArClientFileToClient instead of calling this directly since this interface may change)",
+		    &myGetFileChunkCB, 
+		    "string: file to get; ubyte4: offset to start at; ubyte4: maximum number of bytes to get (0 or more than 30000 means 30000)",
+		    "ubyte2: return code, 0 = good, 1 = tried to go outside allowed area, 2 = no such file (or can't read), 3 = empty file name, 4 = error reading file, 5 = offset past the end of the file; string: fileGotten; IF return was 0 then ubyte4: size of the whole file; byte4: time_t that file was last modified; ubyte4: offset of this chunk; ubyte4: numBytes; ubyte4: CRC-32 of the data; data buffer that is numBytes in length", 
+		    "FileAccess", "RETURN_SINGLE|SLOW_PACKET");
+
   // snag our base dir and make sure we have enough room for a /
   strncpy(myBaseDir, topDir, sizeof(myBaseDir) - 2);
   myBaseDir[sizeof(myBaseDir) - 2] = '\0';
@@ -504,35 +651,38 @@ AREXPORT void ArServerFileToClient::getFileWithTimestamp
 
 
 
-AREXPORT void ArServerFileToClient::doGetFile(ArServerClient *client,
-                                              ArNetPacket *packet,
-                                              bool isSetTimestamp)
-{
-  ArNetPacket sendPacket;
+/**
+   Checks a file name a client asked for and finds the file it means
+   (matching case) under our base directory.
 
-  char fileNameRaw[2048];
-  packet->bufToStr(fileNameRaw, sizeof(fileNameRaw));
+   @param fileNameRaw the file name from the client
 
-  // should check for operation here, but thats not implemented yet
+   @param fileName gets the file name with the case matched
 
+   @param fileNameLen the length of the fileName buffer
+
+   @param wholeName gets the whole name (with our base dir) to open
+
+   @return 0 if the file name is good, otherwise the return code to
+   send back (1 = tried to go outside allowed area, 2 = no such file,
+   3 = empty file name)
+**/
+AREXPORT int ArServerFileToClient::findFile(const char *fileNameRaw,
+					    char *fileName, 
+					    size_t fileNameLen,
+					    std::string *wholeName)
+{
   char fileNameCooked[2048];
   strcpy(fileNameCooked, fileNameRaw);
   ArUtil::fixSlashes(fileNameCooked, sizeof(fileNameCooked));
 
 
-  char fileName[2048];
   if (!ArUtil::matchCase(myBaseDir, fileNameCooked, 
-                         fileName, sizeof(fileName)))
+                         fileName, fileNameLen))
   {
     ArLog::log(ArLog::Normal, 
 	             "ArServerFileToClient: can't open file '%s'", fileNameRaw);
-    sendPacket.uByte2ToBuf(2);
-    sendPacket.strToBuf(fileNameRaw);
-    client->sendPacketTcp(&sendPacket);
-    // send an empty packet so that forwarding knows we're done
-    sendPacket.empty();
-    client->sendPacketTcp(&sendPacket);
-    return;
+    return 2;
   }
 
   size_t len = strlen(fileName);
@@ -557,13 +707,7 @@ AREXPORT void ArServerFileToClient::doGetFile(ArServerClient *client,
 	       "ArServerFileToClient: '%s' tried to access outside allowed area",
 	       fileStr);
     delete[] fileStr;
-    sendPacket.uByte2ToBuf(1);    
-    sendPacket.strToBuf(fileNameRaw);
-    client->sendPacketTcp(&sendPacket);
-    // send an empty packet so that forwarding knows we're done
-    sendPacket.empty();
-    client->sendPacketTcp(&sendPacket);
-    return;
+    return 1;
   }
 
   if (strlen(fileStr) > 0)
@@ -575,24 +719,173 @@ AREXPORT void ArServerFileToClient::doGetFile(ArServerClient *client,
     ArLog::log(ArLog::Normal, 
 	       "ArServerFileToClient: can't get file, empty filename");
     delete[] fileStr;
-    sendPacket.uByte2ToBuf(3);
-    sendPacket.strToBuf(fileNameRaw);
-    client->sendPacketTcp(&sendPacket);
-    // send an empty packet so that forwarding knows we're done
-    sendPacket.empty();
-    client->sendPacketTcp(&sendPacket);
-    return;
+    return 3;
   }
 
   // walk from our base down and try to find the first by name
   // ignoring case
   
   // put our base and where we want to go together
-  std::string wholeName;
-  wholeName = myBaseDir;
-  wholeName += fileStr;
+  *wholeName = myBaseDir;
+  *wholeName += fileStr;
 
   delete[] fileStr;
+  return 0;
+}
+
+/**
+   This maps the file into memory and makes the same packets
+   doGetFile would (data packets, then the zero size one, then the
+   empty one), but only one at a time as the client's socket drains,
+   each one is copied straight from the map into the packet buffer.
+   So a big file costs one packet's worth of memory and one copy,
+   instead of the whole file in the send list and three copies.
+**/
+class ArServerFileToClient::FileSource : public ArNetPacketSource
+{
+public:
+  FileSource(int fd, const char *fileName, const char *fileNameRaw,
+	     ArTypes::UByte2 command, bool isSetTimestamp, 
+	     time_t modified, const char *clientIP) :
+    myFd(fd), myMap(NULL), mySize(0), myOffset(0), 
+    myFileName(fileName), myFileNameRaw(fileNameRaw), myCommand(command),
+    myIsSetTimestamp(isSetTimestamp), myModified(modified),
+    myClientIP(clientIP), myState(STATE_DATA)
+    {
+      struct stat fileStat;
+      if (fstat(myFd, &fileStat) == 0)
+	mySize = fileStat.st_size;
+      if (mySize > 0 && 
+	  (myMap = (const char *)mmap(NULL, mySize, PROT_READ, MAP_PRIVATE, 
+				      myFd, 0)) == MAP_FAILED)
+      {
+	ArLog::log(ArLog::Normal, 
+		   "ArServerFileToClient: Could not map file %s", 
+		   myFileName.c_str());
+	myMap = NULL;
+	myState = STATE_ERROR;
+      }
+    }
+  virtual ~FileSource()
+    {
+      if (myMap != NULL)
+	munmap((void *)myMap, mySize);
+      close(myFd);
+    }
+  virtual bool getNextPacket(ArNetPacket *packet)
+    {
+      size_t chunk;
+      struct stat fileStat;
+
+      if (myState == STATE_DATA && myOffset >= mySize)
+	myState = STATE_END;
+
+      if (myState == STATE_DATA)
+      {
+	chunk = mySize - myOffset;
+	if (chunk > CHUNK_SIZE)
+	  chunk = CHUNK_SIZE;
+	// if the file got shorter under us then reading the map
+	// past its new end would fault, so stop with an error
+	if (fstat(myFd, &fileStat) != 0 || 
+	    (size_t)fileStat.st_size < myOffset + chunk)
+	{
+	  ArLog::log(ArLog::Normal, 
+		     "ArServerFileToClient: Error sending file %s (it shrank)", 
+		     myFileName.c_str());
+	  myState = STATE_ERROR;
+	}
+	else
+	{
+	  packet->uByte2ToBuf(0);
+	  packet->strToBuf(myFileNameRaw.c_str());
+	  packet->uByte4ToBuf(chunk);
+	  if (myIsSetTimestamp)
+	    packet->byte4ToBuf(myModified);
+	  packet->dataToBuf(&myMap[myOffset], chunk);
+	  packet->setCommand(myCommand);
+	  myOffset += chunk;
+	  return true;
+	}
+      }
+
+      if (myState == STATE_ERROR)
+      {
+	packet->uByte2ToBuf(4);
+	packet->strToBuf(myFileNameRaw.c_str());
+	myState = STATE_EMPTY;
+      }
+      else if (myState == STATE_END)
+      {
+	// Send a zero size to indicate that the file is done
+	packet->uByte2ToBuf(0);
+	packet->strToBuf(myFileNameRaw.c_str());
+	packet->uByte4ToBuf(0);
+	if (myIsSetTimestamp)
+	  packet->byte4ToBuf(myModified);
+	ArLog::log(ArLog::Normal, "ArServerFileToClient: Sent file %s to %s", 
+		   myFileName.c_str(), myClientIP.c_str());
+	myState = STATE_EMPTY;
+      }
+      else if (myState == STATE_EMPTY)
+      {
+	// send an empty packet so that forwarding knows we're done
+	myState = STATE_DONE;
+      }
+      else
+	return false;
+
+      packet->setCommand(myCommand);
+      return true;
+    }
+protected:
+  enum { CHUNK_SIZE = 30000 };
+  enum State
+  {
+    STATE_DATA, ///< sending the file's data
+    STATE_ERROR, ///< need to send the error
+    STATE_END, ///< need to send the zero size packet
+    STATE_EMPTY, ///< need to send the empty packet
+    STATE_DONE ///< sent everything
+  };
+  int myFd;
+  const char *myMap;
+  size_t mySize;
+  size_t myOffset;
+  std::string myFileName;
+  std::string myFileNameRaw;
+  ArTypes::UByte2 myCommand;
+  bool myIsSetTimestamp;
+  time_t myModified;
+  std::string myClientIP;
+  State myState;
+};
+
+AREXPORT void ArServerFileToClient::doGetFile(ArServerClient *client,
+                                              ArNetPacket *packet,
+                                              bool isSetTimestamp)
+{
+  ArNetPacket sendPacket;
+
+  char fileNameRaw[2048];
+  packet->bufToStr(fileNameRaw, sizeof(fileNameRaw));
+
+  // should check for operation here, but thats not implemented yet
+
+  char fileName[2048];
+  std::string wholeName;
+  int findRet;
+  if ((findRet = findFile(fileNameRaw, fileName, sizeof(fileName), 
+			  &wholeName)) != 0)
+  {
+    sendPacket.uByte2ToBuf(findRet);
+    sendPacket.strToBuf(fileNameRaw);
+    client->sendPacketTcp(&sendPacket);
+    // send an empty packet so that forwarding knows we're done
+    sendPacket.empty();
+    client->sendPacketTcp(&sendPacket);
+    return;
+  }
 
   ArLog::log(ArLog::Verbose, 
 	     "ArServerFileToClient: Trying to open %s from base %s", 
@@ -600,6 +893,28 @@ AREXPORT void ArServerFileToClient::doGetFile(ArServerClient *client,
   
   struct stat fileStat;
   stat(wholeName.c_str(), &fileStat);
+
+  if (myStreamFiles)
+  {
+    int fd;
+    if ((fd = ArUtil::open(wholeName.c_str(), O_RDONLY)) < 0)
+    {
+      ArLog::log(ArLog::Normal, 
+		 "ArServerFileToClient: can't open file '%s'", fileName);
+      sendPacket.uByte2ToBuf(2);
+      sendPacket.strToBuf(fileNameRaw);
+      client->sendPacketTcp(&sendPacket);
+      // send an empty packet so that forwarding knows we're done
+      sendPacket.empty();
+      client->sendPacketTcp(&sendPacket);
+      return;
+    }
+    client->sendPacketSourceTcp(
+	    new FileSource(fd, fileName, fileNameRaw, packet->getCommand(),
+			   isSetTimestamp, fileStat.st_mtime, 
+			   client->getIPString()));
+    return;
+  }
  
   FILE *file = NULL;
   if ((file = ArUtil::fopen(wholeName.c_str(), "rb")) == NULL)
@@ -637,60 +952,148 @@ AREXPORT void ArServerFileToClient::doGetFile(ArServerClient *client,
   } // end while more to read
 
 
-  if (ferror(file))
+  if (ferror(file))
+  {
+    ArLog::log(ArLog::Normal, "ArServerFileToClient: Error sending file %s", 
+	       fileName);
+    sendPacket.empty();
+    sendPacket.uByte2ToBuf(4);
+    sendPacket.strToBuf(fileNameRaw);
+    client->sendPacketTcp(&sendPacket);
+    // send an empty packet so that forwarding knows we're done
+    sendPacket.empty();
+    client->sendPacketTcp(&sendPacket);
+    return;
+  }
+ 
+  // Send the remnants from the last iteration of the while loop above
+  if (ret != 0) {
+
+    sendPacket.empty();
+    sendPacket.uByte2ToBuf(0);
+    sendPacket.strToBuf(fileNameRaw);
+    sendPacket.uByte4ToBuf(ret);
+    if (isSetTimestamp) {
+      sendPacket.byte4ToBuf(fileStat.st_mtime);
+    }
+    sendPacket.dataToBuf(buf, ret);
+    //printf("Sent packet with %d\n", ret);
+    client->sendPacketTcp(&sendPacket);
+  }
+
+  // Send a zero size to indicate that the file is ndone
+  sendPacket.empty();
+  sendPacket.uByte2ToBuf(0);
+  sendPacket.strToBuf(fileNameRaw);
+  sendPacket.uByte4ToBuf(0);
+  if (isSetTimestamp) {
+    sendPacket.byte4ToBuf(fileStat.st_mtime);
+  }
+
+
+  //printf("Sent packet end\n");
+  client->sendPacketTcp(&sendPacket);
+  
+  
+  // send an empty packet so that forwarding knows we're done
+  sendPacket.empty();
+  client->sendPacketTcp(&sendPacket);
+
+  if (feof(file))
+  {
+    ArLog::log(ArLog::Normal, "ArServerFileToClient: Sent file %s to %s", 
+	             fileName, client->getIPString());
+  }
+  fclose(file);
+
+}
+
+/**
+   This is for resumable transfers, the client asks for a piece of
+   the file at an offset (so it can have several requests out at once
+   and pick up where it left off after losing the connection) and
+   each piece comes back with a CRC so the client can check it.
+**/
+AREXPORT void ArServerFileToClient::getFileChunk(ArServerClient *client,
+						 ArNetPacket *packet)
+{
+  ArNetPacket sendPacket;
+  char fileNameRaw[2048];
+  char fileName[2048];
+  std::string wholeName;
+  ArTypes::UByte4 offset;
+  ArTypes::UByte4 maxBytes;
+  struct stat fileStat;
+  char buf[30000];
+  ssize_t numRead;
+  int ret;
+  int fd;
+
+  packet->bufToStr(fileNameRaw, sizeof(fileNameRaw));
+  offset = packet->bufToUByte4();
+  maxBytes = packet->bufToUByte4();
+  if (maxBytes == 0 || maxBytes > sizeof(buf))
+    maxBytes = sizeof(buf);
+
+  if ((ret = findFile(fileNameRaw, fileName, sizeof(fileName), 
+		      &wholeName)) != 0)
+  {
+    sendPacket.uByte2ToBuf(ret);
+    sendPacket.strToBuf(fileNameRaw);
+    client->sendPacketTcp(&sendPacket);
+    return;
+  }
+
+  if ((fd = ArUtil::open(wholeName.c_str(), O_RDONLY)) < 0 ||
+      fstat(fd, &fileStat) != 0)
+  {
+    ArLog::log(ArLog::Normal, 
+	       "ArServerFileToClient: can't open file '%s'", fileName);
+    if (fd >= 0)
+      close(fd);
+    sendPacket.uByte2ToBuf(2);
+    sendPacket.strToBuf(fileNameRaw);
+    client->sendPacketTcp(&sendPacket);
+    return;
+  }
+
+  if (offset > (ArTypes::UByte4)fileStat.st_size)
+  {
+    ArLog::log(ArLog::Normal, 
+	       "ArServerFileToClient: chunk of '%s' at %u is past its end (%ld)",
+	       fileName, offset, (long)fileStat.st_size);
+    close(fd);
+    sendPacket.uByte2ToBuf(5);
+    sendPacket.strToBuf(fileNameRaw);
+    client->sendPacketTcp(&sendPacket);
+    return;
+  }
+
+  if (maxBytes > fileStat.st_size - offset)
+    maxBytes = fileStat.st_size - offset;
+  numRead = pread(fd, buf, maxBytes, offset);
+  close(fd);
+
+  if (numRead < 0)
   {
-    ArLog::log(ArLog::Normal, "ArServerFileToClient: Error sending file %s", 
+    ArLog::log(ArLog::Normal, 
+	       "ArServerFileToClient: Error reading chunk of file %s", 
 	       fileName);
-    sendPacket.empty();
     sendPacket.uByte2ToBuf(4);
     sendPacket.strToBuf(fileNameRaw);
     client->sendPacketTcp(&sendPacket);
-    // send an empty packet so that forwarding knows we're done
-    sendPacket.empty();
-    client->sendPacketTcp(&sendPacket);
     return;
   }
- 
-  // Send the remnants from the last iteration of the while loop above
-  if (ret != 0) {
-
-    sendPacket.empty();
-    sendPacket.uByte2ToBuf(0);
-    sendPacket.strToBuf(fileNameRaw);
-    sendPacket.uByte4ToBuf(ret);
-    if (isSetTimestamp) {
-      sendPacket.byte4ToBuf(fileStat.st_mtime);
-    }
-    sendPacket.dataToBuf(buf, ret);
-    //printf("Sent packet with %d\n", ret);
-    client->sendPacketTcp(&sendPacket);
-  }
 
-  // Send a zero size to indicate that the file is ndone
-  sendPacket.empty();
   sendPacket.uByte2ToBuf(0);
   sendPacket.strToBuf(fileNameRaw);
-  sendPacket.uByte4ToBuf(0);
-  if (isSetTimestamp) {
-    sendPacket.byte4ToBuf(fileStat.st_mtime);
-  }
-
-
-  //printf("Sent packet end\n");
-  client->sendPacketTcp(&sendPacket);
-  
-  
-  // send an empty packet so that forwarding knows we're done
-  sendPacket.empty();
+  sendPacket.uByte4ToBuf(fileStat.st_size);
+  sendPacket.byte4ToBuf(fileStat.st_mtime);
+  sendPacket.uByte4ToBuf(offset);
+  sendPacket.uByte4ToBuf(numRead);
+  sendPacket.uByte4ToBuf(ArUtil::crc32(buf, numRead));
+  sendPacket.dataToBuf(buf, numRead);
   client->sendPacketTcp(&sendPacket);
-
-  if (feof(file))
-  {
-    ArLog::log(ArLog::Normal, "ArServerFileToClient: Sent file %s to %s", 
-	             fileName, client->getIPString());
-  }
-  fclose(file);
-
 }
 
 // -----------------------------------------------------------------------------
@@ -703,7 +1106,8 @@ AREXPORT ArServerFileFromClient::ArServerFileFromClient(ArServerBase *server,
   myPutFileCB(this, &ArServerFileFromClient::putFile),
   myPutFileInterleavedCB(this, &ArServerFileFromClient::putFileInterleaved),
   myPutFileWithTimestampCB(this, &ArServerFileFromClient::putFileWithTimestamp),
-  myPutFileWithTimestampInterleavedCB(this, &ArServerFileFromClient::putFileWithTimestampInterleaved)
+  myPutFileWithTimestampInterleavedCB(this, &ArServerFileFromClient::putFileWithTimestampInterleaved),
+  myPutFileChunkCB(this, &ArServerFileFromClient::putFileChunk)
 {
 
   myServer = server;
@@ -734,6 +1138,14 @@ AREXPORT ArServerFileFromClient::ArServerFileFromClient(ArServerBase *server,
 		    "uByte2: return code, 0 = good (got file), 1 = getting file, 2 = tried to go outside allowed area, 3 = bad directory, 4 = empty file name (or other problem with fileName), 5 = can't write temp file, 6 = error moving file from temp to perm, 7 = another client putting file, 8 = timeout (no activity for 15 seconds) and another client wanted to put the file, 9 = client adding to, finishing, or canceling a file the server doesn't have, 10 = gotPacket, awaiting next packet, 11 = cancelled put; string: fileName",
 		    "FileAccess", "RETURN_SINGLE|SLOW_PACKET|DO_NOT_FORWARD");
 
+  myServer->addData("putFileChunk", 
+		    "Puts a file in chunks that can be resumed (use ArClientFileFromClient instead of calling this directly since this interface may change)",
+		    &myPutFileChunkCB, 
+		    "uByte2: command, 0 = start (or resume) file, 1 = chunk of file, 2 = done with file, 3 = cancel put; string: file being sent; IF command == 0 then uByte4: size of the whole file; byte4: time_t last modified (-1 to not set it); IF command == 1 then uByte4: offset of this chunk; uByte4: CRC-32 of the data; uByte4: numBytes; numBytes of data",
+		    "uByte2: return code, 0 = good (got file), 1 = ready for chunks, 2 = tried to go outside allowed area, 3 = bad directory, 4 = empty file name (or other problem with fileName), 5 = can't write temp file, 6 = error moving file from temp to perm, 7 = another client putting file, 9 = client adding to, finishing, or canceling a file the server doesn't have, 10 = got chunk, 11 = cancelled put, 12 = bad checksum on chunk, 13 = done but file isn't complete, 14 = chunk is after a gap; string: fileName; uByte4: offset (for 1 and 14 the offset to send from next, for 10 and 12 the offset of the chunk, for 13 how much the server has); uByte4: numBytes of the chunk (for 10 and 12)",
+		    "FileAccess", "RETURN_SINGLE|SLOW_PACKET|DO_NOT_FORWARD");
+
+  myChunkedPutTimeout = 3600;
   myFileNumber = 0;
   // snag our base dir and make sure we have enough room for a /
   strncpy(myBaseDir, topDir, sizeof(myBaseDir) - 2);
@@ -753,7 +1165,17 @@ AREXPORT ArServerFileFromClient::ArServerFileFromClient(ArServerBase *server,
 
 AREXPORT ArServerFileFromClient::~ArServerFileFromClient()
 {
+  std::map<std::string, ChunkedInfo *>::iterator it;
 
+  // nothing can resume these once we're gone, so clean them up
+  for (it = myChunkedMap.begin(); it != myChunkedMap.end(); it++)
+  {
+    if ((*it).second->myFile != NULL)
+      fclose((*it).second->myFile);
+    unlink((*it).second->myTempFileName.c_str());
+    delete (*it).second;
+  }
+  myChunkedMap.clear();
 }
 
 
@@ -784,6 +1206,83 @@ AREXPORT void ArServerFileFromClient::putFileWithTimestampInterleaved
   internalPutFile(client, packet, true, true);
 }
 
+/**
+   Works out where a file a client wants to put should go (matching
+   the case of the directory and file if they already exist).
+
+   @param fileNameRaw the file name from the client
+   @param fileName gets the real file name to put the file in
+   @param errorCode gets the return code to send back if this fails
+   (3 = bad directory, 4 = problem with the file name)
+   @return true if the file name is good, false otherwise
+**/
+AREXPORT bool ArServerFileFromClient::findPutFileName(const char *fileNameRaw,
+						      std::string *fileName,
+						      int *errorCode)
+{
+  char directoryRaw[2048];
+  directoryRaw[0] = '\0';
+  char fileNamePart[2048];
+  fileNamePart[0] = '\0';
+  if (!ArUtil::getDirectory(fileNameRaw, 
+					                    directoryRaw, 
+                            sizeof(directoryRaw)) ||
+	      !ArUtil::getFileName(fileNameRaw, 
+				                     fileNamePart, 
+                           sizeof(fileNamePart)))
+  {
+    ArLog::log(ArLog::Normal, 
+               "ArServerFileFromClient: Problem with filename '%s'", 
+               fileNameRaw);
+    *errorCode = 4;
+    return false;
+  }
+ 
+//    ArUtil::appendSlash(directoryRaw, sizeof(directoryRaw));
+
+  char directory[2048];
+  printf("DirectoryRaw %s\n", directoryRaw);
+  if (strlen(directoryRaw) == 0)
+  {
+    //strcpy(directory, ".");
+    strcpy(directory, myBaseDir);
+  }
+  else if (!ArUtil::matchCase(myBaseDir, 
+                              directoryRaw, 
+                              directory, 
+                              sizeof(directory)))
+  {
+    ArLog::log(ArLog::Normal, 
+		             "ArServerFileFromClient: Bad directory for '%s'", 
+		             fileNameRaw);
+    *errorCode = 3;
+    return false;
+  }
+
+  char tmpDir[2048];
+  tmpDir[0] = '\0';
+  //sprintf(tmpDir, "%s", tmpDir, directory);
+  strcpy(tmpDir, directory);
+  ArUtil::appendSlash(tmpDir, sizeof(tmpDir));
+  char matchedFileName[2048];
+  
+  if (ArUtil::matchCase(tmpDir, fileNamePart, 
+				     matchedFileName, 
+				     sizeof(matchedFileName)))
+  {
+    *fileName = tmpDir;
+    *fileName += matchedFileName;
+    //printf("matched from %s %s\n", tmpDir, matchedFileName);
+  }
+  else
+  {
+    *fileName = tmpDir;
+    *fileName += fileNamePart;
+    //printf("unmatched from %s %s\n", tmpDir, fileNamePart);
+  }
+  return true;
+}
+
 AREXPORT void ArServerFileFromClient::internalPutFile(ArServerClient *client, 
                                                       ArNetPacket *packet,
                                                       bool interleaved,
@@ -804,71 +1303,14 @@ AREXPORT void ArServerFileFromClient::internalPutFile(ArServerClient *client,
   packet->bufToStr(fileNameRaw, sizeof(fileNameRaw));
   if (doing == 0)
   {
-    char directoryRaw[2048];
-    directoryRaw[0] = '\0';
-    char fileNamePart[2048];
-    fileNamePart[0] = '\0';
-    if (!ArUtil::getDirectory(fileNameRaw, 
-					                    directoryRaw, 
-                              sizeof(directoryRaw)) ||
-	      !ArUtil::getFileName(fileNameRaw, 
-				                     fileNamePart, 
-                             sizeof(fileNamePart)))
-    {
-      ArLog::log(ArLog::Normal, 
-                 "ArServerFileFromClient: Problem with filename '%s'", 
-                 fileNameRaw);
-      sendPacket.uByte2ToBuf(4);
-      sendPacket.strToBuf(fileNameRaw);
-      client->sendPacketTcp(&sendPacket);
-      // just added this 4/5/06
-      return;
-    }
-   
-//    ArUtil::appendSlash(directoryRaw, sizeof(directoryRaw));
-
-    char directory[2048];
-    printf("DirectoryRaw %s\n", directoryRaw);
-    if (strlen(directoryRaw) == 0)
-    {
-      //strcpy(directory, ".");
-      strcpy(directory, myBaseDir);
-    }
-    else if (!ArUtil::matchCase(myBaseDir, 
-                                directoryRaw, 
-                                directory, 
-                                sizeof(directory)))
+    int errorCode;
+    if (!findPutFileName(fileNameRaw, &fileName, &errorCode))
     {
-      ArLog::log(ArLog::Normal, 
-		             "ArServerFileFromClient: Bad directory for '%s'", 
-		             fileNameRaw);
-      sendPacket.uByte2ToBuf(3);
+      sendPacket.uByte2ToBuf(errorCode);
       sendPacket.strToBuf(fileNameRaw);
       client->sendPacketTcp(&sendPacket);
       return;
     }
-
-    char tmpDir[2048];
-    tmpDir[0] = '\0';
-    //sprintf(tmpDir, "%s", tmpDir, directory);
-    strcpy(tmpDir, directory);
-    ArUtil::appendSlash(tmpDir, sizeof(tmpDir));
-    char matchedFileName[2048];
-    
-    if (ArUtil::matchCase(tmpDir, fileNamePart, 
-				     matchedFileName, 
-				     sizeof(matchedFileName)))
-    {
-      fileName = tmpDir;
-      fileName += matchedFileName;
-      //printf("matched from %s %s\n", tmpDir, matchedFileName);
-    }
-    else
-    {
-      fileName = tmpDir;
-      fileName += fileNamePart;
-      //printf("unmatched from %s %s\n", tmpDir, fileNamePart);
-    }
     
     ArLog::log(ArLog::Normal, 
                "ArServerFileFromClient: Checking file %s (as %s)",
@@ -1154,6 +1596,346 @@ AREXPORT void ArServerFileFromClient::internalPutFile(ArServerClient *client,
   }
 }
 
+/**
+   Moves a finished file from the temp dir to where it belongs,
+   calling the pre and post move callbacks around it.
+
+   @param tempFileName the file in the temp dir
+   @param realFileName where the file goes
+   @param fileTimestamp the modified time to give the file, -1 to leave it
+
+   @return true if the file was moved, false otherwise
+**/
+AREXPORT bool ArServerFileFromClient::moveFromTemp(const char *tempFileName,
+						   const char *realFileName,
+						   time_t fileTimestamp)
+{
+  std::list<ArFunctor *>::iterator fit;
+  char systemBuf[6400];
+  int ret;
+
+  sprintf(systemBuf, "mv -f \"%s\" \"%s\"", tempFileName, realFileName);
+
+  myMovingFileName = realFileName;
+
+  // call our pre move callbacks
+  for (fit = myPreMoveCallbacks.begin(); 
+       fit != myPreMoveCallbacks.end(); 
+       fit++)
+    (*fit)->invoke();
+
+  if ((ret = system(systemBuf)) == 0)
+  {
+    if (fileTimestamp != -1)
+      ArUtil::changeFileTimestamp(realFileName, fileTimestamp);
+  }
+  else
+  {
+    unlink(tempFileName);
+    ArLog::log(ArLog::Normal, "Couldn't move temp file for %s (ret of '%s' is %d)", realFileName, systemBuf, ret);
+  }
+
+  // call our post move callbacks
+  for (fit = myPostMoveCallbacks.begin(); 
+       fit != myPostMoveCallbacks.end(); 
+       fit++)
+    (*fit)->invoke();
+
+  myMovingFileName = "";
+  return ret == 0;
+}
+
+/**
+   This puts a file in chunks, each with its offset and CRC, so the
+   client can have several chunks out at once and, if the connection
+   drops, can start again (from any connection) where the server left
+   off instead of from the beginning.  The server only takes chunks in
+   order, anything after a gap is refused and the client backs up to
+   the first chunk that wasn't taken.
+
+   Unfinished puts are kept for setChunkedPutTimeout seconds (an hour
+   by default) after their last activity.
+**/
+AREXPORT void ArServerFileFromClient::putFileChunk(ArServerClient *client,
+						   ArNetPacket *packet)
+{
+  ArNetPacket sendPacket;
+  std::map<std::string, ChunkedInfo *>::iterator it;
+  ChunkedInfo *info = NULL;
+  std::string fileName;
+  char fileNameRaw[2048];
+  fileNameRaw[0] = '\0';
+
+  ArTypes::UByte2 doing = packet->bufToUByte2();
+  packet->bufToStr(fileNameRaw, sizeof(fileNameRaw));
+
+  if (doing == 0)
+  {
+    ArTypes::UByte4 totalSize = packet->bufToUByte4();
+    time_t fileTimestamp = packet->bufToByte4();
+    int errorCode;
+
+    if (!findPutFileName(fileNameRaw, &fileName, &errorCode))
+    {
+      sendPacket.uByte2ToBuf(errorCode);
+      sendPacket.strToBuf(fileNameRaw);
+      client->sendPacketTcp(&sendPacket);
+      return;
+    }
+
+    // get rid of puts nobody came back to finish
+    it = myChunkedMap.begin();
+    while (it != myChunkedMap.end())
+    {
+      info = (*it).second;
+      if ((*it).first != fileNameRaw && 
+	  info->myLastActivity.secSince() > myChunkedPutTimeout)
+      {
+	ArLog::log(ArLog::Normal, 
+		   "ArServerFileFromClient: Dropping abandoned put of '%s'",
+		   (*it).first.c_str());
+	fclose(info->myFile);
+	unlink(info->myTempFileName.c_str());
+	delete info;
+	myChunkedMap.erase(it++);
+      }
+      else
+	it++;
+    }
+    info = NULL;
+
+    if ((it = myChunkedMap.find(fileNameRaw)) != myChunkedMap.end())
+    {
+      info = (*it).second;
+      if ((info->myClient != client || 
+	   !info->myClientCreationTime.isAt(client->getCreationTime())) &&
+	  info->myLastActivity.secSince() <= 15)
+      {
+	ArLog::log(ArLog::Normal, 
+		   "ArServerFileFromClient: Another client putting file '%s'", 
+		   fileNameRaw);
+	sendPacket.uByte2ToBuf(7);
+	sendPacket.strToBuf(fileNameRaw);
+	sendPacket.uByte4ToBuf(0);
+	sendPacket.uByte4ToBuf(0);
+	client->sendPacketTcp(&sendPacket);
+	return;
+      }
+      // if it's the same file as before we can pick up where we left off
+      if (ArUtil::strcasecmp(info->myRealFileName, fileName) == 0 &&
+	  info->myTotalSize == totalSize && 
+	  info->myFileTimestamp == fileTimestamp)
+      {
+	ArLog::log(ArLog::Normal, 
+		   "ArServerFileFromClient: Resuming file %s at %u of %u bytes from %s", 
+		   fileNameRaw, info->myReceived, info->myTotalSize,
+		   client->getIPString());
+	info->myClient = client;
+	info->myClientCreationTime = client->getCreationTime();
+	info->myLastActivity.setToNow();
+	sendPacket.uByte2ToBuf(1);
+	sendPacket.strToBuf(fileNameRaw);
+	sendPacket.uByte4ToBuf(info->myReceived);
+	sendPacket.uByte4ToBuf(0);
+	client->sendPacketTcp(&sendPacket);
+	return;
+      }
+      // otherwise it's a different file, so start over
+      ArLog::log(ArLog::Normal, 
+		 "ArServerFileFromClient: File %s changed, restarting put",
+		 fileNameRaw);
+      fclose(info->myFile);
+      unlink(info->myTempFileName.c_str());
+      delete info;
+      myChunkedMap.erase(it);
+      info = NULL;
+    }
+
+    char tempFileName[3200];
+    tempFileName[0] = '\0';
+    sprintf(tempFileName, "%sArServerFileFromClient.%d.%d", myTempDir, getpid(), myFileNumber);
+    myFileNumber++;
+
+    FILE *file;
+    if ((file = ArUtil::fopen(tempFileName, "wb")) == NULL)
+    {
+      ArLog::log(ArLog::Normal, 
+                 "ArServerFileFromClient: Can't open tmp file for '%s' (tried '%s')", 
+                 fileNameRaw, tempFileName);
+      sendPacket.uByte2ToBuf(5);
+      sendPacket.strToBuf(fileNameRaw);
+      sendPacket.uByte4ToBuf(0);
+      sendPacket.uByte4ToBuf(0);
+      client->sendPacketTcp(&sendPacket);
+      return;
+    }
+
+    ArLog::log(ArLog::Normal, 
+	       "ArServerFileFromClient: Receiving chunked file %s (as %s) of %u bytes", 
+	       fileNameRaw, fileName.c_str(), totalSize);
+    info = new ChunkedInfo;
+    info->myRealFileName = fileName;
+    info->myTempFileName = tempFileName;
+    info->myFile = file;
+    info->myTotalSize = totalSize;
+    info->myReceived = 0;
+    info->myFileTimestamp = fileTimestamp;
+    info->myLastActivity.setToNow();
+    info->myClient = client;
+    info->myClientCreationTime = client->getCreationTime();
+    myChunkedMap[fileNameRaw] = info;
+
+    sendPacket.uByte2ToBuf(1);
+    sendPacket.strToBuf(fileNameRaw);
+    sendPacket.uByte4ToBuf(0);
+    sendPacket.uByte4ToBuf(0);
+    client->sendPacketTcp(&sendPacket);
+    return;
+  }
+
+  // everything else needs a put that's going on
+  if ((it = myChunkedMap.find(fileNameRaw)) == myChunkedMap.end())
+  {
+    ArLog::log(ArLog::Normal, 
+	       "ArServerFileFromClient: Couldn't find chunked entry for '%s'", 
+	       fileNameRaw);
+    sendPacket.uByte2ToBuf(9);
+    sendPacket.strToBuf(fileNameRaw);
+    sendPacket.uByte4ToBuf(0);
+    sendPacket.uByte4ToBuf(0);
+    client->sendPacketTcp(&sendPacket);
+    return;
+  }
+  info = (*it).second;
+
+  // make sure this client is the one sending the file, otherwise
+  // just ignore it
+  if (info->myClient != client || 
+      !info->myClientCreationTime.isAt(client->getCreationTime()))
+  {
+    ArLog::log(ArLog::Normal, 
+	       "ArServerFileFromClient: Got chunk packet for file '%s' from the wrong client, ignoring it", 
+	       fileNameRaw);
+    return;
+  }
+  info->myLastActivity.setToNow();
+
+  if (doing == 1)
+  {
+    ArTypes::UByte4 offset = packet->bufToUByte4();
+    ArTypes::UByte4 crc = packet->bufToUByte4();
+    ArTypes::UByte4 numBytes = packet->bufToUByte4();
+    char buf[32000];
+
+    if (numBytes > sizeof(buf) || 
+	numBytes > (ArTypes::UByte4)(packet->getDataLength() - 
+				    packet->getDataReadLength()))
+      numBytes = 0;
+    packet->bufToData(buf, numBytes);
+
+    if (ArUtil::crc32(buf, numBytes) != crc)
+    {
+      ArLog::log(ArLog::Normal, 
+		 "ArServerFileFromClient: Bad checksum on chunk at %u of '%s'", 
+		 offset, fileNameRaw);
+      sendPacket.uByte2ToBuf(12);
+      sendPacket.strToBuf(fileNameRaw);
+      sendPacket.uByte4ToBuf(offset);
+      sendPacket.uByte4ToBuf(numBytes);
+    }
+    // we only take the chunk right after what we have
+    else if (offset == info->myReceived)
+    {
+      if (numBytes > info->myTotalSize - info->myReceived ||
+	  fwrite(buf, 1, numBytes, info->myFile) != numBytes)
+      {
+	ArLog::log(ArLog::Normal, 
+		   "ArServerFileFromClient: Couldn't write chunk at %u of '%s'",
+		   offset, fileNameRaw);
+	sendPacket.uByte2ToBuf(5);
+	sendPacket.strToBuf(fileNameRaw);
+	sendPacket.uByte4ToBuf(offset);
+	sendPacket.uByte4ToBuf(numBytes);
+	fclose(info->myFile);
+	unlink(info->myTempFileName.c_str());
+	delete info;
+	myChunkedMap.erase(it);
+      }
+      else
+      {
+	info->myReceived += numBytes;
+	sendPacket.uByte2ToBuf(10);
+	sendPacket.strToBuf(fileNameRaw);
+	sendPacket.uByte4ToBuf(offset);
+	sendPacket.uByte4ToBuf(numBytes);
+      }
+    }
+    // we already have this one
+    else if (offset < info->myReceived)
+    {
+      sendPacket.uByte2ToBuf(10);
+      sendPacket.strToBuf(fileNameRaw);
+      sendPacket.uByte4ToBuf(offset);
+      sendPacket.uByte4ToBuf(numBytes);
+    }
+    // there's a gap before this one, so tell the client where we are
+    else
+    {
+      sendPacket.uByte2ToBuf(14);
+      sendPacket.strToBuf(fileNameRaw);
+      sendPacket.uByte4ToBuf(info->myReceived);
+      sendPacket.uByte4ToBuf(0);
+    }
+    client->sendPacketTcp(&sendPacket);
+  }
+  else if (doing == 2)
+  {
+    if (info->myReceived != info->myTotalSize)
+    {
+      ArLog::log(ArLog::Normal, 
+		 "ArServerFileFromClient: Told chunked file '%s' is done but only have %u of %u bytes", 
+		 fileNameRaw, info->myReceived, info->myTotalSize);
+      sendPacket.uByte2ToBuf(13);
+      sendPacket.strToBuf(fileNameRaw);
+      sendPacket.uByte4ToBuf(info->myReceived);
+      sendPacket.uByte4ToBuf(0);
+      client->sendPacketTcp(&sendPacket);
+      return;
+    }
+
+    fclose(info->myFile);
+    info->myFile = NULL;
+    if (moveFromTemp(info->myTempFileName.c_str(), 
+		     info->myRealFileName.c_str(), info->myFileTimestamp))
+    {
+      ArLog::log(ArLog::Normal, "Done with chunked file %s from %s", 
+		 fileNameRaw, client->getIPString());
+      sendPacket.uByte2ToBuf(0);
+    }
+    else
+      sendPacket.uByte2ToBuf(6);
+    sendPacket.strToBuf(fileNameRaw);
+    sendPacket.uByte4ToBuf(info->myReceived);
+    sendPacket.uByte4ToBuf(0);
+    delete info;
+    myChunkedMap.erase(it);
+    client->sendPacketTcp(&sendPacket);
+  }
+  else if (doing == 3)
+  {
+    ArLog::log(ArLog::Normal, "Cancelling chunked file %s", fileNameRaw);
+    fclose(info->myFile);
+    unlink(info->myTempFileName.c_str());
+    delete info;
+    myChunkedMap.erase(it);
+    sendPacket.uByte2ToBuf(11);
+    sendPacket.strToBuf(fileNameRaw);
+    sendPacket.uByte4ToBuf(0);
+    sendPacket.uByte4ToBuf(0);
+    client->sendPacketTcp(&sendPacket);
+  }
+}
+
 AREXPORT void ArServerFileFromClient::addPreMoveCallback(
 	ArFunctor *functor, ArListPos::Pos position)
 {
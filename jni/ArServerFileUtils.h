@@ -28,6 +28,8 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "Aria.h"
 #include "ArServerBase.h"
 
+#include <vector>
+
 
 /// Provides a list of files to clients
 /**
@@ -55,17 +57,72 @@ public:
   /// The function that gets the directory listing in a better way
   AREXPORT void getDirListingMultiplePackets(ArServerClient *client,
 				      ArNetPacket *packet);
+  /// The function that gets a filtered page of the directory listing
+  AREXPORT void getDirListingFiltered(ArServerClient *client,
+				      ArNetPacket *packet);
   /// The function that gets the default upload/download dir
   AREXPORT void getDefaultUploadDownloadDir(
 	  ArServerClient *client, ArNetPacket *packet);
+  /// Sets how long a cached listing is trusted when it can't be watched
+  void setCachePollInterval(int mSecs) { myCachePollInterval = mSecs; }
+  /// Sets how many directory listings are cached (0 to not cache)
+  void setMaxCachedDirs(size_t maxCachedDirs) 
+    { myMaxCachedDirs = maxCachedDirs; }
 protected:
+  /// One entry in a cached directory listing
+  class DirEntry
+  {
+  public:
+    std::string myName;
+    // 1 for dir, 2 for file (same as the packets)
+    int myType;
+    ArTypes::UByte4 myATime;
+    ArTypes::UByte4 myMTime;
+    ArTypes::UByte4 mySize;
+  };
+  /// The cached listing of one directory
+  class DirCache
+  {
+  public:
+    std::string myWholeDir;
+    // directories then files, each sorted without case
+    std::vector<DirEntry> myEntries;
+    size_t myNumDirs;
+    bool myValid;
+    // the inotify watch, -1 if it isn't watched
+    int myWatch;
+    time_t myDirMTime;
+    ArTime myLastScan;
+    ArTime myLastUsed;
+  };
+  AREXPORT int findDir(const char *directory, std::string *wholeDir);
+  AREXPORT DirCache *getDirCache(const std::string &wholeDir, 
+				 DirCache *uncached);
+  AREXPORT bool scanDir(DirCache *cache);
+  AREXPORT void readWatches(void);
+  AREXPORT void removeDirCache(DirCache *cache);
+  AREXPORT void sendListing(ArServerClient *client, const char *directory,
+			    bool filtered, ArTypes::UByte4 start, 
+			    ArTypes::UByte4 maxEntries, int type, 
+			    const char *pattern);
+
   char myBaseDir[2048];
   std::string myDefaultUploadDownloadDir;
   ArServerBase *myServer;
+
+  ArMutex myCacheMutex;
+  std::map<std::string, DirCache *> myDirCaches;
+  std::map<int, DirCache *> myWatchToDirCache;
+  int myInotifyFD;
+  int myCachePollInterval;
+  size_t myMaxCachedDirs;
+
   ArFunctor2C<ArServerFileLister, ArServerClient *, 
       ArNetPacket *> myGetDirListingCB;
   ArFunctor2C<ArServerFileLister, ArServerClient *, 
       ArNetPacket *> myGetDirListingMultiplePacketsCB;
+  ArFunctor2C<ArServerFileLister, ArServerClient *, 
+      ArNetPacket *> myGetDirListingFilteredCB;
   ArFunctor2C<ArServerFileLister, ArServerClient *, 
       ArNetPacket *> myGetDefaultUploadDownloadDirCB;
 };
@@ -100,6 +157,15 @@ public:
   AREXPORT void getFileWithTimestamp(ArServerClient *client,
                                      ArNetPacket *packet);
 
+  /// Gets a chunk of the file (for resumable transfers)
+  AREXPORT void getFileChunk(ArServerClient *client,
+                             ArNetPacket *packet);
+
+  /// Sets whether files are streamed out as the socket drains (default true)
+  void setStreamFiles(bool streamFiles) { myStreamFiles = streamFiles; }
+  /// Gets whether files are streamed out as the socket drains
+  bool getStreamFiles(void) { return myStreamFiles; }
+
 
 protected:
 
@@ -107,9 +173,16 @@ protected:
                           ArNetPacket *packet,
                           bool isSetTimestamp);
 
+  AREXPORT int findFile(const char *fileNameRaw, char *fileName, 
+			size_t fileNameLen, std::string *wholeName);
+
 protected:
   
+  /// Sends a file out of a memory map as the client's socket drains
+  class FileSource;
+
   char myBaseDir[2048];
+  bool myStreamFiles;
   ArServerBase *myServer;
   ArFunctor2C<ArServerFileToClient, 
               ArServerClient *, 
@@ -118,6 +191,10 @@ protected:
   ArFunctor2C<ArServerFileToClient, 
               ArServerClient *, 
               ArNetPacket *> myGetFileWithTimestampCB;
+
+  ArFunctor2C<ArServerFileToClient, 
+              ArServerClient *, 
+              ArNetPacket *> myGetFileChunkCB;
 };
 
 // ----------------------------------------------------------------------------
@@ -157,6 +234,11 @@ public:
   /// Puts the file with interleaved responses
   AREXPORT void putFileWithTimestampInterleaved(ArServerClient *client, 
                                                 ArNetPacket *packet);
+  /// Puts the file in chunks that can be resumed
+  AREXPORT void putFileChunk(ArServerClient *client, 
+                             ArNetPacket *packet);
+  /// Sets how long an unfinished chunked put is kept for resuming
+  void setChunkedPutTimeout(int seconds) { myChunkedPutTimeout = seconds; }
 
   /// Adds a callback to be called before moving from temp dir to final loc
   AREXPORT void addPreMoveCallback(
@@ -177,6 +259,11 @@ protected:
 				                        bool interleaved,
                                 bool isSetTimestamp);
 
+  AREXPORT bool findPutFileName(const char *fileNameRaw, 
+				std::string *fileName, int *errorCode);
+  AREXPORT bool moveFromTemp(const char *tempFileName, 
+			     const char *realFileName, time_t fileTimestamp);
+
   char myBaseDir[2048];
   char myTempDir[2048];
   ArServerBase *myServer;
@@ -191,6 +278,8 @@ protected:
       ArNetPacket *> myPutFileWithTimestampCB;
   ArFunctor2C<ArServerFileFromClient, ArServerClient *, 
       ArNetPacket *> myPutFileWithTimestampInterleavedCB;
+  ArFunctor2C<ArServerFileFromClient, ArServerClient *, 
+      ArNetPacket *> myPutFileChunkCB;
 
   std::string myMovingFileName;
 
@@ -217,6 +306,29 @@ protected:
 
   // map of raw filenames to FileInfo (so we don't have to walk it all the time)
   std::map<std::string, FileInfo *> myMap;
+
+  class ChunkedInfo
+  {
+  public:
+    ChunkedInfo() { myFile = NULL; myTotalSize = 0; myReceived = 0; }
+    virtual ~ChunkedInfo() {}
+    std::string myRealFileName;
+    std::string myTempFileName;
+    FILE *myFile;
+    ArTypes::UByte4 myTotalSize;
+    // how many bytes (from the start) we have
+    ArTypes::UByte4 myReceived;
+    time_t myFileTimestamp;
+    ArTime myLastActivity;
+    // same caveat as for FileInfo, only compare against this
+    ArServerClient *myClient;
+    ArTime myClientCreationTime;
+  };
+
+  // map of raw filenames to the chunked puts, these outlive the
+  // client that started them so that another connection can resume
+  std::map<std::string, ChunkedInfo *> myChunkedMap;
+  int myChunkedPutTimeout;
 };
 
 
@@ -90,7 +90,7 @@ AREXPORT bool ArServerHandlerCommands::addCommand(
   else
     group = "CustomCommands";
   if (myServer->addData(realName.c_str(), description, fun, "none", "none", 
-			group.c_str(), "RETURN_NONE"))
+			group.c_str(), "RETURN_NONE|CONTROL_PRIORITY"))
   {
     myCommands.push_back(realName.c_str());
     myCommandDescriptions.push_back(description);
@@ -146,7 +146,7 @@ AREXPORT bool ArServerHandlerCommands::addStringCommand(
     group = "CustomCommands";
   if (myServer->addData(realName.c_str(), description, fun, 
 			"string: argumentToCommand", "none", group.c_str(),
-			"RETURN_NONE"))
+			"RETURN_NONE|CONTROL_PRIORITY"))
   {
     myStringCommands.push_back(realName.c_str());
     myStringCommandDescriptions.push_back(description);
@@ -27,6 +27,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArServerHandlerConfig.h"
 
 #include "ArClientArgUtils.h"
+#include "ArNetSharedPacket.h"
 
 /**
 @param server the server to add data to
@@ -49,6 +50,8 @@ AREXPORT ArServerHandlerConfig::ArServerHandlerConfig(ArServerBase *server,
   myPreWriteCallbacks(),
   myPostWriteCallbacks(),
   myGetConfigBySectionsCB(this, &ArServerHandlerConfig::getConfigBySections),
+  myGetConfigChangesSinceCB(this, 
+			    &ArServerHandlerConfig::getConfigChangesSince),
   myGetConfigCB(this, &ArServerHandlerConfig::getConfig),
   mySetConfigCB(this, &ArServerHandlerConfig::setConfig),
   myReloadConfigCB(this, &ArServerHandlerConfig::reloadConfig),
@@ -59,6 +62,12 @@ AREXPORT ArServerHandlerConfig::ArServerHandlerConfig(ArServerBase *server,
   myDefaultConfigMutex.setLogName(
 	  "ArServerHandlerConfig::myDefaultConfigMutex");
   myConfigMutex.setLogName("ArServerHandlerConfig::myConfigMutex");
+  myConfigCacheMutex.setLogName("ArServerHandlerConfig::myConfigCacheMutex");
+  myConfigCacheVersion = myConfig->getChangeVersion();
+  // the wall clock second plus the millisecond on the other clock, so
+  // even a quick restart gets a different one
+  myChangeEpoch = ((ArTypes::UByte4)time(NULL) * 1000 + 
+		   ArTime().getMSec());
   myAddedDefaultServerCommands = false;
 
   myServer->addData("getConfigBySections", 
@@ -69,6 +78,13 @@ AREXPORT ArServerHandlerConfig::ArServerHandlerConfig(ArServerBase *server,
                     "ConfigEditing", "RETURN_UNTIL_EMPTY");
 
 
+  myServer->addData("getConfigChangesSince", 
+                    "Gets the configuration information that changed since the given version", 
+                    &myGetConfigChangesSinceCB, 
+                    "uByte4: change version last seen (0 for everything); optional byte: last priority; optional uByte4: change epoch last seen", 
+                    "packet with byte 'V', uByte4 current change version and uByte4 current change epoch, then a packet like getConfigBySections for each changed section (with only the changed params), then an empty packet", 
+                    "ConfigEditing", "RETURN_UNTIL_EMPTY");
+
   myServer->addData("getConfig", 
     "gets the configuration information from the server", 
     &myGetConfigCB, 
@@ -109,6 +125,9 @@ AREXPORT ArServerHandlerConfig::ArServerHandlerConfig(ArServerBase *server,
 
 AREXPORT ArServerHandlerConfig::~ArServerHandlerConfig()
 {
+  myConfigCacheMutex.lock();
+  clearConfigCache();
+  myConfigCacheMutex.unlock();
   if (myDefault != NULL)
     delete myDefault;
 }
@@ -315,6 +334,56 @@ AREXPORT void ArServerHandlerConfig::handleGetConfig(ArServerClient *client,
                                                      ArPriority::Priority lastPriority)
 {
 
+  unsigned int command = myServer->findCommandFromName(
+	  isMultiplePackets ? "getConfigBySections" : "getConfig");
+  std::pair<unsigned int, int> key(command, lastPriority);
+  std::map<std::pair<unsigned int, int>, 
+	   std::list<ArNetSharedPacket *> >::iterator cacheIt;
+  std::list<ArNetSharedPacket *>::iterator pIt;
+
+  ArLog::log(ArLog::Normal, "Config requested.");
+
+  myConfigCacheMutex.lock();
+  // if anything was parsed into the config since we built these
+  // they're stale (configUpdated also clears them)
+  if (myConfigCacheVersion != myConfig->getChangeVersion())
+  {
+    clearConfigCache();
+    myConfigCacheVersion = myConfig->getChangeVersion();
+  }
+  if ((cacheIt = myConfigCache.find(key)) == myConfigCache.end())
+  {
+    cacheIt = myConfigCache.insert(
+	    std::pair<std::pair<unsigned int, int>, 
+	    std::list<ArNetSharedPacket *> >(
+		    key, std::list<ArNetSharedPacket *>())).first;
+    buildConfigPackets(&(*cacheIt).second, command,
+		       isMultiplePackets, lastPriority);
+  }
+  else
+    ArLog::log(ArLog::Verbose, "Sending cached config.");
+
+  for (pIt = (*cacheIt).second.begin(); pIt != (*cacheIt).second.end(); pIt++)
+    client->sendSharedPacketTcp(*pIt);
+  myConfigCacheMutex.unlock();
+
+} // end method handleGetConfig
+
+/**
+   @param packets where the packets are put, with command set
+
+   @param command the command the packets should go out as
+
+   @param isMultiplePackets see handleGetConfig
+
+   @param lastPriority see handleGetConfig
+**/
+void ArServerHandlerConfig::buildConfigPackets(
+	std::list<ArNetSharedPacket *> *packets,
+	unsigned int command,
+	bool isMultiplePackets,
+	ArPriority::Priority lastPriority)
+{
   ArConfigArg param;
 
  
@@ -326,7 +395,6 @@ AREXPORT void ArServerHandlerConfig::handleGetConfig(ArServerClient *client,
   std::set<std::string> sent;
 
   ArNetPacket sending;
-  ArLog::log(ArLog::Normal, "Config requested.");
 
   std::list<ArConfigSection *> *sections = myConfig->getSections();
   for (std::list<ArConfigSection *>::iterator sIt = sections->begin(); 
@@ -392,7 +460,7 @@ AREXPORT void ArServerHandlerConfig::handleGetConfig(ArServerClient *client,
     } // end if length exceeded...
     else if (isMultiplePackets) {
 
-      client->sendPacketTcp(&sending);
+      packets->push_back(new ArNetSharedPacket(&sending, command));
 
     } // end else send in chunks...
 
@@ -403,7 +471,7 @@ AREXPORT void ArServerHandlerConfig::handleGetConfig(ArServerClient *client,
   if (isMultiplePackets) {
 
     sending.empty();
-    client->sendPacketTcp(&sending);
+    packets->push_back(new ArNetSharedPacket(&sending, command));
   }
   else { //  send the entire config in one packet
 
@@ -415,11 +483,32 @@ AREXPORT void ArServerHandlerConfig::handleGetConfig(ArServerClient *client,
       sending.empty();
     }
 
-    client->sendPacketTcp(&sending);
+    packets->push_back(new ArNetSharedPacket(&sending, command));
 
   } // end else send the entire packet
 
-} // end method getConfigBySections
+} // end method buildConfigPackets
+
+/**
+   The caller must have myConfigCacheMutex locked
+**/
+void ArServerHandlerConfig::clearConfigCache(void)
+{
+  std::map<std::pair<unsigned int, int>, 
+	   std::list<ArNetSharedPacket *> >::iterator cacheIt;
+  std::list<ArNetSharedPacket *>::iterator pIt;
+
+  for (cacheIt = myConfigCache.begin(); 
+       cacheIt != myConfigCache.end(); 
+       cacheIt++)
+  {
+    for (pIt = (*cacheIt).second.begin(); 
+	 pIt != (*cacheIt).second.end(); 
+	 pIt++)
+      (*pIt)->release();
+  }
+  myConfigCache.clear();
+}
 
 
 AREXPORT void ArServerHandlerConfig::getConfigBySections(ArServerClient *client, 
@@ -462,6 +551,106 @@ AREXPORT void ArServerHandlerConfig::getConfigBySections(ArServerClient *client,
 } // end method getConfigBySections
 
 
+AREXPORT void ArServerHandlerConfig::getConfigChangesSince(
+	ArServerClient *client, ArNetPacket *packet)
+{
+  unsigned int since = 0;
+  bool haveEpoch = false;
+  ArTypes::UByte4 epoch = 0;
+  ArPriority::Priority lastPriority = ArPriority::DETAILED;
+  ArNetPacket sending;
+  ArConfigArg param;
+  std::set<std::string> sent;
+  
+  if (packet->getDataReadLength() < packet->getDataLength())
+    since = packet->bufToUByte4();
+  if (packet->getDataReadLength() < packet->getDataLength())
+  {
+    char priorityVal = packet->bufToByte();
+    if ((priorityVal >= 0) && (priorityVal <= ArPriority::LAST_PRIORITY)) 
+      lastPriority = (ArPriority::Priority) priorityVal;
+    else if (priorityVal > ArPriority::LAST_PRIORITY) 
+      lastPriority = ArPriority::LAST_PRIORITY;
+  }
+  if (packet->getDataReadLength() < packet->getDataLength())
+  {
+    haveEpoch = true;
+    epoch = packet->bufToUByte4();
+  }
+
+  ArClientArg clientArg(true, lastPriority);
+
+  lockConfig();
+  // if they haven't seen anything, or saw a version from another run
+  // of the server (where the versions meant something else), they get
+  // everything
+  if (!haveEpoch || epoch != myChangeEpoch || 
+      since > myConfig->getChangeVersion())
+    since = 0;
+  ArLog::log(ArLog::Normal, "Config changes since %u requested (now %u).",
+	     since, myConfig->getChangeVersion());
+
+  sending.byteToBuf('V');
+  sending.uByte4ToBuf(myConfig->getChangeVersion());
+  sending.uByte4ToBuf(myChangeEpoch);
+  client->sendPacketTcp(&sending);
+
+  std::list<ArConfigSection *> *sections = myConfig->getSections();
+  for (std::list<ArConfigSection *>::iterator sIt = sections->begin(); 
+       sIt != sections->end(); 
+       sIt++)
+  {
+    ArConfigSection *section = (*sIt);
+    if (section == NULL || 
+	(since != 0 && section->getChangeVersion() <= since))
+      continue;
+
+    sending.empty();
+    sent.clear();
+    sending.byteToBuf('S');
+    sending.strToBuf(section->getName());
+    sending.strToBuf(section->getComment());
+
+    std::list<ArConfigArg> *params = section->getParams();
+    for (std::list<ArConfigArg>::iterator pIt = params->begin(); 
+         pIt != params->end(); 
+         pIt++)
+    {
+      param = (*pIt);
+      if (since != 0 && param.getChangeVersion() <= since)
+	continue;
+
+      bool isCheckableName = 
+      (param.getType() != ArConfigArg::DESCRIPTION_HOLDER && 
+       param.getType() != ArConfigArg::SEPARATOR &&
+       param.getType() != ArConfigArg::STRING_HOLDER);
+
+      // if we've already sent it don't send it again
+      if (isCheckableName &&
+          sent.find(param.getName()) != sent.end()) 
+        continue;
+      else if (isCheckableName) 
+        sent.insert(param.getName());
+
+      if (clientArg.isSendableParamType(param))
+      {
+        sending.byteToBuf('P');
+        clientArg.createPacket(param, &sending);
+      }
+    }
+
+    if (!sending.isValid()) 
+      ArLog::log(ArLog::Terse, "Config section %s cannot be sent; packet size exceeded",
+                 section->getName());
+    else
+      client->sendPacketTcp(&sending);
+  }
+  unlockConfig();
+
+  sending.empty();
+  client->sendPacketTcp(&sending);
+}
+
 AREXPORT void ArServerHandlerConfig::getConfig(ArServerClient *client, 
                                                ArNetPacket *packet)
 {
@@ -495,6 +684,7 @@ bool ArServerHandlerConfig::internalSetConfig(ArServerClient *client,
   ArNetPacket retPacket;
   ArConfig *config;
   bool ret = true;
+  unsigned int startVersion;
 
   if (client != NULL)
     config = myConfig;
@@ -503,6 +693,7 @@ bool ArServerHandlerConfig::internalSetConfig(ArServerClient *client,
 
   if (client != NULL)
     lockConfig();
+  startVersion = config->getChangeVersion();
   ArArgumentBuilder *builder = NULL;
   if (client != NULL)
     ArLog::log(ArLog::Normal, "Got new config from client %s", client->getIPString());
@@ -535,9 +726,18 @@ bool ArServerHandlerConfig::internalSetConfig(ArServerClient *client,
   }
   if (firstError[0] == '\0')
   {
+    if (client != NULL)
+      ArLog::log(ArLog::Normal, 
+		 "Config from client %s changed %u values", 
+		 client->getIPString(), 
+		 config->getChangeVersion() - startVersion);
+    // the default config is brand new so everything in it counts,
+    // otherwise only redo the sections the client actually changed
     if (config->callProcessFileCallBacks(true, 
                                            errorBuffer, 
-                                           sizeof(errorBuffer)))
+                                           sizeof(errorBuffer),
+					   client != NULL,
+					   startVersion))
     {
       if (client != NULL)
 	ArLog::log(ArLog::Normal, "New config from client %s was fine.",
@@ -765,6 +965,11 @@ AREXPORT bool ArServerHandlerConfig::configUpdated(ArServerClient *client)
 
   std::list<ArFunctor *>::iterator fit;
 
+  // whatever changed, the packets we have may not show it anymore
+  myConfigCacheMutex.lock();
+  clearConfigCache();
+  myConfigCacheMutex.unlock();
+
   // call our post write callbacks
   for (fit = myConfigUpdatedCallbacks.begin(); 
        fit != myConfigUpdatedCallbacks.end(); 
@@ -29,6 +29,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArServerBase.h"
 
 class ArServerClient;
+class ArNetSharedPacket;
 
 /// Class for sending and receiving ArConfig data via ArNetworking.
 /**
@@ -53,6 +54,18 @@ class ArServerClient;
  *        complete description of the parameter (display hints are included).  
  *        See ArClientArgUtils for more information.
  *    </li>
+ *    <li>getConfigChangesSince: Takes the change version (ubyte4) the
+ *        client last saw, and optionally a last priority (byte) like
+ *        getConfigBySections and the change epoch (ubyte4) the client
+ *        last saw.  Replies with a packet holding a Version Indicator
+ *        ('V' (byte)), the current change version (ubyte4) and the
+ *        current change epoch (ubyte4), then a packet laid out like
+ *        getConfigBySections for each section that changed since that
+ *        version holding only the parameters that changed, then an
+ *        empty packet.  The change epoch is different each time the
+ *        server runs (since the versions start over), so a version of 0,
+ *        or a missing or different epoch, gets everything.
+ *    </li>
  *    <li>getConfig:  This request has been superceded by getConfigBySections. (It
  *        replies with a single packet containing all of the ArConfig 
  *        sections as described above.  If the ArConfig is large, then it 
@@ -70,6 +83,10 @@ class ArServerClient;
  *        This is the parameter name (string) followed by the parameter value
  *        formatted as text (string).  See ArClientArgUtils for more information.
  *        
+ *        Only the process file callbacks that weren't added for a
+ *        particular section, or were added for a section that this
+ *        actually changed, are called.
+ *
  *        A reply packet containing a string is sent to the client. If the 
  *        string is empty, then the config was successfully updated.  Otherwise,
  *        the string contains the name of the first parameter that caused an
@@ -103,6 +120,14 @@ class ArServerClient;
  *  want to make it AFTER you're done adding things to the config, ie
  *  last, so that the default code can work correctly (it needs to know
  *  about all the info).
+ *
+ *  The packets for getConfigBySections and getConfig are kept and
+ *  sent again until the ArConfig's change version goes up (which
+ *  parsing a changed value, adding params or sections, or changing
+ *  section comments or flags all do) or configUpdated() is called.  So
+ *  if you change a variable that's in the config directly, call
+ *  configUpdated() afterwards, or clients will keep getting the old
+ *  value.
 **/
 class ArServerHandlerConfig
 {
@@ -137,6 +162,10 @@ public:
   /// Handles the "getConfigBySections" request.
   AREXPORT void getConfigBySections(ArServerClient *client, ArNetPacket *packet);
 
+  /// Handles the "getConfigChangesSince" request.
+  AREXPORT void getConfigChangesSince(ArServerClient *client, 
+				      ArNetPacket *packet);
+
   /// Handles the (deprecated) "getConfig" request.
   AREXPORT void getConfig(ArServerClient *client, ArNetPacket *packet);
   
@@ -198,6 +227,13 @@ protected:
                                 ArNetPacket *packet,
                                 bool isMultiplePackets,
                                 ArPriority::Priority lastPriority);
+  /// Builds the packets handleGetConfig sends out
+  void buildConfigPackets(std::list<ArNetSharedPacket *> *packets,
+			  unsigned int command,
+			  bool isMultiplePackets,
+			  ArPriority::Priority lastPriority);
+  /// Releases the cached packets
+  void clearConfigCache(void);
 
   /// Internal method that handles a setConfig packet for myConfig or
   /// myDefaults
@@ -219,12 +255,24 @@ protected:
   bool myAddedDefaultServerCommands;
 
   ArMutex myConfigMutex;
+
+  // the packets handleGetConfig sent, by command and last priority, so
+  // a bunch of clients asking for the same config only encode it once
+  std::map<std::pair<unsigned int, int>, 
+	   std::list<ArNetSharedPacket *> > myConfigCache;
+  // the config's change version when myConfigCache was built
+  unsigned int myConfigCacheVersion;
+  ArMutex myConfigCacheMutex;
+  // different every time the server runs, since the change versions
+  // start over each run
+  ArTypes::UByte4 myChangeEpoch;
   
   std::list<ArFunctor *> myPreWriteCallbacks;
   std::list<ArFunctor *> myPostWriteCallbacks;
   std::list<ArFunctor *> myConfigUpdatedCallbacks;
 
   ArFunctor2C<ArServerHandlerConfig, ArServerClient*, ArNetPacket *> myGetConfigBySectionsCB;
+  ArFunctor2C<ArServerHandlerConfig, ArServerClient*, ArNetPacket *> myGetConfigChangesSinceCB;
   ArFunctor2C<ArServerHandlerConfig, ArServerClient*, ArNetPacket *> myGetConfigCB;
   ArFunctor2C<ArServerHandlerConfig, ArServerClient*, ArNetPacket *> mySetConfigCB;
   ArFunctor2C<ArServerHandlerConfig, ArServerClient*, ArNetPacket *> myReloadConfigCB;
@@ -288,60 +288,37 @@ AREXPORT void ArServerHandlerMap::writePointsToClient(
   }
   
   int maxInPacketCount = 1000; // Maximum number of points sent in a packet
-  int currentCount = 0;		// Number put into the current packet 
-  int remainingCount = pointCount; // Total number of points remaining to be sent
-  bool isStartPacket = true;	// Whether a new packet is being started
-  
+  int inPacketCount;		// Number put into the current packet 
   int totalCount = 0;
-  
-  for (std::vector<ArPose>::iterator pointIt = points->begin(); 
-       pointIt != points->end();
-       pointIt++) {
-    
-    // Start a new packet if the previous one was sent (or there is no 
-    // previous one)
-    if (isStartPacket) {
-      
-      isStartPacket = false;
-      
-      sendPacket.empty();
-      currentCount = 0;
-      
-      // Leftover points...
-      if (maxInPacketCount > remainingCount) {
-	maxInPacketCount = remainingCount;
-      }
-      
-      // The first item in the packet is the number of points contained
-      sendPacket.byte4ToBuf(maxInPacketCount);
-      
-    } // end if starting a new packet
-    
-    // Add the current point to the packet (think that the test should 
-    // always be true)
-    if (currentCount < maxInPacketCount) {
-      
-      currentCount++;
-      remainingCount--;
-      
-      sendPacket.byte4ToBuf(
-	      ArMath::roundInt((*pointIt).getX()));
-      sendPacket.byte4ToBuf(
-	      ArMath::roundInt((*pointIt).getY()));
+  int i;
+  std::vector<ArPose>::iterator pointIt = points->begin();
+
+  while (totalCount < pointCount) 
+  {
+    inPacketCount = pointCount - totalCount;
+    if (inPacketCount > maxInPacketCount)
+      inPacketCount = maxInPacketCount;
+
+    // The first item in the packet is the number of points contained,
+    // then the points, the room for all of them is checked for at once
+    sendPacket.empty();
+    ArBasePacket::Writer writer(&sendPacket, 4 + 8 * inPacketCount);
+    if (!writer.isValid())
+    {
+      ArLog::log(ArLog::Terse, 
+		 "ArServerHandlerMap: Could not fit %d points in a packet", 
+		 inPacketCount);
+      return;
     }
-    
-    // If the packet is full, send it and then start a new one
-    if (currentCount == maxInPacketCount) {
-      
-      totalCount += currentCount;
-      
-      client->sendPacketTcp(&sendPacket);
-      //ArUtil::sleep(1);
-      
-      isStartPacket = true;
+    writer.byte4ToBuf(inPacketCount);
+    for (i = 0; i < inPacketCount; i++, pointIt++)
+    {
+      writer.byte4ToBuf(ArMath::roundInt((*pointIt).getX()));
+      writer.byte4ToBuf(ArMath::roundInt((*pointIt).getY()));
     }
-    
-  } // end for each point
+    totalCount += inPacketCount;
+    client->sendPacketTcp(&sendPacket);
+  }
   
   ArLog::log(ArLog::Verbose, 
 	     "ArServerHandlerMap::writePointsToClient() totalCount = %i", 
@@ -381,66 +358,40 @@ AREXPORT void ArServerHandlerMap::writeLinesToClient(
     lineCount = lines->size();
   }
   
-  int maxInPacketCount = 1000; // Maximum number of points sent in a packet
-  int currentCount = 0;		// Number put into the current packet 
-  int remainingCount = lineCount; // Total number of points remaining to be sent
-  bool isStartPacket = true;	// Whether a new packet is being started
-  
+  int maxInPacketCount = 1000; // Maximum number of lines sent in a packet
+  int inPacketCount;		// Number put into the current packet 
   int totalCount = 0;
-  
-  for (std::vector<ArLineSegment>::iterator lineIt = lines->begin(); 
-       lineIt != lines->end();
-       lineIt++) 
+  int i;
+  std::vector<ArLineSegment>::iterator lineIt = lines->begin();
+
+  while (totalCount < lineCount) 
   {
-    
-    // Start a new packet if the previous one was sent (or there is no 
-    // previous one)
-    if (isStartPacket) {
-      
-      isStartPacket = false;
-      
-      sendPacket.empty();
-      currentCount = 0;
-      
-      // Leftover points...
-      if (maxInPacketCount > remainingCount) {
-	maxInPacketCount = remainingCount;
-      }
-      
-      // The first item in the packet is the number of points contained
-      sendPacket.byte4ToBuf(maxInPacketCount);
-      
-    } // end if starting a new packet
-    
-    // Add the current point to the packet (think that the test should 
-    // always be true)
-    if (currentCount < maxInPacketCount) {
-      
-      currentCount++;
-      remainingCount--;
-      
-      sendPacket.byte4ToBuf(
-	      ArMath::roundInt((*lineIt).getX1()));
-      sendPacket.byte4ToBuf(
-	      ArMath::roundInt((*lineIt).getY1()));
-      sendPacket.byte4ToBuf(
-	      ArMath::roundInt((*lineIt).getX2()));
-      sendPacket.byte4ToBuf(
-	      ArMath::roundInt((*lineIt).getY2()));
+    inPacketCount = lineCount - totalCount;
+    if (inPacketCount > maxInPacketCount)
+      inPacketCount = maxInPacketCount;
+
+    // The first item in the packet is the number of lines contained,
+    // then the lines, the room for all of them is checked for at once
+    sendPacket.empty();
+    ArBasePacket::Writer writer(&sendPacket, 4 + 16 * inPacketCount);
+    if (!writer.isValid())
+    {
+      ArLog::log(ArLog::Terse, 
+		 "ArServerHandlerMap: Could not fit %d lines in a packet", 
+		 inPacketCount);
+      return;
     }
-    
-    // If the packet is full, send it and then start a new one
-    if (currentCount == maxInPacketCount) {
-      
-      totalCount += currentCount;
-      
-      client->sendPacketTcp(&sendPacket);
-      //ArUtil::sleep(1);
-      
-      isStartPacket = true;
+    writer.byte4ToBuf(inPacketCount);
+    for (i = 0; i < inPacketCount; i++, lineIt++)
+    {
+      writer.byte4ToBuf(ArMath::roundInt((*lineIt).getX1()));
+      writer.byte4ToBuf(ArMath::roundInt((*lineIt).getY1()));
+      writer.byte4ToBuf(ArMath::roundInt((*lineIt).getX2()));
+      writer.byte4ToBuf(ArMath::roundInt((*lineIt).getY2()));
     }
-    
-  } // end for each point
+    totalCount += inPacketCount;
+    client->sendPacketTcp(&sendPacket);
+  }
   
   ArLog::log(ArLog::Verbose, 
 	     "ArServerHandlerMap::writePointsToClient() totalCount = %i", 
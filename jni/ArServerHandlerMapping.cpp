@@ -168,12 +168,15 @@ AREXPORT void ArServerHandlerMapping::serverMappingStart(
   }
 
 
+  // the loggers write in the background so that mapping with a fast
+  // laser doesn't slow down the robot's cycle
   myLaserLogger = new ArLaserLogger(myRobot, myLaser, 300, 25, myFileName.c_str(),
 				  true, Aria::getJoyHandler(), 
 				  myTempDirectory.c_str(), 
 				  myUseReflectorValues,
 				  Aria::getRobotJoyHandler(),
-				  &myLocationDataMap);
+				  &myLocationDataMap,
+				  true);
   if (myLaserLogger == NULL)
   {
     ArLog::log(ArLog::Normal, "MappingStart: myLaserLogger == NULL");
@@ -208,7 +211,8 @@ AREXPORT void ArServerHandlerMapping::serverMappingStart(
 				     myTempDirectory.c_str(), 
 				     myUseReflectorValues,
 				     Aria::getRobotJoyHandler(),
-				     &myLocationDataMap);
+				     &myLocationDataMap,
+				     true);
   }
 
   // toss our strings for the start on there
@@ -241,6 +245,8 @@ AREXPORT void ArServerHandlerMapping::serverMappingEnd(
 	ArServerClient *client, ArNetPacket *packet)
 {
   std::list<ArFunctor *>::iterator fit;
+  ArLaserLogger *laserLogger;
+  ArLaserLogger *laserLogger2;
 
   ArNetPacket sendPacket;
   if (myLaserLogger == NULL)
@@ -252,18 +258,29 @@ AREXPORT void ArServerHandlerMapping::serverMappingEnd(
     return;
   }
 
+  // the loggers come off the robot while it's locked, but they're
+  // deleted (which waits for their logs to get to the disk) with it
+  // unlocked so the robot isn't held up
   myRobot->lock();
-  delete myLaserLogger;
+  laserLogger = myLaserLogger;
   myLaserLogger = NULL;
+  laserLogger->endLog();
 
   bool haveFile2 = false;
 
-  if (myLaserLogger2 != NULL)
+  laserLogger2 = myLaserLogger2;
+  myLaserLogger2 = NULL;
+  if (laserLogger2 != NULL)
   {
     haveFile2 = true;
-    delete myLaserLogger2;
-    myLaserLogger2 = NULL;
+    laserLogger2->endLog();
   }
+  myRobot->unlock();
+
+  delete laserLogger;
+  if (laserLogger2 != NULL)
+    delete laserLogger2;
+  myRobot->lock();
     
   // now, if our temp directory and base directory are different we
   // need to move it and put the result in the packet, otherwise put
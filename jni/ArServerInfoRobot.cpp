@@ -103,22 +103,8 @@ AREXPORT void ArServerInfoRobot::update(ArServerClient *client,
     sending.strToBuf("Unknown status");
     sending.strToBuf("Unknown mode");
   }
-  if (myRobot->haveStateOfCharge())
-    sending.byte2ToBuf(ArMath::roundInt(myRobot->getStateOfCharge() * 10));
-  else if (myRobot->getRealBatteryVoltage() > 0)
-    sending.byte2ToBuf(ArMath::roundInt(
-	    myRobot->getRealBatteryVoltage() * 10));
-  else
-    sending.byte2ToBuf(ArMath::roundInt(
-	    myRobot->getBatteryVoltage() * 10));
-  sending.byte4ToBuf((int)myRobot->getX());
-  sending.byte4ToBuf((int)myRobot->getY());
-  sending.byte2ToBuf((int)myRobot->getTh());
-  sending.byte2ToBuf((int)myRobot->getVel());
-  sending.byte2ToBuf((int)myRobot->getRotVel());
-  sending.byte2ToBuf((int)myRobot->getLatVel());
-  sending.byteToBuf((char)myRobot->getTemperature());
   myRobot->unlock();
+  numbersToBuf(&sending);
 
   client->sendPacketUdp(&sending);
 }
@@ -128,28 +114,59 @@ AREXPORT void ArServerInfoRobot::updateNumbers(ArServerClient *client,
 {
   ArNetPacket sending;
 
-  myRobot->lock();
-
-  if (myRobot->haveStateOfCharge())
-    sending.byte2ToBuf(ArMath::roundInt(myRobot->getStateOfCharge() * 10));
-  else if (myRobot->getRealBatteryVoltage() > 0)
-    sending.byte2ToBuf(ArMath::roundInt(
-	    myRobot->getRealBatteryVoltage() * 10));
-  else
-    sending.byte2ToBuf(ArMath::roundInt(
-	    myRobot->getBatteryVoltage() * 10));
-  sending.byte4ToBuf((int)myRobot->getX());
-  sending.byte4ToBuf((int)myRobot->getY());
-  sending.byte2ToBuf((int)myRobot->getTh());
-  sending.byte2ToBuf((int)myRobot->getVel());
-  sending.byte2ToBuf((int)myRobot->getRotVel());
-  sending.byte2ToBuf((int)myRobot->getLatVel());
-  sending.byteToBuf((char)myRobot->getTemperature());
-  myRobot->unlock();
+  numbersToBuf(&sending);
 
   client->sendPacketUdp(&sending);
 }
 
+/**
+   This uses the robot's state snapshot so that it doesn't need to
+   lock the robot (and wait for its cycle), unless the robot hasn't
+   run a cycle yet.
+**/
+void ArServerInfoRobot::numbersToBuf(ArNetPacket *sending)
+{
+  ArRobotStateSnapshot state;
+
+  if (!myRobot->getStateSnapshot(&state))
+  {
+    myRobot->lock();
+    if (myRobot->haveStateOfCharge())
+      sending->byte2ToBuf(ArMath::roundInt(myRobot->getStateOfCharge() * 10));
+    else if (myRobot->getRealBatteryVoltage() > 0)
+      sending->byte2ToBuf(ArMath::roundInt(
+	      myRobot->getRealBatteryVoltage() * 10));
+    else
+      sending->byte2ToBuf(ArMath::roundInt(
+	      myRobot->getBatteryVoltage() * 10));
+    sending->byte4ToBuf((int)myRobot->getX());
+    sending->byte4ToBuf((int)myRobot->getY());
+    sending->byte2ToBuf((int)myRobot->getTh());
+    sending->byte2ToBuf((int)myRobot->getVel());
+    sending->byte2ToBuf((int)myRobot->getRotVel());
+    sending->byte2ToBuf((int)myRobot->getLatVel());
+    sending->byteToBuf((char)myRobot->getTemperature());
+    myRobot->unlock();
+    return;
+  }
+
+  if (state.haveStateOfCharge())
+    sending->byte2ToBuf(ArMath::roundInt(state.getStateOfCharge() * 10));
+  else if (state.getRealBatteryVoltage() > 0)
+    sending->byte2ToBuf(ArMath::roundInt(
+	    state.getRealBatteryVoltage() * 10));
+  else
+    sending->byte2ToBuf(ArMath::roundInt(
+	    state.getBatteryVoltage() * 10));
+  sending->byte4ToBuf((int)state.getPose().getX());
+  sending->byte4ToBuf((int)state.getPose().getY());
+  sending->byte2ToBuf((int)state.getPose().getTh());
+  sending->byte2ToBuf((int)state.getVel());
+  sending->byte2ToBuf((int)state.getRotVel());
+  sending->byte2ToBuf((int)state.getLatVel());
+  sending->byteToBuf((char)state.getTemperature());
+}
+
 AREXPORT void ArServerInfoRobot::updateStrings(ArServerClient *client, 
 					       ArNetPacket *packet)
 {
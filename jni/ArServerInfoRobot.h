@@ -125,6 +125,8 @@ protected:
   ArServerBase *myServer;
   ArRobot *myRobot;
   void userTask(void);
+  /// Puts the numbers from updateNumbers into the packet
+  void numbersToBuf(ArNetPacket *sending);
   
   std::string myStatus;
   std::string myMode;
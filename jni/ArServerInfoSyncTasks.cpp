@@ -0,0 +1,102 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "Aria.h"
+#include "ArExport.h"
+#include "ArServerInfoSyncTasks.h"
+
+AREXPORT ArServerInfoSyncTasks::ArServerInfoSyncTasks(ArServerBase *server, 
+						      ArRobot *robot) :
+  mySyncTaskStatsCB(this, &ArServerInfoSyncTasks::syncTaskStats)
+{
+  myRobot = robot;
+  myServer = server;
+
+  myRobot->lock();
+  if (myRobot->getSyncTaskRoot() != NULL)
+    myRobot->getSyncTaskRoot()->setStatsEnabled(true);
+  myRobot->unlock();
+
+  if (myServer != NULL)
+    myServer->addData("syncTaskStats", 
+		      "gets how long each of the robot's sync tasks takes to run",
+		      &mySyncTaskStatsCB, 
+		      "none or ubyte: 1 to reset the stats after sending them",
+		      "ubyte2: numTasks, repeating for numTasks: ubyte: depth; string: name; ubyte4: runs; ubyte4: overruns; ubyte4: p50 usecs; ubyte4: p99 usecs; ubyte4: max usecs", 
+		      "RobotInfo", "RETURN_SINGLE");
+}
+
+AREXPORT ArServerInfoSyncTasks::~ArServerInfoSyncTasks()
+{
+
+}
+
+AREXPORT void ArServerInfoSyncTasks::syncTaskStats(ArServerClient *client, 
+						   ArNetPacket *packet)
+{
+  ArNetPacket sending;
+  std::list<std::pair<ArSyncTask *, int> > tasks;
+  std::list<std::pair<ArSyncTask *, int> >::iterator it;
+  ArSyncTask *task;
+  bool reset = false;
+
+  if (packet->getDataLength() > 0 && packet->bufToUByte() == 1)
+    reset = true;
+
+  myRobot->lock();
+  if (myRobot->getSyncTaskRoot() != NULL)
+    getTasks(myRobot->getSyncTaskRoot(), 0, &tasks);
+
+  sending.uByte2ToBuf(tasks.size());
+  for (it = tasks.begin(); it != tasks.end(); it++)
+  {
+    task = (*it).first;
+    sending.uByteToBuf((*it).second);
+    sending.strToBuf(task->getName().c_str());
+    sending.uByte4ToBuf(task->getStatsCount());
+    sending.uByte4ToBuf(task->getStatsOverruns());
+    sending.uByte4ToBuf(task->getStatsPercentileUSec(50));
+    sending.uByte4ToBuf(task->getStatsPercentileUSec(99));
+    sending.uByte4ToBuf(task->getStatsMaxUSec());
+  }
+
+  if (reset && myRobot->getSyncTaskRoot() != NULL)
+    myRobot->getSyncTaskRoot()->resetStats();
+  myRobot->unlock();
+
+  client->sendPacketTcp(&sending);
+}
+
+void ArServerInfoSyncTasks::getTasks(
+	ArSyncTask *task, int depth, 
+	std::list<std::pair<ArSyncTask *, int> > *tasks)
+{
+  std::list<ArSyncTask *> children;
+  std::list<ArSyncTask *>::iterator it;
+
+  tasks->push_back(std::pair<ArSyncTask *, int>(task, depth));
+  task->getChildren(&children);
+  for (it = children.begin(); it != children.end(); it++)
+    getTasks(*it, depth + 1, tasks);
+}
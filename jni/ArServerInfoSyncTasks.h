@@ -0,0 +1,80 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#ifndef ARSERVERINFOSYNCTASKS_H
+#define ARSERVERINFOSYNCTASKS_H
+
+#include "Aria.h"
+#include "ArServerBase.h"
+
+class ArServerClient;
+
+/** Service providing clients with how long the robot's sync tasks take.
+ * This turns on the stats in the robot's ArSyncTask tree (see
+ * ArSyncTask::setStatsEnabled) and accepts the following data request:
+ * <ul>
+ *  <li><code>syncTaskStats</code> to get the stats for every task</li>
+ * </ul>
+ *
+ * The <code>syncTaskStats</code> request can include the following data:
+ * <ol>
+ *  <li>Reset, if 1 the stats are reset after they're sent (1-byte unsigned integer)</li>
+ * </ol>
+ *
+ * The <code>syncTaskStats</code> request replies with the following data packet:
+ * <ol>
+ *  <li>Number of tasks (2-byte unsigned integer)</li>
+ *  <li>For each task, in the order they run:
+ *    <ol>
+ *      <li>Depth in the tree, 0 for the root (1-byte unsigned integer)</li>
+ *      <li>Task name (Null-terminated string)</li>
+ *      <li>Number of runs (4-byte unsigned integer)</li>
+ *      <li>Number of runs longer than the cycle warning time (4-byte unsigned integer)</li>
+ *      <li>Median run time in microseconds (4-byte unsigned integer)</li>
+ *      <li>99th percentile run time in microseconds (4-byte unsigned integer)</li>
+ *      <li>Longest run time in microseconds (4-byte unsigned integer)</li>
+ *    </ol>
+ *  </li>
+ * </ol>
+ *
+ * The time for a task includes all of the tasks under it.  This
+ * service's request is in the <code>RobotInfo</code> group.
+ */
+class ArServerInfoSyncTasks
+{
+public:
+  AREXPORT ArServerInfoSyncTasks(ArServerBase *server, ArRobot *robot);
+  AREXPORT virtual ~ArServerInfoSyncTasks();
+  AREXPORT void syncTaskStats(ArServerClient *client, ArNetPacket *packet);
+protected:
+  /// Gets the task and everything under it, with how deep each one is
+  void getTasks(ArSyncTask *task, int depth, 
+		std::list<std::pair<ArSyncTask *, int> > *tasks);
+  ArRobot *myRobot;
+  ArServerBase *myServer;
+  ArFunctor2C<ArServerInfoSyncTasks, ArServerClient *, ArNetPacket *> mySyncTaskStatsCB;
+};
+
+
+#endif
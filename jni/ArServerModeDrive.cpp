@@ -53,7 +53,7 @@ AREXPORT ArServerModeDrive::ArServerModeDrive(ArServerBase *server,
 		"drives the robot as with a joystick",
 		&myServerDriveJoystickCB,
 		"byte2: vel, byte2: rotVel",
-		"none", "Movement", "RETURN_NONE");    
+		"none", "Movement", "RETURN_NONE|CONTROL_PRIORITY");    
   }
   if ((myJoyHandler = Aria::getJoyHandler()) == NULL)
   {
@@ -105,12 +105,12 @@ AREXPORT ArServerModeRatioDrive::ArServerModeRatioDrive(
     addModeData("ratioDrive", "drives the robot as with a joystick",
 		&myServerRatioDriveCB,
 		"double: transRatio; double: rotRatio; double: throttleRatio ",
-		"none", "Movement", "RETURN_NONE");
+		"none", "Movement", "RETURN_NONE|CONTROL_PRIORITY");
     myServer->addData("setSafeDrive", 
 		      "sets whether we drive the robot safely or not",
 		      &myServerSetSafeDriveCB,
 		      "byte: 1 == drive safely, 0 == drive unsafely",
-		      "none", "UnsafeMovement", "RETURN_NONE");
+		      "none", "UnsafeMovement", "RETURN_NONE|CONTROL_PRIORITY");
     myServer->addData("getSafeDrive", 
 		      "gets whether we drive the robot safely or not",
 		      &myServerGetSafeDriveCB,
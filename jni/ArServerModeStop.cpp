@@ -37,7 +37,7 @@ AREXPORT ArServerModeStop::ArServerModeStop(ArServerBase *server,
   if (myServer != NULL)
   {
     addModeData("stop", "stops the robot", &myNetStopCB,
-		"none", "none", "Stop", "RETURN_NONE");
+		"none", "none", "Stop", "RETURN_NONE|CONTROL_PRIORITY");
   }
 
   myUseLocationDependentDevices = true;
@@ -198,7 +198,7 @@ AREXPORT bool ArSimulatedLaser::blockingConnect(void)
 
   mySimPacketHandler.setName(getName());
   myRobot->remPacketHandler(&mySimPacketHandler);
-  myRobot->addPacketHandler(&mySimPacketHandler, ArListPos::LAST);
+  myRobot->addPacketHandlerForID(&mySimPacketHandler, 0x60, 0xfe);
 
   // return true if we could send all the commands
   if (myRobot->comInt(36, ArMath::roundInt(mySimBegin)) &&   // Start angle
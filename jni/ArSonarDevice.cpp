@@ -59,7 +59,7 @@ AREXPORT void ArSonarDevice::setRobot(ArRobot *robot)
 {
   myRobot = robot;
   if (myRobot != NULL)
-    myRobot->addSensorInterpTask(myName.c_str(), 10, &myProcessCB);
+    myRobot->addSensorInterpTask(myName.c_str(), 10, &myProcessCB, NULL, true);
   ArRangeDevice::setRobot(robot);
 }
 
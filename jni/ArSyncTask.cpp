@@ -27,29 +27,39 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ariaUtil.h"
 #include "ArSyncTask.h"
 #include "ArLog.h"
+#include "ArWorkerPool.h"
 
 /**
    New should never be called to create an ArSyncTask except to create the 
    root node.  Read the detailed documentation of the class for details.
 */
 AREXPORT ArSyncTask::ArSyncTask(const char *name, ArFunctor *functor,
-				ArTaskState::State *state, ArSyncTask *parent)
+				ArTaskState::State *state, ArSyncTask *parent) :
+  myRunCB(this, &ArSyncTask::run)
 {
   myName = name;
   myStatePointer = state;
   myFunctor = functor;
   myParent = parent;
   myIsDeleting = false;
+  myRunning = false;
+  myInvokingOtherFunctor = NULL;
+  myParallel = false;
   setState(ArTaskState::INIT);
+  resetStats(false);
   if (myParent != NULL)
   {
     setWarningTimeCB(parent->getWarningTimeCB());
     setNoTimeWarningCB(parent->getNoTimeWarningCB());
+    myStatsEnabled = parent->getStatsEnabled();
+    myWorkerPool = parent->getWorkerPool();
   }
   else
   {
     setWarningTimeCB(NULL);
     setNoTimeWarningCB(NULL);
+    myStatsEnabled = false;
+    myWorkerPool = NULL;
   }
 }
 
@@ -249,6 +259,7 @@ AREXPORT void ArSyncTask::run(void)
   ArTaskState::State state;
   ArTime runTime;
   int took;  
+  ArPreciseTime statsStart;
 
   state = getState();
   switch (state) 
@@ -267,6 +278,8 @@ AREXPORT void ArSyncTask::run(void)
   }
   
   runTime.setToNow();
+  if (myStatsEnabled)
+    statsStart.setToNow();
   if (myFunctor != NULL)
     myFunctor->invoke();
   
@@ -279,12 +292,31 @@ AREXPORT void ArSyncTask::run(void)
 	       myName.c_str(), took, (signed int)myWarningTimeCB->invokeR());
   
   
-  for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+  it = myMultiMap.rbegin();
+  while (it != myMultiMap.rend())
   {
     myInvokingOtherFunctor = (*it).second;
-    myInvokingOtherFunctor->run();
+    // run the parallel children next to each other at the same time
+    if (myWorkerPool != NULL && myInvokingOtherFunctor->getParallel())
+    {
+      myParallelRunCBs.clear();
+      for (; it != myMultiMap.rend() && (*it).second->getParallel(); it++)
+	myParallelRunCBs.push_back(&(*it).second->myRunCB);
+      if (myParallelRunCBs.size() > 1)
+	myWorkerPool->runAll(&myParallelRunCBs);
+      else
+	myInvokingOtherFunctor->run();
+    }
+    else
+    {
+      myInvokingOtherFunctor->run();
+      it++;
+    }
   }
   myInvokingOtherFunctor = NULL;
+
+  if (myStatsEnabled)
+    addStats(statsStart.uSecSince());
 }
 
 /**
@@ -395,3 +427,159 @@ AREXPORT ArSyncTask *ArSyncTask::getRunning(void)
     return NULL;
   }
 }
+
+AREXPORT void ArSyncTask::getChildren(std::list<ArSyncTask *> *children)
+{
+  std::multimap<int, ArSyncTask *>::reverse_iterator it;
+
+  for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+    children->push_back((*it).second);
+}
+
+/**
+   @param statsEnabled true to keep stats on how long this node takes
+   to run, false not to (the ones already kept are left alone)
+
+   @param recurse true to set this on all the children too
+**/
+AREXPORT void ArSyncTask::setStatsEnabled(bool statsEnabled, bool recurse)
+{
+  std::multimap<int, ArSyncTask *>::reverse_iterator it;
+
+  myStatsEnabled = statsEnabled;
+  if (!recurse)
+    return;
+  for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+    (*it).second->setStatsEnabled(statsEnabled, recurse);
+}
+
+AREXPORT void ArSyncTask::resetStats(bool recurse)
+{
+  std::multimap<int, ArSyncTask *>::reverse_iterator it;
+  int i;
+
+  myStatsCount = 0;
+  myStatsOverruns = 0;
+  myStatsMaxUSec = 0;
+  for (i = 0; i < STATS_BUCKETS; i++)
+    myStatsBuckets[i] = 0;
+  if (!recurse)
+    return;
+  for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+    (*it).second->resetStats(recurse);
+}
+
+int ArSyncTask::statsBucket(unsigned long uSec)
+{
+  int bit;
+
+  if (uSec < STATS_EXACT)
+    return uSec;
+  // find the highest bit set, then use the next 2 bits below it
+  for (bit = 4; bit < 31 && (uSec >> (bit + 1)) != 0; bit++)
+    ;
+  return (STATS_EXACT + (bit - 4) * 4 + 
+	  (int)((uSec >> (bit - 2)) & 3));
+}
+
+unsigned long ArSyncTask::statsBucketMax(int bucket)
+{
+  int bit;
+  int sub;
+
+  if (bucket < STATS_EXACT)
+    return bucket;
+  bit = (bucket - STATS_EXACT) / 4 + 4;
+  sub = (bucket - STATS_EXACT) % 4;
+  return ((unsigned long)(4 + sub + 1) << (bit - 2)) - 1;
+}
+
+void ArSyncTask::addStats(unsigned long uSec)
+{
+  unsigned int warningTime;
+
+  myStatsCount++;
+  myStatsBuckets[statsBucket(uSec)]++;
+  if (uSec > myStatsMaxUSec)
+    myStatsMaxUSec = uSec;
+  if (myWarningTimeCB != NULL && 
+      (warningTime = myWarningTimeCB->invokeR()) > 0 &&
+      uSec > (unsigned long)warningTime * 1000)
+    myStatsOverruns++;
+}
+
+/**
+   This comes from the histogram, so it is the top of the bucket the
+   percentile falls in (but never more than the longest run), which is
+   within 25 percent of the actual time.
+
+   @param percentile the percent of runs (ie 50 for the median, 99 for
+   the 99th percentile)
+
+   @return the time in microseconds, 0 if there haven't been any runs
+**/
+AREXPORT unsigned long ArSyncTask::getStatsPercentileUSec(double percentile)
+{
+  unsigned int needed;
+  unsigned int seen = 0;
+  unsigned long ret;
+  int i;
+
+  if (myStatsCount == 0)
+    return 0;
+  needed = (unsigned int)ceil(myStatsCount * percentile / 100.0);
+  if (needed < 1)
+    needed = 1;
+  for (i = 0; i < STATS_BUCKETS; i++)
+  {
+    seen += myStatsBuckets[i];
+    if (seen >= needed)
+      break;
+  }
+  if (i >= STATS_BUCKETS)
+    return myStatsMaxUSec;
+  ret = statsBucketMax(i);
+  if (ret > myStatsMaxUSec)
+    ret = myStatsMaxUSec;
+  return ret;
+}
+
+/**
+   Logs the node's stats... the defaulted depth parameter controls how
+   far over to print the data (how many tabs)... it recurses down all
+   its children.
+**/
+AREXPORT void ArSyncTask::logStats(int depth)
+{
+  std::multimap<int, ArSyncTask *>::reverse_iterator it;
+  std::string indent = "";
+  int i;
+
+  for (i = 0; i < depth; i++)
+    indent += "\t";
+  if (!myStatsEnabled)
+    ArLog::log(ArLog::Terse, "%s%s (no stats)", indent.c_str(), 
+	       myName.c_str());
+  else
+    ArLog::log(ArLog::Terse, 
+	       "%s%s runs %u overruns %u p50 %lu us p99 %lu us max %lu us", 
+	       indent.c_str(), myName.c_str(), myStatsCount, myStatsOverruns,
+	       getStatsPercentileUSec(50), getStatsPercentileUSec(99),
+	       myStatsMaxUSec);
+  for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+    (*it).second->logStats(depth + 1);
+}
+
+/**
+   @param workerPool the pool to run parallel children on, NULL to run
+   them one after another like everything else, this isn't owned by
+   the task (and is set on the children too)
+**/
+AREXPORT void ArSyncTask::setWorkerPool(ArWorkerPool *workerPool)
+{
+  std::multimap<int, ArSyncTask *>::reverse_iterator it;
+
+  myWorkerPool = workerPool;
+  for (it = myMultiMap.rbegin(); it != myMultiMap.rend(); it++)
+    (*it).second->setWorkerPool(workerPool);
+}
@@ -27,10 +27,14 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 
 #include <string>
 #include <map>
+#include <list>
+#include <vector>
 #include "ariaTypedefs.h"
 #include "ArFunctor.h"
 #include "ArTaskState.h"
 
+class ArWorkerPool;
+
 /// Class used internally to manage the tasks that are called every cycle
 /**
    This is used internally, no user should normally have to create one, but 
@@ -70,6 +74,21 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 
    The state of a task can be stored in the target of a given ArTaskState::State pointer,
    or if NULL than ArSyncTask will use its own member variable.
+
+   Each node can also keep statistics on how long it takes to run
+   (see setStatsEnabled()), how many times it has run, how many of
+   those took longer than the cycle warning time, and a histogram of
+   the run times in microseconds that getStatsPercentileUSec() uses.
+   The time for a node includes all of its children, so the time for
+   a branch is the time for everything in it.  Stats are off by
+   default, new nodes get the setting of the node they're added to.
+
+   A node can be marked as parallel (see setParallel()), if the node
+   it is in has a worker pool (see setWorkerPool()) then children next
+   to each other that are all parallel are run at the same time on the
+   pool, and the next child isn't run until they are all done.  A
+   parallel task must not depend on the ones next to it and should
+   only lock what it owns (like its own range device).
 */
 
 class ArSyncTask
@@ -136,7 +155,42 @@ public:
 
   // returns whether this node is deleting or not
   AREXPORT bool isDeleting(void);
+
+  /// Gets the children of this node, in the order they're run
+  AREXPORT void getChildren(std::list<ArSyncTask *> *children);
+
+  /// Sets whether this node (and by default its children) keeps run time stats
+  AREXPORT void setStatsEnabled(bool statsEnabled, bool recurse = true);
+  /// Gets whether this node keeps run time stats
+  AREXPORT bool getStatsEnabled(void) { return myStatsEnabled; }
+  /// Resets the run time stats of this node (and by default its children)
+  AREXPORT void resetStats(bool recurse = true);
+  /// Gets how many times this node has run since the stats were reset
+  AREXPORT unsigned int getStatsCount(void) { return myStatsCount; }
+  /// Gets how many runs took longer than the cycle warning time
+  AREXPORT unsigned int getStatsOverruns(void) { return myStatsOverruns; }
+  /// Gets the longest run in microseconds
+  AREXPORT unsigned long getStatsMaxUSec(void) { return myStatsMaxUSec; }
+  /// Gets the run time in microseconds that percentile percent of runs were under
+  AREXPORT unsigned long getStatsPercentileUSec(double percentile);
+  /// Logs the run time stats of the node and all of its children
+  AREXPORT void logStats(int depth = 0);
+
+  /// Sets whether this node can run at the same time as its parallel neighbors
+  AREXPORT void setParallel(bool parallel) { myParallel = parallel; }
+  /// Gets whether this node can run at the same time as its parallel neighbors
+  AREXPORT bool getParallel(void) { return myParallel; }
+  /// Sets the pool that parallel children run on (and on the children's children), NULL for none
+  AREXPORT void setWorkerPool(ArWorkerPool *workerPool);
+  /// Gets the pool that parallel children run on
+  AREXPORT ArWorkerPool *getWorkerPool(void) { return myWorkerPool; }
 protected:
+  /// Gets which histogram bucket a time goes into
+  static int statsBucket(unsigned long uSec);
+  /// Gets the largest time that goes into a histogram bucket
+  static unsigned long statsBucketMax(int bucket);
+  /// Adds a run to the stats
+  void addStats(unsigned long uSec);
   std::multimap<int, ArSyncTask *> myMultiMap;
   ArTaskState::State *myStatePointer;
   ArTaskState::State myState;
@@ -150,6 +204,22 @@ protected:
   bool myRunning;
   // this is just a pointer to what we're invoking so we can know later
   ArSyncTask *myInvokingOtherFunctor;
+
+  // the histogram has one bucket per microsecond under 16, then 4
+  // buckets per power of 2 (so its within 25 percent) up past an hour
+  enum { STATS_EXACT = 16, STATS_BUCKETS = 16 + 28 * 4 };
+  bool myStatsEnabled;
+  unsigned int myStatsCount;
+  unsigned int myStatsOverruns;
+  unsigned long myStatsMaxUSec;
+  unsigned int myStatsBuckets[STATS_BUCKETS];
+
+  bool myParallel;
+  ArWorkerPool *myWorkerPool;
+  ArFunctorC<ArSyncTask> myRunCB;
+  // the run functors of the parallel children being run, kept so it
+  // doesn't have to be allocated each time
+  std::vector<ArFunctor *> myParallelRunCBs;
 };
 
 
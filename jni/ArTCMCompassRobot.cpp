@@ -34,7 +34,7 @@ AREXPORT ArTCMCompassRobot::ArTCMCompassRobot(ArRobot *robot) :
   myRobot = robot;
   myPacketHandlerCB.setName("ArTCMCompassRobot");
   if (myRobot != NULL)
-    myRobot->addPacketHandler(&myPacketHandlerCB);
+    myRobot->addPacketHandlerForID(&myPacketHandlerCB, 0xC0);
 }
 
 AREXPORT ArTCMCompassRobot::~ArTCMCompassRobot()
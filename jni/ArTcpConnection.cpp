@@ -238,6 +238,5 @@ AREXPORT bool ArTcpConnection::isTimeStamping(void)
 AREXPORT ArTime ArTcpConnection::getTimeRead(int index)
 {
   ArTime now;
-  now.setToNow();
   return now;
 }
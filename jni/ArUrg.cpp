@@ -94,7 +94,7 @@ AREXPORT ArUrg::~ArUrg()
   {
     myRobot->remRangeDevice(this);
     myRobot->remLaser(this);
-    myRobot->remSensorInterpTask(&mySensorInterpTask);
+    laserRemSensorInterpTask();
   }
   if (myRawReadings != NULL)
   {
@@ -246,7 +246,7 @@ AREXPORT void ArUrg::setRobot(ArRobot *robot)
 {
   myRobot = robot;
   if (myRobot != NULL)
-    myRobot->addSensorInterpTask("urg", 90, &mySensorInterpTask);
+    laserAddSensorInterpTask("urg", 90, &mySensorInterpTask);
   ArRangeDevice::setRobot(robot);
 }
 
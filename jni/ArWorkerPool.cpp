@@ -0,0 +1,177 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "ArExport.h"
+#include "ariaOSDef.h"
+#include "ArWorkerPool.h"
+#include "ArLog.h"
+#include "ariaUtil.h"
+
+/**
+   @param numWorkers how many threads to start (the thread calling
+   runAll also runs functors, so this can be one less than the number
+   of things that should run at once)
+
+   @param name the name to use for the threads and the mutex
+**/
+AREXPORT ArWorkerPool::ArWorkerPool(int numWorkers, const char *name)
+{
+  std::string threadName;
+  int i;
+
+  myMutex.setLogName(name);
+  myFunctors = NULL;
+  myNextFunctor = 0;
+  myFunctorsLeft = 0;
+  for (i = 0; i < numWorkers; i++)
+  {
+    threadName = name;
+    threadName += "::WorkerThread";
+    myWorkers.push_back(new WorkerThread(this, threadName.c_str()));
+  }
+}
+
+AREXPORT ArWorkerPool::~ArWorkerPool()
+{
+  std::vector<WorkerThread *>::iterator it;
+
+  for (it = myWorkers.begin(); it != myWorkers.end(); it++)
+    (*it)->stopRunning();
+  myWorkCond.broadcast();
+  for (it = myWorkers.begin(); it != myWorkers.end(); it++)
+  {
+    (*it)->join();
+    delete (*it);
+  }
+  myWorkers.clear();
+}
+
+/**
+   This shouldn't be called from more than one thread at a time.
+
+   @param functors the functors to run, this isn't copied so it must
+   not change until this returns
+**/
+AREXPORT void ArWorkerPool::runAll(const std::vector<ArFunctor *> *functors)
+{
+  size_t left;
+
+  if (functors->empty())
+    return;
+
+  myMutex.lock();
+  myFunctors = functors;
+  myNextFunctor = 0;
+  myFunctorsLeft = functors->size();
+  myMutex.unlock();
+  myWorkCond.broadcast();
+
+  // we help out instead of just waiting
+  runFunctors();
+
+  // then wait for the ones the workers took... the wait is timed in
+  // case the last one finished between us checking and waiting
+  while (1)
+  {
+    myMutex.lock();
+    left = myFunctorsLeft;
+    myMutex.unlock();
+    if (left == 0)
+      break;
+    myDoneCond.timedWait(1);
+  }
+
+  myMutex.lock();
+  myFunctors = NULL;
+  myMutex.unlock();
+}
+
+void ArWorkerPool::runFunctors(void)
+{
+  ArFunctor *functor;
+  bool done;
+
+  while (1)
+  {
+    myMutex.lock();
+    if (myFunctors == NULL || myNextFunctor >= myFunctors->size())
+    {
+      myMutex.unlock();
+      return;
+    }
+    functor = (*myFunctors)[myNextFunctor];
+    myNextFunctor++;
+    myMutex.unlock();
+
+    functor->invoke();
+
+    myMutex.lock();
+    myFunctorsLeft--;
+    done = (myFunctorsLeft == 0);
+    myMutex.unlock();
+    if (done)
+      myDoneCond.signal();
+  }
+}
+
+void ArWorkerPool::waitForFunctors(void)
+{
+  bool haveFunctors;
+
+  myMutex.lock();
+  haveFunctors = (myFunctors != NULL && myNextFunctor < myFunctors->size());
+  myMutex.unlock();
+  // this is timed so a missed wakeup only costs a little (and runAll
+  // doesn't need us to finish anyways)
+  if (!haveFunctors)
+    myWorkCond.timedWait(100);
+}
+
+ArWorkerPool::WorkerThread::WorkerThread(ArWorkerPool *pool, 
+					 const char *name)
+{
+  setThreadName(name);
+  myPool = pool;
+  runAsync();
+}
+
+ArWorkerPool::WorkerThread::~WorkerThread()
+{
+
+}
+
+void *ArWorkerPool::WorkerThread::runThread(void *arg)
+{
+  threadStarted();
+
+  while (getRunning())
+  {
+    myPool->waitForFunctors();
+    if (getRunning())
+      myPool->runFunctors();
+  }
+
+  threadFinished();
+  return NULL;
+}
@@ -0,0 +1,86 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#ifndef ARWORKERPOOL_H
+#define ARWORKERPOOL_H
+
+#include <vector>
+#include "ariaTypedefs.h"
+#include "ArFunctor.h"
+#include "ArMutex.h"
+#include "ArCondition.h"
+#include "ArASyncTask.h"
+
+/// A few threads that run a set of functors at the same time
+/**
+   runAll() hands out the functors it is given to the pool's threads
+   (and runs some of them itself), then returns once all of them are
+   done.  The thread calling runAll() takes functors too, so all of
+   them always get run even if the workers are slow to wake up.
+
+   ArRobot uses this to run the sensor interp tasks that are marked as
+   parallel at the same time (see ArRobot::setSensorInterpThreads).
+**/
+class ArWorkerPool
+{
+public:
+  /// Constructor
+  AREXPORT ArWorkerPool(int numWorkers, const char *name = "ArWorkerPool");
+  /// Destructor (stops the threads)
+  AREXPORT virtual ~ArWorkerPool();
+  /// Runs all the functors, returning when they're all done
+  AREXPORT void runAll(const std::vector<ArFunctor *> *functors);
+  /// Gets how many threads there are (besides the one calling runAll)
+  AREXPORT int getNumWorkers(void) const { return myWorkers.size(); }
+protected:
+  /// Runs functors until there aren't any left to start
+  void runFunctors(void);
+  /// Waits for there to be functors to run
+  void waitForFunctors(void);
+
+  class WorkerThread : public ArASyncTask
+  {
+  public:
+    /// Constructor
+    WorkerThread(ArWorkerPool *pool, const char *name);
+    /// Destructor
+    virtual ~WorkerThread(void);
+    virtual void *runThread(void *arg);
+  protected:
+    ArWorkerPool *myPool;
+  };
+  friend class ArWorkerPool::WorkerThread;
+
+  std::vector<WorkerThread *> myWorkers;
+  ArMutex myMutex;
+  // the functors from runAll, the next one to start, and how many
+  // haven't finished
+  const std::vector<ArFunctor *> *myFunctors;
+  size_t myNextFunctor;
+  size_t myFunctorsLeft;
+  ArCondition myWorkCond;
+  ArCondition myDoneCond;
+};
+
+#endif
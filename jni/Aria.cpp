@@ -229,6 +229,8 @@ AREXPORT void Aria::uninit()
   ArModuleLoader::closeAll();
 #endif // ARINTERFACE
   ArSocket::shutdown();
+  // write out anything still waiting to be logged
+  ArLog::setAsync(false);
 }
 
 /**
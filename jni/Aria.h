@@ -31,10 +31,13 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArTcpConnection.h"
 #include "ArSimpleConnector.h"
 #include "ArLogFileConnection.h"
+#include "ArReplayConnection.h"
 #include "ArLog.h"
+#include "ArBinaryLog.h"
 #include "ArRobotPacket.h"
 #include "ArRobotPacketSender.h"
 #include "ArRobotPacketReceiver.h"
+#include "ArRobotPacketRecorder.h"
 #include "ArRobotConfigPacketReader.h"
 #include "ArRobotTypes.h"
 #include "ariaUtil.h"
@@ -45,9 +48,12 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #include "ArConfigArg.h"
 #include "ArConfigGroup.h"
 #include "ArRobot.h"
+#include "ArRobotStateSnapshot.h"
 #include "ArCommands.h"
 #include "ArJoyHandler.h"
 #include "ArSyncTask.h"
+#include "ArWorkerPool.h"
+#include "ArBackgroundWriter.h"
 #include "ArTaskState.h"
 #include "ariaInternal.h"
 #include "ArSonarDevice.h"
@@ -109,6 +115,7 @@ MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
 #endif
 #include "ArActionGotoStraight.h"
 #include "ArDataLogger.h"
+#include "ArDataLogReader.h"
 #include "ArRobotJoyHandler.h"
 #include "ArRatioInputKeydrive.h"
 #include "ArRatioInputJoydrive.h"
@@ -180,6 +180,70 @@ AREXPORT unsigned int ArUtil::getTime(void)
 #endif
 }
 
+/**
+   Get the time in microseconds, counting from some arbitrary point.
+   This wraps around (every 71 minutes where longs are 32 bits) so it
+   is only good for timing short things, with unsigned subtraction.
+   @return microsecond time
+*/
+AREXPORT unsigned long ArUtil::getTimeUSec(void)
+{
+#if defined(_POSIX_TIMERS) && defined(_POSIX_MONOTONIC_CLOCK)
+  struct timespec tp;
+  if (clock_gettime(CLOCK_MONOTONIC, &tp) == 0)
+    return tp.tv_nsec / 1000 + (unsigned long)tp.tv_sec * 1000000;
+#endif
+#if !defined(WIN32)
+  struct timeval tv;
+  if (gettimeofday(&tv,NULL) == 0)
+    return tv.tv_usec + (unsigned long)tv.tv_sec * 1000000;
+  else
+    return 0;
+#elif defined(WIN32)
+  return (unsigned long)timeGetTime() * 1000;
+#endif
+}
+
+/**
+   This is for things that hand data between threads without a mutex
+   (like ArRobot::getStateSnapshot), it keeps both the compiler and the
+   processor from moving memory accesses across it.
+**/
+AREXPORT void ArUtil::memoryBarrier(void)
+{
+#ifdef WIN32
+  MemoryBarrier();
+#else
+  __sync_synchronize();
+#endif
+}
+
+/**
+   This is a full memory barrier too.
+**/
+AREXPORT int ArUtil::atomicAdd(volatile int *val, int amount)
+{
+#ifdef WIN32
+  return InterlockedExchangeAdd((volatile LONG *)val, amount) + amount;
+#else
+  return __sync_add_and_fetch(val, amount);
+#endif
+}
+
+/**
+   This is a full memory barrier too.
+**/
+AREXPORT bool ArUtil::atomicCompareAndSwap(volatile int *val, int oldVal, 
+					   int newVal)
+{
+#ifdef WIN32
+  return InterlockedCompareExchange((volatile LONG *)val, newVal, 
+				    oldVal) == oldVal;
+#else
+  return __sync_bool_compare_and_swap(val, oldVal, newVal);
+#endif
+}
+
 /*
    Takes a string and splits it into a list of words. It appends the words
    to the outList. If there is nothing found, it will not touch the outList.
@@ -924,9 +988,65 @@ AREXPORT bool ArUtil::getStringFromRegistry(REGKEY root,
 #if defined(_POSIX_TIMERS) && defined(_POSIX_MONOTONIC_CLOCK)
 bool ArTime::ourMonotonicClock = true;
 #endif 
+bool ArTime::ourVirtualClock = false;
+time_t ArTime::ourVirtualSec = 0;
+long ArTime::ourVirtualNSec = 0;
+volatile unsigned int ArTime::ourVirtualSeq = 0;
+
+/**
+   When the virtual clock is used, setToNow (on ArTime and
+   ArPreciseTime) gives whatever time was last set with setVirtualNow
+   instead of reading the system's clock.  This is for replaying
+   recorded data (see ArReplayConnection) as fast as it can go while
+   everything that uses time still sees the time from the recording.
+   Note that it doesn't change ArUtil::sleep or ArCondition::timedWait,
+   those still use the real clock.
+**/
+AREXPORT void ArTime::setVirtualClock(bool useVirtualClock)
+{
+  ourVirtualClock = useVirtualClock;
+}
+
+/**
+   This should only be called from one thread (whatever is driving the
+   virtual clock), but any thread can read the time.
+**/
+AREXPORT void ArTime::setVirtualNow(time_t sec, long nSec)
+{
+  // odd while it's being changed so readers know to try again
+  ourVirtualSeq++;
+  ArUtil::memoryBarrier();
+  ourVirtualSec = sec;
+  ourVirtualNSec = nSec;
+  ArUtil::memoryBarrier();
+  ourVirtualSeq++;
+}
+
+AREXPORT void ArTime::getVirtualNow(time_t *sec, long *nSec)
+{
+  unsigned int seq;
+
+  while (1)
+  {
+    seq = ourVirtualSeq;
+    ArUtil::memoryBarrier();
+    *sec = ourVirtualSec;
+    *nSec = ourVirtualNSec;
+    ArUtil::memoryBarrier();
+    if ((seq & 1) == 0 && seq == ourVirtualSeq)
+      return;
+  }
+}
 
 AREXPORT void ArTime::setToNow(void)
 {
+  if (ourVirtualClock)
+  {
+    long nSec;
+    getVirtualNow(&mySec, &nSec);
+    myMSec = nSec / 1000000;
+    return;
+  }
 // if we have the best way of finding time use that
 #if defined(_POSIX_TIMERS) && defined(_POSIX_MONOTONIC_CLOCK)
   if (ourMonotonicClock)
@@ -976,6 +1096,50 @@ AREXPORT void ArTime::setToNow(void)
       
 }
 
+/**
+   On linux this is clock_gettime on the monotonic clock (the same
+   clock ArTime uses), which doesn't actually make a system call since
+   the kernel maps it into each process, on windows its only as
+   precise as timeGetTime.  If ArTime is using the virtual clock
+   (ArTime::setVirtualClock) this uses it too.
+**/
+AREXPORT void ArPreciseTime::setToNow(void)
+{
+  if (ArTime::usingVirtualClock())
+  {
+    ArTime::getVirtualNow(&mySec, &myNSec);
+    return;
+  }
+#if defined(_POSIX_TIMERS) && defined(_POSIX_MONOTONIC_CLOCK)
+  if (ArTime::usingMonotonicClock())
+  {
+    struct timespec timeNow;
+    if (clock_gettime(CLOCK_MONOTONIC, &timeNow) == 0)
+    {
+      mySec = timeNow.tv_sec;
+      myNSec = timeNow.tv_nsec;
+      return;
+    }
+  }
+#endif
+#ifndef WIN32
+  struct timeval timeNow;
+  
+  if (gettimeofday(&timeNow, NULL) == 0)
+  {
+    mySec = timeNow.tv_sec;
+    myNSec = timeNow.tv_usec * 1000;
+  }
+  else
+    ArLog::logNoLock(ArLog::Terse, "ArPreciseTime::setToNow: invalid return from gettimeofday.");
+#else
+  long timeNow;
+  timeNow = timeGetTime();
+  mySec = timeNow / 1000;
+  myNSec = (timeNow % 1000) * 1000000;
+#endif
+}
+
 AREXPORT ArRunningAverage::ArRunningAverage(size_t numToAverage)
 {
   myNumToAverage = numToAverage;
@@ -1780,6 +1944,46 @@ AREXPORT bool ArUtil::floatIsNormal(double f)
 #endif
 }
 
+/// The lookup table for ArUtil::crc32, made the first time it's used
+class ArUtilCrc32Table
+{
+public:
+  ArUtilCrc32Table()
+    {
+      ArTypes::UByte4 c;
+      int i, k;
+      for (i = 0; i < 256; i++)
+      {
+	c = (ArTypes::UByte4)i;
+	for (k = 0; k < 8; k++)
+	  c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+	myTable[i] = c;
+      }
+    }
+  ArTypes::UByte4 myTable[256];
+};
+
+/**
+   To get the CRC of data that comes in pieces pass the return from
+   the previous piece in as @a crc.
+
+   @param data the data to compute the CRC of
+   @param length the number of bytes in data
+   @param crc the CRC so far (0 to start)
+**/
+AREXPORT ArTypes::UByte4 ArUtil::crc32(const void *data, size_t length,
+				       ArTypes::UByte4 crc)
+{
+  static ArUtilCrc32Table table;
+  const unsigned char *bytes = (const unsigned char *)data;
+  size_t i;
+
+  crc = crc ^ 0xffffffff;
+  for (i = 0; i < length; i++)
+    crc = table.myTable[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+  return crc ^ 0xffffffff;
+}
+
 
 AREXPORT long ArMath::randomInRange(long m, long n)
 {
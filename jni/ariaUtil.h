@@ -97,6 +97,17 @@ public:
   /// Get the time in milliseconds
   AREXPORT static unsigned int getTime(void);
 
+  /// Get the time in microseconds (wraps, so only use for differences)
+  AREXPORT static unsigned long getTimeUSec(void);
+
+  /// Makes sure all memory reads and writes before this finish before any after it
+  AREXPORT static void memoryBarrier(void);
+  /// Adds amount to val as one step no other thread can see half of, returning the new value
+  AREXPORT static int atomicAdd(volatile int *val, int amount);
+  /// Sets val to newVal if it is oldVal, as one step, returning whether it did
+  AREXPORT static bool atomicCompareAndSwap(volatile int *val, int oldVal, 
+					    int newVal);
+
   /// Delete all members of a set. Does NOT empty the set.
   /** 
       Assumes that T is an iterator that supports the operator*, operator!=
@@ -396,6 +407,10 @@ public:
   /** Return true if the value of @a f is not NaN and is not infinite (+/- INF) */
   AREXPORT static bool floatIsNormal(double f);
 
+  /// Computes the CRC-32 of some data (the same one zlib and ethernet use)
+  AREXPORT static ArTypes::UByte4 crc32(const void *data, size_t length,
+					ArTypes::UByte4 crc = 0);
+
 protected:
 //#ifndef WIN32
   /// this splits up a file name (it isn't exported since it'd crash with dlls)
@@ -885,6 +900,8 @@ class ArTime
 public:
   /// Constructor. Time is initialized to the current time.
   ArTime() { setToNow(); }
+  /// Constructor with the given time (this does NOT read the clock)
+  ArTime(time_t sec, time_t mSec) { mySec = sec; myMSec = mSec; }
   /// Destructor
   ~ArTime() {}
   
@@ -992,26 +1009,141 @@ public:
 #endif
       return false;
     }
+  /// Sets whether the time comes from the virtual clock instead of the system
+  AREXPORT static void setVirtualClock(bool useVirtualClock);
+  /// Gets whether the time comes from the virtual clock instead of the system
+  static bool usingVirtualClock(void) { return ourVirtualClock; }
+  /// Sets what time it is on the virtual clock
+  AREXPORT static void setVirtualNow(time_t sec, long nSec);
+  /// Gets what time it is on the virtual clock
+  AREXPORT static void getVirtualNow(time_t *sec, long *nSec);
 protected:
   time_t mySec;
   time_t myMSec;
 #if defined(_POSIX_TIMERS) && defined(_POSIX_MONOTONIC_CLOCK)
   static bool ourMonotonicClock;
 #endif 
+  static bool ourVirtualClock;
+  static time_t ourVirtualSec;
+  static long ourVirtualNSec;
+  static volatile unsigned int ourVirtualSeq;
 };
 
-/// A subclass of pose that also has the time the pose was taken
+/// A timestamp with nanosecond storage, for timing things shorter than a millisecond
 /**
+   This is kept alongside ArTime for the places that need to time
+   things more finely than a millisecond or that make a lot of
+   timestamps.  It reads the same clock as ArTime (the monotonic clock
+   where there is one), so you can convert between the two with the
+   ArPreciseTime(ArTime) constructor and toArTime().
+
+   Unlike ArTime the constructor does NOT read the clock, the time
+   starts at 0 until you call setToNow() (or use now()), so members
+   and locals that get set later don't pay for reading the clock.
+
+   The differences (uSecSince(), mSecSince()) work the same way as
+   ArTime::mSecSince(), the given time minus this one.  Microsecond
+   differences fit in a 32 bit long for a bit over half an hour, so
+   use secSince() for anything that could be apart longer than that.
+*/
+class ArPreciseTime
+{
+public:
+  /// Constructor, the time is 0 (this does NOT read the clock)
+  ArPreciseTime() { mySec = 0; myNSec = 0; }
+  /// Constructor from an ArTime
+  explicit ArPreciseTime(const ArTime &time) 
+    { mySec = time.getSec(); myNSec = time.getMSec() * 1000000; }
+  /// Destructor
+  ~ArPreciseTime() {}
+  /// Gets a time set to now
+  static ArPreciseTime now(void) 
+    { ArPreciseTime ret; ret.setToNow(); return ret; }
+  /// Sets the time to now
+  AREXPORT void setToNow(void);
+  /// Gets this as an ArTime (to the millisecond)
+  ArTime toArTime(void) const
+    { return ArTime(mySec, myNSec / 1000000); }
+  /// Gets the number of microseconds since the given timestamp to this one
+  long uSecSince(const ArPreciseTime &since) const
+    { return ((long)(since.mySec - mySec) * 1000000 + 
+	      (since.myNSec - myNSec) / 1000); }
+  /// Gets the number of milliseconds since the given timestamp to this one
+  long mSecSince(const ArPreciseTime &since) const
+    { return ((long)(since.mySec - mySec) * 1000 + 
+	      (since.myNSec - myNSec) / 1000000); }
+  /// Gets the number of seconds since the given timestamp to this one
+  double secSince(const ArPreciseTime &since) const
+    { return ((double)(since.mySec - mySec) + 
+	      (since.myNSec - myNSec) / 1000000000.0); }
+  /// Gets the number of microseconds from this timestamp to now
+  long uSecSince(void) const { return uSecSince(now()); }
+  /// Gets the number of milliseconds from this timestamp to now
+  long mSecSince(void) const { return mSecSince(now()); }
+  /// Gets the number of seconds from this timestamp to now
+  double secSince(void) const { return secSince(now()); }
+  /// returns whether the given time is before this one or not
+  bool isBefore(const ArPreciseTime &testTime) const
+    { return (testTime.mySec < mySec || 
+	      (testTime.mySec == mySec && testTime.myNSec < myNSec)); }
+  /// returns whether the given time is equal to this time or not
+  bool isAt(const ArPreciseTime &testTime) const
+    { return (testTime.mySec == mySec && testTime.myNSec == myNSec); }
+  /// returns whether the given time is after this one or not
+  bool isAfter(const ArPreciseTime &testTime) const
+    { return testTime.isBefore(*this); }
+  /// Add some microseconds (can be negative) to this time
+  void addUSec(long uSec) { addNSec(uSec % 1000000 * 1000, uSec / 1000000); }
+  /// Add some milliseconds (can be negative) to this time
+  void addMSec(long mSec) { addNSec(mSec % 1000 * 1000000, mSec / 1000); }
+  /// Gets the seconds value (since the arbitrary starting time)
+  time_t getSec(void) const { return mySec; }
+  /// Gets the nanoseconds value (occuring after the seconds value)
+  long getNSec(void) const { return myNSec; }
+  /// Sets the seconds value (since the arbitrary starting time)
+  void setSec(time_t sec) { mySec = sec; }
+  /// Sets the nanoseconds value (occuring after the seconds value)
+  void setNSec(long nSec) { myNSec = nSec; }
+  /// Gets if the time has been set (isn't 0)
+  bool isSet(void) const { return (mySec != 0 || myNSec != 0); }
+  /// Logs the time
+  void log(void) const
+    { ArLog::log(ArLog::Terse, "Time: %ld.%09ld", (long)mySec, myNSec); }
+protected:
+  void addNSec(long nSec, long sec)
+    {
+      myNSec += nSec;
+      mySec += sec;
+      if (myNSec >= 1000000000)
+      {
+	myNSec -= 1000000000;
+	mySec++;
+      }
+      else if (myNSec < 0)
+      {
+	myNSec += 1000000000;
+	mySec--;
+      }
+    }
+  time_t mySec;
+  long myNSec;
+};
 
+/// A subclass of pose that also has the time the pose was taken
+/**
+   The time is 0 unless it is given to the constructor (the
+   constructors do NOT read the clock, since most of these are
+   temporaries or get their time set later), use setTimeToNow() or
+   setTime() to set it.
  */
 class ArPoseWithTime : public ArPose
 {
 public:
   ArPoseWithTime(double x = 0, double y = 0, double th = 0,
-	 ArTime thisTime = ArTime()) : ArPose(x, y, th)
-    { myTime = thisTime; }
+	 ArTime thisTime = ArTime(0, 0)) : ArPose(x, y, th), myTime(thisTime)
+    { }
   /// Copy Constructor
-  ArPoseWithTime(const ArPose &pose) : ArPose(pose) {}
+  ArPoseWithTime(const ArPose &pose) : ArPose(pose), myTime(0, 0) {}
   virtual ~ArPoseWithTime() {}
   void setTime(ArTime newTime) { myTime = newTime; }
   void setTimeToNow(void) { myTime.setToNow(); }
@@ -0,0 +1,213 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "Aria.h"
+#include <ctype.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+   Times parsing a big generated config file's lines into argument
+   builders the way ArFileParser::parseLine does, with ArArgumentBuilder
+   and with OldArgumentBuilder, which keeps args the way
+   ArArgumentBuilder did before it kept them inline (a new argv of
+   argvLen pointers for every builder, a new[] for every arg and a
+   copy of each line into a 10000 char buffer).  
+
+   Usage: argumentBuilderBenchmark [sections] [paramsPerSection] [passes]
+**/
+
+/// ArArgumentBuilder's storage from before args were kept inline
+class OldArgumentBuilder
+{
+public:
+  OldArgumentBuilder(size_t argvLen = 512)
+    {
+      myArgc = 0;
+      myArgvLen = argvLen;
+      myArgv = new char *[myArgvLen];
+      myFirstAdd = true;
+    }
+  ~OldArgumentBuilder()
+    {
+      size_t i;
+      for (i = 0; i < myArgc; i++)
+	delete[] myArgv[i];
+      delete[] myArgv;
+    }
+  void addPlain(const char *str)
+    {
+      char buf[10000];
+      int i;
+      int startNonSpace;
+      int len;
+      bool findingSpace = true;
+
+      strncpy(buf, str, sizeof(buf));
+      len = strlen(buf);
+      for (i = 0; i < len && isspace(buf[i]); i++)
+	;
+      if (i == len)
+	return;
+      for (startNonSpace = i; ; ++i)
+      {
+	if (!findingSpace && !(i == len || isspace(buf[i])))
+	{
+	  startNonSpace = i;
+	  findingSpace = true;
+	}
+	else if (findingSpace && (i == len || isspace(buf[i])))
+	{
+	  if (myArgc + 1 < myArgvLen)
+	  {
+	    myArgv[myArgc] = new char[i - startNonSpace + 1];
+	    strncpy(myArgv[myArgc], &buf[startNonSpace], i - startNonSpace);
+	    myArgv[myArgc][i - startNonSpace] = '\0';
+	    if (!myFirstAdd)
+	      myFullString += " ";
+	    myFullString += myArgv[myArgc];
+	    myFirstAdd = false;
+	    myArgc++;
+	  }
+	  findingSpace = false;
+	}
+	if (i == len)
+	  break;
+      }
+    }
+  void setExtraString(const char *str) { myExtraString = str; }
+  size_t getArgc(void) const { return myArgc; }
+protected:
+  size_t myArgc;
+  char **myArgv;
+  size_t myArgvLen;
+  std::string myExtraString;
+  std::string myFullString;
+  bool myFirstAdd;
+};
+
+/// Splits the keyword off the line like ArFileParser does
+const char *splitKeyword(char *line, char *keyword, size_t keywordLen)
+{
+  size_t i;
+  for (i = 0; line[i] != '\0' && !isspace(line[i]) && i + 1 < keywordLen; 
+       i++)
+    keyword[i] = line[i];
+  keyword[i] = '\0';
+  while (line[i] != '\0' && isspace(line[i]))
+    i++;
+  return &line[i];
+}
+
+/// Parses every line with the given builder type, returns the args made
+template <class Builder>
+unsigned long parseLines(const std::vector<std::string> *lines, int passes)
+{
+  std::vector<std::string>::const_iterator it;
+  char line[10000];
+  char keyword[512];
+  const char *valueStart;
+  unsigned long args = 0;
+  int pass;
+
+  for (pass = 0; pass < passes; pass++)
+  {
+    for (it = lines->begin(); it != lines->end(); it++)
+    {
+      strncpy(line, (*it).c_str(), sizeof(line) - 1);
+      line[sizeof(line) - 1] = '\0';
+      valueStart = splitKeyword(line, keyword, sizeof(keyword));
+      Builder builder(512);
+      builder.addPlain(valueStart);
+      builder.setExtraString(keyword);
+      args += builder.getArgc();
+    }
+  }
+  return args;
+}
+
+int main(int argc, char **argv)
+{
+  int sections = 50;
+  int params = 200;
+  int passes = 20;
+  std::vector<std::string> lines;
+  char buf[1024];
+  int i;
+  int j;
+  ArTime started;
+  long oldMSecs;
+  long newMSecs;
+  unsigned long oldArgs;
+  unsigned long newArgs;
+
+  Aria::init();
+
+  if (argc > 1)
+    sections = atoi(argv[1]);
+  if (argc > 2)
+    params = atoi(argv[2]);
+  if (argc > 3)
+    passes = atoi(argv[3]);
+
+  // a config like the big ARNL ones, a mix of numbers, words and lists
+  for (i = 0; i < sections; i++)
+  {
+    snprintf(buf, sizeof(buf), "Section Section%d", i);
+    lines.push_back(buf);
+    for (j = 0; j < params; j++)
+    {
+      if (j % 4 == 0)
+	snprintf(buf, sizeof(buf), "IntParam%d %d", j, i * j);
+      else if (j % 4 == 1)
+	snprintf(buf, sizeof(buf), "DoubleParam%d %g", j, i * 0.25 + j);
+      else if (j % 4 == 2)
+	snprintf(buf, sizeof(buf), "StringParam%d some_value_%d", j, j);
+      else
+	snprintf(buf, sizeof(buf), "ListParam%d %d %d %d %d %d", 
+		 j, i, j, i + j, i * 2, j * 2);
+      lines.push_back(buf);
+    }
+  }
+
+  printf("Parsing %d lines %d times\n", (int)lines.size(), passes);
+
+  started.setToNow();
+  oldArgs = parseLines<OldArgumentBuilder>(&lines, passes);
+  oldMSecs = started.mSecSince();
+
+  started.setToNow();
+  newArgs = parseLines<ArArgumentBuilder>(&lines, passes);
+  newMSecs = started.mSecSince();
+
+  printf("old builder: %6ld ms (%lu args)\n", oldMSecs, oldArgs);
+  printf("ArArgumentBuilder: %6ld ms (%lu args)\n", newMSecs, newArgs);
+  if (oldArgs != newArgs)
+  {
+    printf("The builders made different numbers of args!\n");
+    return 1;
+  }
+  return 0;
+}
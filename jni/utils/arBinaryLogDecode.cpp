@@ -0,0 +1,77 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "Aria.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+   Turns a binary log made with ArBinaryLog into the text ArLog would
+   have written (see ArBinaryLog::decode).
+
+   Usage: arBinaryLogDecode <binaryLog> [textFile] [-noTime]
+
+   The text goes to stdout if no text file is given, -noTime leaves
+   the time off the start of each line.
+**/
+int main(int argc, char **argv)
+{
+  const char *binaryName = NULL;
+  const char *textName = NULL;
+  bool logTime = true;
+  FILE *out;
+  bool ret;
+  int i;
+
+  for (i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-noTime") == 0)
+      logTime = false;
+    else if (binaryName == NULL)
+      binaryName = argv[i];
+    else if (textName == NULL)
+      textName = argv[i];
+  }
+  if (binaryName == NULL)
+  {
+    printf("Usage: %s <binaryLog> [textFile] [-noTime]\n", argv[0]);
+    return 1;
+  }
+
+  Aria::init();
+
+  if (textName == NULL)
+    out = stdout;
+  else if ((out = ArUtil::fopen(textName, "w")) == NULL)
+  {
+    printf("Could not open %s to write to\n", textName);
+    return 1;
+  }
+
+  ret = ArBinaryLog::decode(binaryName, out, logTime);
+
+  if (out != stdout)
+    fclose(out);
+  return ret ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+/*
+MobileRobots Advanced Robotics Interface for Applications (ARIA)
+Copyright (C) 2004, 2005 ActivMedia Robotics LLC
+Copyright (C) 2006, 2007, 2008, 2009 MobileRobots Inc.
+
+     This program is free software; you can redistribute it and/or modify
+     it under the terms of the GNU General Public License as published by
+     the Free Software Foundation; either version 2 of the License, or
+     (at your option) any later version.
+
+     This program is distributed in the hope that it will be useful,
+     but WITHOUT ANY WARRANTY; without even the implied warranty of
+     MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+     GNU General Public License for more details.
+
+     You should have received a copy of the GNU General Public License
+     along with this program; if not, write to the Free Software
+     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+If you wish to redistribute ARIA under different terms, contact 
+MobileRobots for information about a commercial version of ARIA at 
+robots@mobilerobots.com or 
+MobileRobots Inc, 10 Columbia Drive, Amherst, NH 03031; 800-639-9481
+*/
+#include "Aria.h"
+#include <stdio.h>
+
+/**
+   Turns a columnar log made with ArDataLogger into a CSV file (see
+   ArDataLogReader::exportCSV).
+
+   Usage: exportDataLogCSV <columnarLog> <csvFile>
+
+   Run it on the device the log was written on, the log is in that
+   machine's byte order.
+**/
+int main(int argc, char **argv)
+{
+  if (argc < 3)
+  {
+    printf("Usage: %s <columnarLog> <csvFile>\n", argv[0]);
+    return 1;
+  }
+
+  Aria::init();
+
+  if (!ArDataLogReader::exportCSV(argv[1], argv[2]))
+  {
+    printf("Could not export %s to %s\n", argv[1], argv[2]);
+    return 1;
+  }
+  return 0;
+}